@@ -7908,6 +7908,8 @@ cmd_heal_volume_statistics_out (dict_t *dict, int  brick)
         char            *end_time_str = NULL;
         char            *crawl_type = NULL;
         int             progress = -1;
+        uint64_t        data_healed = 0;
+        uint64_t        data_heal_rate = 0;
 
         snprintf (key, sizeof key, "%d-hostname", brick);
         ret = dict_get_str (dict, key, &hostname);
@@ -7917,6 +7919,18 @@ cmd_heal_volume_statistics_out (dict_t *dict, int  brick)
         cli_out ("\nCrawl statistics for brick no %d", brick);
         cli_out ("Hostname of brick %s", hostname);
 
+        /* not sent by older self-heal daemons */
+        snprintf (key, sizeof key, "statistics-%d-data_healed", brick);
+        if (dict_get_uint64 (dict, key, &data_healed) == 0) {
+                snprintf (key, sizeof key, "statistics-%d-data_heal_rate",
+                          brick);
+                if (dict_get_uint64 (dict, key, &data_heal_rate))
+                        data_heal_rate = 0;
+                cli_out ("Data healed into brick: %"PRIu64" bytes "
+                         "(%"PRIu64" bytes/sec)", data_healed,
+                         data_heal_rate);
+        }
+
         snprintf (key, sizeof key, "statistics-%d-count", brick);
         ret = dict_get_uint64 (dict, key, &num_entries);
         if (ret)
@@ -8095,6 +8109,37 @@ out:
         return;
 }
 
+/* sweep progress of a brick's self-heal daemon, for the heal launch
+ * commands of the xlators reporting it */
+void
+cmd_heal_volume_progress_out (dict_t *dict, int brick)
+{
+        int             ret = 0;
+        char            key[256] = {0};
+        char           *hostname = NULL;
+        char           *path = NULL;
+        char           *progress = NULL;
+
+        snprintf (key, sizeof key, "%d-progress", brick);
+        ret = dict_get_str (dict, key, &progress);
+        if (ret)
+                goto out;
+        snprintf (key, sizeof key, "%d-hostname", brick);
+        ret = dict_get_str (dict, key, &hostname);
+        if (ret)
+                goto out;
+        snprintf (key, sizeof key, "%d-path", brick);
+        ret = dict_get_str (dict, key, &path);
+        if (ret)
+                goto out;
+
+        cli_out ("\nBrick %s:%s", hostname, path);
+        cli_out ("Progress: %s", progress);
+
+out:
+        return;
+}
+
 int
 gf_is_cli_heal_get_command (gf_xl_afr_op_t heal_op)
 {
@@ -8250,7 +8295,9 @@ gf_cli_heal_volume_cbk (struct rpc_req *req, struct iovec *iov,
         }
 
         ret = rsp.op_ret;
-        if (!gf_is_cli_heal_get_command (heal_op))
+        if (!gf_is_cli_heal_get_command (heal_op) &&
+            (heal_op != GF_SHD_OP_HEAL_INDEX) &&
+            (heal_op != GF_SHD_OP_HEAL_FULL))
                 goto out;
 
         dict = dict_new ();
@@ -8297,6 +8344,11 @@ gf_cli_heal_volume_cbk (struct rpc_req *req, struct iovec *iov,
                 for (i = 0; i < brick_count; i++)
                         cmd_heal_volume_brick_out (dict, i);
                 break;
+        case GF_SHD_OP_HEAL_INDEX:
+        case GF_SHD_OP_HEAL_FULL:
+                for (i = 0; i < brick_count; i++)
+                        cmd_heal_volume_progress_out (dict, i);
+                break;
         default:
                 break;
         }
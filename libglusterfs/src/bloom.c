@@ -0,0 +1,165 @@
+/*
+  Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "bloom.h"
+#include "hashfn.h"
+#include "byte-order.h"
+#include "mem-pool.h"
+
+/* ln(2) * bits per name, rounded */
+#define GF_BLOOM_HASHES 7
+
+gf_bloom_t *
+gf_bloom_new (uint32_t expected)
+{
+        gf_bloom_t *bloom = NULL;
+        uint64_t    want  = 0;
+        uint32_t    nbits = GF_BLOOM_MIN_BITS;
+
+        want = (uint64_t) expected * GF_BLOOM_BITS_PER_NAME;
+        while (nbits < want && nbits < (1U << 31))
+                nbits <<= 1;
+
+        bloom = GF_CALLOC (1, sizeof (*bloom) + nbits / 8,
+                           gf_common_mt_bloom_t);
+        if (!bloom)
+                return NULL;
+
+        bloom->nbits = nbits;
+        bloom->nhashes = GF_BLOOM_HASHES;
+
+        return bloom;
+}
+
+
+void
+gf_bloom_free (gf_bloom_t *bloom)
+{
+        GF_FREE (bloom);
+}
+
+
+void
+gf_bloom_hash (const char *name, uint32_t *h1, uint32_t *h2)
+{
+        int len = strlen (name);
+
+        *h1 = gf_dm_hashfn (name, len);
+        /* odd, so that the probe sequence visits every bit */
+        *h2 = SuperFastHash (name, len) | 1;
+}
+
+
+void
+gf_bloom_add (gf_bloom_t *bloom, const char *name)
+{
+        uint32_t h1  = 0;
+        uint32_t h2  = 0;
+        uint32_t bit = 0;
+        uint32_t i   = 0;
+
+        gf_bloom_hash (name, &h1, &h2);
+
+        for (i = 0; i < bloom->nhashes; i++) {
+                bit = (h1 + i * h2) & (bloom->nbits - 1);
+                bloom->bits[bit >> 3] |= (1 << (bit & 7));
+        }
+
+        bloom->count++;
+}
+
+
+gf_boolean_t
+gf_bloom_check_hash (const gf_bloom_t *bloom, uint32_t h1, uint32_t h2)
+{
+        uint32_t bit = 0;
+        uint32_t i   = 0;
+
+        for (i = 0; i < bloom->nhashes; i++) {
+                bit = (h1 + i * h2) & (bloom->nbits - 1);
+                if (!(bloom->bits[bit >> 3] & (1 << (bit & 7))))
+                        return _gf_false;
+        }
+
+        return _gf_true;
+}
+
+
+gf_boolean_t
+gf_bloom_check (const gf_bloom_t *bloom, const char *name)
+{
+        uint32_t h1 = 0;
+        uint32_t h2 = 0;
+
+        gf_bloom_hash (name, &h1, &h2);
+
+        return gf_bloom_check_hash (bloom, h1, h2);
+}
+
+
+size_t
+gf_bloom_serialized_size (const gf_bloom_t *bloom)
+{
+        return sizeof (gf_bloom_hdr_t) + bloom->nbits / 8;
+}
+
+
+void
+gf_bloom_serialize (const gf_bloom_t *bloom, char *buf)
+{
+        gf_bloom_hdr_t hdr = {0, };
+
+        hdr.magic   = hton32 (GF_BLOOM_MAGIC);
+        hdr.nbits   = hton32 (bloom->nbits);
+        hdr.nhashes = hton32 (bloom->nhashes);
+        hdr.count   = hton32 (bloom->count);
+
+        memcpy (buf, &hdr, sizeof (hdr));
+        memcpy (buf + sizeof (hdr), bloom->bits, bloom->nbits / 8);
+}
+
+
+gf_bloom_t *
+gf_bloom_unserialize (const char *buf, size_t len)
+{
+        gf_bloom_hdr_t  hdr   = {0, };
+        gf_bloom_t     *bloom = NULL;
+        uint32_t        nbits = 0;
+        uint32_t        nhashes = 0;
+
+        if (!buf || len < sizeof (hdr))
+                return NULL;
+
+        memcpy (&hdr, buf, sizeof (hdr));
+        if (ntoh32 (hdr.magic) != GF_BLOOM_MAGIC)
+                return NULL;
+
+        nbits = ntoh32 (hdr.nbits);
+        if (nbits < GF_BLOOM_MIN_BITS || (nbits & (nbits - 1)) ||
+            len != sizeof (hdr) + nbits / 8)
+                return NULL;
+
+        /* every check probes nhashes bits */
+        nhashes = ntoh32 (hdr.nhashes);
+        if (nhashes == 0 || nhashes > GF_BLOOM_MAX_HASHES)
+                return NULL;
+
+        bloom = GF_CALLOC (1, sizeof (*bloom) + nbits / 8,
+                           gf_common_mt_bloom_t);
+        if (!bloom)
+                return NULL;
+
+        bloom->nbits   = nbits;
+        bloom->nhashes = nhashes;
+        bloom->count   = ntoh32 (hdr.count);
+        memcpy (bloom->bits, buf + sizeof (hdr), nbits / 8);
+
+        return bloom;
+}
@@ -0,0 +1,74 @@
+/*
+  Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __BLOOM_H__
+#define __BLOOM_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "common-utils.h"
+
+/*
+ * Bloom filter over names. Bricks build one per directory and clients
+ * use it to rule out subvolumes which cannot have a name.
+ *
+ * The serialized form is a gf_bloom_hdr_t in network byte order followed
+ * by the bit array, so that it can travel in a dict.
+ */
+
+#define GF_BLOOM_MAGIC          0x626c6f31      /* "blo1" */
+#define GF_BLOOM_BITS_PER_NAME  10              /* ~1% false positives */
+#define GF_BLOOM_MIN_BITS       512
+#define GF_BLOOM_MAX_HASHES     16              /* accepted from the wire */
+
+typedef struct gf_bloom_hdr {
+        uint32_t        magic;
+        uint32_t        nbits;
+        uint32_t        nhashes;
+        uint32_t        count;
+} gf_bloom_hdr_t;
+
+typedef struct gf_bloom {
+        uint32_t        nbits;          /* power of two */
+        uint32_t        nhashes;
+        uint32_t        count;          /* names added */
+        uint8_t         bits[];
+} gf_bloom_t;
+
+gf_bloom_t *
+gf_bloom_new (uint32_t expected);
+
+void
+gf_bloom_free (gf_bloom_t *bloom);
+
+/* a name is hashed once and then checked against any number of filters */
+void
+gf_bloom_hash (const char *name, uint32_t *h1, uint32_t *h2);
+
+void
+gf_bloom_add (gf_bloom_t *bloom, const char *name);
+
+gf_boolean_t
+gf_bloom_check_hash (const gf_bloom_t *bloom, uint32_t h1, uint32_t h2);
+
+gf_boolean_t
+gf_bloom_check (const gf_bloom_t *bloom, const char *name);
+
+size_t
+gf_bloom_serialized_size (const gf_bloom_t *bloom);
+
+void
+gf_bloom_serialize (const gf_bloom_t *bloom, char *buf);
+
+gf_bloom_t *
+gf_bloom_unserialize (const char *buf, size_t len);
+
+#endif /* __BLOOM_H__ */
@@ -22,6 +22,8 @@ typedef struct {
 	call_frame_t *frame;
 	glusterfs_fop_t fop;
         struct mem_pool *stub_mem_pool; /* pointer to stub mempool in ctx_t */
+        struct timeval queued;          /* when the stub got queued, if the
+                                           queueing xlator keeps track */
 
 	union {
 		fop_lookup_t lookup;
@@ -105,6 +105,24 @@ gf_changelog_next_change (char *bufptr, size_t maxlen);
 int
 gf_changelog_done (char *file);
 
+/* history API */
+int
+gf_history_changelog (char *changelog_dir, unsigned long start,
+                      unsigned long end, int n_parallel,
+                      unsigned long *actual_end);
+
+ssize_t
+gf_history_changelog_scan ();
+
+int
+gf_history_changelog_start_fresh ();
+
+ssize_t
+gf_history_changelog_next_change (char *bufptr, size_t maxlen);
+
+int
+gf_history_changelog_done (char *file);
+
 /* newer flexible API */
 int
 gf_changelog_init (void *xl);
@@ -11,6 +11,7 @@
 #include <openssl/md5.h>
 #include <zlib.h>
 #include <stdint.h>
+#include <string.h>
 
 /*
  * The "weak" checksum required for the rsync algorithm.
@@ -34,3 +35,136 @@ gf_rsync_strong_checksum (unsigned char *data, size_t len, unsigned char *md5)
 {
         MD5 (data, len, md5);
 }
+
+
+/*
+ * xxHash64 (Yann Collet, BSD licensed algorithm). Many times faster than
+ * MD5 and good enough to tell whether two copies of a block differ.
+ */
+
+#define XXH_PRIME64_1 11400714785074694791ULL
+#define XXH_PRIME64_2 14029467366897019727ULL
+#define XXH_PRIME64_3  1609587929392839161ULL
+#define XXH_PRIME64_4  9650029242287828579ULL
+#define XXH_PRIME64_5  2870177450012600261ULL
+
+#define XXH_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+static inline uint64_t
+xxh_read64 (const unsigned char *p)
+{
+        uint64_t v;
+
+        memcpy (&v, p, sizeof (v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap64 (v);
+#endif
+        return v;
+}
+
+static inline uint32_t
+xxh_read32 (const unsigned char *p)
+{
+        uint32_t v;
+
+        memcpy (&v, p, sizeof (v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap32 (v);
+#endif
+        return v;
+}
+
+static inline uint64_t
+xxh_round (uint64_t acc, uint64_t input)
+{
+        acc += input * XXH_PRIME64_2;
+        acc = XXH_ROTL64 (acc, 31);
+        return acc * XXH_PRIME64_1;
+}
+
+static inline uint64_t
+xxh_merge_round (uint64_t acc, uint64_t val)
+{
+        acc ^= xxh_round (0, val);
+        return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+uint64_t
+gf_xxh64 (const unsigned char *p, size_t len, uint64_t seed)
+{
+        const unsigned char *end = p + len;
+        uint64_t             h   = 0;
+        uint64_t             v1, v2, v3, v4;
+
+        if (len >= 32) {
+                const unsigned char *limit = end - 32;
+
+                v1 = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+                v2 = seed + XXH_PRIME64_2;
+                v3 = seed;
+                v4 = seed - XXH_PRIME64_1;
+
+                do {
+                        v1 = xxh_round (v1, xxh_read64 (p));
+                        v2 = xxh_round (v2, xxh_read64 (p + 8));
+                        v3 = xxh_round (v3, xxh_read64 (p + 16));
+                        v4 = xxh_round (v4, xxh_read64 (p + 24));
+                        p += 32;
+                } while (p <= limit);
+
+                h = XXH_ROTL64 (v1, 1) + XXH_ROTL64 (v2, 7) +
+                        XXH_ROTL64 (v3, 12) + XXH_ROTL64 (v4, 18);
+                h = xxh_merge_round (h, v1);
+                h = xxh_merge_round (h, v2);
+                h = xxh_merge_round (h, v3);
+                h = xxh_merge_round (h, v4);
+        } else {
+                h = seed + XXH_PRIME64_5;
+        }
+
+        h += (uint64_t) len;
+
+        while (p + 8 <= end) {
+                h ^= xxh_round (0, xxh_read64 (p));
+                h = XXH_ROTL64 (h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+                p += 8;
+        }
+
+        if (p + 4 <= end) {
+                h ^= (uint64_t) xxh_read32 (p) * XXH_PRIME64_1;
+                h = XXH_ROTL64 (h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+                p += 4;
+        }
+
+        while (p < end) {
+                h ^= (*p) * XXH_PRIME64_5;
+                h = XXH_ROTL64 (h, 11) * XXH_PRIME64_1;
+                p++;
+        }
+
+        h ^= h >> 33;
+        h *= XXH_PRIME64_2;
+        h ^= h >> 29;
+        h *= XXH_PRIME64_3;
+        h ^= h >> 32;
+
+        return h;
+}
+
+
+/*
+ * Strong checksum in the MD5_DIGEST_LENGTH bytes the rchecksum fop
+ * carries: the xxhash64 of the data, big endian, zero padded.
+ */
+void
+gf_rsync_xxh64_checksum (unsigned char *data, size_t len, unsigned char *sum)
+{
+        uint64_t h = 0;
+        int      i = 0;
+
+        h = gf_xxh64 (data, len, 0);
+
+        memset (sum, 0, MD5_DIGEST_LENGTH);
+        for (i = 0; i < 8; i++)
+                sum[i] = (h >> (56 - 8 * i)) & 0xff;
+}
@@ -17,4 +17,13 @@ gf_rsync_weak_checksum (unsigned char *buf, size_t len);
 void
 gf_rsync_strong_checksum (unsigned char *buf, size_t len, unsigned char *sum);
 
+/* value of GF_RCHECKSUM_TYPE_KEY for the xxhash64 strong checksum */
+#define GF_RCHECKSUM_XXH64 "xxh64"
+
+uint64_t
+gf_xxh64 (const unsigned char *buf, size_t len, uint64_t seed);
+
+void
+gf_rsync_xxh64_checksum (unsigned char *buf, size_t len, unsigned char *sum);
+
 #endif /* __CHECKSUM_H__ */
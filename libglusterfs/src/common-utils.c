@@ -3342,6 +3342,237 @@ gf_thread_create (pthread_t *thread, const pthread_attr_t *attr,
         return ret;
 }
 
+#ifdef GF_LINUX_HOST_OS
+
+#define GF_CPU_ONLINE_PATH "/sys/devices/system/cpu/online"
+#define GF_NUMA_NODE_PATH  "/sys/devices/system/node/node%d/cpulist"
+#define GF_NUMA_MAX_NODES  64
+
+/* parse a kernel style cpu list ("0-3,8,10-11") */
+static int
+gf_cpulist_parse (const char *list, cpu_set_t *set)
+{
+        const char *p     = list;
+        char       *end   = NULL;
+        long        first = 0;
+        long        last  = 0;
+
+        CPU_ZERO (set);
+
+        while (*p && *p != '\n') {
+                first = strtol (p, &end, 10);
+                if (end == p || first < 0)
+                        return -1;
+
+                last = first;
+                if (*end == '-') {
+                        p = end + 1;
+                        last = strtol (p, &end, 10);
+                        if (end == p || last < first)
+                                return -1;
+                }
+
+                if (last >= CPU_SETSIZE)
+                        return -1;
+
+                for (; first <= last; first++)
+                        CPU_SET (first, set);
+
+                p = end;
+                if (*p == ',')
+                        p++;
+                else if (*p && *p != '\n')
+                        return -1;
+        }
+
+        return CPU_COUNT (set) ? 0 : -1;
+}
+
+
+static int
+gf_cpulist_read (const char *path, cpu_set_t *set)
+{
+        char buf[4096] = {0, };
+        int  fd        = -1;
+        int  ret       = -1;
+
+        fd = open (path, O_RDONLY);
+        if (fd < 0)
+                return -1;
+
+        ret = sys_read (fd, buf, sizeof (buf) - 1);
+        sys_close (fd);
+        if (ret <= 0)
+                return -1;
+
+        return gf_cpulist_parse (buf, set);
+}
+
+
+static int
+gf_numa_node_cpus (int node, cpu_set_t *set)
+{
+        char path[PATH_MAX] = {0, };
+
+        snprintf (path, sizeof (path), GF_NUMA_NODE_PATH, node);
+
+        return gf_cpulist_read (path, set);
+}
+
+
+static int
+gf_numa_node_count (void)
+{
+        char path[PATH_MAX] = {0, };
+        int  nodes          = 0;
+
+        for (nodes = 0; nodes < GF_NUMA_MAX_NODES; nodes++) {
+                snprintf (path, sizeof (path), GF_NUMA_NODE_PATH, nodes);
+                if (access (path, F_OK) != 0)
+                        break;
+        }
+
+        return nodes;
+}
+
+
+/* CPUs the index'th thread may run on under @placement; with @check_only
+ * only the syntax is looked at, the CPUs and nodes may belong to another
+ * machine */
+static int
+gf_thread_placement_cpus (const char *placement, int index, cpu_set_t *set,
+                          gf_boolean_t check_only)
+{
+        cpu_set_t  all;
+        char      *end   = NULL;
+        long       node  = 0;
+        int        nodes = 0;
+        int        nth   = 0;
+        int        cpu   = 0;
+
+        if (!placement || !*placement || !strcmp (placement, "none")) {
+                if (check_only)
+                        return 0;
+                return gf_cpulist_read (GF_CPU_ONLINE_PATH, set);
+        }
+
+        if (!strcmp (placement, "spread")) {
+                if (check_only)
+                        return 0;
+                if (gf_cpulist_read (GF_CPU_ONLINE_PATH, &all) != 0)
+                        return -1;
+
+                nth = index % CPU_COUNT (&all);
+                for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                        if (CPU_ISSET (cpu, &all) && nth-- == 0)
+                                break;
+                }
+
+                CPU_ZERO (set);
+                CPU_SET (cpu, set);
+                return 0;
+        }
+
+        if (!strcmp (placement, "nodes")) {
+                if (check_only)
+                        return 0;
+                nodes = gf_numa_node_count ();
+                if (!nodes)
+                        return gf_cpulist_read (GF_CPU_ONLINE_PATH, set);
+
+                return gf_numa_node_cpus (index % nodes, set);
+        }
+
+        if (!strncmp (placement, "node:", 5)) {
+                node = strtol (placement + 5, &end, 10);
+                if (end == placement + 5 || *end || node < 0 ||
+                    node >= GF_NUMA_MAX_NODES)
+                        return -1;
+                if (check_only)
+                        return 0;
+
+                return gf_numa_node_cpus (node, set);
+        }
+
+        if (!strncmp (placement, "cpus:", 5))
+                return gf_cpulist_parse (placement + 5, set);
+
+        return -1;
+}
+
+
+int
+gf_thread_placement_validate (const char *placement)
+{
+        cpu_set_t set;
+
+        return gf_thread_placement_cpus (placement, 0, &set, _gf_true);
+}
+
+
+/* the affinity the process was started with (taskset, numactl), so that
+ * threads placed earlier can be handed back to it on "none" */
+static cpu_set_t    gf_inherited_cpus;
+static gf_boolean_t gf_inherited_cpus_saved;
+
+void
+gf_thread_placement_init (void)
+{
+        CPU_ZERO (&gf_inherited_cpus);
+        if (sched_getaffinity (0, sizeof (gf_inherited_cpus),
+                               &gf_inherited_cpus) == 0)
+                gf_inherited_cpus_saved = _gf_true;
+}
+
+
+int
+gf_thread_set_placement (pthread_t thread, const char *placement, int index)
+{
+        cpu_set_t set;
+        int       ret = -1;
+
+        if (!placement || !*placement || !strcmp (placement, "none")) {
+                if (!gf_inherited_cpus_saved)
+                        return 0;
+                return pthread_setaffinity_np (thread,
+                                               sizeof (gf_inherited_cpus),
+                                               &gf_inherited_cpus);
+        }
+
+        ret = gf_thread_placement_cpus (placement, index, &set, _gf_false);
+        if (ret)
+                return ret;
+
+        return pthread_setaffinity_np (thread, sizeof (set), &set);
+}
+
+#else /* !GF_LINUX_HOST_OS */
+
+int
+gf_thread_placement_validate (const char *placement)
+{
+        if (!placement || !*placement || !strcmp (placement, "none"))
+                return 0;
+
+        return -1;
+}
+
+
+void
+gf_thread_placement_init (void)
+{
+}
+
+
+int
+gf_thread_set_placement (pthread_t thread, const char *placement, int index)
+{
+        return gf_thread_placement_validate (placement);
+}
+
+#endif /* GF_LINUX_HOST_OS */
+
+
 int
 gf_skip_header_section (int fd, int header_len)
 {
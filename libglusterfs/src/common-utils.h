@@ -709,6 +709,21 @@ int gf_set_timestamp  (const char *src, const char* dest);
 
 int gf_thread_create (pthread_t *thread, const pthread_attr_t *attr,
                       void *(*start_routine)(void *), void *arg);
+
+/* Thread placement policies understood by gf_thread_set_placement():
+ *   none          - affinity of the process at startup, as saved by
+ *                   gf_thread_placement_init()
+ *   spread        - the n'th thread of a pool on the n'th online CPU
+ *   nodes         - the n'th thread on the CPUs of NUMA node n % #nodes
+ *   node:<N>      - all threads on the CPUs of NUMA node N
+ *   cpus:<list>   - all threads on the CPUs in <list> ("0-3,8-11")
+ */
+#define GF_THREAD_PLACEMENT_MAX 256
+
+void gf_thread_placement_init (void);
+int gf_thread_placement_validate (const char *placement);
+int gf_thread_set_placement (pthread_t thread, const char *placement,
+                             int index);
 gf_boolean_t
 gf_is_service_running (char *pidfile, int *pid);
 int
@@ -15,6 +15,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <sys/time.h>
 
 #include "logging.h"
 #include "event.h"
@@ -27,6 +28,10 @@
 #include <sys/epoll.h>
 
 
+/* ref, gen and in_handler are updated with atomic builtins so that the
+ * dispatch path does not need slot->lock. The lock still serializes
+ * register, unregister and select_on against each other.
+ */
 struct event_slot_epoll {
 	int fd;
 	int events;
@@ -34,6 +39,7 @@ struct event_slot_epoll {
 	int ref;
 	int do_close;
 	int in_handler;
+	int events_gen;  /* bumped by every event_select_on_epoll() */
 	void *data;
 	event_handler_t handler;
 	gf_lock_t lock;
@@ -194,11 +200,7 @@ event_slot_get (struct event_pool *event_pool, int idx)
 
 	slot = &table[offset];
 
-	LOCK (&slot->lock);
-	{
-		slot->ref++;
-	}
-	UNLOCK (&slot->lock);
+	__sync_fetch_and_add (&slot->ref, 1);
 
 	return slot;
 }
@@ -212,18 +214,15 @@ event_slot_unref (struct event_pool *event_pool, struct event_slot_epoll *slot,
 	int fd = -1;
 	int do_close = 0;
 
-	LOCK (&slot->lock);
-	{
-		ref = --slot->ref;
-		fd = slot->fd;
-		do_close = slot->do_close;
-	}
-	UNLOCK (&slot->lock);
-
+	ref = __sync_sub_and_fetch (&slot->ref, 1);
 	if (ref)
 		/* slot still alive */
 		goto done;
 
+	/* last reference, nobody else looks at the slot any more */
+	fd = slot->fd;
+	do_close = slot->do_close;
+
 	event_slot_dealloc (event_pool, idx);
 
 	if (do_close)
@@ -420,7 +419,8 @@ event_unregister_epoll_common (struct event_pool *event_pool, int fd,
                 }
 
 		slot->do_close = do_close;
-		slot->gen++; /* detect unregister in dispatch_handler() */
+		/* detect unregister in dispatch_handler() */
+		__sync_fetch_and_add (&slot->gen, 1);
         }
 unlock:
 	UNLOCK (&slot->lock);
@@ -474,12 +474,17 @@ event_select_on_epoll (struct event_pool *event_pool, int fd, int idx,
 	LOCK (&slot->lock);
 	{
 		__slot_update_events (slot, poll_in, poll_out);
+		/* a handler thread re-arming from the old events sees
+		   this change and re-arms again */
+		__sync_add_and_fetch (&slot->events_gen, 1);
 
 		epoll_event.events = slot->events;
 		ev_data->idx = idx;
 		ev_data->gen = slot->gen;
 
-		if (slot->in_handler)
+		/* full barrier: either the handler thread sees the new
+		   events after dropping in_handler, or we see it at 0 */
+		if (__sync_add_and_fetch (&slot->in_handler, 0))
 			/* in_handler indicates at least one thread
 			   executing event_dispatch_epoll_handler()
 			   which will perform epoll_ctl(EPOLL_CTL_MOD)
@@ -515,7 +520,8 @@ out:
 
 static int
 event_dispatch_epoll_handler (struct event_pool *event_pool,
-                              struct epoll_event *event)
+                              struct epoll_event *event,
+                              struct event_thread_stats *stats)
 {
         struct event_data  *ev_data = NULL;
 	struct event_slot_epoll *slot = NULL;
@@ -525,6 +531,10 @@ event_dispatch_epoll_handler (struct event_pool *event_pool,
 	int                 gen = -1;
         int                 ret = -1;
 	int                 fd = -1;
+	int                 events_gen = 0;
+        struct timeval      begin = {0, };
+        struct timeval      end = {0, };
+        uint64_t            usec = 0;
 
 	ev_data = (void *)&event->data;
         handler = NULL;
@@ -535,70 +545,83 @@ event_dispatch_epoll_handler (struct event_pool *event_pool,
 
 	slot = event_slot_get (event_pool, idx);
 
-	LOCK (&slot->lock);
-	{
-		fd = slot->fd;
-		if (fd == -1) {
-			gf_msg ("epoll", GF_LOG_ERROR, 0,
-                                LG_MSG_STALE_FD_FOUND, "stale fd found on "
-                                "idx=%d, gen=%d, events=%d, slot->gen=%d",
-				idx, gen, event->events, slot->gen);
-			/* fd got unregistered in another thread */
-			goto pre_unlock;
-		}
-
-		if (gen != slot->gen) {
-			gf_msg ("epoll", GF_LOG_ERROR, 0,
-                                LG_MSG_GENERATION_MISMATCH, "generation "
-                                "mismatch on idx=%d, gen=%d, slot->gen=%d, "
-                                "slot->fd=%d", idx, gen, slot->gen, slot->fd);
-			/* slot was re-used and therefore is another fd! */
-			goto pre_unlock;
-		}
+	/* The reference taken above keeps the slot from being re-used,
+	   so fd, handler and data stay those of this registration. A
+	   concurrent unregister only bumps the generation.
+	*/
+	fd = slot->fd;
+	if (fd == -1) {
+		gf_msg ("epoll", GF_LOG_ERROR, 0,
+			LG_MSG_STALE_FD_FOUND, "stale fd found on "
+			"idx=%d, gen=%d, events=%d, slot->gen=%d",
+			idx, gen, event->events, slot->gen);
+		/* fd got unregistered in another thread */
+		goto out;
+	}
 
-		handler = slot->handler;
-		data = slot->data;
+	__sync_fetch_and_add (&slot->in_handler, 1);
 
-		slot->in_handler++;
+	if (gen != __sync_add_and_fetch (&slot->gen, 0)) {
+		gf_msg ("epoll", GF_LOG_ERROR, 0,
+			LG_MSG_GENERATION_MISMATCH, "generation "
+			"mismatch on idx=%d, gen=%d, slot->gen=%d, "
+			"slot->fd=%d", idx, gen, slot->gen, slot->fd);
+		/* slot was re-used and therefore is another fd! */
+		__sync_sub_and_fetch (&slot->in_handler, 1);
+		goto out;
 	}
-pre_unlock:
-	UNLOCK (&slot->lock);
 
-        if (!handler)
-		goto out;
+	handler = slot->handler;
+	data = slot->data;
+
+        gettimeofday (&begin, NULL);
 
 	ret = handler (fd, idx, data,
 		       (event->events & (EPOLLIN|EPOLLPRI)),
 		       (event->events & (EPOLLOUT)),
 		       (event->events & (EPOLLERR|EPOLLHUP)));
 
-	LOCK (&slot->lock);
-	{
-		slot->in_handler--;
+        gettimeofday (&end, NULL);
+        usec = (end.tv_sec - begin.tv_sec) * 1000000
+                + (end.tv_usec - begin.tv_usec);
 
-		if (gen != slot->gen) {
-			/* event_unregister() happened while we were
-			   in handler()
-			*/
-			gf_msg_debug ("epoll", 0, "generation bumped on idx=%d"
-                                      " from gen=%d to slot->gen=%d, fd=%d, "
-				      "slot->fd=%d", idx, gen, slot->gen, fd,
-                                      slot->fd);
-			goto post_unlock;
-		}
+        stats->dispatched++;
+        stats->handler_usec += usec;
+        if (usec > stats->max_handler_usec)
+                stats->max_handler_usec = usec;
+
+	/* pairs with the barrier in event_select_on_epoll() */
+	if (__sync_sub_and_fetch (&slot->in_handler, 1))
+		goto out;
 
-		/* This call also picks up the changes made by another
-		   thread calling event_select_on_epoll() while this
-		   thread was busy in handler()
+	if (gen != __sync_add_and_fetch (&slot->gen, 0)) {
+		/* event_unregister() happened while we were
+		   in handler()
 		*/
-                if (slot->in_handler == 0) {
-                        event->events = slot->events;
-                        ret = epoll_ctl (event_pool->fd, EPOLL_CTL_MOD,
-                                         fd, event);
-                }
+		gf_msg_debug ("epoll", 0, "generation bumped on idx=%d"
+			      " from gen=%d to slot->gen=%d, fd=%d, "
+			      "slot->fd=%d", idx, gen, slot->gen, fd,
+			      slot->fd);
+		goto out;
 	}
-post_unlock:
-	UNLOCK (&slot->lock);
+
+	/* This call also picks up the changes made by another
+	   thread calling event_select_on_epoll() while this
+	   thread was busy in handler(). It takes no lock: a select
+	   that saw in_handler at 0 re-arms on its own, and if it
+	   changed the events after we read them, our MOD may have
+	   landed after its own with the old set. events_gen moving
+	   tells us so and we re-arm with the new events; a select
+	   bumping it only after our check issues its MOD after ours.
+	   A racing unregister at worst makes this fail with ENOENT,
+	   the fd itself is kept open by our reference.
+	*/
+	do {
+		events_gen = __sync_add_and_fetch (&slot->events_gen, 0);
+		event->events = slot->events;
+		ret = epoll_ctl (event_pool->fd, EPOLL_CTL_MOD, fd, event);
+	} while ((ret == 0) &&
+		 (events_gen != __sync_add_and_fetch (&slot->events_gen, 0)));
 out:
 	event_slot_unref (event_pool, slot, idx);
 
@@ -670,7 +693,8 @@ event_dispatch_epoll_worker (void *data)
                         /* sys call */
                         continue;
 
-		ret = event_dispatch_epoll_handler (event_pool, &event);
+		ret = event_dispatch_epoll_handler (event_pool, &event,
+                                                   &event_pool->stats[myindex - 1]);
         }
 out:
         if (ev_data)
@@ -727,6 +751,9 @@ event_dispatch_epoll (struct event_pool *event_pool)
                                               ev_data);
                         if (!ret) {
                                 event_pool->pollers[i] = t_id;
+                                if (event_pool->placement[0])
+                                        gf_thread_set_placement (t_id,
+                                                event_pool->placement, i);
 
                                 /* mark all threads other than one in index 0
                                  * as detachable. Errors can be ignored, they
@@ -821,6 +848,11 @@ event_reconfigure_threads_epoll (struct event_pool *event_pool, int value)
                                         } else {
                                                 pthread_detach (t_id);
                                                 event_pool->pollers[i] = t_id;
+                                                if (event_pool->placement[0])
+                                                        gf_thread_set_placement (
+                                                                t_id,
+                                                                event_pool->placement,
+                                                                i);
                                         }
                                 }
                         }
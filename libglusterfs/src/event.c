@@ -20,6 +20,7 @@
 #include "event.h"
 #include "mem-pool.h"
 #include "common-utils.h"
+#include "statedump.h"
 #include "libglusterfs-messages.h"
 
 
@@ -272,3 +273,93 @@ event_dispatch_destroy (struct event_pool *event_pool)
 
         return ret;
 }
+
+
+void
+event_pool_dump (struct event_pool *event_pool)
+{
+        struct event_thread_stats *stats = NULL;
+        char                       key[GF_DUMP_MAX_BUF_LEN];
+        int                        i = 0;
+
+        if (!event_pool)
+                return;
+
+        gf_proc_dump_add_section ("event-pool");
+        gf_proc_dump_write ("event_pool.threads", "%d",
+                            event_pool->eventthreadcount);
+        gf_proc_dump_write ("event_pool.active_threads", "%d",
+                            event_pool->activethreadcount);
+        gf_proc_dump_write ("event_pool.placement", "%s",
+                            event_pool->placement[0] ?
+                            event_pool->placement : "none");
+
+        for (i = 0; i < EVENT_MAX_THREADS; i++) {
+                stats = &event_pool->stats[i];
+                if (!stats->dispatched)
+                        continue;
+
+                snprintf (key, sizeof (key), "thread[%d].dispatched", i + 1);
+                gf_proc_dump_write (key, "%"PRIu64, stats->dispatched);
+
+                snprintf (key, sizeof (key), "thread[%d].avg_handler_usec",
+                          i + 1);
+                gf_proc_dump_write (key, "%"PRIu64,
+                                    stats->handler_usec / stats->dispatched);
+
+                snprintf (key, sizeof (key), "thread[%d].max_handler_usec",
+                          i + 1);
+                gf_proc_dump_write (key, "%"PRIu64, stats->max_handler_usec);
+        }
+}
+
+
+/* Move the running poller threads according to @placement and remember it
+ * for the ones started later. Only the epoll backend runs pollers.
+ */
+int
+event_pool_set_placement (struct event_pool *event_pool,
+                          const char *placement)
+{
+        int ret = 0;
+        int i   = 0;
+
+        GF_VALIDATE_OR_GOTO ("event", event_pool, out);
+
+        /* "none" is what a pool starts with: nothing to move */
+        if (!placement || !strcmp (placement, "none"))
+                placement = "";
+
+        if (gf_thread_placement_validate (placement) != 0) {
+                gf_msg ("event", GF_LOG_WARNING, EINVAL,
+                        LG_MSG_THREAD_PLACEMENT_FAILED,
+                        "invalid thread placement \"%s\"", placement);
+                return -1;
+        }
+
+        pthread_mutex_lock (&event_pool->mutex);
+        {
+                if (!strcmp (event_pool->placement, placement))
+                        goto unlock;
+
+                strncpy (event_pool->placement, placement,
+                         sizeof (event_pool->placement) - 1);
+
+                for (i = 0; i < EVENT_MAX_THREADS; i++) {
+                        if (!event_pool->pollers[i])
+                                continue;
+                        ret = gf_thread_set_placement (event_pool->pollers[i],
+                                                       event_pool->placement,
+                                                       i);
+                        if (ret)
+                                gf_msg ("event", GF_LOG_WARNING, ret,
+                                        LG_MSG_THREAD_PLACEMENT_FAILED,
+                                        "failed to place event thread %d "
+                                        "(%s)", i + 1, event_pool->placement);
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&event_pool->mutex);
+out:
+        return ret;
+}
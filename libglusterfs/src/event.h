@@ -12,6 +12,9 @@
 #define _EVENT_H_
 
 #include <pthread.h>
+#include <stdint.h>
+
+#include "common-utils.h"
 
 struct event_pool;
 struct event_ops;
@@ -30,6 +33,13 @@ typedef int (*event_handler_t) (int fd, int idx, void *data,
 #define EVENT_EPOLL_SLOTS 1024
 #define EVENT_MAX_THREADS  32
 
+/* written only by the owning event thread */
+struct event_thread_stats {
+        uint64_t dispatched;       /* events handed to a handler */
+        uint64_t handler_usec;     /* time spent in handlers */
+        uint64_t max_handler_usec;
+};
+
 struct event_pool {
 	struct event_ops *ops;
 
@@ -57,6 +67,12 @@ struct event_pool {
                                                      * and live status */
         int destroy;
         int activethreadcount;
+
+        struct event_thread_stats stats[EVENT_MAX_THREADS];
+
+        /* gf_thread_set_placement() policy of the poller threads,
+         * under mutex */
+        char placement[GF_THREAD_PLACEMENT_MAX];
 };
 
 struct event_ops {
@@ -93,4 +109,7 @@ int event_dispatch (struct event_pool *event_pool);
 int event_reconfigure_threads (struct event_pool *event_pool, int value);
 int event_pool_destroy (struct event_pool *event_pool);
 int event_dispatch_destroy (struct event_pool *event_pool);
+void event_pool_dump (struct event_pool *event_pool);
+int event_pool_set_placement (struct event_pool *event_pool,
+                              const char *placement);
 #endif /* _EVENT_H_ */
@@ -355,6 +355,9 @@ gf_globals_init_once ()
                 goto out;
         }
 
+        /* before any of our threads get placed */
+        gf_thread_placement_init ();
+
         ret = synctask_init ();
         if (ret) {
                 gf_msg ("", GF_LOG_CRITICAL, 0, LG_MSG_SYNCTASK_INIT_FAILED,
@@ -146,7 +146,9 @@
 
 #define GLUSTERFS_WRITE_IS_APPEND "glusterfs.write-is-append"
 #define GLUSTERFS_WRITE_UPDATE_ATOMIC "glusterfs.write-update-atomic"
+#define GLUSTERFS_READ_NOCACHE "glusterfs.read-nocache"
 #define GLUSTERFS_OPEN_FD_COUNT "glusterfs.open-fd-count"
+#define GF_RCHECKSUM_TYPE_KEY "glusterfs.rchecksum-type"
 #define GLUSTERFS_INODELK_COUNT "glusterfs.inodelk-count"
 #define GLUSTERFS_ENTRYLK_COUNT "glusterfs.entrylk-count"
 #define GLUSTERFS_POSIXLK_COUNT "glusterfs.posixlk-count"
@@ -158,6 +160,14 @@
 
 #define QUOTA_SIZE_KEY "trusted.glusterfs.quota.size"
 
+/* bytes each data brick holds of a disperse stripe: a stripe is this
+ * times the number of data bricks (cluster/disperse checks it matches
+ * its EC_METHOD_CHUNK_SIZE) */
+#define GF_EC_CHUNK_SIZE 512
+
+/* block size features/shard uses when shard-block-size is not set */
+#define GF_SHARD_BLOCK_SIZE_DEFAULT (4 * GF_UNIT_MB)
+
 /* Index xlator related */
 #define GF_XATTROP_INDEX_GFID "glusterfs.xattrop_index_gfid"
 #define GF_XATTROP_INDEX_COUNT "glusterfs.xattrop_index_count"
@@ -383,6 +393,9 @@ typedef enum {
 /* key value which quick read uses to get small files in lookup cbk */
 #define GF_CONTENT_KEY "glusterfs.content"
 
+/* key with which dht asks for the bloom filter of names in a directory */
+#define GF_NAME_BLOOM_KEY "glusterfs.name-bloom"
+
 struct _xlator_cmdline_option {
         struct list_head    cmd_args;
         char               *volume;
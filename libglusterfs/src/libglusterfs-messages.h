@@ -36,7 +36,7 @@
  */
 
 #define GLFS_LG_BASE            GLFS_MSGID_COMP_LIBGLUSTERFS
-#define GLFS_LG_NUM_MESSAGES    201
+#define GLFS_LG_NUM_MESSAGES    202
 #define GLFS_LG_MSGID_END       (GLFS_LG_BASE + GLFS_LG_NUM_MESSAGES + 1)
 /* Messaged with message IDs */
 #define glfs_msg_start_lg GLFS_LG_BASE, "Invalid: Start of messages"
@@ -1716,6 +1716,16 @@
  */
 #define LG_MSG_LOCK_FAILURE                              (GLFS_LG_BASE + 201)
 
+/*!
+ * @messageid
+ * @diagnosis A thread could not be moved to the CPUs of the configured
+ *            placement policy
+ * @recommendedaction Check that the CPUs/NUMA nodes named in the policy
+ *            exist on this machine
+ *
+ */
+#define LG_MSG_THREAD_PLACEMENT_FAILED                   (GLFS_LG_BASE + 202)
+
 /*!
  * @messageid
  * @diagnosis
@@ -13,6 +13,9 @@
 #include "xlator.h"
 #include <stdlib.h>
 #include <stdarg.h>
+#ifdef GF_LINUX_HOST_OS
+#include <sched.h>
+#endif
 
 #define GF_MEM_POOL_LIST_BOUNDARY        (sizeof(struct list_head))
 #define GF_MEM_POOL_PTR                  (sizeof(struct mem_pool*))
@@ -45,6 +48,120 @@ gf_mem_acct_enable_set (void *data)
         return;
 }
 
+void
+gf_mem_acct_init (struct mem_acct *mem_acct, uint32_t num_types)
+{
+        memset (mem_acct, 0, GF_MEM_ACCT_SIZE (num_types));
+
+        mem_acct->num_types = num_types;
+        mem_acct->shards = (struct mem_acct_shard *) &mem_acct->rec[num_types];
+        LOCK_INIT (&mem_acct->lock);
+        mem_acct->refcnt = 1;
+}
+
+static inline struct mem_acct_shard *
+gf_mem_acct_shard (struct mem_acct *mem_acct, uint32_t type)
+{
+        uint64_t idx = 0;
+
+#ifdef GF_LINUX_HOST_OS
+        int      cpu = sched_getcpu ();
+
+        if (cpu >= 0) {
+                idx = cpu % GF_MEM_ACCT_SHARDS;
+                goto out;
+        }
+#endif
+        /* pthread_t values are far apart; spread them with a
+         * multiplicative hash */
+        idx = ((uint64_t) (uintptr_t) pthread_self ()
+               * 0x9E3779B97F4A7C15ULL) >> 60;
+        idx %= GF_MEM_ACCT_SHARDS;
+#ifdef GF_LINUX_HOST_OS
+out:
+#endif
+        return &mem_acct->shards[idx * mem_acct->num_types + type];
+}
+
+static inline void
+gf_mem_acct_watermark (int64_t *max, int64_t val)
+{
+        int64_t old = *max;
+
+        while (val > old) {
+                if (__sync_bool_compare_and_swap (max, old, val))
+                        break;
+                old = *max;
+        }
+}
+
+/* moves whatever the shard has gathered into the type's record */
+static void
+gf_mem_acct_fold (struct mem_acct_rec *rec, struct mem_acct_shard *shard)
+{
+        int64_t size = 0;
+        int64_t num  = 0;
+
+        size = __sync_fetch_and_add (&shard->size, 0);
+        num = __sync_fetch_and_add (&shard->num_allocs, 0);
+
+        __sync_fetch_and_sub (&shard->size, size);
+        __sync_fetch_and_sub (&shard->num_allocs, num);
+
+        size = __sync_add_and_fetch (&rec->size, size);
+        num = __sync_add_and_fetch (&rec->num_allocs, num);
+
+        gf_mem_acct_watermark (&rec->max_size, size);
+        gf_mem_acct_watermark (&rec->max_num_allocs, num);
+}
+
+static inline void
+gf_mem_acct_update (struct mem_acct *mem_acct, uint32_t type, int64_t size,
+                    int64_t num)
+{
+        struct mem_acct_shard *shard = NULL;
+        int64_t                s     = 0;
+        int64_t                n     = 0;
+
+        shard = gf_mem_acct_shard (mem_acct, type);
+
+        s = __sync_add_and_fetch (&shard->size, size);
+        n = __sync_add_and_fetch (&shard->num_allocs, num);
+        if (num > 0)
+                __sync_fetch_and_add (&shard->total_allocs, 1);
+
+        if ((s >= GF_MEM_ACCT_FOLD_SIZE) || (s <= -GF_MEM_ACCT_FOLD_SIZE) ||
+            (n >= GF_MEM_ACCT_FOLD_NUM) || (n <= -GF_MEM_ACCT_FOLD_NUM))
+                gf_mem_acct_fold (&mem_acct->rec[type], shard);
+}
+
+/**
+ * usage of @type: the folded record plus what is left in the shards. this
+ * is exact only at quiescence; with allocations (and hence folds) going
+ * on, a delta on its way from a shard to the record may be counted twice
+ * or not at all, so the numbers are a close snapshot, not a consistent one.
+ */
+void
+gf_mem_acct_rec_read (struct mem_acct *mem_acct, uint32_t type,
+                      struct mem_acct_rec *rec)
+{
+        struct mem_acct_shard *shard = NULL;
+        int                    i     = 0;
+
+        *rec = mem_acct->rec[type];
+
+        for (i = 0; i < GF_MEM_ACCT_SHARDS; i++) {
+                shard = &mem_acct->shards[i * mem_acct->num_types + type];
+
+                rec->size += shard->size;
+                rec->num_allocs += shard->num_allocs;
+                rec->total_allocs += shard->total_allocs;
+        }
+
+        rec->max_size = max (rec->max_size, rec->size);
+        rec->max_num_allocs = max (rec->max_num_allocs, rec->num_allocs);
+}
+
 int
 gf_mem_set_acct_info (xlator_t *xl, char **alloc_ptr, size_t size,
 		      uint32_t type, const char *typestr)
@@ -64,21 +181,11 @@ gf_mem_set_acct_info (xlator_t *xl, char **alloc_ptr, size_t size,
 
         GF_ASSERT (type <= xl->mem_acct->num_types);
 
-        LOCK(&xl->mem_acct->rec[type].lock);
-        {
-		if (!xl->mem_acct->rec[type].typestr)
-			xl->mem_acct->rec[type].typestr = typestr;
-                xl->mem_acct->rec[type].size += size;
-                xl->mem_acct->rec[type].num_allocs++;
-                xl->mem_acct->rec[type].total_allocs++;
-                xl->mem_acct->rec[type].max_size =
-                        max (xl->mem_acct->rec[type].max_size,
-                             xl->mem_acct->rec[type].size);
-                xl->mem_acct->rec[type].max_num_allocs =
-                        max (xl->mem_acct->rec[type].max_num_allocs,
-                             xl->mem_acct->rec[type].num_allocs);
-        }
-        UNLOCK(&xl->mem_acct->rec[type].lock);
+        /* every allocation of a type passes the same string */
+        if (!xl->mem_acct->rec[type].typestr)
+                xl->mem_acct->rec[type].typestr = typestr;
+
+        gf_mem_acct_update (xl->mem_acct, type, size, 1);
 
         INCREMENT_ATOMIC (xl->mem_acct->lock, xl->mem_acct->refcnt);
 
@@ -313,16 +420,8 @@ __gf_free (void *free_ptr)
         GF_ASSERT (GF_MEM_TRAILER_MAGIC ==
                 *(uint32_t *)((char *)free_ptr + header->size));
 
-        LOCK (&mem_acct->rec[header->type].lock);
-        {
-                mem_acct->rec[header->type].size -= header->size;
-                mem_acct->rec[header->type].num_allocs--;
-                /* If all the instaces are freed up then ensure typestr is
-                 * set to NULL */
-                if (!mem_acct->rec[header->type].num_allocs)
-                        mem_acct->rec[header->type].typestr = NULL;
-        }
-        UNLOCK (&mem_acct->rec[header->type].lock);
+        gf_mem_acct_update (mem_acct, header->type,
+                            -(int64_t) header->size, -1);
 
         if (DECREMENT_ATOMIC (mem_acct->lock, mem_acct->refcnt) == 0) {
                 FREE (mem_acct);
@@ -36,18 +36,41 @@
 #define GF_MEM_TRAILER_MAGIC 0xBAADF00D
 #define GF_MEM_INVALID_MAGIC 0xDEADC0DE
 
+/*
+ * GF_MALLOC/GF_FREE account into one of GF_MEM_ACCT_SHARDS per-type shards,
+ * picked by the CPU the thread runs on, with atomic adds and no lock. A
+ * shard's running delta is folded into the type's mem_acct_rec once it
+ * grows past GF_MEM_ACCT_FOLD_SIZE bytes or GF_MEM_ACCT_FOLD_NUM allocations
+ * either way, which is also when the max_* watermarks are updated; they can
+ * hence miss a peak by at most that much per shard. The numbers are put
+ * together by gf_mem_acct_rec_read () when a statedump asks for them; they
+ * are exact only while no thread allocates or frees memory of that type.
+ */
+#define GF_MEM_ACCT_SHARDS      16
+#define GF_MEM_ACCT_FOLD_SIZE   (64 * 1024)
+#define GF_MEM_ACCT_FOLD_NUM    64
+
+struct mem_acct_shard {
+        int64_t         size;
+        int64_t         num_allocs;
+        uint64_t        total_allocs;
+};
+
+/* size and num_allocs hold what has been folded from the shards so far;
+ * total_allocs is only kept in the shards */
 struct mem_acct_rec {
 	const char     *typestr;
-        size_t          size;
-        size_t          max_size;
-        uint32_t        num_allocs;
-        uint32_t        total_allocs;
-        uint32_t        max_num_allocs;
-        gf_lock_t       lock;
+        int64_t         size;
+        int64_t         max_size;
+        int64_t         num_allocs;
+        int64_t         max_num_allocs;
+        uint64_t        total_allocs;
 };
 
 struct mem_acct {
         uint32_t            num_types;
+        /* num_types entries per shard, shard after shard */
+        struct mem_acct_shard *shards;
         /*
          * The lock is only used on ancient platforms (e.g. RHEL5) to keep
          * refcnt increment/decrement atomic.  We could even make its existence
@@ -59,6 +82,12 @@ struct mem_acct {
         struct mem_acct_rec rec[0];
 };
 
+#define GF_MEM_ACCT_SIZE(num_types)                                     \
+        (sizeof (struct mem_acct)                                       \
+         + (num_types) * (sizeof (struct mem_acct_rec)                  \
+                          + GF_MEM_ACCT_SHARDS                          \
+                            * sizeof (struct mem_acct_shard)))
+
 struct mem_header {
         uint32_t        type;
         size_t          size;
@@ -97,6 +126,13 @@ gf_asprintf (char **string_ptr, const char *format, ...);
 void
 __gf_free (void *ptr);
 
+void
+gf_mem_acct_init (struct mem_acct *mem_acct, uint32_t num_types);
+
+void
+gf_mem_acct_rec_read (struct mem_acct *mem_acct, uint32_t type,
+                      struct mem_acct_rec *rec);
+
 
 static inline
 void* __gf_default_malloc (size_t size)
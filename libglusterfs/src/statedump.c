@@ -12,6 +12,7 @@
 #include "glusterfs.h"
 #include "logging.h"
 #include "iobuf.h"
+#include "event.h"
 #include "statedump.h"
 #include "stack.h"
 #include "common-utils.h"
@@ -222,7 +223,7 @@ static void
 gf_proc_dump_xlator_mem_info (xlator_t *xl)
 {
         int     i = 0;
-        struct mem_acct rec = {0,};
+        struct mem_acct_rec rec = {0,};
 
         if (!xl)
                 return;
@@ -234,22 +235,19 @@ gf_proc_dump_xlator_mem_info (xlator_t *xl)
         gf_proc_dump_write ("num_types", "%d", xl->mem_acct->num_types);
 
         for (i = 0; i < xl->mem_acct->num_types; i++) {
-                if (!(memcmp (&xl->mem_acct->rec[i], &rec,
-                              sizeof (struct mem_acct))))
+                gf_mem_acct_rec_read (xl->mem_acct, i, &rec);
+                if (!rec.total_allocs)
                         continue;
 
                 gf_proc_dump_add_section ("%s.%s - usage-type %s memusage",
-                                          xl->type, xl->name,
-                                          xl->mem_acct->rec[i].typestr);
-                gf_proc_dump_write ("size", "%u", xl->mem_acct->rec[i].size);
-                gf_proc_dump_write ("num_allocs", "%u",
-                                    xl->mem_acct->rec[i].num_allocs);
-                gf_proc_dump_write ("max_size", "%u",
-                                    xl->mem_acct->rec[i].max_size);
-                gf_proc_dump_write ("max_num_allocs", "%u",
-                                    xl->mem_acct->rec[i].max_num_allocs);
-                gf_proc_dump_write ("total_allocs", "%u",
-                                    xl->mem_acct->rec[i].total_allocs);
+                                          xl->type, xl->name, rec.typestr);
+                gf_proc_dump_write ("size", "%"PRId64, rec.size);
+                gf_proc_dump_write ("num_allocs", "%"PRId64, rec.num_allocs);
+                gf_proc_dump_write ("max_size", "%"PRId64, rec.max_size);
+                gf_proc_dump_write ("max_num_allocs", "%"PRId64,
+                                    rec.max_num_allocs);
+                gf_proc_dump_write ("total_allocs", "%"PRIu64,
+                                    rec.total_allocs);
         }
 
         return;
@@ -259,33 +257,32 @@ static void
 gf_proc_dump_xlator_mem_info_only_in_use (xlator_t *xl)
 {
         int     i = 0;
+        struct mem_acct_rec rec = {0,};
 
         if (!xl)
                 return;
 
-        if (!xl->mem_acct->rec)
+        if (!xl->mem_acct)
                 return;
 
         gf_proc_dump_add_section ("%s.%s - Memory usage", xl->type, xl->name);
         gf_proc_dump_write ("num_types", "%d", xl->mem_acct->num_types);
 
         for (i = 0; i < xl->mem_acct->num_types; i++) {
-                if (!xl->mem_acct->rec[i].size)
+                gf_mem_acct_rec_read (xl->mem_acct, i, &rec);
+                if (!rec.size)
                         continue;
 
                 gf_proc_dump_add_section ("%s.%s - usage-type %d", xl->type,
                                           xl->name,i);
 
-                gf_proc_dump_write ("size", "%u",
-                                    xl->mem_acct->rec[i].size);
-                gf_proc_dump_write ("max_size", "%u",
-                                    xl->mem_acct->rec[i].max_size);
-                gf_proc_dump_write ("num_allocs", "%u",
-                                    xl->mem_acct->rec[i].num_allocs);
-                gf_proc_dump_write ("max_num_allocs", "%u",
-                                    xl->mem_acct->rec[i].max_num_allocs);
-                gf_proc_dump_write ("total_allocs", "%u",
-                                    xl->mem_acct->rec[i].total_allocs);
+                gf_proc_dump_write ("size", "%"PRId64, rec.size);
+                gf_proc_dump_write ("max_size", "%"PRId64, rec.max_size);
+                gf_proc_dump_write ("num_allocs", "%"PRId64, rec.num_allocs);
+                gf_proc_dump_write ("max_num_allocs", "%"PRId64,
+                                    rec.max_num_allocs);
+                gf_proc_dump_write ("total_allocs", "%"PRIu64,
+                                    rec.total_allocs);
         }
 
         return;
@@ -564,6 +561,7 @@ gf_proc_dump_enable_all_options ()
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_mem, _gf_true);
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_iobuf, _gf_true);
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_callpool, _gf_true);
+        GF_PROC_DUMP_SET_OPTION (dump_options.dump_event, _gf_true);
         GF_PROC_DUMP_SET_OPTION (dump_options.xl_options.dump_priv, _gf_true);
         GF_PROC_DUMP_SET_OPTION (dump_options.xl_options.dump_inode, _gf_true);
         GF_PROC_DUMP_SET_OPTION (dump_options.xl_options.dump_fd, _gf_true);
@@ -585,6 +583,8 @@ is_gf_proc_dump_all_disabled ()
         GF_CHECK_DUMP_OPTION_ENABLED (dump_options.dump_iobuf, all_disabled, out);
         GF_CHECK_DUMP_OPTION_ENABLED (dump_options.dump_callpool, all_disabled,
                                    out);
+        GF_CHECK_DUMP_OPTION_ENABLED (dump_options.dump_event, all_disabled,
+                                   out);
         GF_CHECK_DUMP_OPTION_ENABLED (dump_options.xl_options.dump_priv,
                                    all_disabled, out);
         GF_CHECK_DUMP_OPTION_ENABLED (dump_options.xl_options.dump_inode,
@@ -610,6 +610,7 @@ gf_proc_dump_enable_default_options ()
 {
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_mem, _gf_true);
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_callpool, _gf_true);
+        GF_PROC_DUMP_SET_OPTION (dump_options.dump_event, _gf_true);
 
         return 0;
 }
@@ -621,6 +622,7 @@ gf_proc_dump_disable_all_options ()
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_mem, _gf_false);
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_iobuf, _gf_false);
         GF_PROC_DUMP_SET_OPTION (dump_options.dump_callpool, _gf_false);
+        GF_PROC_DUMP_SET_OPTION (dump_options.dump_event, _gf_false);
         GF_PROC_DUMP_SET_OPTION (dump_options.xl_options.dump_priv, _gf_false);
         GF_PROC_DUMP_SET_OPTION (dump_options.xl_options.dump_inode,
                                  _gf_false);
@@ -650,6 +652,8 @@ gf_proc_dump_parse_set_option (char *key, char *value)
                 opt_key = &dump_options.dump_iobuf;
         } else if (!strcasecmp (key, "callpool")) {
                 opt_key = &dump_options.dump_callpool;
+        } else if (!strcasecmp (key, "event")) {
+                opt_key = &dump_options.dump_event;
         } else if (!strcasecmp (key, "priv")) {
                 opt_key = &dump_options.xl_options.dump_priv;
         } else if (!strcasecmp (key, "fd")) {
@@ -825,6 +829,8 @@ gf_proc_dump_info (int signum, glusterfs_ctx_t *ctx)
                 iobuf_stats_dump (ctx->iobuf_pool);
         if (GF_PROC_DUMP_IS_OPTION_ENABLED (callpool))
                 gf_proc_dump_pending_frames (ctx->pool);
+        if (GF_PROC_DUMP_IS_OPTION_ENABLED (event))
+                event_pool_dump (ctx->event_pool);
 
         if (ctx->master) {
                 gf_proc_dump_add_section ("fuse");
@@ -735,6 +735,9 @@ syncenv_scale (struct syncenv *env)
 						syncenv_processor, &env->proc[i]);
                         if (ret)
                                 break;
+                        if (env->placement[0])
+                                gf_thread_set_placement (env->proc[i].processor,
+                                                         env->placement, i);
                         env->procs++;
                         i++;
                 }
@@ -743,6 +746,55 @@ unlock:
         pthread_mutex_unlock (&env->mutex);
 }
 
+/* Move the running processors according to @placement (see
+ * gf_thread_set_placement()) and remember it for the ones started later.
+ */
+int
+syncenv_set_placement (struct syncenv *env, const char *placement)
+{
+        int ret = 0;
+        int i   = 0;
+
+        if (!env)
+                return -1;
+
+        /* "none" is what a pool starts with: nothing to move */
+        if (!placement || !strcmp (placement, "none"))
+                placement = "";
+
+        if (gf_thread_placement_validate (placement) != 0) {
+                gf_msg ("syncop", GF_LOG_WARNING, EINVAL,
+                        LG_MSG_THREAD_PLACEMENT_FAILED,
+                        "invalid thread placement \"%s\"", placement);
+                return -1;
+        }
+
+        pthread_mutex_lock (&env->mutex);
+        {
+                if (!strcmp (env->placement, placement))
+                        goto unlock;
+
+                strncpy (env->placement, placement,
+                         sizeof (env->placement) - 1);
+
+                for (i = 0; i < env->procmax; i++) {
+                        if (!env->proc[i].processor)
+                                continue;
+                        ret = gf_thread_set_placement (env->proc[i].processor,
+                                                       env->placement, i);
+                        if (ret)
+                                gf_msg ("syncop", GF_LOG_WARNING, ret,
+                                        LG_MSG_THREAD_PLACEMENT_FAILED,
+                                        "failed to place syncenv processor "
+                                        "%d (%s)", i, env->placement);
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&env->mutex);
+
+        return ret;
+}
+
 /* The syncenv threads are cleaned up in this routine.
  */
 void
@@ -106,6 +106,8 @@ struct syncenv {
 
         int                 destroy; /* FLAG to mark syncenv is in destroy mode
                                         so that no more synctasks are accepted*/
+
+        char                placement[GF_THREAD_PLACEMENT_MAX];
 };
 
 
@@ -258,6 +260,7 @@ struct syncopctx {
 struct syncenv * syncenv_new (size_t stacksize, int procmin, int procmax);
 void syncenv_destroy (struct syncenv *);
 void syncenv_scale (struct syncenv *env);
+int syncenv_set_placement (struct syncenv *env, const char *placement);
 
 int synctask_new1 (struct syncenv *, size_t stacksize, synctask_fn_t,
                     synctask_cbk_t, call_frame_t *frame, void *);
@@ -18,7 +18,12 @@
 
 #include <cmocka.h>
 
+/* mock() is not thread safe: threads of a test set their own THIS here */
+__thread xlator_t **global_mock_this;
+
 xlator_t **__glusterfs_this_location ()
 {
+    if (global_mock_this)
+        return global_mock_this;
     return ((xlator_t **)(uintptr_t)mock());
 }
@@ -0,0 +1,104 @@
+/*
+  Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "hashfn.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+#define NAMES_MAX 64
+#define NAME_LEN_MAX 300
+
+/*
+ * Helper functions
+ */
+static void
+helper_names_fill(char names[][NAME_LEN_MAX], const char **msgs, int *lens,
+                  int cnt, unsigned int seed)
+{
+    int i, j;
+
+    srandom(seed);
+    for (i = 0; i < cnt; i++) {
+        // cover lengths on, just before and just after the 16 byte blocks
+        lens[i] = (i < 50) ? i : random() % NAME_LEN_MAX;
+        for (j = 0; j < lens[i]; j++)
+            names[i][j] = 1 + random() % 255;
+        msgs[i] = names[i];
+    }
+}
+
+static void
+helper_batch_check(const char **msgs, const int *lens, int cnt)
+{
+    uint32_t hashes[NAMES_MAX];
+    int i;
+
+    memset(hashes, 0, sizeof(hashes));
+    gf_dm_hashfn_batch(msgs, lens, hashes, cnt);
+
+    for (i = 0; i < cnt; i++)
+        assert_int_equal(hashes[i], gf_dm_hashfn(msgs[i], lens[i]));
+    // nothing is written past the last name
+    for (; i < NAMES_MAX; i++)
+        assert_int_equal(hashes[i], 0);
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_gf_dm_hashfn_batch(void **state)
+{
+    static char names[NAMES_MAX][NAME_LEN_MAX];
+    const char *msgs[NAMES_MAX];
+    int lens[NAMES_MAX];
+    int cnt;
+
+    helper_names_fill(names, msgs, lens, NAMES_MAX, 1);
+
+    // every count, so each number of lanes in the last group is used
+    for (cnt = 0; cnt <= NAMES_MAX; cnt++)
+        helper_batch_check(msgs, lens, cnt);
+
+    // the same names in another order land in other lanes
+    helper_names_fill(names, msgs, lens, NAMES_MAX, 2);
+    helper_batch_check(msgs + 1, lens + 1, NAMES_MAX - 1);
+}
+
+static void
+test_gf_dm_hashfn_batch_names(void **state)
+{
+    const char *msgs[] = { "a", "file.txt", ".file.txt.aBcDeF",
+                           "0123456789abcdef", "0123456789abcdef0",
+                           "" };
+    int lens[6];
+    int i;
+
+    for (i = 0; i < 6; i++)
+        lens[i] = strlen(msgs[i]);
+
+    helper_batch_check(msgs, lens, 6);
+}
+
+int main(void) {
+    const struct CMUnitTest libglusterfs_hashfn_tests[] = {
+        cmocka_unit_test(test_gf_dm_hashfn_batch),
+        cmocka_unit_test(test_gf_dm_hashfn_batch_names),
+    };
+
+    return cmocka_run_group_tests(libglusterfs_hashfn_tests, NULL, NULL);
+}
@@ -17,6 +17,7 @@
 #include <setjmp.h>
 #include <inttypes.h>
 #include <string.h>
+#include <pthread.h>
 #include <cmocka_pbc.h>
 #include <cmocka.h>
 
@@ -45,6 +46,17 @@ int
 gf_mem_set_acct_info (xlator_t *xl, char **alloc_ptr, size_t size,
                       uint32_t type, const char *typestr);
 
+/*
+ * THIS for threads, which cannot use mock() (see global_mock.c)
+ */
+extern __thread xlator_t **global_mock_this;
+
+#define ACCT_THREADS 4
+#define ACCT_CYCLES 1000
+// more than GF_MEM_ACCT_FOLD_NUM live allocations, and more than
+// GF_MEM_ACCT_FOLD_SIZE bytes of them, in every thread
+#define ACCT_LIVE 100
+
 /*
  * Helper functions
  */
@@ -52,47 +64,79 @@ static xlator_t *
 helper_xlator_init(uint32_t num_types)
 {
     xlator_t *xl;
-    int i, ret;
 
     REQUIRE(num_types > 0);
 
     xl = test_calloc(1, sizeof(xlator_t));
     assert_non_null(xl);
-    xl->mem_acct->num_types = num_types;
-    xl->mem_acct = test_calloc (sizeof(struct mem_acct)
-                                + sizeof(struct mem_acct_rec) * num_types);
+    xl->mem_acct = test_calloc (1, GF_MEM_ACCT_SIZE(num_types));
     assert_non_null(xl->mem_acct);
+    gf_mem_acct_init(xl->mem_acct, num_types);
 
     xl->ctx = test_calloc(1, sizeof(glusterfs_ctx_t));
     assert_non_null(xl->ctx);
 
-    for (i = 0; i < num_types; i++) {
-            ret = LOCK_INIT(&(xl->mem_acct->rec[i].lock));
-            assert_int_equal(ret, 0);
-    }
-
     ENSURE(num_types == xl->mem_acct->num_types);
     ENSURE(NULL != xl);
 
     return xl;
 }
 
-static int
-helper_xlator_destroy(xlator_t *xl)
+static struct mem_acct_rec
+helper_rec(xlator_t *xl, uint32_t type)
 {
-    int i, ret;
+    struct mem_acct_rec rec;
 
-    for (i = 0; i < xl->mem_acct->num_types; i++) {
-            ret = LOCK_DESTROY(&(xl->mem_acct->rec[i].lock));
-            assert_int_equal(ret, 0);
-    }
+    gf_mem_acct_rec_read(xl->mem_acct, type, &rec);
+    return rec;
+}
 
-    free(xl->mem_acct->rec);
+static int
+helper_xlator_destroy(xlator_t *xl)
+{
+    free(xl->mem_acct);
     free(xl->ctx);
     free(xl);
     return 0;
 }
 
+struct helper_acct_thread {
+    xlator_t *xl;
+    uint32_t type;
+    void *live[ACCT_LIVE];
+    size_t live_size;
+};
+
+static size_t
+helper_acct_size(int cycle)
+{
+    return (cycle % 8 + 1) * 1024;
+}
+
+// allocates and frees in cycles, leaving the last ACCT_LIVE allocations
+static void *
+helper_acct_cycles(void *arg)
+{
+    struct helper_acct_thread *t = arg;
+    int i;
+
+    global_mock_this = &t->xl;
+
+    for (i = 0; i < ACCT_CYCLES; i++) {
+        if (t->live[i % ACCT_LIVE]) {
+            __gf_free(t->live[i % ACCT_LIVE]);
+            t->live_size -= helper_acct_size(i - ACCT_LIVE);
+        }
+        t->live[i % ACCT_LIVE] = __gf_malloc(helper_acct_size(i), t->type,
+                                             "ACCT");
+        if (!t->live[i % ACCT_LIVE])
+            return NULL;
+        t->live_size += helper_acct_size(i);
+    }
+
+    return t;
+}
+
 static void
 helper_check_memory_headers( char *mem,
         xlator_t *xl,
@@ -191,11 +235,11 @@ test_gf_mem_set_acct_info_memory(void **state)
 
     //Check values
     assert_ptr_equal(typestr, xl->mem_acct->rec[type].typestr);
-    assert_int_equal(xl->mem_acct->rec[type].size, size);
-    assert_int_equal(xl->mem_acct->rec[type].num_allocs, 1);
-    assert_int_equal(xl->mem_acct->rec[type].total_allocs, 1);
-    assert_int_equal(xl->mem_acct->rec[type].max_size, size);
-    assert_int_equal(xl->mem_acct->rec[type].max_num_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).size, size);
+    assert_int_equal(helper_rec(xl, type).num_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).total_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).max_size, size);
+    assert_int_equal(helper_rec(xl, type).max_num_allocs, 1);
 
     // Check memory
     helper_check_memory_headers(temp_ptr, xl, size, type);
@@ -236,11 +280,11 @@ test_gf_calloc_default_calloc(void **state)
     memset(mem, 0x5A, size);
 
     // Check xl did not change
-    assert_int_equal(xl->mem_acct->rec[type].size, 0);
-    assert_int_equal(xl->mem_acct->rec[type].num_allocs, 0);
-    assert_int_equal(xl->mem_acct->rec[type].total_allocs, 0);
-    assert_int_equal(xl->mem_acct->rec[type].max_size, 0);
-    assert_int_equal(xl->mem_acct->rec[type].max_num_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).size, 0);
+    assert_int_equal(helper_rec(xl, type).num_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).total_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).max_size, 0);
+    assert_int_equal(helper_rec(xl, type).max_num_allocs, 0);
 
     free(mem);
     helper_xlator_destroy(xl);
@@ -270,11 +314,11 @@ test_gf_calloc_mem_acct_enabled(void **state)
     memset(mem, 0x5A, size);
 
     // Check xl values
-    assert_int_equal(xl->mem_acct->rec[type].size, size);
-    assert_int_equal(xl->mem_acct->rec[type].num_allocs, 1);
-    assert_int_equal(xl->mem_acct->rec[type].total_allocs, 1);
-    assert_int_equal(xl->mem_acct->rec[type].max_size, size);
-    assert_int_equal(xl->mem_acct->rec[type].max_num_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).size, size);
+    assert_int_equal(helper_rec(xl, type).num_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).total_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).max_size, size);
+    assert_int_equal(helper_rec(xl, type).max_num_allocs, 1);
 
     // Check memory
     helper_check_memory_headers(mem - sizeof(mem_header_t), xl, size, type);
@@ -303,11 +347,11 @@ test_gf_malloc_default_malloc(void **state)
     memset(mem, 0x5A, size);
 
     // Check xl did not change
-    assert_int_equal(xl->mem_acct->rec[type].size, 0);
-    assert_int_equal(xl->mem_acct->rec[type].num_allocs, 0);
-    assert_int_equal(xl->mem_acct->rec[type].total_allocs, 0);
-    assert_int_equal(xl->mem_acct->rec[type].max_size, 0);
-    assert_int_equal(xl->mem_acct->rec[type].max_num_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).size, 0);
+    assert_int_equal(helper_rec(xl, type).num_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).total_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).max_size, 0);
+    assert_int_equal(helper_rec(xl, type).max_num_allocs, 0);
 
     free(mem);
     helper_xlator_destroy(xl);
@@ -337,11 +381,11 @@ test_gf_malloc_mem_acct_enabled(void **state)
     memset(mem, 0x5A, size);
 
     // Check xl values
-    assert_int_equal(xl->mem_acct->rec[type].size, size);
-    assert_int_equal(xl->mem_acct->rec[type].num_allocs, 1);
-    assert_int_equal(xl->mem_acct->rec[type].total_allocs, 1);
-    assert_int_equal(xl->mem_acct->rec[type].max_size, size);
-    assert_int_equal(xl->mem_acct->rec[type].max_num_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).size, size);
+    assert_int_equal(helper_rec(xl, type).num_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).total_allocs, 1);
+    assert_int_equal(helper_rec(xl, type).max_size, size);
+    assert_int_equal(helper_rec(xl, type).max_num_allocs, 1);
 
     // Check memory
     helper_check_memory_headers(mem - sizeof(mem_header_t), xl, size, type);
@@ -375,11 +419,11 @@ test_gf_realloc_default_realloc(void **state)
     memset(mem, 0x5A, size);
 
     // Check xl did not change
-    assert_int_equal(xl->mem_acct->rec[type].size, 0);
-    assert_int_equal(xl->mem_acct->rec[type].num_allocs, 0);
-    assert_int_equal(xl->mem_acct->rec[type].total_allocs, 0);
-    assert_int_equal(xl->mem_acct->rec[type].max_size, 0);
-    assert_int_equal(xl->mem_acct->rec[type].max_num_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).size, 0);
+    assert_int_equal(helper_rec(xl, type).num_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).total_allocs, 0);
+    assert_int_equal(helper_rec(xl, type).max_size, 0);
+    assert_int_equal(helper_rec(xl, type).max_num_allocs, 0);
 
     free(mem);
     helper_xlator_destroy(xl);
@@ -420,11 +464,11 @@ test_gf_realloc_mem_acct_enabled(void **state)
     // not to the realloc + the malloc.
     // Is this a bug?
     //
-    assert_int_equal(xl->mem_acct->rec[type].size, size+1024);
-    assert_int_equal(xl->mem_acct->rec[type].num_allocs, 2);
-    assert_int_equal(xl->mem_acct->rec[type].total_allocs, 2);
-    assert_int_equal(xl->mem_acct->rec[type].max_size, size+1024);
-    assert_int_equal(xl->mem_acct->rec[type].max_num_allocs, 2);
+    assert_int_equal(helper_rec(xl, type).size, size+1024);
+    assert_int_equal(helper_rec(xl, type).num_allocs, 2);
+    assert_int_equal(helper_rec(xl, type).total_allocs, 2);
+    assert_int_equal(helper_rec(xl, type).max_size, size+1024);
+    assert_int_equal(helper_rec(xl, type).max_num_allocs, 2);
 
     // Check memory
     helper_check_memory_headers(mem - sizeof(mem_header_t), xl, size, type);
@@ -465,6 +509,67 @@ test_gf_realloc_ptr(void **state)
     helper_xlator_destroy(xl);
 }
 
+static void
+test_gf_mem_acct_threads(void **state)
+{
+    struct helper_acct_thread threads[ACCT_THREADS];
+    pthread_t tids[ACCT_THREADS];
+    struct mem_acct_rec rec;
+    xlator_t *xl;
+    uint32_t type;
+    size_t live_size;
+    void *res;
+    int i, j;
+
+    // Initialize xl
+    xl = helper_xlator_init(10);
+    xl->ctx->mem_acct_enable = 1;
+    type = 5;
+
+    memset(threads, 0, sizeof(threads));
+    for (i = 0; i < ACCT_THREADS; i++) {
+        threads[i].xl = xl;
+        threads[i].type = type;
+        assert_int_equal(pthread_create(&tids[i], NULL, helper_acct_cycles,
+                                        &threads[i]), 0);
+    }
+
+    live_size = 0;
+    for (i = 0; i < ACCT_THREADS; i++) {
+        assert_int_equal(pthread_join(tids[i], &res), 0);
+        assert_ptr_equal(res, &threads[i]);
+        live_size += threads[i].live_size;
+    }
+
+    // shards went past their thresholds and were folded into the record
+    assert_true(xl->mem_acct->rec[type].max_size > 0);
+    assert_true(xl->mem_acct->rec[type].max_num_allocs > 0);
+
+    // at rest, record and shards add up exactly
+    rec = helper_rec(xl, type);
+    assert_int_equal(rec.size, live_size);
+    assert_int_equal(rec.num_allocs, ACCT_THREADS * ACCT_LIVE);
+    assert_int_equal(rec.total_allocs, ACCT_THREADS * ACCT_CYCLES);
+    assert_true(rec.max_size >= rec.size);
+    assert_true(rec.max_num_allocs >= rec.num_allocs);
+    assert_int_equal(xl->mem_acct->refcnt, 1 + ACCT_THREADS * ACCT_LIVE);
+
+    // free what is left from this thread
+    global_mock_this = &xl;
+    for (i = 0; i < ACCT_THREADS; i++)
+        for (j = 0; j < ACCT_LIVE; j++)
+            __gf_free(threads[i].live[j]);
+    global_mock_this = NULL;
+
+    rec = helper_rec(xl, type);
+    assert_int_equal(rec.size, 0);
+    assert_int_equal(rec.num_allocs, 0);
+    assert_int_equal(rec.total_allocs, ACCT_THREADS * ACCT_CYCLES);
+    assert_int_equal(xl->mem_acct->refcnt, 1);
+
+    helper_xlator_destroy(xl);
+}
+
 int main(void) {
     const struct CMUnitTest libglusterfs_mem_pool_tests[] = {
         cmocka_unit_test(test_gf_mem_acct_enable_set),
@@ -477,6 +582,7 @@ int main(void) {
         cmocka_unit_test(test_gf_realloc_default_realloc),
         cmocka_unit_test(test_gf_realloc_mem_acct_enabled),
         cmocka_unit_test(test_gf_realloc_ptr),
+        cmocka_unit_test(test_gf_mem_acct_threads),
     };
 
     return cmocka_run_group_tests(libglusterfs_mem_pool_tests, NULL, NULL);
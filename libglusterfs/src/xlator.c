@@ -494,9 +494,6 @@ xlator_notify (xlator_t *xl, int event, void *data, ...)
 int
 xlator_mem_acct_init (xlator_t *xl, int num_types)
 {
-        int             i = 0;
-        int             ret = 0;
-
         if (!xl)
                 return -1;
 
@@ -507,25 +504,13 @@ xlator_mem_acct_init (xlator_t *xl, int num_types)
                 return 0;
 
 
-        xl->mem_acct = MALLOC (sizeof(struct mem_acct)
-                               + sizeof(struct mem_acct_rec) * num_types);
+        xl->mem_acct = MALLOC (GF_MEM_ACCT_SIZE (num_types));
 
         if (!xl->mem_acct) {
                 return -1;
         }
-        memset (xl->mem_acct, 0, sizeof(struct mem_acct));
-
-        xl->mem_acct->num_types = num_types;
-        LOCK_INIT (&xl->mem_acct->lock);
-        xl->mem_acct->refcnt = 1;
 
-        for (i = 0; i < num_types; i++) {
-                memset (&xl->mem_acct->rec[i], 0, sizeof(struct mem_acct_rec));
-                ret = LOCK_INIT(&(xl->mem_acct->rec[i].lock));
-                if (ret) {
-                        fprintf(stderr, "Unable to lock..errno : %d",errno);
-                }
-        }
+        gf_mem_acct_init (xl->mem_acct, num_types);
 
         return 0;
 }
@@ -562,7 +547,6 @@ xlator_list_destroy (xlator_list_t *list)
 static int
 xlator_memrec_free (xlator_t *xl)
 {
-        uint32_t        i               = 0;
         struct mem_acct *mem_acct       = NULL;
 
         if (!xl) {
@@ -571,9 +555,6 @@ xlator_memrec_free (xlator_t *xl)
         mem_acct = xl->mem_acct;
 
         if (mem_acct) {
-                for (i = 0; i < mem_acct->num_types; i++) {
-                        LOCK_DESTROY (&(mem_acct->rec[i].lock));
-                }
                 if (DECREMENT_ATOMIC (mem_acct->lock, mem_acct->refcnt) == 0) {
                         FREE (mem_acct);
                         xl->mem_acct = NULL;
@@ -1058,3 +1039,41 @@ xlator_subvolume_count (xlator_t *this)
                 i++;
         return i;
 }
+
+/* Looks down the first path of the graph from @xl for the block size of
+ * a shard and the stripe size of a disperse volume below it. Either is
+ * left at 0 when there is no such xlator on the path.
+ */
+void
+xlator_probe_backend (xlator_t *xl, uint64_t *shard_block_size,
+                      uint64_t *stripe_size)
+{
+        char    *value      = NULL;
+        int32_t  redundancy = 0;
+        int      count      = 0;
+
+        *shard_block_size = 0;
+        *stripe_size = 0;
+
+        for (; xl; xl = xl->children ? xl->children->xlator : NULL) {
+                if (!strcmp (xl->type, "features/shard")) {
+                        *shard_block_size = GF_SHARD_BLOCK_SIZE_DEFAULT;
+                        if (!dict_get_str (xl->options, "shard-block-size",
+                                           &value))
+                                gf_string2bytesize_uint64 (value,
+                                                           shard_block_size);
+                        continue;
+                }
+
+                if (strcmp (xl->type, "cluster/disperse"))
+                        continue;
+
+                count = xlator_subvolume_count (xl);
+                if (!dict_get_str (xl->options, "redundancy", &value) &&
+                    !gf_string2int32 (value, &redundancy) &&
+                    (count > redundancy))
+                        *stripe_size = (uint64_t)(count - redundancy)
+                                       * GF_EC_CHUNK_SIZE;
+                break;
+        }
+}
@@ -988,4 +988,8 @@ glusterfs_reachable_leaves(xlator_t *base, dict_t *leaves);
 int
 xlator_subvolume_count (xlator_t *this);
 
+void
+xlator_probe_backend (xlator_t *xl, uint64_t *shard_block_size,
+                      uint64_t *stripe_size);
+
 #endif /* _XLATOR_H */
@@ -205,6 +205,10 @@ struct rpc_transport {
 
         uint64_t                   total_bytes_read;
         uint64_t                   total_bytes_write;
+        uint64_t                   total_writev_calls;
+        uint64_t                   total_msgs_written;
+        uint64_t                   total_readv_calls;
+        uint64_t                   total_msgs_read;
 
         struct list_head           list;
         int                        bind_insecure;
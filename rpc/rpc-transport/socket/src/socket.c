@@ -44,6 +44,7 @@
 #define SSL_OWN_CERT_OPT    "transport.socket.ssl-own-cert"
 #define SSL_PRIVATE_KEY_OPT "transport.socket.ssl-private-key"
 #define SSL_CA_LIST_OPT     "transport.socket.ssl-ca-list"
+#define SSL_KTLS_OPT        "transport.socket.ssl-ktls"
 #define OWN_THREAD_OPT      "transport.socket.own-thread"
 
 /*
@@ -394,6 +395,18 @@ ssl_setup_connection (rpc_transport_t *this, int server)
 		NID_commonName, peer_CN, sizeof(peer_CN)-1);
 	peer_CN[sizeof(peer_CN)-1] = '\0';
 	gf_log(this->name,GF_LOG_INFO,"peer CN = %s", peer_CN);
+
+#ifdef SSL_OP_ENABLE_KTLS
+        if (priv->ssl_ktls) {
+                priv->ktls_tx = !!BIO_get_ktls_send (SSL_get_wbio (
+                                                        priv->ssl_ssl));
+                gf_log (this->name, GF_LOG_INFO,
+                        "kernel TLS is %s for send, %s for receive",
+                        priv->ktls_tx ? "active" : "not active",
+                        BIO_get_ktls_recv (SSL_get_rbio (priv->ssl_ssl))
+                        ? "active" : "not active");
+        }
+#endif
         return gf_strdup(peer_CN);
 
 	/* Error paths. */
@@ -418,6 +431,132 @@ ssl_teardown_connection (socket_private_t *priv)
                 priv->ssl_ssl = NULL;
         }
         priv->use_ssl = _gf_false;
+        priv->ktls_tx = _gf_false;
+}
+
+
+/*
+ * Serve a read from the receive buffer when it holds data, otherwise read
+ * from the socket with the receive buffer appended to the caller's vector.
+ * One syscall then picks up whatever the peer has already sent after the
+ * requested bytes (typically the next few small RPC records), while large
+ * payloads still land directly in the caller's iobufs.
+ */
+static ssize_t
+__socket_buffered_readv (rpc_transport_t *this, struct iovec *opvector,
+                         int opcount)
+{
+        socket_private_t *priv    = NULL;
+        struct iovec      vector[MAX_IOVEC + 1];
+        size_t            req_len = 0;
+        ssize_t           ret     = -1;
+
+        priv = this->private;
+
+        if (priv->rcvbuf_head < priv->rcvbuf_tail) {
+                ret = iov_load (opvector, opcount,
+                                &priv->rcvbuf[priv->rcvbuf_head],
+                                priv->rcvbuf_tail - priv->rcvbuf_head);
+                priv->rcvbuf_head += ret;
+                if (priv->rcvbuf_head == priv->rcvbuf_tail)
+                        priv->rcvbuf_head = priv->rcvbuf_tail = 0;
+                return ret;
+        }
+
+        if (priv->rcvbuf_size && !priv->rcvbuf)
+                priv->rcvbuf = GF_MALLOC (priv->rcvbuf_size,
+                                          gf_common_mt_char);
+
+        this->total_readv_calls++;
+
+        if (!priv->rcvbuf || opcount > MAX_IOVEC)
+                return readv (priv->sock, opvector, IOV_MIN(opcount));
+
+        memcpy (vector, opvector, sizeof (*opvector) * opcount);
+        vector[opcount].iov_base = priv->rcvbuf;
+        vector[opcount].iov_len  = priv->rcvbuf_size;
+
+        req_len = iov_length (opvector, opcount);
+
+        ret = readv (priv->sock, vector, opcount + 1);
+        if (ret > (ssize_t)req_len) {
+                priv->rcvbuf_tail = ret - req_len;
+                ret = req_len;
+        }
+
+        return ret;
+}
+
+
+/*
+ * Input that was already read off the socket (into our receive buffer or
+ * into the SSL read-ahead buffer) does not make the socket readable again.
+ */
+static gf_boolean_t
+socket_input_pending (socket_private_t *priv)
+{
+        gf_boolean_t pending = _gf_false;
+
+        pthread_mutex_lock (&priv->lock);
+        {
+                if (priv->connected != 1)
+                        goto unlock;
+
+                if (priv->use_ssl) {
+                        if (priv->ssl_ssl)
+                                pending = SSL_HAS_PENDING (priv->ssl_ssl);
+                } else {
+                        pending = (priv->rcvbuf_head < priv->rcvbuf_tail);
+                }
+        }
+unlock:
+        pthread_mutex_unlock (&priv->lock);
+
+        return pending;
+}
+
+
+/*
+ * SSL_write() takes one buffer and turns it into at least one record, so
+ * writing a message vector element by element costs a record (and a
+ * syscall) per header.  Copy consecutive small elements into one buffer
+ * of up to a full record instead.  ssl_do() retries until the whole
+ * buffer is written or fails, the caller moves over the consumed
+ * elements as with writev().
+ */
+static ssize_t
+__socket_ssl_writev (rpc_transport_t *this, struct iovec *opvector,
+                     int opcount)
+{
+        socket_private_t *priv = NULL;
+        size_t            len  = 0;
+        int               i    = 0;
+
+        priv = this->private;
+
+        if ((opcount == 1) || (opvector->iov_len >= SOCKET_SSL_RECORD_SIZE))
+                goto single;
+
+        if (!priv->ssl_wbuf) {
+                priv->ssl_wbuf = GF_MALLOC (SOCKET_SSL_RECORD_SIZE,
+                                            gf_common_mt_char);
+                if (!priv->ssl_wbuf)
+                        goto single;
+        }
+
+        for (i = 0; i < opcount; i++) {
+                if (len + opvector[i].iov_len > SOCKET_SSL_RECORD_SIZE)
+                        break;
+
+                memcpy (&priv->ssl_wbuf[len], opvector[i].iov_base,
+                        opvector[i].iov_len);
+                len += opvector[i].iov_len;
+        }
+
+        return ssl_write_one (this, priv->ssl_wbuf, len);
+
+single:
+        return ssl_write_one (this, opvector->iov_base, opvector->iov_len);
 }
 
 
@@ -425,16 +564,14 @@ static ssize_t
 __socket_ssl_readv (rpc_transport_t *this, struct iovec *opvector, int opcount)
 {
 	socket_private_t    *priv = NULL;
-	int                  sock = -1;
 	int                  ret = -1;
 
 	priv = this->private;
-	sock = priv->sock;
 
 	if (priv->use_ssl) {
 		ret = ssl_read_one (this, opvector->iov_base, opvector->iov_len);
 	} else {
-		ret = readv (sock, opvector, IOV_MIN(opcount));
+		ret = __socket_buffered_readv (this, opvector, opcount);
 	}
 
 	return ret;
@@ -588,11 +725,12 @@ __socket_rwv (rpc_transport_t *this, struct iovec *vector, int count,
                          */
                         ret = -1;
                 } else if (write) {
-			if (priv->use_ssl) {
-                                ret = ssl_write_one (this, opvector->iov_base,
-                                                     opvector->iov_len);
+			if (priv->use_ssl && !priv->ktls_tx) {
+                                ret = __socket_ssl_writev (this, opvector,
+                                                           opcount);
 			} else {
 				ret = writev (sock, opvector, IOV_MIN(opcount));
+                                this->total_writev_calls++;
 			}
 
                         if (ret == 0 || (ret == -1 && errno == EAGAIN)) {
@@ -975,6 +1113,9 @@ __socket_reset (rpc_transport_t *this)
 
         memset (&priv->incoming, 0, sizeof (priv->incoming));
 
+        /* leftovers belong to the old connection */
+        priv->rcvbuf_head = priv->rcvbuf_tail = 0;
+
         event_unregister_close (this->ctx->event_pool, priv->sock, priv->idx);
 
         priv->sock = -1;
@@ -1112,12 +1253,35 @@ out:
 }
 
 
+static void
+__socket_ioq_entry_done (rpc_transport_t *this, struct ioq *entry,
+                         int direct)
+{
+	socket_private_t *priv = NULL;
+	char              a_byte = 0;
+
+        this->total_msgs_written++;
+        __socket_ioq_entry_free (entry);
+
+        priv = this->private;
+        if (priv->own_thread) {
+                /*
+                 * The pipe should only remain readable if there are
+                 * more entries after this, so drain the byte
+                 * representing this entry.
+                 */
+                if (!direct && read(priv->pipe[0],&a_byte,1) < 1) {
+                        gf_log(this->name,GF_LOG_WARNING,
+                               "read error on pipe");
+                }
+        }
+}
+
+
 static int
 __socket_ioq_churn_entry (rpc_transport_t *this, struct ioq *entry, int direct)
 {
         int               ret = -1;
-	socket_private_t *priv = NULL;
-	char              a_byte = 0;
 
         ret = __socket_writev (this, entry->pending_vector,
                                entry->pending_count,
@@ -1127,19 +1291,75 @@ __socket_ioq_churn_entry (rpc_transport_t *this, struct ioq *entry, int direct)
         if (ret == 0) {
                 /* current entry was completely written */
                 GF_ASSERT (entry->pending_count == 0);
-                __socket_ioq_entry_free (entry);
-		priv = this->private;
-		if (priv->own_thread) {
-			/*
-			 * The pipe should only remain readable if there are
-			 * more entries after this, so drain the byte
-			 * representing this entry.
-			 */
-			if (!direct && read(priv->pipe[0],&a_byte,1) < 1) {
-				gf_log(this->name,GF_LOG_WARNING,
-				       "read error on pipe");
-			}
-		}
+                __socket_ioq_entry_done (this, entry, direct);
+        }
+
+        return ret;
+}
+
+
+/*
+ * Gather the pending vectors of as many queued entries as fit into one
+ * writev, so that a burst of small messages goes out in a single syscall.
+ * Entries are only accounted for (and freed) after the bytes actually
+ * written are known; a partially written entry keeps its remainder in its
+ * own pending_vector for the next round.
+ */
+static int
+__socket_ioq_churn_batch (rpc_transport_t *this)
+{
+        socket_private_t *priv    = NULL;
+        struct ioq       *entry   = NULL;
+        struct ioq       *tmp     = NULL;
+        struct iovec      vector[SOCKET_BATCH_IOVEC];
+        struct iovec     *iov     = NULL;
+        int               count   = 0;
+        int               batched = 0;
+        size_t            bytes   = 0;
+        size_t            len     = 0;
+        int               ret     = -1;
+
+        priv = this->private;
+
+        list_for_each_entry (entry, &priv->ioq, list) {
+                if (count + entry->pending_count > SOCKET_BATCH_IOVEC)
+                        break;
+
+                memcpy (&vector[count], entry->pending_vector,
+                        sizeof (struct iovec) * entry->pending_count);
+                count += entry->pending_count;
+                batched++;
+        }
+
+        ret = __socket_rwv (this, vector, count, NULL, NULL, &bytes, 1);
+
+        list_for_each_entry_safe (entry, tmp, &priv->ioq, list) {
+                if (!batched--)
+                        break;
+
+                len = iov_length (entry->pending_vector, entry->pending_count);
+                if (bytes >= len) {
+                        bytes -= len;
+                        entry->pending_count = 0;
+                        __socket_ioq_entry_done (this, entry, 0);
+                        continue;
+                }
+
+                /* partially written, move past what went out */
+                iov = entry->pending_vector;
+                while (bytes && bytes >= iov->iov_len) {
+                        bytes -= iov->iov_len;
+                        iov++;
+                        entry->pending_count--;
+                }
+                iov->iov_base += bytes;
+                iov->iov_len  -= bytes;
+                entry->pending_vector = iov;
+
+                /* an error still fails the whole queue */
+                if (ret != -1)
+                        ret = 1;
+                break;
         }
 
         return ret;
@@ -1162,7 +1382,10 @@ __socket_ioq_churn (rpc_transport_t *this)
                 /* pick next entry */
                 entry = priv->ioq_next;
 
-                ret = __socket_ioq_churn_entry (this, entry, 0);
+                if (entry->list.next == &priv->ioq)
+                        ret = __socket_ioq_churn_entry (this, entry, 0);
+                else
+                        ret = __socket_ioq_churn_batch (this);
 
                 if (ret != 0)
                         break;
@@ -2275,12 +2498,25 @@ static int
 socket_event_poll_in (rpc_transport_t *this)
 {
         int                     ret    = -1;
+        int                     failed = 0;
         rpc_transport_pollin_t *pollin = NULL;
         socket_private_t       *priv = this->private;
 
-	ret = socket_proto_state_machine (this, &pollin);
+        /* records already sitting in the receive buffer will not raise
+         * another poll event, hand all of them up now. They have been
+         * taken off the wire, so a failed notify does not drop the ones
+         * behind it: they are still delivered and the failure is
+         * returned once the buffer is drained. */
+        do {
+                pollin = NULL;
+
+                ret = socket_proto_state_machine (this, &pollin);
+
+                if (!pollin)
+                        break;
+
+                this->total_msgs_read++;
 
-	if (pollin) {
                 priv->ot_state = OT_CALLBACK;
                 ret = rpc_transport_notify (this, RPC_TRANSPORT_MSG_RECEIVED,
                                             pollin);
@@ -2288,9 +2524,13 @@ socket_event_poll_in (rpc_transport_t *this)
                         priv->ot_state = OT_RUNNING;
                 }
                 rpc_transport_pollin_destroy (pollin);
-        }
 
-        return ret;
+                if ((ret < 0) && !failed)
+                        failed = ret;
+        } while ((priv->ot_state != OT_PLEASE_DIE) &&
+                 socket_input_pending (priv));
+
+        return failed ? failed : ret;
 }
 
 
@@ -2746,8 +2986,12 @@ socket_server_event_handler (int fd, int idx, void *data,
 
 			new_priv->sock = new_sock;
 			new_priv->own_thread = priv->own_thread;
+                        new_priv->rcvbuf_size = priv->rcvbuf_size;
 
                         new_priv->ssl_ctx = priv->ssl_ctx;
+                        /* the context already has kTLS enabled, the flag
+                         * tells the connection to look for it */
+                        new_priv->ssl_ktls = priv->ssl_ktls;
 			if (new_priv->use_ssl && !new_priv->own_thread) {
 				cname = ssl_setup_connection(new_trans,1);
                                 if (!cname) {
@@ -3798,6 +4042,9 @@ socket_init (rpc_transport_t *this)
         priv->nodelay = 1;
         priv->bio = 0;
         priv->windowsize = GF_DEFAULT_SOCKET_WINDOW_SIZE;
+        /* accepted transports have no options, the listener passes its
+         * own value on */
+        priv->rcvbuf_size = GF_SOCKET_READ_BATCH_SIZE;
         INIT_LIST_HEAD (&priv->ioq);
 
         /* All the below section needs 'this->options' to be present */
@@ -3897,6 +4144,18 @@ socket_init (rpc_transport_t *this)
                 priv->backlog = backlog;
         }
 
+        optstr = NULL;
+
+        if (dict_get_str (this->options, "transport.socket.read-batch-size",
+                          &optstr) == 0) {
+                if (gf_string2bytesize_size (optstr,
+                                             &priv->rcvbuf_size) != 0) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "invalid number format: %s", optstr);
+                        return -1;
+                }
+        }
+
         optstr = NULL;
 
          /* Check if socket read failures are to be logged */
@@ -3982,6 +4241,23 @@ socket_init (rpc_transport_t *this)
                "using %s polling thread",
 	       priv->own_thread ? "private" : "system");
 
+        if (dict_get_str (this->options, SSL_KTLS_OPT, &optstr) == 0) {
+                if (gf_string2boolean (optstr, &priv->ssl_ktls) != 0) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "invalid value given for %s boolean",
+                                SSL_KTLS_OPT);
+                        priv->ssl_ktls = _gf_false;
+                }
+#ifndef SSL_OP_ENABLE_KTLS
+                if (priv->ssl_ktls) {
+                        gf_log (this->name, GF_LOG_WARNING,
+                                "%s set but OpenSSL has no kernel TLS "
+                                "support (ignored)", SSL_KTLS_OPT);
+                        priv->ssl_ktls = _gf_false;
+                }
+#endif
+        }
+
         if (!dict_get_int32 (this->options, "ssl-cert-depth", &cert_depth)) {
                 gf_log (this->name, GF_LOG_INFO,
                         "using certificate depth %d", cert_depth);
@@ -4050,6 +4326,19 @@ socket_init (rpc_transport_t *this)
 					       sizeof(priv->ssl_session_id));
 
 		SSL_CTX_set_verify(priv->ssl_ctx,SSL_VERIFY_PEER,0);
+
+                /*
+                 * With kernel TLS the kernel does the record work and
+                 * OpenSSL must read records one at a time; otherwise let
+                 * OpenSSL pull in as much as the socket has per read.
+                 */
+#ifdef SSL_OP_ENABLE_KTLS
+                if (priv->ssl_ktls)
+                        SSL_CTX_set_options (priv->ssl_ctx,
+                                             SSL_OP_ENABLE_KTLS);
+                else
+#endif
+                        SSL_CTX_set_read_ahead (priv->ssl_ctx, 1);
 	}
 
         if (priv->own_thread) {
@@ -4097,6 +4386,8 @@ fini (rpc_transport_t *this)
                         "transport %p destroyed", this);
 
                 pthread_mutex_destroy (&priv->lock);
+                GF_FREE (priv->rcvbuf);
+                GF_FREE (priv->ssl_wbuf);
 		if (priv->ssl_private_key) {
 			GF_FREE(priv->ssl_private_key);
 		}
@@ -4185,6 +4476,14 @@ struct volume_options options[] = {
         { .key   = {"transport.socket.read-fail-log"},
           .type  = GF_OPTION_TYPE_BOOL
         },
+        { .key   = {"transport.socket.read-batch-size"},
+          .type  = GF_OPTION_TYPE_SIZET,
+          .min   = 0,
+          .max   = GF_SOCKET_READ_BATCH_SIZE_MAX,
+          .description = "Size of the per-connection receive buffer that "
+                         "picks up several small RPC records with a single "
+                         "read. 0 reads every record separately."
+        },
         { .key   = {SSL_ENABLED_OPT},
           .type  = GF_OPTION_TYPE_BOOL
         },
@@ -4200,6 +4499,13 @@ struct volume_options options[] = {
 	{ .key   = {OWN_THREAD_OPT},
 	  .type  = GF_OPTION_TYPE_BOOL
 	},
+        { .key   = {SSL_KTLS_OPT},
+          .type  = GF_OPTION_TYPE_BOOL,
+          .description = "Hand the negotiated TLS session to the kernel "
+                         "(kTLS) where OpenSSL and the kernel support it, "
+                         "so that messages are sent with plain writev(). "
+                         "Ignored if SSL is not enabled."
+        },
         { .key = {"ssl-cert-depth"},
           .type = GF_OPTION_TYPE_INT,
           .description = "Maximum certificate-chain depth.  If zero, the "
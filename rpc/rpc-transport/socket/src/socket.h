@@ -25,6 +25,23 @@
 #define MAX_IOVEC 16
 #endif /* MAX_IOVEC */
 
+/* largest plaintext an SSL record carries, small iovecs are coalesced
+ * up to this size before SSL_write */
+#define SOCKET_SSL_RECORD_SIZE SSL3_RT_MAX_PLAIN_LENGTH
+
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+#define SSL_HAS_PENDING(ssl) SSL_has_pending (ssl)
+#else
+#define SSL_HAS_PENDING(ssl) (SSL_pending (ssl) > 0)
+#endif
+
+/* upper bound on the iovecs gathered from queued messages in one writev */
+#ifdef IOV_MAX
+#define SOCKET_BATCH_IOVEC (IOV_MAX < 1024 ? IOV_MAX : 1024)
+#else
+#define SOCKET_BATCH_IOVEC 1024
+#endif
+
 #define GF_DEFAULT_SOCKET_LISTEN_PORT  GF_DEFAULT_BASE_PORT
 
 #define RPC_MAX_FRAGMENT_SIZE 0x7fffffff
@@ -156,6 +173,9 @@ struct gf_sock_incoming_frag {
 
 #define GF_SOCKET_RA_MAX 1024
 
+#define GF_SOCKET_READ_BATCH_SIZE     (64 * GF_UNIT_KB)
+#define GF_SOCKET_READ_BATCH_SIZE_MAX (1 * GF_UNIT_MB)
+
 struct gf_sock_incoming {
         sp_rpcrecord_state_t  record_state;
         struct gf_sock_incoming_frag frag;
@@ -229,9 +249,17 @@ typedef struct {
 	pthread_t              thread;
 	int                    pipe[2];
 	gf_boolean_t           own_thread;
+        gf_boolean_t           ssl_ktls;        /* kTLS requested */
+        gf_boolean_t           ktls_tx;         /* kernel encrypts sends */
+        char                  *ssl_wbuf;        /* SSL record staging */
         ot_state_t             ot_state;
         uint32_t               ot_gen;
         gf_boolean_t           is_server;
+        /* receive buffer, holds data read past the current record */
+        char                  *rcvbuf;
+        size_t                 rcvbuf_size;
+        size_t                 rcvbuf_head;
+        size_t                 rcvbuf_tail;
 } socket_private_t;
 
 
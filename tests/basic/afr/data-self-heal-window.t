@@ -0,0 +1,48 @@
+#!/bin/bash
+#Test data self-heal with several blocks in flight.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+cleanup;
+
+function data_healed_into_brick1 {
+        $CLI volume heal $V0 statistics | \
+                grep -A2 "brick no 1" | \
+                awk '/Data healed into brick/ {print ($5 > 0) ? "Y" : "N"}'
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/brick{0,1}
+TEST $CLI volume set $V0 cluster.data-self-heal-algorithm diff
+TEST $CLI volume set $V0 cluster.data-self-heal-window-size 16
+TEST $CLI volume set $V0 cluster.data-self-heal off
+TEST $CLI volume set $V0 cluster.metadata-self-heal off
+TEST $CLI volume set $V0 cluster.entry-self-heal off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=16
+TEST kill_brick $V0 $H0 $B0/brick1
+# change every other block, the rest must match by checksum
+for i in {0..127..2}; do
+        dd if=/dev/urandom of=$M0/file bs=128k count=1 seek=$i \
+           conv=notrunc 2>/dev/null
+done
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=1 seek=16 conv=notrunc
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+
+TEST cmp $B0/brick0/file $B0/brick1/file
+EXPECT "Y" data_healed_into_brick1
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,69 @@
+#!/bin/bash
+#Test that reads are spread over the bricks by their measured latency.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function child_read_samples {
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a "child_latency\[$1\].samples" $fpath | cut -f2 -d'='
+        cleanup_mount_statedump $V0
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/brick{0,1}
+TEST $CLI volume set $V0 self-heal-daemon off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+# all bricks are local here, which would otherwise always win
+TEST $CLI volume set $V0 cluster.choose-local off
+TEST $CLI volume set $V0 cluster.read-hash-mode 3
+TEST $CLI volume set $V0 cluster.read-hedge on
+TEST ! $CLI volume set $V0 cluster.read-hash-mode 4
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0 --direct-io-mode=yes
+
+TEST dd if=/dev/urandom of=$M0/file bs=128k count=8
+for i in {1..200}; do
+        dd if=$M0/file of=/dev/null bs=128k count=8 2>/dev/null
+done
+TEST cmp $M0/file $B0/brick0/file
+
+TEST [ "$(child_read_samples 0)" -gt 0 ]
+TEST [ "$(child_read_samples 1)" -gt 0 ]
+
+# stall brick0 with reads in flight: its latency shoots up and the reads
+# that follow go to brick1
+brick0_pid=$(get_brick_pid $V0 $H0 $B0/brick0)
+(for i in {1..20}; do
+        dd if=$M0/file of=/dev/null bs=128k count=8 2>/dev/null
+done) &
+reader=$!
+TEST kill -STOP $brick0_pid
+sleep 3
+TEST kill -CONT $brick0_pid
+wait $reader
+
+samples0=$(child_read_samples 0)
+samples1=$(child_read_samples 1)
+for i in {1..100}; do
+        dd if=$M0/file of=/dev/null bs=128k count=8 2>/dev/null
+done
+reads0=$(( $(child_read_samples 0) - samples0 ))
+reads1=$(( $(child_read_samples 1) - samples1 ))
+TEST [ $reads1 -gt $(( 10 * reads0 )) ]
+
+# reads still work with one of the bricks gone
+TEST kill_brick $V0 $H0 $B0/brick0
+TEST cmp $M0/file $B0/brick1/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
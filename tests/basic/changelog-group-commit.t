@@ -0,0 +1,52 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../changelog.rc
+
+function count_created {
+        cat $B0/${V0}1/.glusterfs/changelogs/CHANGELOG* | \
+                grep -a -o "/gc[0-9]*" | sort -u | wc -l
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}1
+TEST $CLI volume set $V0 changelog.encoding ascii
+TEST $CLI volume set $V0 changelog.journal-commit-delay 100
+TEST $CLI volume start $V0
+TEST $CLI volume set $V0 changelog.changelog on
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# records of concurrent creates share writes to the changelog
+for i in {1..100}; do
+        echo $i > $M0/gc$i &
+done
+wait
+
+# and every one of them is there once the fops have returned
+TEST $CLI volume set $V0 changelog.rollover-time 1
+EXPECT_WITHIN 10 "100" count_created
+
+# write each record on its own
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume set $V0 changelog.journal-buffer-size 0
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" online_brick_count
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+for i in {101..120}; do
+        echo $i > $M0/gc$i
+done
+EXPECT_WITHIN 10 "120" count_created
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
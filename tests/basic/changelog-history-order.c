@@ -0,0 +1,63 @@
+/*
+ * Consume the history of a brick's changelogs between two timestamps,
+ * logging at debug level to the given log file.
+ *
+ * usage: changelog-history-order <brick> <scratch-dir> <log-file>
+ *                                <start> <end>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+#include "changelog.h"
+
+int
+main (int argc, char **argv)
+{
+        char          cl_dir[PATH_MAX] = {0,};
+        char          fbuf[PATH_MAX]   = {0,};
+        unsigned long end_ts           = 0;
+        ssize_t       nr_changes       = 0;
+        int           consumed         = 0;
+        int           ret              = 0;
+
+        if (argc != 6) {
+                fprintf (stderr, "usage: %s <brick> <scratch-dir> "
+                         "<log-file> <start> <end>\n", argv[0]);
+                return 1;
+        }
+
+        ret = gf_changelog_register (argv[1], argv[2], argv[3], 8, 5);
+        if (ret) {
+                fprintf (stderr, "register failed: %s\n", strerror (errno));
+                return 1;
+        }
+
+        snprintf (cl_dir, sizeof (cl_dir), "%s/.glusterfs/changelogs",
+                  argv[1]);
+        ret = gf_history_changelog (cl_dir, strtoul (argv[4], NULL, 10),
+                                    strtoul (argv[5], NULL, 10), 5, &end_ts);
+        if (ret == -1) {
+                fprintf (stderr, "history failed: %s\n", strerror (errno));
+                return 1;
+        }
+
+        /* scanning returns 0 once every changelog is published */
+        while ((nr_changes = gf_history_changelog_scan ()) > 0) {
+                while (gf_history_changelog_next_change (fbuf,
+                                                         PATH_MAX) > 0) {
+                        gf_history_changelog_done (fbuf);
+                        consumed++;
+                }
+        }
+        if (nr_changes < 0) {
+                fprintf (stderr, "scan failed: %s\n", strerror (errno));
+                return 1;
+        }
+
+        printf ("%d\n", consumed);
+        return 0;
+}
@@ -0,0 +1,62 @@
+#!/bin/bash
+# History changelogs parsed by several threads are published in order
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../changelog.rc
+
+HISTORY_LOG=/tmp/changelog-history-order.log
+HISTORY_SCRATCH=/tmp/changelog-history-order
+
+# timestamps of the changelogs in the order they were published
+function published {
+        grep -a -o "published .*CHANGELOG\.[0-9]*" $HISTORY_LOG | \
+                grep -o "[0-9]*$"
+}
+
+function published_in_order {
+        published | sort -n -c
+}
+
+cleanup;
+rm -rf $HISTORY_LOG $HISTORY_SCRATCH
+
+TEST build_tester $(dirname $0)/changelog-history-order.c \
+        $(pkg-config --cflags --libs libgfchangelog)
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}1
+TEST $CLI volume set $V0 changelog.rollover-time 1
+TEST $CLI volume start $V0
+TEST $CLI volume set $V0 changelog.changelog on
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# a changelog or so for every second of changes, more than there are
+# parsing threads
+start=$(date +%s)
+for i in {1..20}; do
+        for j in {1..10}; do
+                echo $i > $M0/f$i.$j
+        done
+        sleep 1
+done
+sleep 2
+end=$(date +%s)
+
+mkdir -p $HISTORY_SCRATCH
+TEST $(dirname $0)/changelog-history-order $B0/${V0}1 $HISTORY_SCRATCH \
+        $HISTORY_LOG $start $end
+
+TEST [ "$(published | wc -l)" -ge 10 ]
+TEST published_in_order
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+rm -f $(dirname $0)/changelog-history-order
+rm -rf $HISTORY_LOG $HISTORY_SCRATCH
+cleanup;
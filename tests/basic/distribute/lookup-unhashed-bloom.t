@@ -0,0 +1,77 @@
+#!/bin/bash
+# Lookups of missing names skip the bricks whose name filter rules them out,
+# but never a brick where the name turned up after the filter was cached
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function bloom_counter {
+        local fpath=$(generate_mount_statedump $V0)
+        grep -a "lookup_bloom.$1" $fpath | head -1 | cut -f2 -d'='
+        cleanup_mount_statedump $V0
+}
+
+MISSING=0
+function bloom_skips_missing {
+        MISSING=$((MISSING + 1))
+        stat $M0/dir/missing$MISSING 2>/dev/null
+        if [ "$(bloom_counter hits)" -gt 0 ]; then
+                echo "Y"
+        else
+                echo "N"
+        fi
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..3}
+TEST $CLI volume set $V0 cluster.lookup-unhashed on
+TEST $CLI volume set $V0 cluster.lookup-unhashed-bloom on
+TEST $CLI volume set $V0 storage.name-bloom-refresh-interval 1
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0 \
+        --entry-timeout=0 --attribute-timeout=0
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M1 \
+        --entry-timeout=0 --attribute-timeout=0
+
+TEST mkdir $M0/dir
+for i in {1..50}; do
+        echo $i > $M0/dir/file$i
+done
+
+# the bricks build the filters in the background once the directory has
+# settled, and hand them out with the following lookups
+EXPECT_WITHIN 20 "Y" bloom_skips_missing
+
+# names that do exist are still found
+EXPECT "50" echo $(ls $M0/dir | wc -l)
+TEST [ "$(cat $M0/dir/file{1..50} | wc -l)" -eq 50 ]
+
+# From the other mount, move a file to a name hashed to another brick and
+# remove the link file left on that brick, so that the name is only on a
+# brick whose filter, as $M0 cached it, does not have it.
+moved=""
+for i in {1..50}; do
+        mv $M1/dir/file$i $M1/dir/moved$i
+        linkto=$(find $B0/${V0}{0..3}/dir -name moved$i -perm -1000 -size 0)
+        if [ -n "$linkto" ]; then
+                moved=moved$i
+                break
+        fi
+done
+TEST [ -n "$moved" ]
+TEST rm -f $linkto
+
+TEST stat $M0/dir/$moved
+EXPECT "$i" cat $M0/dir/$moved
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+function dirs_with_layout {
+        find $B0/${V0}1 -path $B0/${V0}1/.glusterfs -prune -o -type d \
+             -exec getfattr -n trusted.glusterfs.dht -e hex {} \; 2>/dev/null \
+             | grep -c "^trusted.glusterfs.dht="
+}
+
+function dirs_with_checkpoint {
+        find $B0/${V0}0 -path $B0/${V0}0/.glusterfs -prune -o -type d \
+             -exec getfattr -d -m "trusted.glusterfs.dht.crawled" {} \; \
+             2>/dev/null | grep -c "^trusted.glusterfs.dht.crawled"
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 cluster.rebal-crawl-threads 4
+TEST ! $CLI volume set $V0 cluster.rebal-crawl-threads 9
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+# 4 top level directories, 4 below each and 4 below those: 84 in all
+for i in {1..4}; do
+        for j in {1..4}; do
+                for k in {1..4}; do
+                        TEST mkdir -p $M0/d$i/d$j/d$k
+                        for f in {1..5}; do
+                                echo $i$j$k$f > $M0/d$i/d$j/d$k/f$f
+                        done
+                done
+        done
+done
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}1
+TEST $CLI volume rebalance $V0 start
+EXPECT_WITHIN $REBALANCE_TIMEOUT "0" rebalance_completed
+
+# every directory got its layout from one of the crawl tasks, and the
+# checkpoints of the finished run are gone
+EXPECT "85" dirs_with_layout
+EXPECT "0" dirs_with_checkpoint
+
+for i in {1..4}; do
+        for j in {1..4}; do
+                for k in {1..4}; do
+                        for f in {1..5}; do
+                                EXPECT "$i$j$k$f" cat $M0/d$i/d$j/d$k/f$f
+                        done
+                done
+        done
+done
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
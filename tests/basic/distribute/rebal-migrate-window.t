@@ -0,0 +1,49 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../dht.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 cluster.rebal-migrate-window 8
+TEST $CLI volume set $V0 cluster.rebal-block-size 64KB
+TEST ! $CLI volume set $V0 cluster.rebal-migrate-window 0
+TEST ! $CLI volume set $V0 cluster.rebal-block-size 2MB
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST mkdir $M0/dir
+for i in {1..20}; do
+        TEST dd if=/dev/urandom of=$M0/dir/file$i bs=64k count=$i
+done
+# a sparse file, whose holes must survive the migration
+TEST dd if=/dev/urandom of=$M0/dir/sparse bs=64k count=1 seek=100
+TEST dd if=/dev/urandom of=$M0/dir/sparse bs=64k count=1 seek=10 conv=notrunc
+
+for f in $M0/dir/*; do
+        md5sum $f >> $B0/md5sums
+done
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}1
+TEST $CLI volume rebalance $V0 start force
+EXPECT_WITHIN $REBALANCE_TIMEOUT "0" rebalance_completed
+
+TEST md5sum -c --quiet $B0/md5sums
+
+# the sparse file keeps its holes wherever it lands
+EXPECT "Y" echo $(for b in $B0/${V0}0 $B0/${V0}1; do
+        [ -s $b/dir/sparse ] && \
+        [ $(du -k $b/dir/sparse | cut -f1) -lt 1024 ] && echo Y; done)
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+rm -f $B0/md5sums
+
+cleanup;
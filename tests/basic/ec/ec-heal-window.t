@@ -0,0 +1,51 @@
+#!/bin/bash
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+# Checks that data heal with a non-default block and window size rebuilds
+# files correctly, from both the mount and the self-heal daemon
+
+# bricks whose self-heal daemon sweep progress "volume heal" reports
+function heal_progress_count {
+        $CLI volume heal $V0 | grep -c "^Progress: \(last\|running\) sweep: [0-9]* files, [0-9]* KB rebuilt at [0-9]* KB/s$"
+}
+
+cleanup
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 disperse.heal-block-size 64KB
+TEST $CLI volume set $V0 disperse.self-heal-window-size 8
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "65536" mount_get_option_value $M0 $V0-disperse-0 heal-block-size
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "8" mount_get_option_value $M0 $V0-disperse-0 self-heal-window-size
+
+TEST kill_brick $V0 $H0 $B0/${V0}2
+TEST dd if=/dev/urandom of=$M0/a bs=1M count=5
+TEST dd if=/dev/urandom of=$M0/b bs=1000 count=777
+md5a=$(md5sum $M0/a | awk '{print $1}')
+md5b=$(md5sum $M0/b | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+EXPECT "3" heal_progress_count
+
+# the rebuilt fragments alone must give back the data
+TEST kill_brick $V0 $H0 $B0/${V0}0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "2" ec_child_up_count $V0 0
+EXPECT "$md5a" echo $(md5sum $M0/a | awk '{print $1}')
+EXPECT "$md5b" echo $(md5sum $M0/b | awk '{print $1}')
+
+cleanup
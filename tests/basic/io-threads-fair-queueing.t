@@ -0,0 +1,40 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function iot_client_count {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "client\[[0-9]*\].client_uid" $fpath | grep -vc "<none>"
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-thread-fair-queueing on
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M1
+
+TEST dd if=/dev/zero of=$M0/file0 bs=1M count=8 conv=fsync
+TEST dd if=/dev/zero of=$M1/file1 bs=1M count=8 conv=fsync
+TEST cmp $M0/file1 $M1/file0
+
+EXPECT "2" iot_client_count
+
+# requests are still served after switching back to a single queue
+TEST $CLI volume set $V0 performance.io-thread-fair-queueing off
+TEST dd if=/dev/zero of=$M0/file2 bs=1M count=8 conv=fsync
+TEST cmp $M1/file2 $M0/file0
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,39 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function iot_queue_count {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a -c "queue\[[0-9]*\].queue_size" $fpath
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-thread-queue-count 4
+TEST $CLI volume set $V0 performance.io-thread-fair-queueing on
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+EXPECT "4" iot_queue_count
+
+for i in {1..8}; do
+        dd if=/dev/zero of=$M0/file$i bs=1M count=4 conv=fsync 2>/dev/null &
+done
+wait
+
+for i in {2..8}; do
+        TEST cmp $M0/file1 $M0/file$i
+done
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,45 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function readdirp_fill_count {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "readdirp_fill_count" $fpath | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 storage.readdirp-fill-threads 4
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0 \
+        --entry-timeout=0 --attribute-timeout=0 --use-readdirp=yes
+
+TEST mkdir $M0/dir
+for i in {1..200}; do
+        echo $i > $M0/dir/file$i
+done
+TEST mkdir $M0/dir/subdir
+
+# sizes are filled in from the brick by readdirp
+EXPECT "201" echo $(ls -l $M0/dir | grep -c "^[-d]")
+EXPECT "200" echo $(ls -l $M0/dir | awk '$5 == 2 || $5 == 3 || $5 == 4' | wc -l)
+
+# shrink the pool and make sure entries are still filled serially
+TEST $CLI volume set $V0 storage.readdirp-fill-threads 0
+EXPECT "201" echo $(ls -l $M0/dir | grep -c "^[-d]")
+
+TEST [ "$(readdirp_fill_count)" -gt 0 ]
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
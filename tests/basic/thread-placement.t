@@ -0,0 +1,42 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_placement {
+        local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+        grep -a "^$1=" $fpath | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume start $V0
+
+EXPECT "none" brick_placement event_pool.placement
+
+TEST ! $CLI volume set $V0 server.event-thread-placement somewhere
+TEST ! $CLI volume set $V0 performance.io-thread-placement cpus:1-
+TEST ! $CLI volume set $V0 client.event-thread-placement node:x
+
+TEST $CLI volume set $V0 server.event-thread-placement spread
+TEST $CLI volume set $V0 performance.io-thread-placement cpus:0
+TEST $CLI volume set $V0 client.event-thread-placement nodes
+
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "spread" brick_placement event_pool.placement
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "cpus:0" brick_placement thread_placement
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/zero of=$M0/file bs=1M count=4 conv=fsync
+EXPECT "4194304" stat -c %s $M0/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,63 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+SLEEP_TIME=2
+
+# signature type is the first byte of the signature xattr
+function signature_type {
+        getfattr -e hex -n trusted.bit-rot.signature $1 2>/dev/null | \
+                grep "^trusted.bit-rot.signature" | cut -c 29-30
+}
+
+# the last chunk the scrubber reported as not matching its signature
+function reported_chunk {
+        grep -a -o "Chunk [0-9]* \[offset [0-9]*, [0-9]* bytes\] of object" \
+                $SCRUB_LOG | tail -1 | cut -d ' ' -f 2
+}
+
+function bad_file_marked {
+        getfattr -n trusted.bit-rot.bad-file $1 >/dev/null 2>&1 && echo "Y"
+}
+
+cleanup;
+
+SCRUB_LOG=$(gluster --print-logdir)/scrub.log
+rm -f $SCRUB_LOG
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume start $V0
+
+TEST $CLI volume bitrot $V0 enable
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" get_bitd_count
+TEST $CLI volume bitrot $V0 signing-time $SLEEP_TIME
+
+# objects of 1MB and more are signed in chunks
+TEST $CLI volume set $V0 features.chunked-sign-threshold 1MB
+
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+
+TEST dd if=/dev/urandom of=$M0/big bs=1M count=8
+echo "small" > $M0/small
+
+EXPECT_WITHIN $(($SLEEP_TIME * 10)) "02" signature_type $B0/${V0}0/big
+EXPECT_WITHIN $(($SLEEP_TIME * 10)) "01" signature_type $B0/${V0}0/small
+
+# corrupt the fourth 1MB chunk behind the stub's back, the scrubber (run
+# every 10 seconds through the debug interval) has to point at that chunk
+TEST dd if=/dev/urandom of=$B0/${V0}0/big bs=1M count=1 seek=3 conv=notrunc
+TEST $CLI volume set $V0 features.scrub-debug-interval 10
+
+EXPECT_WITHIN 60 "Y" bad_file_marked $B0/${V0}0/big
+EXPECT "3" reported_chunk
+TEST ! bad_file_marked $B0/${V0}0/small
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# many disjoint byte-range locks held by one process, conflicts checked
+# from another process on the same mount
+function range_locks {
+        python - $1 <<EOF
+import fcntl, os, sys, time
+
+fd = os.open(sys.argv[1], os.O_RDWR)
+for i in range(0, 2000):
+        fcntl.lockf(fd, fcntl.LOCK_EX, 10, i * 20)
+
+pid = os.fork()
+if pid == 0:
+        f2 = os.open(sys.argv[1], os.O_RDWR)
+        ok = 0
+        # gaps between the locks are free
+        for i in range(0, 2000):
+                fcntl.lockf(f2, fcntl.LOCK_EX | fcntl.LOCK_NB, 10, i * 20 + 10)
+                ok += 1
+        # locked ranges conflict
+        for i in (0, 999, 1999):
+                try:
+                        fcntl.lockf(f2, fcntl.LOCK_EX | fcntl.LOCK_NB, 1, i * 20 + 5)
+                except IOError:
+                        ok += 1
+        # waits till the parent drops the lock
+        fcntl.lockf(f2, fcntl.LOCK_EX, 10, 500 * 20)
+        os._exit(0 if ok == 2003 else 1)
+
+time.sleep(2)
+fcntl.lockf(fd, fcntl.LOCK_UN, 10, 500 * 20)
+(_, status) = os.waitpid(pid, 0)
+print("Y" if status == 0 else "N")
+EOF
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume start $V0
+
+TEST glusterfs --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST touch $M0/file
+EXPECT "Y" range_locks $M0/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
@@ -0,0 +1,66 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# two mounts on the host configured with the same shared cache: pages
+# one of them read are served to the other, and never once overwritten
+
+function ioc_stat {
+        mount_get_option_value $1 $V0-io-cache $2
+}
+
+SHM=/dev/shm/$V0-io-cache
+
+cleanup;
+rm -f $SHM
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.shared-cache $SHM
+TEST $CLI volume set $V0 performance.shared-cache-size 64MB
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.cache-refresh-timeout 1
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=8
+TEST cp $B0/data $M0/file
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+
+EXPECT "$SHM" ioc_stat $M0 shared_cache
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M0/file)"
+TEST [ $(ioc_stat $M0 shared_stores) -gt 0 ]
+
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M1/file)"
+TEST [ $(ioc_stat $M1 shared_hits) -gt 0 ]
+
+# a write through one mount must not let the other see old pages
+TEST dd if=/dev/urandom of=$B0/data bs=128k count=1 conv=notrunc
+TEST dd if=$B0/data of=$M0/file bs=128k count=1 conv=notrunc
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M1/file)"
+
+# nor may a mount which validated the old mtime before the write have
+# the old pages it did not cache itself served from the shared cache
+# once its cache-timeout has passed
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M0/file)"
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+TEST dd if=$M1/file of=/dev/null bs=128k count=1
+TEST dd if=/dev/urandom of=$B0/data bs=128k count=1 seek=40 conv=notrunc
+TEST dd if=$B0/data of=$M0/file bs=128k count=1 skip=40 seek=40 conv=notrunc
+sleep 2
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M1/file)"
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M1
+
+rm -f $B0/data $SHM
+cleanup;
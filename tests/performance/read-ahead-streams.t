@@ -0,0 +1,61 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# interleaved sequential and strided reads on one fd must each be
+# recognized by read-ahead and still return the right data
+
+function strided_read {
+        python - $1 $2 <<EOF
+import os, sys
+
+src = open(sys.argv[1], "rb")
+dst = os.open(sys.argv[2], os.O_RDONLY)
+ok = True
+for i in range(0, 64):
+        # a sequential stream from the start and a strided one from 4MB
+        for off in (i * 4096, 4194304 + i * 65536):
+                src.seek(off)
+                if os.pread(dst, 4096, off) != src.read(4096):
+                        ok = False
+print("Y" if ok else "N")
+EOF
+}
+
+function ra_stat {
+        mount_get_option_value $M0 $V0-read-ahead $1
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+# two data bricks of 512 bytes each
+EXPECT "1024" ra_stat stripe_size
+
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=8
+TEST cp $B0/data $M0/file
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+EXPECT "Y" strided_read $B0/data $M0/file
+TEST [ $(ra_stat streams) -ge 2 ]
+TEST [ $(ra_stat hits) -gt 0 ]
+
+TEST dd if=$M0/file of=/dev/null bs=128k
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M0/file)"
+
+rm -f $B0/data
+cleanup;
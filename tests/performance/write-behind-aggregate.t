@@ -0,0 +1,41 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+# small sequential and overlapping writes put together by write-behind's
+# aggregate-writes mode must reach a disperse volume intact
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 disperse 3 redundancy 1 $H0:$B0/${V0}{0..2}
+TEST $CLI volume set $V0 performance.write-behind-aggregate-writes on
+TEST $CLI volume set $V0 performance.write-behind-aggregate-size 1MB
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+EXPECT "1" mount_get_option_value $M0 $V0-write-behind aggregate_writes
+EXPECT "1048576" mount_get_option_value $M0 $V0-write-behind aggregate_size
+# two data bricks of 512 bytes each
+EXPECT "1024" mount_get_option_value $M0 $V0-write-behind aggregate_align
+
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=8
+TEST dd if=$B0/data of=$M0/file bs=4k
+# rewrite parts of it, unaligned and overlapping
+TEST dd if=/dev/urandom of=$B0/patch bs=3000 count=100
+TEST dd if=$B0/patch of=$B0/data bs=3000 seek=7 conv=notrunc
+TEST dd if=$B0/patch of=$M0/file bs=3000 seek=7 conv=notrunc
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "3" ec_child_up_count $V0 0
+
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M0/file)"
+
+rm -f $B0/data $B0/patch
+cleanup;
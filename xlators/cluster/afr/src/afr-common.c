@@ -1066,6 +1066,151 @@ afr_hash_child (afr_read_subvol_args_t *args, int32_t child_count, int hashmode)
 }
 
 
+/* Pick the readable child (other than @skip) with the least expected
+   wait: its smoothed read latency times the reads it already has in
+   flight. Ties are broken round robin, so that children without samples
+   yet all get some. */
+int
+afr_least_loaded_child (xlator_t *this, unsigned char *readable, int skip)
+{
+        afr_private_t       *priv       = NULL;
+        afr_child_latency_t *lat        = NULL;
+        int                  i          = 0;
+        int                  child      = 0;
+        int                  start      = 0;
+        int                  best       = -1;
+        uint64_t             score      = 0;
+        uint64_t             best_score = 0;
+
+        priv = this->private;
+
+        start = __sync_fetch_and_add (&priv->read_rr, 1) % priv->child_count;
+
+        for (i = 0; i < priv->child_count; i++) {
+                child = (start + i) % priv->child_count;
+                if (!readable[child] || child == skip)
+                        continue;
+
+                lat = &priv->child_latency[child];
+                score = (uint64_t) (__sync_add_and_fetch (&lat->inflight, 0)
+                                    + 1) * (lat->ewma_usec + 1);
+                if (best == -1 || score < best_score) {
+                        best = child;
+                        best_score = score;
+                }
+        }
+
+        return best;
+}
+
+
+gf_boolean_t
+afr_read_latency_tracked (xlator_t *this)
+{
+        afr_private_t *priv = NULL;
+
+        priv = this->private;
+
+        return (priv->hash_mode == AFR_READ_HASH_LEAST_LOADED ||
+                priv->read_hedge);
+}
+
+
+/* a read is being sent to @child, afr_read_latency_end() must follow
+   for every call */
+void
+afr_read_latency_begin (xlator_t *this, int child, struct timeval *start)
+{
+        afr_private_t *priv = NULL;
+
+        priv = this->private;
+
+        __sync_add_and_fetch (&priv->child_latency[child].inflight, 1);
+        gettimeofday (start, NULL);
+}
+
+
+void
+afr_read_latency_end (xlator_t *this, int child, struct timeval *start)
+{
+        afr_private_t       *priv   = NULL;
+        afr_child_latency_t *lat    = NULL;
+        struct timeval       now    = {0, };
+        int64_t              usec   = 0;
+        int                  bucket = 0;
+        int                  i      = 0;
+
+        if (!timerisset (start))
+                return;
+
+        priv = this->private;
+        lat = &priv->child_latency[child];
+
+        gettimeofday (&now, NULL);
+        usec = (now.tv_sec - start->tv_sec) * 1000000 +
+                (now.tv_usec - start->tv_usec);
+        if (usec < 0)
+                usec = 0;
+
+        __sync_sub_and_fetch (&lat->inflight, 1);
+
+        while ((usec >> (bucket + 1)) &&
+               bucket < AFR_READ_LATENCY_BUCKETS - 1)
+                bucket++;
+
+        LOCK (&lat->lock);
+        {
+                /* alpha = 1/8, as for the smoothed rtt of tcp */
+                lat->ewma_usec += (usec - lat->ewma_usec) / 8;
+                lat->samples++;
+                lat->hist[bucket]++;
+                if (++lat->hist_total >= AFR_READ_LATENCY_WINDOW) {
+                        lat->hist_total = 0;
+                        for (i = 0; i < AFR_READ_LATENCY_BUCKETS; i++) {
+                                lat->hist[i] /= 2;
+                                lat->hist_total += lat->hist[i];
+                        }
+                }
+        }
+        UNLOCK (&lat->lock);
+}
+
+
+/* Upper bound of the 99th percentile of recent read latencies of @child,
+   0 while there are too few samples to tell. */
+uint64_t
+afr_read_latency_p99 (xlator_t *this, int child)
+{
+        afr_private_t       *priv  = NULL;
+        afr_child_latency_t *lat   = NULL;
+        uint32_t             tail  = 0;
+        uint32_t             seen  = 0;
+        uint64_t             p99   = 0;
+        int                  i     = 0;
+
+        priv = this->private;
+        lat = &priv->child_latency[child];
+
+        LOCK (&lat->lock);
+        {
+                if (lat->hist_total < AFR_READ_LATENCY_MIN_SAMPLES)
+                        goto unlock;
+
+                tail = lat->hist_total / 100;
+                for (i = AFR_READ_LATENCY_BUCKETS - 1; i > 0; i--) {
+                        seen += lat->hist[i];
+                        if (seen > tail)
+                                break;
+                }
+                p99 = 1ULL << (i + 1);
+        }
+unlock:
+        UNLOCK (&lat->lock);
+
+        return p99;
+}
+
+
 int
 afr_read_subvol_select_by_policy (inode_t *inode, xlator_t *this,
 				  unsigned char *readable,
@@ -1082,6 +1227,9 @@ afr_read_subvol_select_by_policy (inode_t *inode, xlator_t *this,
 	if (priv->read_child >= 0 && readable[priv->read_child])
                 return priv->read_child;
 
+        if (priv->hash_mode == AFR_READ_HASH_LEAST_LOADED)
+                return afr_least_loaded_child (this, readable, -1);
+
         if (inode_is_linked (inode)) {
                 gf_uuid_copy (local_args.gfid, inode->gfid);
                 local_args.ia_type = inode->ia_type;
@@ -1990,6 +2138,9 @@ afr_lookup_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
 	local = frame->local;
 
+        afr_read_latency_end (this, child_index,
+                              &local->cont.lookup.start);
+
 	local->replies[child_index].valid = 1;
 	local->replies[child_index].op_ret = op_ret;
 	local->replies[child_index].op_errno = op_errno;
@@ -2254,6 +2405,15 @@ afr_lookup_do (call_frame_t *frame, xlator_t *this, int err)
                 goto out;
         }
 
+        timerclear (&local->cont.lookup.start);
+        if (afr_read_latency_tracked (this)) {
+                for (i = 0; i < priv->child_count; i++) {
+                        if (local->child_up[i])
+                                afr_read_latency_begin (this, i,
+                                                &local->cont.lookup.start);
+                }
+        }
+
         for (i = 0; i < priv->child_count; i++) {
                 if (local->child_up[i]) {
                         STACK_WIND_COOKIE (frame, afr_lookup_cbk,
@@ -3842,6 +4002,25 @@ afr_priv_dump (xlator_t *this)
         gf_proc_dump_write("favorite_child", "%d", priv->favorite_child);
         gf_proc_dump_write("wait_count", "%u", priv->wait_count);
         gf_proc_dump_write("quorum-reads", "%d", priv->quorum_reads);
+        gf_proc_dump_write("read_hash_mode", "%u", priv->hash_mode);
+        gf_proc_dump_write("read_hedge", "%d", priv->read_hedge);
+        for (i = 0; priv->child_latency && i < priv->child_count; i++) {
+                sprintf (key, "child_latency[%d].ewma_usec", i);
+                gf_proc_dump_write(key, "%"PRId64,
+                                   priv->child_latency[i].ewma_usec);
+                sprintf (key, "child_latency[%d].p99_usec", i);
+                gf_proc_dump_write(key, "%"PRIu64,
+                                   afr_read_latency_p99 (this, i));
+                sprintf (key, "child_latency[%d].inflight", i);
+                gf_proc_dump_write(key, "%d",
+                                   priv->child_latency[i].inflight);
+                sprintf (key, "child_latency[%d].samples", i);
+                gf_proc_dump_write(key, "%"PRIu64,
+                                   priv->child_latency[i].samples);
+                sprintf (key, "child_latency[%d].hedged", i);
+                gf_proc_dump_write(key, "%"PRIu64,
+                                   priv->child_latency[i].hedged);
+        }
 
         return 0;
 }
@@ -4377,6 +4556,14 @@ afr_priv_destroy (afr_private_t *priv)
         GF_FREE (priv->pending_key);
         GF_FREE (priv->children);
         GF_FREE (priv->child_up);
+        if (priv->child_latency) {
+                for (i = 0; i < priv->child_count; i++)
+                        LOCK_DESTROY (&priv->child_latency[i].lock);
+                pthread_mutex_destroy (&priv->hedge.mutex);
+                pthread_cond_destroy (&priv->hedge.cond);
+        }
+        GF_FREE (priv->child_latency);
+        GF_FREE (priv->shd.data_heal);
         LOCK_DESTROY (&priv->lock);
 
         GF_FREE (priv);
@@ -1665,6 +1665,8 @@ afr_readv_cbk (call_frame_t *frame, void *cookie,
 
 	local = frame->local;
 
+        afr_read_latency_end (this, (long) cookie, &local->cont.readv.start);
+
 	if (op_ret < 0) {
 		local->op_ret = -1;
 		local->op_errno = op_errno;
@@ -1679,6 +1681,376 @@ afr_readv_cbk (call_frame_t *frame, void *cookie,
 }
 
 
+/*
+ * Hedged reads: the read goes to its child on a frame of its own, and if
+ * no reply came back within the recent p99 latency of that child, the
+ * same read is sent to the least loaded other readable child. The first
+ * good reply answers the read, the other one is dropped.
+ */
+
+typedef struct afr_read_hedge afr_read_hedge_t;
+
+typedef struct {
+        afr_read_hedge_t *hedge;
+        int               subvol;
+        struct timeval    start;
+} afr_read_hedge_wind_t;
+
+struct afr_read_hedge {
+        struct list_head       list;        /* in priv->hedge.pending */
+        struct timespec        deadline;
+        gf_lock_t              lock;
+        int                    refcount;
+        xlator_t              *this;
+        call_frame_t          *frame;       /* NULL once answered */
+        int                    pending;     /* winds without a reply */
+        gf_boolean_t           hedged;
+        fd_t                  *fd;
+        size_t                 size;
+        off_t                  offset;
+        uint32_t               flags;
+        dict_t                *xdata;
+        afr_read_hedge_wind_t  winds[2];
+};
+
+
+static void
+afr_read_hedge_unref (afr_read_hedge_t *hedge)
+{
+        int refcount = 0;
+
+        LOCK (&hedge->lock);
+        {
+                refcount = --hedge->refcount;
+        }
+        UNLOCK (&hedge->lock);
+
+        if (refcount)
+                return;
+
+        fd_unref (hedge->fd);
+        if (hedge->xdata)
+                dict_unref (hedge->xdata);
+        LOCK_DESTROY (&hedge->lock);
+        GF_FREE (hedge);
+}
+
+
+static void
+afr_read_hedge_dequeue (xlator_t *this, afr_read_hedge_t *hedge)
+{
+        afr_private_t *priv   = NULL;
+        gf_boolean_t   queued = _gf_false;
+
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->hedge.mutex);
+        {
+                if (!list_empty (&hedge->list)) {
+                        list_del_init (&hedge->list);
+                        queued = _gf_true;
+                }
+        }
+        pthread_mutex_unlock (&priv->hedge.mutex);
+
+        if (queued)
+                afr_read_hedge_unref (hedge);
+}
+
+
+int
+afr_readv_hedge_cbk (call_frame_t *frame, void *cookie,
+                     xlator_t *this, int32_t op_ret, int32_t op_errno,
+                     struct iovec *vector, int32_t count, struct iatt *buf,
+                     struct iobref *iobref, dict_t *xdata)
+{
+        afr_read_hedge_wind_t *wind       = NULL;
+        afr_read_hedge_t      *hedge      = NULL;
+        call_frame_t          *read_frame = NULL;
+	afr_local_t           *local      = NULL;
+
+        wind = cookie;
+        hedge = wind->hedge;
+
+        afr_read_latency_end (this, wind->subvol, &wind->start);
+
+        LOCK (&hedge->lock);
+        {
+                hedge->pending--;
+                if (hedge->frame && (op_ret >= 0 || !hedge->pending)) {
+                        read_frame = hedge->frame;
+                        hedge->frame = NULL;
+                }
+        }
+        UNLOCK (&hedge->lock);
+
+        if (read_frame) {
+                afr_read_hedge_dequeue (this, hedge);
+
+                if (op_ret >= 0) {
+                        AFR_STACK_UNWIND (readv, read_frame, op_ret,
+                                          op_errno, vector, count, buf,
+                                          iobref, xdata);
+                } else {
+                        local = read_frame->local;
+                        local->op_ret = -1;
+                        local->op_errno = op_errno;
+                        afr_read_txn_continue (read_frame, this,
+                                               wind->subvol);
+                }
+        }
+
+        STACK_DESTROY (frame->root);
+        afr_read_hedge_unref (hedge);
+
+        return 0;
+}
+
+
+static void
+afr_read_hedge_wind (afr_read_hedge_t *hedge, call_frame_t *frame, int n)
+{
+        afr_private_t         *priv = NULL;
+        afr_read_hedge_wind_t *wind = NULL;
+
+        priv = hedge->this->private;
+        wind = &hedge->winds[n];
+
+        afr_read_latency_begin (hedge->this, wind->subvol, &wind->start);
+
+        STACK_WIND_COOKIE (frame, afr_readv_hedge_cbk, wind,
+                           priv->children[wind->subvol],
+                           priv->children[wind->subvol]->fops->readv,
+                           hedge->fd, hedge->size, hedge->offset,
+                           hedge->flags, hedge->xdata);
+}
+
+
+/* the deadline of @hedge passed without a reply */
+static void
+afr_read_hedge_fire (afr_read_hedge_t *hedge)
+{
+        xlator_t      *this   = NULL;
+        afr_private_t *priv   = NULL;
+        afr_local_t   *local  = NULL;
+        call_frame_t  *frame  = NULL;
+        int            subvol = -1;
+        int            first  = 0;
+
+        this = hedge->this;
+        priv = this->private;
+        first = hedge->winds[0].subvol;
+
+        LOCK (&hedge->lock);
+        {
+                if (!hedge->frame || hedge->hedged)
+                        goto unlock;
+
+                local = hedge->frame->local;
+                subvol = afr_least_loaded_child (this, local->readable,
+                                                 first);
+                if (subvol < 0 || !local->child_up[subvol] ||
+                    local->read_attempted[subvol])
+                        goto unlock;
+
+                frame = copy_frame (hedge->frame);
+                if (!frame)
+                        goto unlock;
+
+                local->read_attempted[subvol] = 1;
+                hedge->hedged = _gf_true;
+                hedge->pending++;
+                hedge->refcount++;
+                hedge->winds[1].subvol = subvol;
+        }
+unlock:
+        UNLOCK (&hedge->lock);
+
+        if (frame) {
+                __sync_add_and_fetch (&priv->child_latency[first].hedged, 1);
+                afr_read_hedge_wind (hedge, frame, 1);
+        }
+}
+
+
+static void *
+afr_read_hedge_proc (void *data)
+{
+        xlator_t         *this  = NULL;
+        afr_private_t    *priv  = NULL;
+        afr_read_hedge_t *hedge = NULL;
+        struct timespec   now   = {0, };
+
+        this = data;
+        THIS = this;
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->hedge.mutex);
+        while (!priv->hedge.fini) {
+                if (list_empty (&priv->hedge.pending)) {
+                        pthread_cond_wait (&priv->hedge.cond,
+                                           &priv->hedge.mutex);
+                        continue;
+                }
+
+                hedge = list_entry (priv->hedge.pending.next,
+                                    afr_read_hedge_t, list);
+
+                clock_gettime (CLOCK_REALTIME, &now);
+                if (now.tv_sec < hedge->deadline.tv_sec ||
+                    (now.tv_sec == hedge->deadline.tv_sec &&
+                     now.tv_nsec < hedge->deadline.tv_nsec)) {
+                        pthread_cond_timedwait (&priv->hedge.cond,
+                                                &priv->hedge.mutex,
+                                                &hedge->deadline);
+                        continue;
+                }
+
+                list_del_init (&hedge->list);
+                pthread_mutex_unlock (&priv->hedge.mutex);
+
+                afr_read_hedge_fire (hedge);
+                afr_read_hedge_unref (hedge);
+
+                pthread_mutex_lock (&priv->hedge.mutex);
+        }
+        pthread_mutex_unlock (&priv->hedge.mutex);
+
+        return NULL;
+}
+
+
+static int
+afr_read_hedge_enqueue (xlator_t *this, afr_read_hedge_t *hedge,
+                        uint64_t usec)
+{
+        afr_private_t    *priv = NULL;
+        afr_read_hedge_t *tmp  = NULL;
+        int               ret  = 0;
+
+        priv = this->private;
+
+        /* the clock pthread_cond_timedwait() measures against */
+        clock_gettime (CLOCK_REALTIME, &hedge->deadline);
+        hedge->deadline.tv_sec += usec / 1000000;
+        hedge->deadline.tv_nsec += (usec % 1000000) * 1000;
+        if (hedge->deadline.tv_nsec >= 1000000000) {
+                hedge->deadline.tv_sec++;
+                hedge->deadline.tv_nsec -= 1000000000;
+        }
+
+        pthread_mutex_lock (&priv->hedge.mutex);
+        {
+                if (!priv->hedge.running) {
+                        ret = gf_thread_create (&priv->hedge.thread, NULL,
+                                                afr_read_hedge_proc, this);
+                        if (ret) {
+                                gf_msg (this->name, GF_LOG_WARNING, ret,
+                                        AFR_MSG_READ_HEDGE_FAILED,
+                                        "failed to start the read hedging "
+                                        "thread");
+                                goto unlock;
+                        }
+                        priv->hedge.running = _gf_true;
+                }
+
+                /* deadlines mostly come in order, look from the back */
+                list_for_each_entry_reverse (tmp, &priv->hedge.pending,
+                                             list) {
+                        if (tmp->deadline.tv_sec < hedge->deadline.tv_sec ||
+                            (tmp->deadline.tv_sec == hedge->deadline.tv_sec &&
+                             tmp->deadline.tv_nsec <=
+                             hedge->deadline.tv_nsec))
+                                break;
+                }
+                list_add (&hedge->list, &tmp->list);
+                if (priv->hedge.pending.next == &hedge->list)
+                        pthread_cond_signal (&priv->hedge.cond);
+        }
+unlock:
+        pthread_mutex_unlock (&priv->hedge.mutex);
+
+        return ret;
+}
+
+
+/* returns 0 if the read was sent, hedged */
+static int
+afr_readv_hedge (call_frame_t *frame, xlator_t *this, int subvol)
+{
+	afr_local_t      *local = NULL;
+	afr_private_t    *priv  = NULL;
+        afr_read_hedge_t *hedge = NULL;
+        call_frame_t     *first = NULL;
+        uint64_t          p99   = 0;
+
+	local = frame->local;
+	priv = this->private;
+
+        if (AFR_COUNT (local->readable, priv->child_count) < 2)
+                return -1;
+
+        p99 = afr_read_latency_p99 (this, subvol);
+        if (!p99)
+                return -1;
+
+        hedge = GF_CALLOC (1, sizeof (*hedge), gf_afr_mt_read_hedge_t);
+        if (!hedge)
+                return -1;
+
+        first = copy_frame (frame);
+        if (!first) {
+                GF_FREE (hedge);
+                return -1;
+        }
+
+        INIT_LIST_HEAD (&hedge->list);
+        LOCK_INIT (&hedge->lock);
+        hedge->this = this;
+        hedge->frame = frame;
+        hedge->fd = fd_ref (local->fd);
+        hedge->size = local->cont.readv.size;
+        hedge->offset = local->cont.readv.offset;
+        hedge->flags = local->cont.readv.flags;
+        if (local->xdata_req)
+                hedge->xdata = dict_ref (local->xdata_req);
+        hedge->winds[0].hedge = hedge;
+        hedge->winds[0].subvol = subvol;
+        hedge->winds[1].hedge = hedge;
+        hedge->pending = 1;
+        /* one for the first wind, one for the pending list */
+        hedge->refcount = 2;
+
+        if (afr_read_hedge_enqueue (this, hedge, p99))
+                hedge->refcount--;
+
+        afr_read_hedge_wind (hedge, first, 0);
+
+        return 0;
+}
+
+
+void
+afr_read_hedge_queue_fini (xlator_t *this)
+{
+        afr_private_t *priv = NULL;
+
+        priv = this->private;
+        if (!priv || !priv->hedge.running)
+                return;
+
+        pthread_mutex_lock (&priv->hedge.mutex);
+        {
+                priv->hedge.fini = _gf_true;
+                pthread_cond_signal (&priv->hedge.cond);
+        }
+        pthread_mutex_unlock (&priv->hedge.mutex);
+
+        pthread_join (priv->hedge.thread, NULL);
+        priv->hedge.running = _gf_false;
+}
+
+
 int
 afr_readv_wind (call_frame_t *frame, xlator_t *this, int subvol)
 {
@@ -1694,6 +2066,19 @@ afr_readv_wind (call_frame_t *frame, xlator_t *this, int subvol)
 		return 0;
 	}
 
+        /* only the first attempt is hedged, retries go the normal way */
+        if (priv->read_hedge && !local->cont.readv.hedged) {
+                local->cont.readv.hedged = _gf_true;
+                if (afr_readv_hedge (frame, this, subvol) == 0)
+                        return 0;
+        }
+
+        if (afr_read_latency_tracked (this))
+                afr_read_latency_begin (this, subvol,
+                                        &local->cont.readv.start);
+        else
+                timerclear (&local->cont.readv.start);
+
 	STACK_WIND_COOKIE (frame, afr_readv_cbk, (void *) (long) subvol,
 			   priv->children[subvol],
 			   priv->children[subvol]->fops->readv,
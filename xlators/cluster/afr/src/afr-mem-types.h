@@ -44,6 +44,9 @@ enum gf_afr_mem_types_ {
 	gf_afr_mt_reply_t,
 	gf_afr_mt_subvol_healer_t,
 	gf_afr_mt_spbc_timeout_t,
+        gf_afr_mt_child_latency_t,
+        gf_afr_mt_read_hedge_t,
+        gf_afr_mt_data_heal_stats_t,
         gf_afr_mt_end
 };
 #endif
@@ -40,7 +40,7 @@
  */
 
 #define GLFS_COMP_BASE_AFR      GLFS_MSGID_COMP_AFR
-#define GLFS_NUM_MESSAGES       37
+#define GLFS_NUM_MESSAGES       38
 #define GLFS_MSGID_END          (GLFS_COMP_BASE_AFR + GLFS_NUM_MESSAGES + 1)
 
 #define glfs_msg_start_x GLFS_COMP_BASE_AFR, "Invalid: Start of messages"
@@ -327,6 +327,14 @@
 */
 #define AFR_MSG_SELF_HEAL_FAILED                (GLFS_COMP_BASE_AFR + 37)
 
+/*!
+ * @messageid 108038
+ * @diagnosis The thread re-issuing slow reads could not be started, reads
+ * are not hedged.
+ * @recommendedaction
+*/
+#define AFR_MSG_READ_HEDGE_FAILED               (GLFS_COMP_BASE_AFR + 38)
+
 
 
 #define glfs_msg_end_x GLFS_MSGID_END, "Invalid: End of messages"
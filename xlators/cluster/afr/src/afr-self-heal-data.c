@@ -14,6 +14,7 @@
 #include "byte-order.h"
 #include "protocol-common.h"
 #include "afr-messages.h"
+#include "checksum.h"
 
 enum {
 	AFR_SELFHEAL_DATA_FULL = 0,
@@ -37,6 +38,8 @@ __checksum_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 	local->replies[i].op_errno = op_errno;
 	if (strong)
 		memcpy (local->replies[i].checksum, strong, MD5_DIGEST_LENGTH);
+	if (xdata)
+		local->replies[i].xdata = dict_ref (xdata);
 
 	syncbarrier_wake (&local->barrier);
 	return 0;
@@ -69,6 +72,21 @@ attr_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 
+/* which strong checksum the brick computed: older bricks only know md5
+   and do not say */
+static gf_boolean_t
+__afr_checksum_is_xxh64 (struct afr_reply *reply)
+{
+        char *type = NULL;
+
+        if (!reply->xdata ||
+            dict_get_str (reply->xdata, GF_RCHECKSUM_TYPE_KEY, &type))
+                return _gf_false;
+
+        return (strcmp (type, GF_RCHECKSUM_XXH64) == 0);
+}
+
+
 static gf_boolean_t
 __afr_selfheal_data_checksums_match (call_frame_t *frame, xlator_t *this,
 				     fd_t *fd, int source,
@@ -78,6 +96,9 @@ __afr_selfheal_data_checksums_match (call_frame_t *frame, xlator_t *this,
 	afr_private_t *priv = NULL;
 	afr_local_t *local = NULL;
 	unsigned char *wind_subvols = NULL;
+	dict_t *xdata = NULL;
+	gf_boolean_t xxh64 = _gf_false;
+	gf_boolean_t match = _gf_false;
 	int i = 0;
 
 	priv = this->private;
@@ -89,24 +110,42 @@ __afr_selfheal_data_checksums_match (call_frame_t *frame, xlator_t *this,
 			wind_subvols[i] = 1;
 	}
 
+        xdata = dict_new ();
+        if (xdata &&
+            dict_set_str (xdata, GF_RCHECKSUM_TYPE_KEY, GF_RCHECKSUM_XXH64)) {
+                dict_unref (xdata);
+                xdata = NULL;
+        }
+
 	AFR_ONLIST (wind_subvols, frame, __checksum_cbk, rchecksum, fd,
-		    offset, size, NULL);
+		    offset, size, xdata);
 
 	if (!local->replies[source].valid || local->replies[source].op_ret != 0)
-		return _gf_false;
+		goto out;
+
+        xxh64 = __afr_checksum_is_xxh64 (&local->replies[source]);
 
 	for (i = 0; i < priv->child_count; i++) {
 		if (i == source)
 			continue;
                 if (local->replies[i].valid) {
+                        /* a mix of old and new bricks can not be
+                           compared, heal the block */
+                        if (__afr_checksum_is_xxh64 (&local->replies[i]) !=
+                            xxh64)
+                                goto out;
                         if (memcmp (local->replies[source].checksum,
                                     local->replies[i].checksum,
                                     MD5_DIGEST_LENGTH))
-                                return _gf_false;
+                                goto out;
                 }
 	}
 
-	return _gf_true;
+	match = _gf_true;
+out:
+        if (xdata)
+                dict_unref (xdata);
+	return match;
 }
 
 
@@ -147,6 +186,7 @@ __afr_selfheal_data_read_write (call_frame_t *frame, xlator_t *this, fd_t *fd,
 	int count = 0;
 	struct iobref *iobref = NULL;
 	int ret = 0;
+	int copied = 0;
 	int i = 0;
 	afr_private_t *priv = NULL;
 
@@ -210,8 +250,13 @@ __afr_selfheal_data_read_write (call_frame_t *frame, xlator_t *this, fd_t *fd,
 			   as successfully healed.
 			*/
 			healed_sinks[i] = 0;
+		} else {
+			copied = ret;
 		}
 	}
+	/* bytes of this block written to the sinks, for the heal stats */
+	if (ret >= 0)
+		ret = copied;
         if (iovec)
                 GF_FREE (iovec);
 	if (iobref)
@@ -330,41 +375,173 @@ afr_data_self_heal_type_get (afr_private_t *priv, unsigned char *healed_sinks,
         return type;
 }
 
+#define AFR_SELFHEAL_DATA_BLOCK_SIZE (128 * 1024)
+
+/*
+ * State shared by the workers healing the blocks of one file. Up to
+ * data-self-heal-window-size workers run at once, each taking the next
+ * block not yet taken, so that as many blocks are in flight.
+ */
+typedef struct {
+	call_frame_t      *frame;
+	xlator_t          *this;
+	fd_t              *fd;
+	int                source;
+	unsigned char     *healed_sinks;
+	struct afr_reply  *replies;
+	int                type;
+	off_t              size;
+	off_t              next;      /* next block to heal, atomically */
+	int                ret;       /* first failure */
+	uint64_t           copied;    /* bytes of the blocks written */
+	syncbarrier_t      barrier;
+} afr_data_heal_window_t;
+
+
 static int
-afr_selfheal_data_do (call_frame_t *frame, xlator_t *this, fd_t *fd,
-		      int source, unsigned char *healed_sinks,
-		      struct afr_reply *replies)
+afr_selfheal_data_blocks (void *opaque)
 {
+	afr_data_heal_window_t *win = opaque;
 	afr_private_t *priv = NULL;
-	off_t off = 0;
-	size_t block = 128 * 1024;
-	int type = AFR_SELFHEAL_DATA_FULL;
-	int ret = -1;
 	call_frame_t *iter_frame = NULL;
+	off_t off = 0;
+	int ret = 0;
 
-	priv = this->private;
+	priv = win->this->private;
 
-        type = afr_data_self_heal_type_get (priv, healed_sinks, source,
-                                            replies);
+	iter_frame = afr_copy_frame (win->frame);
+	if (!iter_frame) {
+		ret = -ENOMEM;
+		goto out;
+	}
 
-	iter_frame = afr_copy_frame (frame);
-	if (!iter_frame)
-		return -ENOMEM;
+	for (;;) {
+		off = __sync_fetch_and_add (&win->next,
+					    AFR_SELFHEAL_DATA_BLOCK_SIZE);
+		if (off >= win->size || win->ret < 0)
+			break;
 
-	for (off = 0; off < replies[source].poststat.ia_size; off += block) {
-                if (AFR_COUNT (healed_sinks, priv->child_count) == 0) {
+                if (AFR_COUNT (win->healed_sinks, priv->child_count) == 0) {
                         ret = -ENOTCONN;
                         goto out;
                 }
 
-		ret = afr_selfheal_data_block (iter_frame, this, fd, source,
-					       healed_sinks, off, block, type,
-					       replies);
+		ret = afr_selfheal_data_block (iter_frame, win->this, win->fd,
+					       win->source, win->healed_sinks,
+					       off, AFR_SELFHEAL_DATA_BLOCK_SIZE,
+					       win->type, win->replies);
 		if (ret < 0)
 			goto out;
+		if (ret > 0)
+			__sync_add_and_fetch (&win->copied, ret);
 
 		AFR_STACK_RESET (iter_frame);
 	}
+	ret = 0;
+out:
+	if (ret < 0)
+		__sync_bool_compare_and_swap (&win->ret, 0, ret);
+	if (iter_frame)
+		AFR_STACK_DESTROY (iter_frame);
+	return ret;
+}
+
+
+static int
+afr_selfheal_data_blocks_done (int ret, call_frame_t *frame, void *opaque)
+{
+	afr_data_heal_window_t *win = opaque;
+
+	syncbarrier_wake (&win->barrier);
+	return 0;
+}
+
+
+static void
+afr_selfheal_data_account (xlator_t *this, unsigned char *healed_sinks,
+			   uint64_t bytes, struct timeval *start)
+{
+	afr_private_t *priv = NULL;
+	struct timeval now = {0, };
+	uint64_t usec = 0;
+	int i = 0;
+
+	priv = this->private;
+	if (!priv->shd.data_heal)
+		return;
+
+	gettimeofday (&now, NULL);
+	usec = (now.tv_sec - start->tv_sec) * 1000000 +
+		(now.tv_usec - start->tv_usec);
+
+	for (i = 0; i < priv->child_count; i++) {
+		if (!healed_sinks[i])
+			continue;
+		__sync_add_and_fetch (&priv->shd.data_heal[i].bytes, bytes);
+		__sync_add_and_fetch (&priv->shd.data_heal[i].usec, usec);
+	}
+}
+
+
+static int
+afr_selfheal_data_do (call_frame_t *frame, xlator_t *this, fd_t *fd,
+		      int source, unsigned char *healed_sinks,
+		      struct afr_reply *replies)
+{
+	afr_private_t *priv = NULL;
+	afr_data_heal_window_t win = {0, };
+	struct timeval start = {0, };
+	int workers = 0;
+	int spawned = 0;
+	int ret = -1;
+	int i = 0;
+
+	priv = this->private;
+
+	gettimeofday (&start, NULL);
+
+	win.frame = frame;
+	win.this = this;
+	win.fd = fd;
+	win.source = source;
+	win.healed_sinks = healed_sinks;
+	win.replies = replies;
+	win.size = replies[source].poststat.ia_size;
+        win.type = afr_data_self_heal_type_get (priv, healed_sinks, source,
+                                                replies);
+
+	workers = min (priv->data_self_heal_window_size,
+		       win.size / AFR_SELFHEAL_DATA_BLOCK_SIZE + 1);
+
+	if (workers > 1) {
+		ret = syncbarrier_init (&win.barrier);
+		if (ret)
+			workers = 1;
+	}
+
+	if (workers <= 1) {
+		ret = afr_selfheal_data_blocks (&win);
+	} else {
+		for (i = 0; i < workers; i++) {
+			if (synctask_new (this->ctx->env,
+					  afr_selfheal_data_blocks,
+					  afr_selfheal_data_blocks_done,
+					  NULL, &win) == 0)
+				spawned++;
+		}
+		if (spawned)
+			syncbarrier_wait (&win.barrier, spawned);
+		else
+			win.ret = -ENOMEM;
+		syncbarrier_destroy (&win.barrier);
+		ret = win.ret;
+	}
+
+	if (win.copied)
+		afr_selfheal_data_account (this, healed_sinks, win.copied,
+					   &start);
+	if (ret < 0)
+		goto out;
 
 	afr_selfheal_data_restore_time (frame, this, fd->inode, source,
 					healed_sinks, replies);
@@ -372,8 +549,6 @@ afr_selfheal_data_do (call_frame_t *frame, xlator_t *this, fd_t *fd,
 	ret = afr_selfheal_data_fsync (frame, this, fd, healed_sinks);
 
 out:
-	if (iter_frame)
-		AFR_STACK_DESTROY (iter_frame);
 	return ret;
 }
 
@@ -1008,6 +1008,12 @@ afr_selfheal_daemon_init (xlator_t *this)
         if (!shd->statistics)
                 goto out;
 
+        shd->data_heal = GF_CALLOC (sizeof (*shd->data_heal),
+                                    priv->child_count,
+                                    gf_afr_mt_data_heal_stats_t);
+        if (!shd->data_heal)
+                goto out;
+
         for (i = 0; i < priv->child_count ; i++) {
                 shd->statistics[i] = eh_new (AFR_STATISTICS_HISTORY_SIZE,
 					     _gf_false,
@@ -1070,6 +1076,41 @@ out:
 }
 
 
+/* bytes healed into brick @child and the rate they were healed at */
+static void
+afr_shd_dict_add_data_heal_stats (xlator_t *this, dict_t *output, int xl_id,
+                                  int child)
+{
+        afr_private_t *priv  = NULL;
+        char           key[64];
+        uint64_t       bytes = 0;
+        uint64_t       usec  = 0;
+        int            ret   = 0;
+
+        priv = this->private;
+
+        bytes = __sync_add_and_fetch (&priv->shd.data_heal[child].bytes, 0);
+        usec = __sync_add_and_fetch (&priv->shd.data_heal[child].usec, 0);
+
+        snprintf (key, sizeof (key), "statistics-%d-%d-data_healed",
+                  xl_id, child);
+        ret = dict_set_uint64 (output, key, bytes);
+        if (ret)
+                goto out;
+
+        snprintf (key, sizeof (key), "statistics-%d-%d-data_heal_rate",
+                  xl_id, child);
+        ret = dict_set_uint64 (output, key,
+                               usec ? (uint64_t) ((double) bytes * 1000000 / usec)
+                               : 0);
+out:
+        if (ret)
+                gf_msg (this->name, GF_LOG_ERROR, -ret,
+                        AFR_MSG_DICT_SET_FAILED,
+                        "Could not add data heal statistics to output");
+}
+
+
 int
 afr_xl_op (xlator_t *this, dict_t *input, dict_t *output)
 {
@@ -1165,6 +1206,8 @@ afr_xl_op (xlator_t *this, dict_t *input, dict_t *output)
                 break;
         case GF_SHD_OP_STATISTICS:
 		for (i = 0; i < priv->child_count; i++) {
+                        afr_shd_dict_add_data_heal_stats (this, output, xl_id,
+                                                          i);
 			eh_dump (shd->statistics[i], output,
 				 afr_add_crawl_event);
 			afr_shd_dict_add_crawl_event (this, output,
@@ -47,6 +47,12 @@ struct subvol_healer {
 	pthread_t        thread;
 };
 
+/* data healed into a brick, updated atomically */
+typedef struct {
+        uint64_t                bytes;
+        uint64_t                usec;    /* time spent healing data to it */
+} afr_data_heal_stats_t;
+
 typedef struct {
 	gf_boolean_t            iamshd;
 	gf_boolean_t            enabled;
@@ -56,6 +62,7 @@ typedef struct {
 
         eh_t                    *split_brain;
         eh_t                    **statistics;
+        afr_data_heal_stats_t   *data_heal;
 } afr_self_heald_t;
 
 
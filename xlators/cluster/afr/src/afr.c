@@ -154,6 +154,8 @@ reconfigure (xlator_t *this, dict_t *options)
         GF_OPTION_RECONF ("read-hash-mode", priv->hash_mode,
                           options, uint32, out);
 
+        GF_OPTION_RECONF ("read-hedge", priv->read_hedge, options, bool, out);
+
         if (read_subvol) {
                 index = xlator_subvolume_index (this, read_subvol);
                 if (index == -1) {
@@ -305,6 +307,8 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("read-hash-mode", priv->hash_mode, uint32, out);
 
+        GF_OPTION_INIT ("read-hedge", priv->read_hedge, bool, out);
+
         priv->favorite_child = -1;
         GF_OPTION_INIT ("favorite-child", fav_child, xlator, out);
         if (fav_child) {
@@ -397,6 +401,21 @@ init (xlator_t *this)
                 goto out;
         }
 
+        priv->child_latency = GF_CALLOC (child_count,
+                                         sizeof (*priv->child_latency),
+                                         gf_afr_mt_child_latency_t);
+        if (!priv->child_latency) {
+                ret = -ENOMEM;
+                goto out;
+        }
+
+        for (i = 0; i < child_count; i++)
+                LOCK_INIT (&priv->child_latency[i].lock);
+
+        pthread_mutex_init (&priv->hedge.mutex, NULL);
+        pthread_cond_init (&priv->hedge.cond, NULL);
+        INIT_LIST_HEAD (&priv->hedge.pending);
+
         priv->pending_key = GF_CALLOC (sizeof (*priv->pending_key),
                                        child_count,
                                        gf_afr_mt_char);
@@ -463,6 +482,7 @@ fini (xlator_t *this)
         afr_private_t *priv = NULL;
 
         priv = this->private;
+        afr_read_hedge_queue_fini (this);
         this->private = NULL;
         afr_priv_destroy (priv);
         //if (this->itable);//I dont see any destroy func
@@ -559,7 +579,7 @@ struct volume_options options[] = {
         { .key = {"read-hash-mode" },
           .type = GF_OPTION_TYPE_INT,
           .min = 0,
-          .max = 2,
+          .max = 3,
           .default_value = "1",
           .description = "inode-read fops happen only on one of the bricks in "
                          "replicate. AFR will prefer the one computed using "
@@ -567,7 +587,17 @@ struct volume_options options[] = {
                          "0 = first up server, "
                          "1 = hash by GFID of file (all clients use "
                                                     "same subvolume), "
-                         "2 = hash by GFID of file and client PID",
+                         "2 = hash by GFID of file and client PID, "
+                         "3 = brick with the least expected wait, by the "
+                             "measured latency and outstanding reads",
+        },
+        { .key  = {"read-hedge"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Send a read again to another brick when the "
+                         "first one has not replied within the 99th "
+                         "percentile of its recent read latency. The first "
+                         "reply is used.",
         },
         { .key  = {"choose-local" },
           .type = GF_OPTION_TYPE_BOOL,
@@ -50,6 +50,38 @@ typedef int (*afr_changelog_resume_t) (call_frame_t *frame, xlator_t *this);
 #define AFR_INTERSECT(dst,src1,src2,max) ({int __i; for (__i = 0; __i < max; __i++) dst[__i] = src1[__i] && src2[__i];})
 #define AFR_CMP(a1,a2,len) ({int __cmp = 0; int __i; for (__i = 0; __i < len; __i++) if (a1[__i] != a2[__i]) { __cmp = 1; break;} __cmp;})
 
+/* read-hash-mode: send each read to the least loaded readable child */
+#define AFR_READ_HASH_LEAST_LOADED     3
+
+#define AFR_READ_LATENCY_BUCKETS       32    /* log2 buckets of usecs */
+#define AFR_READ_LATENCY_WINDOW        1024  /* samples before aging */
+#define AFR_READ_LATENCY_MIN_SAMPLES   100   /* before p99 is trusted */
+
+/*
+ * Read latency of a child, sampled on readv and lookup. The histogram is
+ * halved every AFR_READ_LATENCY_WINDOW samples so that it follows the
+ * recent behaviour of the brick.
+ */
+typedef struct {
+        gf_lock_t     lock;
+        int32_t       inflight;            /* updated atomically */
+        int64_t       ewma_usec;
+        uint64_t      samples;
+        uint32_t      hist[AFR_READ_LATENCY_BUCKETS];
+        uint32_t      hist_total;
+        uint64_t      hedged;              /* reads re-issued elsewhere */
+} afr_child_latency_t;
+
+/* slow reads waiting to be re-issued on another child */
+typedef struct {
+        pthread_mutex_t   mutex;
+        pthread_cond_t    cond;
+        struct list_head  pending;         /* afr_read_hedge_t, by deadline */
+        pthread_t         thread;
+        gf_boolean_t      running;
+        gf_boolean_t      fini;
+} afr_read_hedge_queue_t;
+
 typedef struct _afr_private {
         gf_lock_t lock;               /* to guard access to child_count, etc */
         unsigned int child_count;     /* total number of children   */
@@ -81,6 +113,10 @@ typedef struct _afr_private {
 	gf_boolean_t metadata_splitbrain_forced_heal; /* on/off */
         int read_child;               /* read-subvolume */
         unsigned int hash_mode;       /* for when read_child is not set */
+        afr_child_latency_t *child_latency;
+        uint32_t read_rr;             /* tie breaker for least loaded */
+        gf_boolean_t read_hedge;
+        afr_read_hedge_queue_t hedge;
         int favorite_child;  /* subvolume to be preferred in resolving
                                          split-brain cases */
 
@@ -442,6 +478,7 @@ typedef struct _afr_local {
                 struct {
                         gf_boolean_t needs_fresh_lookup;
                         uuid_t gfid_req;
+                        struct timeval start;
                 } lookup;
 
                 struct {
@@ -491,6 +528,8 @@ typedef struct _afr_local {
                         off_t offset;
                         int last_index;
                         uint32_t flags;
+                        struct timeval start;
+                        gf_boolean_t hedged;
                 } readv;
 
                 /* dir read */
@@ -793,6 +832,24 @@ afr_read_subvol_select_by_policy (inode_t *inode, xlator_t *this,
 				  unsigned char *readable,
                                   afr_read_subvol_args_t *args);
 
+int
+afr_least_loaded_child (xlator_t *this, unsigned char *readable, int skip);
+
+gf_boolean_t
+afr_read_latency_tracked (xlator_t *this);
+
+void
+afr_read_latency_begin (xlator_t *this, int child, struct timeval *start);
+
+void
+afr_read_latency_end (xlator_t *this, int child, struct timeval *start);
+
+uint64_t
+afr_read_latency_p99 (xlator_t *this, int child);
+
+void
+afr_read_hedge_queue_fini (xlator_t *this);
+
 int
 afr_inode_read_subvol_type_get (inode_t *inode, xlator_t *this,
 				unsigned char *readable, int *event_p,
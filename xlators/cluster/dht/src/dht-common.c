@@ -702,6 +702,12 @@ dht_revalidate_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 
         gf_uuid_unparse (local->loc.gfid, gfid);
 
+        /* a directory's name filters are only as fresh as the last reply */
+        if (local->layout && local->inode &&
+            IA_ISDIR (local->inode->ia_type))
+                dht_layout_bloom_set (this, local->layout, prev->this,
+                                      (op_ret == 0) ? xattr : NULL);
+
         LOCK (&frame->lock);
         {
 
@@ -1497,6 +1503,7 @@ dht_lookup_everywhere_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         dht_conf_t   *conf          = NULL;
         char         gfid[GF_UUID_BUF_SIZE] = {0};
         dict_t       *dict_req      = {0};
+        int           i             = 0;
 
         GF_VALIDATE_OR_GOTO ("dht", frame, out);
         GF_VALIDATE_OR_GOTO ("dht", this, out);
@@ -1516,6 +1523,13 @@ dht_lookup_everywhere_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                       "from subvol %s", op_ret, op_errno, loc->path,
                       subvol->name);
 
+        if ((op_ret == -1) && (op_errno == ENOENT) && local->bloom_maybe) {
+                i = dht_subvol_cnt (this, subvol);
+                if ((i >= 0) && local->bloom_maybe[i])
+                        __sync_fetch_and_add (&conf->bloom_false_positives,
+                                              1);
+        }
+
         LOCK (&frame->lock);
         {
                 if (op_ret == -1) {
@@ -1683,11 +1697,105 @@ out:
 }
 
 
+/*
+ * Pick the subvolumes dht_lookup_everywhere() has to ask for loc: all of
+ * them, less those whose name filter for the parent directory rules the
+ * name out. The hashed subvolume is always asked, as is every subvolume
+ * whose filter is older than DHT_LOOKUP_BLOOM_MAX_AGE; the rebalance
+ * process, which moves names between subvolumes, asks all of them.
+ * Subvolumes that were asked only because their filter said "maybe" are
+ * flagged in local->bloom_maybe, to count false positives when they reply
+ * ENOENT.
+ */
+static int
+dht_lookup_everywhere_subvols (xlator_t *this, dht_local_t *local,
+                               loc_t *loc, xlator_t **subvols)
+{
+        dht_conf_t   *conf   = this->private;
+        dht_layout_t *layout = NULL;
+        gf_boolean_t  skip   = _gf_false;
+        gf_boolean_t  maybe  = _gf_false;
+        uint32_t      h1     = 0;
+        uint32_t      h2     = 0;
+        time_t        now    = 0;
+        uint64_t      checks = 0;
+        uint64_t      hits   = 0;
+        int           cnt    = 0;
+        int           i      = 0;
+        int           j      = 0;
+
+        GF_FREE (local->bloom_maybe);
+        local->bloom_maybe = NULL;
+
+        if (conf->lookup_bloom && !conf->defrag && loc->parent && loc->name)
+                layout = dht_layout_get (this, loc->parent);
+
+        if (layout) {
+                local->bloom_maybe = GF_CALLOC (conf->subvolume_cnt,
+                                                sizeof (char),
+                                                gf_dht_mt_char);
+                if (!local->bloom_maybe) {
+                        dht_layout_unref (this, layout);
+                        layout = NULL;
+                }
+        }
+
+        if (layout) {
+                gf_bloom_hash (loc->name, &h1, &h2);
+                now = time (NULL);
+        }
+
+        for (i = 0; i < conf->subvolume_cnt; i++) {
+                skip = maybe = _gf_false;
+                if (layout && conf->subvolumes[i] != local->hashed_subvol) {
+                        /* revalidations replace the filters meanwhile */
+                        LOCK (&conf->layout_lock);
+                        for (j = 0; j < layout->cnt; j++) {
+                                if (layout->list[j].xlator !=
+                                    conf->subvolumes[i])
+                                        continue;
+                                if (layout->list[j].bloom &&
+                                    (now - layout->list[j].bloom_time) <=
+                                    DHT_LOOKUP_BLOOM_MAX_AGE) {
+                                        maybe = gf_bloom_check_hash (
+                                                layout->list[j].bloom, h1, h2);
+                                        skip = !maybe;
+                                }
+                                break;
+                        }
+                        UNLOCK (&conf->layout_lock);
+                }
+
+                if (skip || maybe)
+                        checks++;
+                if (skip) {
+                        hits++;
+                        continue;
+                }
+                if (maybe)
+                        local->bloom_maybe[i] = 1;
+
+                subvols[cnt++] = conf->subvolumes[i];
+        }
+
+        if (layout)
+                dht_layout_unref (this, layout);
+
+        if (checks) {
+                __sync_fetch_and_add (&conf->bloom_checks, checks);
+                __sync_fetch_and_add (&conf->bloom_hits, hits);
+        }
+
+        return cnt;
+}
+
+
 int
 dht_lookup_everywhere (call_frame_t *frame, xlator_t *this, loc_t *loc)
 {
         dht_conf_t     *conf = NULL;
         dht_local_t    *local = NULL;
+        xlator_t      **subvols = NULL;
         int             i = 0;
         int             call_cnt = 0;
 
@@ -1700,7 +1808,14 @@ dht_lookup_everywhere (call_frame_t *frame, xlator_t *this, loc_t *loc)
         conf = this->private;
         local = frame->local;
 
-        call_cnt = conf->subvolume_cnt;
+        subvols = alloca (conf->subvolume_cnt * sizeof (*subvols));
+        call_cnt = dht_lookup_everywhere_subvols (this, local, loc, subvols);
+        if (!call_cnt) {
+                /* nothing left to reply, ask everyone after all */
+                for (i = 0; i < conf->subvolume_cnt; i++)
+                        subvols[i] = conf->subvolumes[i];
+                call_cnt = conf->subvolume_cnt;
+        }
         local->call_cnt = call_cnt;
 
         if (!local->inode)
@@ -1711,8 +1826,7 @@ dht_lookup_everywhere (call_frame_t *frame, xlator_t *this, loc_t *loc)
 
         for (i = 0; i < call_cnt; i++) {
                 STACK_WIND (frame, dht_lookup_everywhere_cbk,
-                            conf->subvolumes[i],
-                            conf->subvolumes[i]->fops->lookup,
+                            subvols[i], subvols[i]->fops->lookup,
                             loc, local->xattr_req);
         }
 
@@ -2173,6 +2287,16 @@ dht_lookup (call_frame_t *frame, xlator_t *this,
                                        sizeof(uint32_t));
         }
 
+        /* directories come back with their name filters */
+        if (conf->lookup_bloom) {
+                ret = dict_set_int32 (local->xattr_req, GF_NAME_BLOOM_KEY, 1);
+                if (ret)
+                        gf_msg (this->name, GF_LOG_WARNING, 0,
+                                DHT_MSG_DICT_SET_FAILED,
+                                "%s: Failed to set dictionary value:key = %s",
+                                loc->path, GF_NAME_BLOOM_KEY);
+        }
+
         if (!hashed_subvol)
                 hashed_subvol = dht_subvol_get_hashed (this, loc);
         local->hashed_subvol = hashed_subvol;
@@ -4456,6 +4580,95 @@ err:
         return 0;
 }
 
+/*
+ * Hash every name dht_readdirp_cbk() is going to look up in the layout in
+ * one go. Returns an array indexed by the position of the entry in
+ * orig_entries (only filled in for the entries that need it), or NULL to
+ * make the caller search name by name.
+ */
+static uint32_t *
+dht_readdirp_hash_entries (xlator_t *this, dht_methods_t *methods,
+                           dht_layout_t *layout, gf_dirent_t *orig_entries,
+                           gf_boolean_t dirs_only)
+{
+        gf_dirent_t   *orig_entry = NULL;
+        const char   **names = NULL;
+        uint32_t      *batch = NULL;
+        uint32_t      *hashes = NULL;
+        int           *pos   = NULL;
+        int            total = 0;
+        int            cnt   = 0;
+        int            i     = 0;
+        int            ret   = -1;
+
+        if (!layout || methods->layout_search != dht_layout_search)
+                goto out;
+
+        list_for_each_entry (orig_entry, (&orig_entries->list), list)
+                total++;
+
+        /* nothing to batch */
+        if (total < 2)
+                goto out;
+
+        hashes = GF_CALLOC (total, sizeof (*hashes), gf_dht_mt_int32_t);
+        batch = GF_CALLOC (total, sizeof (*batch), gf_dht_mt_int32_t);
+        pos = GF_CALLOC (total, sizeof (*pos), gf_dht_mt_int32_t);
+        names = GF_CALLOC (total, sizeof (*names), gf_dht_mt_char);
+        if (!hashes || !batch || !pos || !names)
+                goto out;
+
+        i = 0;
+        list_for_each_entry (orig_entry, (&orig_entries->list), list) {
+                if (!dirs_only ||
+                    check_is_dir (NULL, (&orig_entry->d_stat), NULL)) {
+                        names[cnt] = orig_entry->d_name;
+                        pos[cnt] = i;
+                        cnt++;
+                }
+                i++;
+        }
+
+        ret = dht_hash_compute_batch (this, layout->type, names, batch, cnt);
+        if (ret)
+                goto out;
+
+        for (i = 0; i < cnt; i++)
+                hashes[pos[i]] = batch[i];
+out:
+        if (ret) {
+                GF_FREE (hashes);
+                hashes = NULL;
+        }
+        GF_FREE (batch);
+        GF_FREE (pos);
+        GF_FREE (names);
+
+        return hashes;
+}
+
+
+static xlator_t *
+dht_readdirp_layout_search (xlator_t *this, dht_methods_t *methods,
+                            dht_layout_t *layout, gf_dirent_t *entry,
+                            uint32_t *hashes, int idx)
+{
+        xlator_t   *subvol = NULL;
+
+        if (!hashes)
+                return methods->layout_search (this, layout, entry->d_name);
+
+        subvol = dht_layout_search_hash (this, layout, hashes[idx]);
+        if (!subvol) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        DHT_MSG_HASHED_SUBVOL_GET_FAILED,
+                        "no subvolume for hash (value) = %u", hashes[idx]);
+        }
+
+        return subvol;
+}
+
+
 int
 dht_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                   int op_errno, gf_dirent_t *orig_entries, dict_t *xdata)
@@ -4475,6 +4688,8 @@ dht_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
         xlator_t     *hashed_subvol = 0;
         int           ret    = 0;
         int           readdir_optimize = 0;
+        uint32_t     *hashes = NULL;
+        int           idx    = -1;
 
         INIT_LIST_HEAD (&entries.list);
         prev = cookie;
@@ -4497,8 +4712,16 @@ dht_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
         if (conf->readdir_optimize == _gf_true)
                  readdir_optimize = 1;
 
+        if (!readdir_optimize ||
+            conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_AUTO)
+                hashes = dht_readdirp_hash_entries (this, methods, layout,
+                                                    orig_entries,
+                                                    conf->search_unhashed !=
+                                                    GF_DHT_LOOKUP_UNHASHED_AUTO);
+
         list_for_each_entry (orig_entry, (&orig_entries->list), list) {
                 next_offset = orig_entry->d_off;
+                idx++;
 
                 if (IA_ISINVAL(orig_entry->d_stat.ia_type)) {
                         /*stat failed somewhere- ignore this entry*/
@@ -4523,8 +4746,12 @@ dht_readdirp_cbk (call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
 
                         }
 
-                        hashed_subvol = methods->layout_search (this, layout,
-                                                         orig_entry->d_name);
+                        hashed_subvol = dht_readdirp_layout_search (this,
+                                                                    methods,
+                                                                    layout,
+                                                                    orig_entry,
+                                                                    hashes,
+                                                                    idx);
 
                         if (prev->this == hashed_subvol)
                                 goto list;
@@ -4550,8 +4777,10 @@ list:
 
                 /* Do this if conf->search_unhashed is set to "auto" */
                 if (conf->search_unhashed == GF_DHT_LOOKUP_UNHASHED_AUTO) {
-                        subvol = methods->layout_search (this, layout,
-                                                         orig_entry->d_name);
+                        subvol = dht_readdirp_layout_search (this, methods,
+                                                             layout,
+                                                             orig_entry,
+                                                             hashes, idx);
                         if (!subvol || (subvol != prev->this)) {
                                 /* TODO: Count the number of entries which need
                                    linkfile to prove its existence in fs */
@@ -4587,6 +4816,8 @@ list:
                 list_add_tail (&entry->list, &entries.list);
                 count++;
         }
+        GF_FREE (hashes);
+        hashes = NULL;
         op_ret = count;
         /* We need to ensure that only the last subvolume's end-of-directory
          * notification is respected so that directory reading does not stop
@@ -4637,6 +4868,8 @@ done:
         }
 
 unwind:
+        GF_FREE (hashes);
+
         if (op_ret < 0)
                 op_ret = 0;
 
@@ -5047,6 +5280,8 @@ dht_mknod (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, err);
         VALIDATE_OR_GOTO (loc, err);
 
+        dht_layout_bloom_drop (this, loc->parent);
+
         dht_get_du_info (frame, this, loc);
 
         local = dht_local_init (frame, loc, NULL, GF_FOP_MKNOD);
@@ -5123,6 +5358,8 @@ dht_symlink (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, err);
         VALIDATE_OR_GOTO (loc, err);
 
+        dht_layout_bloom_drop (this, loc->parent);
+
         local = dht_local_init (frame, loc, NULL, GF_FOP_SYMLINK);
         if (!local) {
                 op_errno = ENOMEM;
@@ -5400,6 +5637,8 @@ dht_link (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (oldloc, err);
         VALIDATE_OR_GOTO (newloc, err);
 
+        dht_layout_bloom_drop (this, newloc->parent);
+
         local = dht_local_init (frame, oldloc, NULL, GF_FOP_LINK);
         if (!local) {
                 op_errno = ENOMEM;
@@ -5545,6 +5784,8 @@ dht_create (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (this, err);
         VALIDATE_OR_GOTO (loc, err);
 
+        dht_layout_bloom_drop (this, loc->parent);
+
         dht_get_du_info (frame, this, loc);
 
         local = dht_local_init (frame, loc, fd, GF_FOP_CREATE);
@@ -5808,6 +6049,8 @@ dht_mkdir (call_frame_t *frame, xlator_t *this,
         VALIDATE_OR_GOTO (loc->path, err);
         VALIDATE_OR_GOTO (this->private, err);
 
+        dht_layout_bloom_drop (this, loc->parent);
+
         conf = this->private;
 
         dht_get_du_info (frame, this, loc);
@@ -16,6 +16,7 @@
 #include "libxlator.h"
 #include "syncop.h"
 #include "refcount.h"
+#include "bloom.h"
 
 #ifndef _DHT_H
 #define _DHT_H
@@ -29,6 +30,10 @@
 #define DHT_LAYOUT_HEAL_DOMAIN      "dht.layout.heal"
 #define TIERING_MIGRATION_KEY       "tiering.migration"
 #define DHT_LAYOUT_HASH_INVALID     1
+/* below this many subvolumes scanning the layout beats a binary search */
+#define DHT_LAYOUT_INDEX_MIN_CNT    32
+/* seconds a name filter is trusted after the brick last sent it */
+#define DHT_LOOKUP_BLOOM_MAX_AGE    2
 
 #include <fnmatch.h>
 
@@ -40,6 +45,14 @@ typedef int (*dht_defrag_cbk_fn_t) (xlator_t        *this, xlator_t *dst_node,
                                     call_frame_t    *frame);
 
 
+/* one entry of the sorted range index kept at the tail of a layout */
+struct dht_layout_range {
+        uint32_t           start;
+        uint32_t           stop;
+        int                pos;   /* index into layout->list[] */
+};
+typedef struct dht_layout_range dht_layout_range_t;
+
 struct dht_layout {
         int                spread_cnt;  /* layout spread count per directory,
                                            is controlled by 'setxattr()' with
@@ -64,6 +77,15 @@ struct dht_layout {
         int                type;
         int                ref; /* use with dht_conf_t->layout_lock */
         gf_boolean_t       search_unhashed;
+        /*
+         * Ranges of list[] sorted by start, for binary search in
+         * dht_layout_search(). Built by dht_layout_index_build() when the
+         * layout is set on an inode; index_cnt is 0 when there is no
+         * usable index (not built yet, or overlapping ranges), in which
+         * case the search falls back to scanning list[].
+         */
+        dht_layout_range_t *index;
+        int                index_cnt;
         struct {
                 int        err;   /* 0 = normal
                                      -1 = dir exists and no xattr
@@ -73,10 +95,29 @@ struct dht_layout {
                 uint32_t   stop;
                 uint32_t   commit_hash;
                 xlator_t  *xlator;
+                /* names in the directory on this subvolume, if the
+                   brick sent them along with the layout, and when it did
+                   last; see dht_layout_bloom_set() */
+                gf_bloom_t *bloom;
+                time_t      bloom_time;
         } list[];
 };
 typedef struct dht_layout  dht_layout_t;
 
+#define DHT_REGEX_LITERAL_MAX 32
+
+/*
+ * Literal text every name matching a hash regex must start or end with,
+ * derived from the pattern; names without it skip regexec().
+ */
+struct dht_regex_filter {
+        char               prefix[DHT_REGEX_LITERAL_MAX];
+        int                prefix_len;
+        char               suffix[DHT_REGEX_LITERAL_MAX];
+        int                suffix_len;
+};
+typedef struct dht_regex_filter dht_regex_filter_t;
+
 struct dht_stat_time {
         uint32_t        atime;
         uint32_t        atime_nsec;
@@ -249,6 +290,10 @@ struct dht_local {
 
         struct dht_skip_linkto_unlink  skip_unlink;
 
+        /* subvolumes dht_lookup_everywhere() asked although their name
+           filter was consulted, indexed like conf->subvolumes */
+        char            *bloom_maybe;
+
         struct {
                 fop_inodelk_cbk_t   inodelk_cbk;
                 dht_lock_t        **locks;
@@ -306,6 +351,18 @@ struct gf_defrag_pattern_list {
         gf_defrag_pattern_list_t  *next;
 };
 
+/* A directory of the rebalance crawl. It is freed, and its subtree
+ * marked as done, once it was read and everything queued under it,
+ * subdirectories and files to migrate, is done as well. */
+struct dht_crawl_dir {
+        struct list_head             list;
+        loc_t                        loc;
+        struct dht_crawl_dir        *parent;
+        int                          refs;
+        int                          failed;
+};
+typedef struct dht_crawl_dir dht_crawl_dir_t;
+
 struct dht_container {
         union {
                 struct list_head             list;
@@ -318,8 +375,20 @@ struct dht_container {
         xlator_t        *this;
         loc_t           *parent_loc;
         dict_t          *migrate_data;
+        dht_crawl_dir_t *crawl_dir;
+        int              failed;   /* file left unmigrated: the directory
+                                      must not be checkpointed */
 };
 
+struct dht_migrating {
+        struct list_head             list;
+        char                        *path;
+        uint64_t                     size;
+        uint64_t                     copied;
+        struct timeval               start;
+};
+typedef struct dht_migrating dht_migrating_t;
+
 struct gf_defrag_info_ {
         uint64_t                     total_files;
         uint64_t                     total_data;
@@ -368,6 +437,23 @@ struct gf_defrag_info_ {
 
         /* Hard link handle requirement */
         synclock_t                   link_lock;
+
+        /* Files whose data is being migrated, under lock */
+        struct list_head             migrating;
+
+        /* Crawl checkpoints: key and value marking a finished subtree */
+        gf_boolean_t                 crawl_checkpoint;
+        char                         crawl_key[256];
+        char                         crawl_mark[32];
+
+        /* Crawl: directories read and skipped, time per phase in usecs */
+        uint64_t                     crawl_dirs;
+        uint64_t                     crawl_skipped;
+        uint64_t                     crawl_lookup_usec;
+        uint64_t                     crawl_layout_usec;
+        uint64_t                     crawl_readdir_usec;
+        uint64_t                     crawl_queue_usec;
+        struct timeval               crawl_end;
 };
 
 typedef struct gf_defrag_info_ gf_defrag_info_t;
@@ -428,11 +514,20 @@ struct dht_conf {
 
         gf_boolean_t    readdir_optimize;
 
+        /* Skip subvolumes with the directory's name bloom filters in
+           dht_lookup_everywhere(); counters are updated atomically */
+        gf_boolean_t    lookup_bloom;
+        uint64_t        bloom_checks;           /* subvolumes checked */
+        uint64_t        bloom_hits;             /* ... and skipped */
+        uint64_t        bloom_false_positives;  /* not skipped, ENOENT */
+
         /* Support regex-based name reinterpretation. */
         regex_t         rsync_regex;
         gf_boolean_t    rsync_regex_valid;
+        dht_regex_filter_t rsync_filter;
         regex_t         extra_regex;
         gf_boolean_t    extra_regex_valid;
+        dht_regex_filter_t extra_filter;
 
         /* Support variable xattr names. */
         char            *xattr_name;
@@ -445,6 +540,14 @@ struct dht_conf {
         gf_boolean_t    randomize_by_gfid;
         char           *dthrottle;
 
+        /* Data migration: blocks in flight per file and their size */
+        int32_t         migrate_window;
+        uint64_t        migrate_blksize;
+
+        /* Tasks crawling directories during rebalance/fix-layout */
+        int32_t         crawl_threads;
+        gf_boolean_t    crawl_checkpoint;
+
         dht_methods_t  *methods;
 
         struct mem_pool *lock_pool;
@@ -602,6 +705,9 @@ dht_layout_t                            *dht_layout_get (xlator_t *this, inode_t
 dht_layout_t                            *dht_layout_for_subvol (xlator_t *this, xlator_t *subvol);
 xlator_t *dht_layout_search (xlator_t   *this, dht_layout_t *layout,
                              const char *name);
+xlator_t *dht_layout_search_hash (xlator_t *this, dht_layout_t *layout,
+                                  uint32_t hash);
+int dht_layout_index_build (dht_layout_t *layout);
 int32_t
 dht_migration_get_dst_subvol(xlator_t *this, dht_local_t  *local);
 int32_t
@@ -620,6 +726,9 @@ int dht_linkfile_unlink (call_frame_t      *frame, xlator_t *this,
                          xlator_t          *subvol, loc_t *loc);
 
 int dht_layouts_init (xlator_t *this, dht_conf_t *conf);
+void dht_layout_bloom_set (xlator_t *this, dht_layout_t *layout,
+                           xlator_t *subvol, dict_t *xattr);
+void dht_layout_bloom_drop (xlator_t *this, inode_t *inode);
 int dht_layout_merge (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
                       int       op_ret, int op_errno, dict_t *xattr);
 
@@ -646,6 +755,9 @@ xlator_t *dht_subvol_next_available (xlator_t *this, xlator_t *prev);
 int       dht_subvol_cnt (xlator_t *this, xlator_t *subvol);
 
 int dht_hash_compute (xlator_t *this, int type, const char *name, uint32_t *hash_p);
+int dht_hash_compute_batch (xlator_t *this, int type, const char **names,
+                            uint32_t *hashes, int cnt);
+void dht_regex_filter_init (dht_regex_filter_t *filter, const char *pattern);
 
 int dht_linkfile_create (call_frame_t    *frame, fop_mknod_cbk_t linkfile_cbk,
                          xlator_t        *this, xlator_t *tovol,
@@ -954,6 +1066,9 @@ gf_defrag_stop (gf_defrag_info_t *defrag, gf_defrag_status_t status,
 void*
 gf_defrag_start (void *this);
 
+void
+gf_defrag_crawl_dir_put (xlator_t *this, dht_crawl_dir_t *dir, int failed);
+
 int32_t
 gf_defrag_handle_hardlink (xlator_t *this, loc_t *loc, dict_t  *xattrs,
                            struct iatt *stbuf);
@@ -39,14 +39,172 @@ dht_hash_compute_internal (int type, const char *name, uint32_t *hash_p)
 }
 
 
+/* characters that stand for themselves when escaped in an ERE */
+#define DHT_REGEX_ESCAPABLE  ".[]()*+?{}|^$\\/-"
+#define DHT_REGEX_SPECIAL    ".[]()*+?{}|^$\\"
+
+/*
+ * If pattern starts with a literal character, store it in *c and return
+ * the number of pattern bytes it takes, else return 0.
+ */
+static int
+dht_regex_literal (const char *pattern, char *c)
+{
+        if (pattern[0] == '\\') {
+                if (pattern[1] && strchr (DHT_REGEX_ESCAPABLE, pattern[1])) {
+                        *c = pattern[1];
+                        return 2;
+                }
+                return 0;
+        }
+
+        if (pattern[0] == '\0' || strchr (DHT_REGEX_SPECIAL, pattern[0]))
+                return 0;
+
+        *c = pattern[0];
+        return 1;
+}
+
+/*
+ * Work out the literal prefix of a '^' anchored pattern and the literal
+ * suffix of a '$' anchored one. Anything the parser is unsure about only
+ * shortens them, the worst case being an empty filter which lets every
+ * name through to regexec().
+ */
+void
+dht_regex_filter_init (dht_regex_filter_t *filter, const char *pattern)
+{
+        const char *p = NULL;
+        char        c = 0;
+        int         n = 0;
+
+        memset (filter, 0, sizeof (*filter));
+
+        /* an alternation can take the anchors away from any branch */
+        if (strchr (pattern, '|'))
+                return;
+
+        if (pattern[0] == '^') {
+                p = pattern + 1;
+                while ((n = dht_regex_literal (p, &c)) != 0) {
+                        p += n;
+                        /* optional or repeated, so it is not required */
+                        if (*p == '*' || *p == '?' || *p == '{')
+                                break;
+                        if (filter->prefix_len == DHT_REGEX_LITERAL_MAX)
+                                break;
+                        filter->prefix[filter->prefix_len++] = c;
+                        if (*p == '+')
+                                break;
+                }
+        }
+
+        /* walk forward keeping the run of literals seen last */
+        p = pattern;
+        while (*p) {
+                if (p[0] == '$' && p[1] == '\0')
+                        return;
+
+                n = dht_regex_literal (p, &c);
+                if (n) {
+                        if (filter->suffix_len == DHT_REGEX_LITERAL_MAX) {
+                                memmove (filter->suffix, filter->suffix + 1,
+                                         DHT_REGEX_LITERAL_MAX - 1);
+                                filter->suffix_len--;
+                        }
+                        filter->suffix[filter->suffix_len++] = c;
+                        p += n;
+                        continue;
+                }
+
+                switch (*p) {
+                case '+':
+                        /* "ab+c" only promises "bc" at the end */
+                        if (filter->suffix_len) {
+                                filter->suffix[0] =
+                                        filter->suffix[filter->suffix_len - 1];
+                                filter->suffix_len = 1;
+                        }
+                        p++;
+                        continue;
+                case '[':
+                        /* skip the bracket expression, "[]...]" and
+                           "[^]...]" start with a literal ']' */
+                        p++;
+                        if (*p == '^')
+                                p++;
+                        if (*p == ']')
+                                p++;
+                        while (*p && *p != ']') {
+                                if (p[0] == '[' && p[1] &&
+                                    strchr (":.=", p[1])) {
+                                        c = p[1];
+                                        p += 2;
+                                        while (*p && !(p[0] == c &&
+                                                       p[1] == ']'))
+                                                p++;
+                                        if (*p)
+                                                p++;
+                                }
+                                if (*p)
+                                        p++;
+                        }
+                        break;
+                case '{':
+                        while (*p && *p != '}')
+                                p++;
+                        break;
+                case '\\':
+                        /* \w, \b, back references and the like */
+                        if (p[1])
+                                p++;
+                        break;
+                default:
+                        break;
+                }
+
+                /* nothing before a non literal is known to be at the
+                   end, this also drops a literal followed by '*', '?' or
+                   a bound */
+                if (*p)
+                        p++;
+                filter->suffix_len = 0;
+        }
+
+        /* not anchored at the end */
+        filter->suffix_len = 0;
+}
+
+
+static inline gf_boolean_t
+dht_regex_filter_match (dht_regex_filter_t *filter, const char *name,
+                        size_t len)
+{
+        if (filter->prefix_len &&
+            ((len < filter->prefix_len) ||
+             memcmp (name, filter->prefix, filter->prefix_len)))
+                return _gf_false;
+
+        if (filter->suffix_len &&
+            ((len < filter->suffix_len) ||
+             memcmp (name + len - filter->suffix_len, filter->suffix,
+                     filter->suffix_len)))
+                return _gf_false;
+
+        return _gf_true;
+}
+
+
 static inline
 gf_boolean_t
-dht_munge_name (const char *original, char *modified, size_t len, regex_t *re)
+dht_munge_name (const char *original, char *modified, size_t len, regex_t *re,
+                dht_regex_filter_t *filter)
 {
         regmatch_t      matches[2];
         size_t          new_len;
 
-        if (regexec(re,original,2,matches,0) != REG_NOMATCH) {
+        if (dht_regex_filter_match (filter, original, len - 1) &&
+            regexec(re,original,2,matches,0) != REG_NOMATCH) {
                 if (matches[1].rm_so != -1) {
                         new_len = matches[1].rm_eo - matches[1].rm_so;
                         /* Equal would fail due to the NUL at the end. */
@@ -64,13 +222,41 @@ dht_munge_name (const char *original, char *modified, size_t len, regex_t *re)
         return _gf_false;
 }
 
+
+/*
+ * Returns the name to hash: either name itself or a munged copy written
+ * to buf, which must hold strlen (name) + 1 bytes.
+ */
+static const char *
+dht_hash_name (xlator_t *this, const char *name, char *buf, size_t len)
+{
+        dht_conf_t      *priv                   = this->private;
+        gf_boolean_t     munged                 = _gf_false;
+
+        if (priv->extra_regex_valid) {
+                munged = dht_munge_name (name, buf, len, &priv->extra_regex,
+                                         &priv->extra_filter);
+        }
+
+        if (!munged && priv->rsync_regex_valid) {
+                gf_msg_trace (this->name, 0, "trying regex for %s", name);
+                munged = dht_munge_name (name, buf, len, &priv->rsync_regex,
+                                         &priv->rsync_filter);
+                if (munged) {
+                        gf_msg_debug (this->name, 0,
+                                      "munged down to %s", buf);
+                }
+        }
+
+        return munged ? buf : name;
+}
+
 int
 dht_hash_compute (xlator_t *this, int type, const char *name, uint32_t *hash_p)
 {
         char            *rsync_friendly_name    = NULL;
         dht_conf_t      *priv                   = this->private;
         size_t           len                    = 0;
-        gf_boolean_t     munged                 = _gf_false;
 
         /*
          * It wouldn't be safe to use alloca in an inline function that doesn't
@@ -79,28 +265,74 @@ dht_hash_compute (xlator_t *this, int type, const char *name, uint32_t *hash_p)
          * inline.
          */
 
-        if (priv->extra_regex_valid) {
+        if (priv->extra_regex_valid || priv->rsync_regex_valid) {
                 len = strlen(name) + 1;
                 rsync_friendly_name = alloca(len);
-                munged = dht_munge_name (name, rsync_friendly_name, len,
-                                         &priv->extra_regex);
+                name = dht_hash_name (this, name, rsync_friendly_name, len);
         }
 
-        if (!munged && priv->rsync_regex_valid) {
-                len = strlen(name) + 1;
-                rsync_friendly_name = alloca(len);
-                gf_msg_trace (this->name, 0, "trying regex for %s", name);
-                munged = dht_munge_name (name, rsync_friendly_name, len,
-                                         &priv->rsync_regex);
-                if (munged) {
-                        gf_msg_debug (this->name, 0,
-                                      "munged down to %s", rsync_friendly_name);
-                }
+        return dht_hash_compute_internal (type, name, hash_p);
+}
+
+
+/*
+ * Same as calling dht_hash_compute() on each of names[], but hashes them
+ * together with gf_dm_hashfn_batch().
+ */
+int
+dht_hash_compute_batch (xlator_t *this, int type, const char **names,
+                        uint32_t *hashes, int cnt)
+{
+        dht_conf_t      *priv                   = this->private;
+        const char     **hash_names             = NULL;
+        int             *lens                   = NULL;
+        char            *buf                    = NULL;
+        size_t           buf_size               = 0;
+        size_t           off                    = 0;
+        size_t           len                    = 0;
+        int              i                      = 0;
+        int              ret                    = -1;
+
+        if (type != DHT_HASH_TYPE_DM && type != DHT_HASH_TYPE_DM_USER)
+                goto out;
+
+        if (cnt <= 0) {
+                ret = 0;
+                goto out;
+        }
+
+        lens = GF_CALLOC (cnt, sizeof (*lens), gf_dht_mt_int32_t);
+        hash_names = GF_CALLOC (cnt, sizeof (*hash_names), gf_dht_mt_char);
+        if (!lens || !hash_names)
+                goto out;
+
+        for (i = 0; i < cnt; i++) {
+                lens[i] = strlen (names[i]);
+                hash_names[i] = names[i];
+                buf_size += lens[i] + 1;
         }
 
-        if (!munged) {
-                rsync_friendly_name = (char *)name;
+        if (priv->extra_regex_valid || priv->rsync_regex_valid) {
+                buf = GF_MALLOC (buf_size, gf_dht_mt_char);
+                if (!buf)
+                        goto out;
+
+                for (i = 0; i < cnt; i++) {
+                        len = lens[i] + 1;
+                        hash_names[i] = dht_hash_name (this, names[i],
+                                                       buf + off, len);
+                        if (hash_names[i] != names[i])
+                                lens[i] = strlen (hash_names[i]);
+                        off += len;
+                }
         }
 
-        return dht_hash_compute_internal (type, rsync_friendly_name, hash_p);
+        gf_dm_hashfn_batch (hash_names, lens, hashes, cnt);
+        ret = 0;
+out:
+        GF_FREE (buf);
+        GF_FREE (hash_names);
+        GF_FREE (lens);
+
+        return ret;
 }
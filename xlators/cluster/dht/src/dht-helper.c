@@ -455,6 +455,8 @@ dht_local_wipe (xlator_t *this, dht_local_t *local)
 
         GF_FREE (local->key);
 
+        GF_FREE (local->bloom_maybe);
+
         GF_FREE (local->rebalance.vector);
 
         if (local->rebalance.iobref)
@@ -21,7 +21,10 @@
 
 #define layout_entry_size (sizeof ((dht_layout_t *)NULL)->list[0])
 
-#define layout_size(cnt) (layout_base_size + (cnt * layout_entry_size))
+#define layout_index_entry_size (sizeof (dht_layout_range_t))
+
+#define layout_size(cnt) (layout_base_size + (cnt * layout_entry_size) \
+                          + (cnt * layout_index_entry_size))
 
 dht_layout_t *
 dht_layout_new (xlator_t *this, int cnt)
@@ -42,6 +45,7 @@ dht_layout_new (xlator_t *this, int cnt)
 
         layout->type = DHT_HASH_TYPE_DM;
         layout->cnt = cnt;
+        layout->index = (dht_layout_range_t *)&layout->list[cnt];
 
         if (conf) {
                 layout->spread_cnt = conf->dir_spread_cnt;
@@ -96,6 +100,9 @@ dht_layout_set (xlator_t *this, inode_t *inode, dht_layout_t *layout)
         if (!conf || !layout)
                 goto out;
 
+        /* layouts on inodes are searched on every name based fop */
+        dht_layout_index_build (layout);
+
         LOCK (&conf->layout_lock);
         {
                 oldret = dht_inode_ctx_layout_get (inode, this, &old_layout);
@@ -119,6 +126,7 @@ dht_layout_unref (xlator_t *this, dht_layout_t *layout)
 {
         dht_conf_t  *conf = NULL;
         int          ref = 0;
+        int          i = 0;
 
         if (!layout || layout->preset || !this->private)
                 return;
@@ -131,8 +139,11 @@ dht_layout_unref (xlator_t *this, dht_layout_t *layout)
         }
         UNLOCK (&conf->layout_lock);
 
-        if (!ref)
+        if (!ref) {
+                for (i = 0; i < layout->cnt; i++)
+                        gf_bloom_free (layout->list[i].bloom);
                 GF_FREE (layout);
+        }
 }
 
 
@@ -155,12 +166,126 @@ dht_layout_ref (xlator_t *this, dht_layout_t *layout)
 }
 
 
+static int
+dht_layout_range_cmp (const void *a, const void *b)
+{
+        const dht_layout_range_t *r1 = a;
+        const dht_layout_range_t *r2 = b;
+
+        if (r1->start != r2->start)
+                return (r1->start < r2->start) ? -1 : 1;
+
+        return r1->pos - r2->pos;
+}
+
+
+int
+dht_layout_index_build (dht_layout_t *layout)
+{
+        dht_layout_range_t *index = NULL;
+        int                 cnt = 0;
+        int                 i = 0;
+
+        if (!layout || !layout->index)
+                return -1;
+
+        /* searches running against this layout scan list[] meanwhile */
+        layout->index_cnt = 0;
+        __sync_synchronize ();
+
+        if (layout->cnt < DHT_LAYOUT_INDEX_MIN_CNT)
+                return -1;
+
+        /* subvolumes which failed or were given no range (start and stop
+           both 0) own no hashes, and would otherwise show up as an
+           overlap at 0 and keep the whole layout unindexed */
+        index = layout->index;
+        for (i = 0; i < layout->cnt; i++) {
+                if (layout->list[i].err != 0)
+                        continue;
+                if ((layout->list[i].start == 0)
+                    && (layout->list[i].stop == 0))
+                        continue;
+                if (layout->list[i].start > layout->list[i].stop)
+                        continue;
+                index[cnt].start = layout->list[i].start;
+                index[cnt].stop  = layout->list[i].stop;
+                index[cnt].pos   = i;
+                cnt++;
+        }
+
+        if (cnt == 0)
+                return -1;
+
+        qsort (index, cnt, sizeof (*index), dht_layout_range_cmp);
+
+        /* with overlaps the first match in list[] order is what counts,
+           which a search over sorted ranges cannot tell */
+        for (i = 1; i < cnt; i++) {
+                if (index[i].start <= index[i - 1].stop)
+                        return -1;
+        }
+
+        __sync_synchronize ();
+        layout->index_cnt = cnt;
+
+        return 0;
+}
+
+
+xlator_t *
+dht_layout_search_hash (xlator_t *this, dht_layout_t *layout, uint32_t hash)
+{
+        dht_layout_range_t *index = NULL;
+        int                 cnt = 0;
+        int                 lo = 0;
+        int                 hi = 0;
+        int                 mid = 0;
+        int                 pos = -1;
+        int                 i = 0;
+
+        /* no barrier needed here: whatever is read from the index is
+           checked against list[] before it is used */
+        cnt = layout->index_cnt;
+        if (cnt > 0) {
+                index = layout->index;
+                lo = 0;
+                hi = cnt - 1;
+                while (lo <= hi) {
+                        mid = lo + (hi - lo) / 2;
+                        if (index[mid].start > hash) {
+                                hi = mid - 1;
+                        } else if (index[mid].stop < hash) {
+                                lo = mid + 1;
+                        } else {
+                                pos = index[mid].pos;
+                                break;
+                        }
+                }
+
+                /* the index is a copy; trust only what list[] says */
+                if ((pos >= 0) && (pos < layout->cnt)
+                    && (layout->list[pos].start <= hash)
+                    && (layout->list[pos].stop >= hash))
+                        return layout->list[pos].xlator;
+        }
+
+        for (i = 0; i < layout->cnt; i++) {
+                if (layout->list[i].start <= hash
+                    && layout->list[i].stop >= hash) {
+                        return layout->list[i].xlator;
+                }
+        }
+
+        return NULL;
+}
+
+
 xlator_t *
 dht_layout_search (xlator_t *this, dht_layout_t *layout, const char *name)
 {
         uint32_t   hash = 0;
         xlator_t  *subvol = NULL;
-        int        i = 0;
         int        ret = 0;
 
         ret = dht_hash_compute (this, layout->type, name, &hash);
@@ -172,13 +297,7 @@ dht_layout_search (xlator_t *this, dht_layout_t *layout, const char *name)
                 goto out;
         }
 
-        for (i = 0; i < layout->cnt; i++) {
-                if (layout->list[i].start <= hash
-                    && layout->list[i].stop >= hash) {
-                        subvol = layout->list[i].xlator;
-                        break;
-                }
-        }
+        subvol = dht_layout_search_hash (this, layout, hash);
 
         if (!subvol) {
                 gf_msg (this->name, GF_LOG_WARNING, 0,
@@ -335,6 +454,86 @@ dht_disk_layout_merge (xlator_t *this, dht_layout_t *layout,
         return 0;
 }
 
+/*
+ * Replace the name filter of subvol in layout with the one in xattr, which
+ * a brick only sends while the directory is unchanged since it read it.
+ * Without one (or on failure, xattr NULL) the old filter is dropped too, as
+ * the directory may have gained names since. Layouts in use are updated by
+ * revalidations, so the filters are only touched under conf->layout_lock.
+ */
+void
+dht_layout_bloom_set (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
+                      dict_t *xattr)
+{
+        gf_bloom_t *bloom = NULL;
+        gf_bloom_t *old = NULL;
+        void       *buf = NULL;
+        int         len = 0;
+        int         i = 0;
+        dht_conf_t *conf = this->private;
+
+        if (xattr && conf->lookup_bloom &&
+            !dict_get_ptr_and_len (xattr, GF_NAME_BLOOM_KEY, &buf, &len)) {
+                bloom = gf_bloom_unserialize (buf, len);
+                if (!bloom)
+                        gf_msg_debug (this->name, 0,
+                                      "invalid name filter from %s",
+                                      subvol->name);
+        }
+
+        LOCK (&conf->layout_lock);
+        {
+                for (i = 0; i < layout->cnt; i++) {
+                        if (layout->list[i].xlator != subvol)
+                                continue;
+                        old = layout->list[i].bloom;
+                        layout->list[i].bloom = bloom;
+                        layout->list[i].bloom_time = time (NULL);
+                        bloom = NULL;
+                        break;
+                }
+        }
+        UNLOCK (&conf->layout_lock);
+
+        gf_bloom_free (old);
+        gf_bloom_free (bloom);
+}
+
+
+/*
+ * Forget the name filters of a directory, for when this client adds names
+ * to it.
+ */
+void
+dht_layout_bloom_drop (xlator_t *this, inode_t *inode)
+{
+        dht_layout_t *layout = NULL;
+        gf_bloom_t   *bloom = NULL;
+        int           i = 0;
+        dht_conf_t   *conf = this->private;
+
+        if (!conf->lookup_bloom || !inode)
+                return;
+
+        layout = dht_layout_get (this, inode);
+        if (!layout)
+                return;
+
+        for (i = 0; i < layout->cnt; i++) {
+                LOCK (&conf->layout_lock);
+                {
+                        bloom = layout->list[i].bloom;
+                        layout->list[i].bloom = NULL;
+                }
+                UNLOCK (&conf->layout_lock);
+
+                gf_bloom_free (bloom);
+        }
+
+        dht_layout_unref (this, layout);
+}
+
+
 int
 dht_layout_merge (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
                   int op_ret, int op_errno, dict_t *xattr)
@@ -363,6 +562,9 @@ dht_layout_merge (xlator_t *this, dht_layout_t *layout, xlator_t *subvol,
                 goto out;
         }
 
+        if (xattr && (i < layout->cnt))
+                dht_layout_bloom_set (this, layout, subvol, xattr);
+
         if (xattr) {
                 /* during lookup and not mkdir */
                 ret = dict_get_ptr_and_len (xattr, conf->xattr_name,
@@ -409,24 +611,32 @@ dht_layout_entry_swap (dht_layout_t *layout, int i, int j)
         uint32_t  commit_hash_swap = 0;
         xlator_t *xlator_swap = 0;
         int       err_swap = 0;
+        gf_bloom_t *bloom_swap = NULL;
+        time_t    bloom_time_swap = 0;
 
         start_swap  = layout->list[i].start;
         stop_swap   = layout->list[i].stop;
         xlator_swap = layout->list[i].xlator;
         err_swap    = layout->list[i].err;
         commit_hash_swap = layout->list[i].commit_hash;
+        bloom_swap  = layout->list[i].bloom;
+        bloom_time_swap = layout->list[i].bloom_time;
 
         layout->list[i].start  = layout->list[j].start;
         layout->list[i].stop   = layout->list[j].stop;
         layout->list[i].xlator = layout->list[j].xlator;
         layout->list[i].err    = layout->list[j].err;
         layout->list[i].commit_hash = layout->list[j].commit_hash;
+        layout->list[i].bloom  = layout->list[j].bloom;
+        layout->list[i].bloom_time = layout->list[j].bloom_time;
 
         layout->list[j].start  = start_swap;
         layout->list[j].stop   = stop_swap;
         layout->list[j].xlator = xlator_swap;
         layout->list[j].err    = err_swap;
         layout->list[j].commit_hash = commit_hash_swap;
+        layout->list[j].bloom  = bloom_swap;
+        layout->list[j].bloom_time = bloom_time_swap;
 }
 
 void
@@ -34,6 +34,9 @@ enum gf_dht_mem_types_ {
         gf_dht_mt_container_t,
         gf_dht_mt_octx_t,
         gf_dht_mt_miginfo_t,
+        gf_dht_mt_migrating_t,
+        gf_dht_mt_crawl_dir_t,
+        gf_dht_mt_crawl_t,
         gf_dht_mt_end
 };
 #endif
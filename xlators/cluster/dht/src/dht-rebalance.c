@@ -676,41 +676,57 @@ out:
         return ret;
 }
 
-static inline int
-__dht_rebalance_migrate_data (xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst,
-                             uint64_t ia_size, int hole_exists)
+/*
+ * State shared by the tasks migrating the data of one file. Up to
+ * rebal-migrate-window tasks run at once, each taking the next block
+ * not yet taken, so that as many reads and writes are outstanding.
+ */
+typedef struct {
+        xlator_t         *from;
+        xlator_t         *to;
+        fd_t             *src;
+        fd_t             *dst;
+        uint64_t          size;
+        uint64_t          blksize;
+        int               hole_exists;
+        uint64_t          next;      /* next block to migrate, atomically */
+        int               ret;       /* first failure */
+        dht_migrating_t  *mig;
+        syncbarrier_t     barrier;
+} dht_migrate_window_t;
+
+
+static int
+dht_migrate_block (dht_migrate_window_t *win, off_t offset, size_t len)
 {
         int            ret    = 0;
         int            count  = 0;
-        off_t          offset = 0;
+        size_t         done   = 0;
         struct iovec  *vector = NULL;
         struct iobref *iobref = NULL;
-        uint64_t       total  = 0;
-        size_t         read_size = 0;
-
-        /* if file size is '0', no need to enter this loop */
-        while (total < ia_size) {
-                read_size = (((ia_size - total) > DHT_REBALANCE_BLKSIZE) ?
-                             DHT_REBALANCE_BLKSIZE : (ia_size - total));
-
-                ret = syncop_readv (from, src, read_size,
-                                    offset, 0, &vector, &count, &iobref, NULL,
-                                    NULL);
-                if (!ret || (ret < 0)) {
+
+        /* a short read leaves the rest of the block for the next readv */
+        while (done < len) {
+                ret = syncop_readv (win->from, win->src, len - done,
+                                    offset + done, 0, &vector, &count,
+                                    &iobref, NULL, NULL);
+                if (!ret || (ret < 0))
                         break;
-                }
 
-                if (hole_exists)
-                        ret = dht_write_with_holes (to, dst, vector, count,
-                                                    ret, offset, iobref);
+                if (win->hole_exists)
+                        ret = dht_write_with_holes (win->to, win->dst, vector,
+                                                    count, ret, offset + done,
+                                                    iobref);
                 else
-                        ret = syncop_writev (to, dst, vector, count,
-                                             offset, iobref, 0, NULL, NULL);
-                if (ret < 0) {
+                        ret = syncop_writev (win->to, win->dst, vector, count,
+                                             offset + done, iobref, 0, NULL,
+                                             NULL);
+                if (ret < 0)
                         break;
-                }
-                offset += ret;
-                total += ret;
+
+                done += ret;
+                if (win->mig)
+                        __sync_add_and_fetch (&win->mig->copied, ret);
 
                 GF_FREE (vector);
                 if (iobref)
@@ -722,15 +738,145 @@ __dht_rebalance_migrate_data (xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst
                 iobref_unref (iobref);
         GF_FREE (vector);
 
-        if (ret >= 0)
-                ret = 0;
-        else
-                ret = -1;
+        return (ret < 0) ? -1 : 0;
+}
+
+
+static int
+dht_migrate_blocks (void *opaque)
+{
+        dht_migrate_window_t *win = opaque;
+        uint64_t              off = 0;
+        int                   ret = 0;
+
+        for (;;) {
+                off = __sync_fetch_and_add (&win->next, win->blksize);
+                if (off >= win->size || win->ret < 0)
+                        break;
+
+                ret = dht_migrate_block (win, off,
+                                         min (win->blksize, win->size - off));
+                if (ret < 0) {
+                        __sync_bool_compare_and_swap (&win->ret, 0, ret);
+                        break;
+                }
+        }
 
         return ret;
 }
 
 
+static int
+dht_migrate_blocks_done (int ret, call_frame_t *frame, void *opaque)
+{
+        dht_migrate_window_t *win = opaque;
+
+        if (frame)
+                STACK_DESTROY (frame->root);
+        syncbarrier_wake (&win->barrier);
+        return 0;
+}
+
+
+static inline int
+__dht_rebalance_migrate_data (xlator_t *this, xlator_t *from, xlator_t *to,
+                              fd_t *src, fd_t *dst, uint64_t ia_size,
+                              int hole_exists, dht_migrating_t *mig)
+{
+        dht_conf_t           *conf    = this->private;
+        dht_migrate_window_t  win     = {0, };
+        struct synctask      *task    = NULL;
+        call_frame_t         *frame   = NULL;
+        int                   workers = 0;
+        int                   spawned = 0;
+        int                   ret     = 0;
+        int                   i       = 0;
+
+        win.from = from;
+        win.to = to;
+        win.src = src;
+        win.dst = dst;
+        win.size = ia_size;
+        win.hole_exists = hole_exists;
+        win.mig = mig;
+        win.blksize = conf->migrate_blksize;
+        if (!win.blksize)
+                win.blksize = DHT_REBALANCE_BLKSIZE;
+
+        /* if file size is '0', no task is needed */
+        workers = min (conf->migrate_window,
+                       ia_size / win.blksize + 1);
+
+        if (workers > 1) {
+                ret = syncbarrier_init (&win.barrier);
+                if (ret)
+                        workers = 1;
+        }
+
+        if (workers <= 1)
+                return dht_migrate_blocks (&win);
+
+        /* the tasks send their fops with the identity of the caller */
+        task = synctask_get ();
+        for (i = 0; i < workers; i++) {
+                frame = task ? copy_frame (task->opframe) : NULL;
+                if (synctask_new (this->ctx->env, dht_migrate_blocks,
+                                  dht_migrate_blocks_done, frame, &win) == 0)
+                        spawned++;
+                else if (frame)
+                        STACK_DESTROY (frame->root);
+        }
+        if (spawned)
+                syncbarrier_wait (&win.barrier, spawned);
+        else
+                win.ret = -1;
+        syncbarrier_destroy (&win.barrier);
+
+        return win.ret;
+}
+
+
+static dht_migrating_t *
+dht_migrating_add (gf_defrag_info_t *defrag, loc_t *loc, uint64_t size)
+{
+        dht_migrating_t *mig = NULL;
+
+        mig = GF_CALLOC (1, sizeof (*mig), gf_dht_mt_migrating_t);
+        if (!mig)
+                return NULL;
+
+        mig->path = gf_strdup (loc->path);
+        mig->size = size;
+        gettimeofday (&mig->start, NULL);
+        INIT_LIST_HEAD (&mig->list);
+
+        LOCK (&defrag->lock);
+        {
+                list_add_tail (&mig->list, &defrag->migrating);
+        }
+        UNLOCK (&defrag->lock);
+
+        return mig;
+}
+
+
+static void
+dht_migrating_del (gf_defrag_info_t *defrag, dht_migrating_t *mig)
+{
+        if (!mig)
+                return;
+
+        LOCK (&defrag->lock);
+        {
+                list_del_init (&mig->list);
+        }
+        UNLOCK (&defrag->lock);
+
+        GF_FREE (mig->path);
+        GF_FREE (mig);
+}
+
+
 static inline int
 __dht_rebalance_open_src_file (xlator_t *from, xlator_t *to, loc_t *loc,
                                struct iatt *stbuf, fd_t **src_fd)
@@ -988,6 +1134,7 @@ dht_migrate_file (xlator_t *this, loc_t *loc, xlator_t *from, xlator_t *to,
         gf_boolean_t    locked               = _gf_false;
         int             lk_ret               = -1;
         gf_defrag_info_t *defrag              =  NULL;
+        dht_migrating_t *mig                 = NULL;
 
         defrag = conf->defrag;
         if (!defrag)
@@ -1110,8 +1257,11 @@ dht_migrate_file (xlator_t *this, loc_t *loc, xlator_t *from, xlator_t *to,
                 file_has_holes = 1;
 
         /* All I/O happens in this function */
-        ret = __dht_rebalance_migrate_data (from, to, src_fd, dst_fd,
-					    stbuf.ia_size, file_has_holes);
+        mig = dht_migrating_add (defrag, loc, stbuf.ia_size);
+        ret = __dht_rebalance_migrate_data (this, from, to, src_fd, dst_fd,
+                                            stbuf.ia_size, file_has_holes,
+                                            mig);
+        dht_migrating_del (defrag, mig);
         if (ret) {
                 gf_msg (this->name, GF_LOG_ERROR, 0,
                         DHT_MSG_MIGRATE_FILE_FAILED,
@@ -1593,6 +1743,7 @@ gf_defrag_migrate_single_file (void *opaque)
                 }
                 UNLOCK (&defrag->lock);
 
+                rebal_entry->failed = 1;
                 ret = 0;
 
                 gf_log (this->name, GF_LOG_ERROR, "Child loc build failed");
@@ -1610,6 +1761,9 @@ gf_defrag_migrate_single_file (void *opaque)
                         DHT_MSG_MIGRATE_FILE_FAILED,
                         "Migrate file failed: %s lookup failed",
                         entry_loc.name);
+                /* a file gone meanwhile has nothing left to migrate */
+                if (ret != -ENOENT)
+                        rebal_entry->failed = 1;
                 ret = 0;
                 goto out;
         }
@@ -1633,6 +1787,8 @@ gf_defrag_migrate_single_file (void *opaque)
                                 defrag->skipped += 1;
                         }
                         UNLOCK (&defrag->lock);
+                        /* left for a restart to try again */
+                        rebal_entry->failed = 1;
                 } else if (op_errno != EEXIST) {
                         gf_msg (this->name, GF_LOG_ERROR, 0,
                                 DHT_MSG_MIGRATE_FILE_FAILED,
@@ -1644,6 +1800,7 @@ gf_defrag_migrate_single_file (void *opaque)
                         }
                         UNLOCK (&defrag->lock);
 
+                        rebal_entry->failed = 1;
                 }
 
                 ret = gf_defrag_handle_migrate_error (op_errno, defrag);
@@ -1669,6 +1826,8 @@ gf_defrag_migrate_single_file (void *opaque)
                         defrag->total_failures += 1;
                 }
                 UNLOCK (&defrag->lock);
+
+                rebal_entry->failed = 1;
         }
 
         LOCK (&defrag->lock);
@@ -1791,9 +1950,15 @@ gf_defrag_task (void *opaque)
 
                                         defrag->defrag_status =
                                                        GF_DEFRAG_STATUS_FAILED;
+                                        gf_defrag_crawl_dir_put
+                                                (iterator->this,
+                                                 iterator->crawl_dir, 1);
                                         goto out;
                                 }
 
+                                gf_defrag_crawl_dir_put (iterator->this,
+                                                         iterator->crawl_dir,
+                                                         iterator->failed);
                                 gf_dirent_free (iterator->df_entry);
                                 GF_FREE (iterator);
                                 continue;
@@ -2094,7 +2259,7 @@ out:
 
 int
 gf_defrag_process_dir (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                       dict_t *migrate_data)
+                       dict_t *migrate_data, dht_crawl_dir_t *crawl_dir)
 {
         int                      ret               = -1;
         fd_t                    *fd                = NULL;
@@ -2298,6 +2463,12 @@ gf_defrag_process_dir (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                                 continue;
                         }
 
+                        /* the directory is not done until this file is */
+                        if (crawl_dir) {
+                                __sync_add_and_fetch (&crawl_dir->refs, 1);
+                                container->crawl_dir = crawl_dir;
+                        }
+
                         /* Q this entry in the dfq */
                         pthread_mutex_lock (&defrag->dfq_mutex);
                         {
@@ -2343,10 +2514,11 @@ out:
 }
 int
 gf_defrag_settle_hash (xlator_t *this, gf_defrag_info_t *defrag,
-                       loc_t *loc, dict_t *fix_layout)
+                       loc_t *loc)
 {
         int     ret;
         dht_conf_t *conf = NULL;
+        dict_t *settle = NULL;
         /*
          * Now we're ready to update the directory commit hash for the volume
          * root, so that hash miscompares and broadcast lookups can stop.
@@ -2375,31 +2547,323 @@ gf_defrag_settle_hash (xlator_t *this, gf_defrag_info_t *defrag,
                 return 0;
         }
 
-        ret = dict_set_uint32 (fix_layout, "new-commit-hash",
+        /* Directories are settled by several crawl tasks at once, so each
+         * call needs a dict of its own. */
+        settle = dict_new ();
+        if (!settle)
+                return -1;
+
+        ret = dict_set_str (settle, GF_XATTR_FIX_LAYOUT_KEY, "yes");
+        if (ret)
+                goto out;
+
+        ret = dict_set_uint32 (settle, "new-commit-hash",
                                defrag->new_commit_hash);
         if (ret) {
                 gf_log (this->name, GF_LOG_ERROR,
                         "Failed to set new-commit-hash");
-                return -1;
+                goto out;
         }
 
-        ret = syncop_setxattr (this, loc, fix_layout, 0, NULL, NULL);
+        ret = syncop_setxattr (this, loc, settle, 0, NULL, NULL);
         if (ret) {
                 gf_log (this->name, GF_LOG_ERROR,
                         "fix layout on %s failed", loc->path);
+                goto out;
+        }
+out:
+        dict_unref (settle);
+        return ret ? -1 : 0;
+}
+
+static uint64_t
+gf_defrag_usec_since (struct timeval *start)
+{
+        struct timeval now = {0,};
+
+        gettimeofday (&now, NULL);
+        return (now.tv_sec - start->tv_sec) * 1000000 +
+               (now.tv_usec - start->tv_usec);
+}
+
+/* Record that the subtree at @loc is done for this rebalance run. */
+static int
+gf_defrag_crawl_checkpoint (xlator_t *this, gf_defrag_info_t *defrag,
+                            loc_t *loc)
+{
+        dict_t *mark = NULL;
+        int     ret  = -1;
+
+        mark = dict_new ();
+        if (!mark)
                 return -1;
+
+        ret = dict_set_str (mark, defrag->crawl_key, defrag->crawl_mark);
+        if (!ret)
+                ret = syncop_setxattr (this, loc, mark, 0, NULL, NULL);
+        if (ret)
+                gf_log (this->name, GF_LOG_WARNING, "failed to set crawl "
+                        "checkpoint on %s (%s)", loc->path, strerror (-ret));
+
+        dict_unref (mark);
+        return ret;
+}
+
+/* Whether a previous run with the same commit hash and command already
+ * finished the subtree, judging by the lookup reply @xattr. */
+static gf_boolean_t
+gf_defrag_crawl_is_done (gf_defrag_info_t *defrag, dict_t *xattr)
+{
+        data_t *data = NULL;
+
+        if (!defrag->crawl_checkpoint || !xattr)
+                return _gf_false;
+
+        data = dict_get (xattr, defrag->crawl_key);
+        if (!data || !data->data)
+                return _gf_false;
+
+        /* "1234:1" must not pass for "1234:10"; the value may or may not
+         * carry its terminating NUL */
+        return (strnlen (data->data, data->len) ==
+                strlen (defrag->crawl_mark)) &&
+               (memcmp (data->data, defrag->crawl_mark,
+                        strlen (defrag->crawl_mark)) == 0);
+}
+
+static dht_crawl_dir_t *
+gf_defrag_crawl_dir_new (loc_t *loc, dht_crawl_dir_t *parent)
+{
+        dht_crawl_dir_t *dir = NULL;
+
+        dir = GF_CALLOC (1, sizeof (*dir), gf_dht_mt_crawl_dir_t);
+        if (!dir)
+                return NULL;
+
+        if (loc_copy (&dir->loc, loc)) {
+                GF_FREE (dir);
+                return NULL;
+        }
+
+        INIT_LIST_HEAD (&dir->list);
+        dir->refs = 1;
+        dir->parent = parent;
+        if (parent)
+                __sync_add_and_fetch (&parent->refs, 1);
+
+        return dir;
+}
+
+/* Drop a reference on @dir. The last one settles the hash of the
+ * directory and checkpoints it, unless something under it failed, and
+ * then drops the reference it held on its parent. The root is settled
+ * by gf_defrag_start_crawl itself. */
+void
+gf_defrag_crawl_dir_put (xlator_t *this, dht_crawl_dir_t *dir, int failed)
+{
+        dht_conf_t       *conf   = this->private;
+        gf_defrag_info_t *defrag = conf->defrag;
+        dht_crawl_dir_t  *parent = NULL;
+
+        while (dir) {
+                if (failed)
+                        dir->failed = 1;
+
+                if (__sync_sub_and_fetch (&dir->refs, 1) > 0)
+                        break;
+
+                parent = dir->parent;
+                failed = dir->failed;
+
+                if (parent && !failed &&
+                    defrag->defrag_status == GF_DEFRAG_STATUS_STARTED) {
+                        if (gf_defrag_settle_hash (this, defrag,
+                                                   &dir->loc) != 0) {
+                                __sync_add_and_fetch (&defrag->total_failures,
+                                                      1);
+                                defrag->defrag_status =
+                                        GF_DEFRAG_STATUS_FAILED;
+                                failed = 1;
+                        } else if (defrag->crawl_checkpoint) {
+                                gf_defrag_crawl_checkpoint (this, defrag,
+                                                            &dir->loc);
+                        }
+                }
+
+                loc_wipe (&dir->loc);
+                GF_FREE (dir);
+                dir = parent;
+        }
+}
+
+/*
+ * State shared by the tasks crawling the directory tree. A task queues
+ * the subdirectories it finds for the others, and takes the most recently
+ * queued one when it is done with its own; a full queue means the subtree
+ * is crawled in place, depth first, as a single task would.
+ */
+#define GF_DEFRAG_CRAWL_QUEUE_MAX       1024
+
+typedef struct {
+        xlator_t          *this;
+        gf_defrag_info_t  *defrag;
+        dict_t            *fix_layout;
+        dict_t            *migrate_data;
+        dict_t            *xattr_req;
+        int                threads;
+        gf_lock_t          lock;
+        struct list_head   queue;     /* LIFO of dht_crawl_dir_t */
+        int                queued;
+        int                running;   /* tasks still taking from the queue */
+        int                ret;       /* first failure */
+        int                refs;      /* the caller and each task */
+        syncbarrier_t      barrier;
+} gf_defrag_crawl_t;
+
+static void
+gf_defrag_crawl_unref (gf_defrag_crawl_t *crawl)
+{
+        if (__sync_sub_and_fetch (&crawl->refs, 1) > 0)
+                return;
+
+        if (crawl->threads > 1)
+                syncbarrier_destroy (&crawl->barrier);
+        LOCK_DESTROY (&crawl->lock);
+        if (crawl->xattr_req)
+                dict_unref (crawl->xattr_req);
+        GF_FREE (crawl);
+}
+
+static int
+gf_defrag_crawl_dir (gf_defrag_crawl_t *crawl, dht_crawl_dir_t *dir);
+
+static dht_crawl_dir_t *
+gf_defrag_crawl_pop (gf_defrag_crawl_t *crawl)
+{
+        dht_crawl_dir_t *dir = NULL;
+
+        LOCK (&crawl->lock);
+        {
+                if (!list_empty (&crawl->queue)) {
+                        dir = list_entry (crawl->queue.next,
+                                          dht_crawl_dir_t, list);
+                        list_del_init (&dir->list);
+                        crawl->queued--;
+                }
         }
+        UNLOCK (&crawl->lock);
 
-        /* TBD: find more efficient solution than adding/deleting every time */
-        dict_del(fix_layout, "new-commit-hash");
+        return dir;
+}
+
+static int
+gf_defrag_crawl_task (void *opaque)
+{
+        gf_defrag_crawl_t *crawl = opaque;
+        dht_crawl_dir_t   *dir   = NULL;
+
+        for (;;) {
+                LOCK (&crawl->lock);
+                {
+                        if (list_empty (&crawl->queue)) {
+                                crawl->running--;
+                                dir = NULL;
+                        } else {
+                                dir = list_entry (crawl->queue.next,
+                                                  dht_crawl_dir_t, list);
+                                list_del_init (&dir->list);
+                                crawl->queued--;
+                        }
+                }
+                UNLOCK (&crawl->lock);
+
+                if (!dir)
+                        break;
+
+                gf_defrag_crawl_dir (crawl, dir);
+        }
 
         return 0;
 }
 
-int
-gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
-                  dict_t *fix_layout, dict_t *migrate_data)
+static int
+gf_defrag_crawl_task_done (int ret, call_frame_t *frame, void *opaque)
+{
+        gf_defrag_crawl_t *crawl = opaque;
+
+        if (frame)
+                STACK_DESTROY (frame->root);
+        syncbarrier_wake (&crawl->barrier);
+        gf_defrag_crawl_unref (crawl);
+        return 0;
+}
+
+/* Hand @dir to another task, or crawl it here if the queue is full. */
+static int
+gf_defrag_crawl_push (gf_defrag_crawl_t *crawl, dht_crawl_dir_t *dir)
 {
+        struct synctask *task   = NULL;
+        call_frame_t    *frame  = NULL;
+        gf_boolean_t     queued = _gf_false;
+        gf_boolean_t     spawn  = _gf_false;
+
+        LOCK (&crawl->lock);
+        {
+                if (crawl->threads > 1 &&
+                    crawl->queued < GF_DEFRAG_CRAWL_QUEUE_MAX) {
+                        list_add (&dir->list, &crawl->queue);
+                        crawl->queued++;
+                        queued = _gf_true;
+
+                        /* the calling task counts as one of the threads */
+                        if (crawl->running < crawl->threads - 1) {
+                                crawl->running++;
+                                __sync_add_and_fetch (&crawl->refs, 1);
+                                spawn = _gf_true;
+                        }
+                }
+        }
+        UNLOCK (&crawl->lock);
+
+        if (!queued)
+                return gf_defrag_crawl_dir (crawl, dir);
+
+        if (!spawn)
+                return 0;
+
+        /* the tasks send their fops with the identity of the crawl */
+        task = synctask_get ();
+        frame = task ? copy_frame (task->opframe) : NULL;
+        if (synctask_new (crawl->this->ctx->env, gf_defrag_crawl_task,
+                          gf_defrag_crawl_task_done, frame, crawl) != 0) {
+                if (frame)
+                        STACK_DESTROY (frame->root);
+                /* whoever drains the queue will take it */
+                LOCK (&crawl->lock);
+                {
+                        crawl->running--;
+                }
+                UNLOCK (&crawl->lock);
+                gf_defrag_crawl_unref (crawl);
+        }
+
+        return 0;
+}
+
+static void
+gf_defrag_crawl_fail (gf_defrag_crawl_t *crawl, int ret)
+{
+        __sync_bool_compare_and_swap (&crawl->ret, 0, ret);
+}
+
+/* Migrate the files of @dir, then fix the layout of each subdirectory
+ * and push it to be crawled in turn. Drops the reference on @dir. */
+static int
+gf_defrag_crawl_dir (gf_defrag_crawl_t *crawl, dht_crawl_dir_t *dir)
+{
+        xlator_t                *this           = crawl->this;
+        gf_defrag_info_t        *defrag         = crawl->defrag;
+        loc_t                   *loc            = &dir->loc;
         int                      ret            = -1;
         loc_t                    entry_loc      = {0,};
         fd_t                    *fd             = NULL;
@@ -2410,8 +2874,19 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         off_t                    offset         = 0;
         struct iatt              iatt           = {0,};
         inode_t                 *linked_inode   = NULL, *inode = NULL;
+        dht_crawl_dir_t         *child          = NULL;
+        dict_t                  *xattr_rsp      = NULL;
+        struct timeval           start          = {0,};
+
+        if (crawl->ret) {
+                ret = crawl->ret;
+                goto out;
+        }
 
+        gettimeofday (&start, NULL);
         ret = syncop_lookup (this, loc, &iatt, NULL, NULL, NULL);
+        __sync_add_and_fetch (&defrag->crawl_lookup_usec,
+                              gf_defrag_usec_since (&start));
         if (ret) {
                 gf_log (this->name, GF_LOG_ERROR, "Lookup failed on %s",
                         loc->path);
@@ -2421,7 +2896,11 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
 
         if ((defrag->cmd != GF_DEFRAG_CMD_START_TIER) &&
             (defrag->cmd != GF_DEFRAG_CMD_START_LAYOUT_FIX)) {
-                ret = gf_defrag_process_dir (this, defrag, loc, migrate_data);
+                gettimeofday (&start, NULL);
+                ret = gf_defrag_process_dir (this, defrag, loc,
+                                             crawl->migrate_data, dir);
+                __sync_add_and_fetch (&defrag->crawl_queue_usec,
+                                      gf_defrag_usec_since (&start));
                 if (ret)
                         goto out;
         }
@@ -2444,9 +2923,14 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         }
 
         INIT_LIST_HEAD (&entries.list);
-        while ((ret = syncop_readdirp (this, fd, 131072, offset, &entries,
-                                       NULL, NULL)) != 0)
-        {
+        for (;;) {
+                gettimeofday (&start, NULL);
+                ret = syncop_readdirp (this, fd, 131072, offset, &entries,
+                                       NULL, NULL);
+                __sync_add_and_fetch (&defrag->crawl_readdir_usec,
+                                      gf_defrag_usec_since (&start));
+                if (ret == 0)
+                        break;
 
                 if (ret < 0) {
                         gf_log (this->name, GF_LOG_ERROR, "Readdir returned %s"
@@ -2466,6 +2950,12 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                                 goto out;
                         }
 
+                        /* another task failed, no point going on */
+                        if (crawl->ret) {
+                                ret = crawl->ret;
+                                goto out;
+                        }
+
                         offset = entry->d_off;
 
                         if (!strcmp (entry->d_name, ".") ||
@@ -2519,8 +3009,16 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
 
                         gf_uuid_copy (entry_loc.pargfid, loc->gfid);
 
+                        if (xattr_rsp) {
+                                dict_unref (xattr_rsp);
+                                xattr_rsp = NULL;
+                        }
+
+                        gettimeofday (&start, NULL);
                         ret = syncop_lookup (this, &entry_loc, &iatt, NULL,
-                                             NULL, NULL);
+                                             crawl->xattr_req, &xattr_rsp);
+                        __sync_add_and_fetch (&defrag->crawl_lookup_usec,
+                                              gf_defrag_usec_since (&start));
                         if (ret) {
                                 gf_log (this->name, GF_LOG_ERROR, "%s"
                                         " lookup failed", entry_loc.path);
@@ -2528,36 +3026,41 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
                                 continue;
                         }
 
-                        ret = syncop_setxattr (this, &entry_loc, fix_layout,
-                                               0, NULL, NULL);
+                        if (gf_defrag_crawl_is_done (defrag, xattr_rsp)) {
+                                gf_msg_debug (this->name, 0, "%s: done by an "
+                                              "earlier run, skipping",
+                                              entry_loc.path);
+                                __sync_add_and_fetch (&defrag->crawl_skipped,
+                                                      1);
+                                continue;
+                        }
+
+                        gettimeofday (&start, NULL);
+                        ret = syncop_setxattr (this, &entry_loc,
+                                               crawl->fix_layout, 0, NULL,
+                                               NULL);
+                        __sync_add_and_fetch (&defrag->crawl_layout_usec,
+                                              gf_defrag_usec_since (&start));
                         if (ret) {
                                 gf_log (this->name, GF_LOG_ERROR, "Setxattr "
                                         "failed for %s", entry_loc.path);
                                 defrag->defrag_status =
                                 GF_DEFRAG_STATUS_FAILED;
-                                defrag->total_failures ++;
+                                __sync_add_and_fetch (&defrag->total_failures,
+                                                      1);
                                 ret = -1;
                                 goto out;
                         }
-                        ret = gf_defrag_fix_layout (this, defrag, &entry_loc,
-                                                    fix_layout, migrate_data);
 
-                        if (ret) {
-                                gf_msg (this->name, GF_LOG_ERROR, 0,
-                                        DHT_MSG_LAYOUT_FIX_FAILED,
-                                        "Fix layout failed for %s",
-                                        entry_loc.path);
-                                defrag->total_failures++;
+                        child = gf_defrag_crawl_dir_new (&entry_loc, dir);
+                        if (!child) {
                                 ret = -1;
                                 goto out;
                         }
 
-                        if (gf_defrag_settle_hash (this, defrag, &entry_loc,
-                            fix_layout) != 0) {
-                                defrag->total_failures++;
-                                ret = -1;
+                        ret = gf_defrag_crawl_push (crawl, child);
+                        if (ret)
                                 goto out;
-                        }
                 }
                 gf_dirent_free (&entries);
                 free_entries = _gf_false;
@@ -2565,19 +3068,108 @@ gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
         }
 
         ret = 0;
+        __sync_add_and_fetch (&defrag->crawl_dirs, 1);
 out:
+        if (ret && !crawl->ret) {
+                if (ret < 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                DHT_MSG_LAYOUT_FIX_FAILED,
+                                "Fix layout failed for %s", loc->path);
+                        __sync_add_and_fetch (&defrag->total_failures, 1);
+                }
+                gf_defrag_crawl_fail (crawl, ret);
+        }
+
         if (free_entries)
                 gf_dirent_free (&entries);
 
+        if (xattr_rsp)
+                dict_unref (xattr_rsp);
+
         loc_wipe (&entry_loc);
 
         if (fd)
                 fd_unref (fd);
 
+        gf_defrag_crawl_dir_put (this, dir, ret != 0);
+
         return ret;
 
 }
 
+int
+gf_defrag_fix_layout (xlator_t *this, gf_defrag_info_t *defrag, loc_t *loc,
+                  dict_t *fix_layout, dict_t *migrate_data)
+{
+        dht_conf_t              *conf           = this->private;
+        gf_defrag_crawl_t       *crawl          = NULL;
+        dht_crawl_dir_t         *root           = NULL;
+        dht_crawl_dir_t         *dir            = NULL;
+        gf_boolean_t             idle           = _gf_false;
+        int                      running        = 0;
+        int                      ret            = -1;
+
+        crawl = GF_CALLOC (1, sizeof (*crawl), gf_dht_mt_crawl_t);
+        if (!crawl)
+                goto out;
+
+        crawl->this = this;
+        crawl->defrag = defrag;
+        crawl->fix_layout = fix_layout;
+        crawl->migrate_data = migrate_data;
+        crawl->threads = conf->crawl_threads;
+        crawl->refs = 1;
+        LOCK_INIT (&crawl->lock);
+        INIT_LIST_HEAD (&crawl->queue);
+
+        if (defrag->crawl_checkpoint) {
+                crawl->xattr_req = dict_new ();
+                if (!crawl->xattr_req ||
+                    dict_set_int32 (crawl->xattr_req, defrag->crawl_key, 0)) {
+                        gf_log (this->name, GF_LOG_WARNING, "crawl "
+                                "checkpoints disabled");
+                        defrag->crawl_checkpoint = _gf_false;
+                }
+        }
+
+        if (crawl->threads > 1 && syncbarrier_init (&crawl->barrier))
+                crawl->threads = 1;
+
+        root = gf_defrag_crawl_dir_new (loc, NULL);
+        if (!root)
+                goto out;
+
+        gf_defrag_crawl_dir (crawl, root);
+
+        /* Help with what the other tasks queued, then wait for them. A
+         * subtree queued when no task could be spawned is taken here. */
+        for (;;) {
+                while ((dir = gf_defrag_crawl_pop (crawl)))
+                        gf_defrag_crawl_dir (crawl, dir);
+
+                LOCK (&crawl->lock);
+                {
+                        running = crawl->running;
+                        idle = list_empty (&crawl->queue);
+                }
+                UNLOCK (&crawl->lock);
+
+                if (!running && idle)
+                        break;
+                if (running)
+                        syncbarrier_wait (&crawl->barrier, 1);
+        }
+
+        ret = crawl->ret;
+out:
+        gettimeofday (&defrag->crawl_end, NULL);
+
+        if (crawl)
+                gf_defrag_crawl_unref (crawl);
+
+        return ret;
+}
+
 int
 gf_defrag_start_crawl (void *data)
 {
@@ -2599,6 +3191,8 @@ gf_defrag_start_crawl (void *data)
         int                     err             = 0;
         int                     thread_spawn_count = 0;
         pthread_t tid[MAX_MIGRATOR_THREAD_COUNT];
+        struct dht_container   *container       = NULL;
+        struct dht_container   *tmp_container   = NULL;
 
         this = data;
         if (!this)
@@ -2767,6 +3361,21 @@ gf_defrag_start_crawl (void *data)
                 }
         }
 
+        /* Subtrees done by an earlier run of this same rebalance are
+         * marked with its commit hash; tiering crawls more than once a
+         * run and does not use the marks. Marks are never removed: a new
+         * rebalance has a new commit hash, so it ignores the ones it finds
+         * and overwrites them as it settles each directory. */
+        defrag->crawl_checkpoint = conf->crawl_checkpoint &&
+                ((defrag->cmd == GF_DEFRAG_CMD_START) ||
+                 (defrag->cmd == GF_DEFRAG_CMD_START_FORCE) ||
+                 (defrag->cmd == GF_DEFRAG_CMD_START_LAYOUT_FIX));
+        snprintf (defrag->crawl_key, sizeof (defrag->crawl_key),
+                  "%s.crawled.%s", conf->xattr_name,
+                  uuid_utoa (defrag->node_uuid));
+        snprintf (defrag->crawl_mark, sizeof (defrag->crawl_mark),
+                  "%u:%d", conf->vol_commit_hash, defrag->cmd);
+
         ret = gf_defrag_fix_layout (this, defrag, &loc, fix_layout,
                                     migrate_data);
         if (ret) {
@@ -2775,7 +3384,7 @@ gf_defrag_start_crawl (void *data)
                 goto out;
         }
 
-        if (gf_defrag_settle_hash (this, defrag, &loc, fix_layout) != 0) {
+        if (gf_defrag_settle_hash (this, defrag, &loc) != 0) {
                 defrag->total_failures++;
                 ret = -1;
                 goto out;
@@ -2832,6 +3441,16 @@ out:
         }
 
         if (defrag->queue) {
+                /* entries left behind by a failed run still hold their
+                 * directories */
+                list_for_each_entry_safe (container, tmp_container,
+                                          &(defrag->queue[0].list), list) {
+                        list_del_init (&container->list);
+                        gf_defrag_crawl_dir_put (this, container->crawl_dir,
+                                                 1);
+                        gf_dirent_free (container->df_entry);
+                        GF_FREE (container);
+                }
                 gf_dirent_free (defrag->queue[0].df_entry);
                 INIT_LIST_HEAD (&(defrag->queue[0].list));
         }
@@ -2918,6 +3537,102 @@ out:
         return NULL;
 }
 
+/* Progress of the files whose data is being migrated right now, as
+ * bytes copied so far and bytes per second since the copy started. */
+static void
+gf_defrag_migrating_status_get (gf_defrag_info_t *defrag, dict_t *dict,
+                                struct timeval *now)
+{
+        dht_migrating_t *mig   = NULL;
+        char             key[64] = {0,};
+        double           usec  = 0;
+        uint64_t         rate  = 0;
+        int              count = 0;
+        int              ret   = 0;
+
+        LOCK (&defrag->lock);
+        {
+                list_for_each_entry (mig, &defrag->migrating, list) {
+                        usec = (now->tv_sec - mig->start.tv_sec) * 1e6 +
+                               (now->tv_usec - mig->start.tv_usec);
+                        rate = (usec > 0) ? (mig->copied * 1e6 / usec) : 0;
+
+                        if (!dict) {
+                                gf_msg (THIS->name, GF_LOG_INFO, 0,
+                                        DHT_MSG_REBALANCE_STATUS,
+                                        "Migrating %s: %"PRIu64" of %"PRIu64
+                                        " bytes, %"PRIu64" bytes/sec",
+                                        mig->path, mig->copied, mig->size,
+                                        rate);
+                                count++;
+                                continue;
+                        }
+
+                        snprintf (key, sizeof (key), "migrating-file-%d",
+                                  count);
+                        ret = dict_set_dynstr_with_alloc (dict, key,
+                                                          mig->path);
+                        snprintf (key, sizeof (key), "migrating-bytes-%d",
+                                  count);
+                        ret |= dict_set_uint64 (dict, key, mig->copied);
+                        snprintf (key, sizeof (key), "migrating-rate-%d",
+                                  count);
+                        ret |= dict_set_uint64 (dict, key, rate);
+                        if (ret)
+                                gf_log (THIS->name, GF_LOG_WARNING,
+                                        "failed to set progress of %s",
+                                        mig->path);
+                        count++;
+                }
+        }
+        UNLOCK (&defrag->lock);
+
+        if (dict && dict_set_int32 (dict, "migrating-files", count))
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set migrating file count");
+}
+
+/* Directories crawled and skipped, the time the crawl took and, summed
+ * over the crawl tasks, the time spent in each of its phases. */
+static void
+gf_defrag_crawl_status_get (gf_defrag_info_t *defrag, dict_t *dict,
+                            struct timeval *now)
+{
+        struct timeval *end     = now;
+        double          elapsed = 0;
+        double          lookup  = defrag->crawl_lookup_usec / 1e6;
+        double          layout  = defrag->crawl_layout_usec / 1e6;
+        double          readdir = defrag->crawl_readdir_usec / 1e6;
+        double          queue   = defrag->crawl_queue_usec / 1e6;
+        int             ret     = 0;
+
+        if (defrag->crawl_end.tv_sec)
+                end = &defrag->crawl_end;
+        elapsed = (end->tv_sec - defrag->start_time.tv_sec) +
+                  (end->tv_usec - defrag->start_time.tv_usec) / 1e6;
+
+        if (!dict) {
+                gf_msg (THIS->name, GF_LOG_INFO, 0, DHT_MSG_REBALANCE_STATUS,
+                        "Crawled %"PRIu64" directories, skipped %"PRIu64
+                        " in %.2f secs (lookup: %.2f, fix-layout: %.2f, "
+                        "readdir: %.2f, queueing files: %.2f secs)",
+                        defrag->crawl_dirs, defrag->crawl_skipped, elapsed,
+                        lookup, layout, readdir, queue);
+                return;
+        }
+
+        ret = dict_set_uint64 (dict, "crawl-dirs", defrag->crawl_dirs);
+        ret |= dict_set_uint64 (dict, "crawl-skipped", defrag->crawl_skipped);
+        ret |= dict_set_double (dict, "crawl-time", elapsed);
+        ret |= dict_set_double (dict, "crawl-lookup-time", lookup);
+        ret |= dict_set_double (dict, "crawl-fix-layout-time", layout);
+        ret |= dict_set_double (dict, "crawl-readdir-time", readdir);
+        ret |= dict_set_double (dict, "crawl-queue-time", queue);
+        if (ret)
+                gf_log (THIS->name, GF_LOG_WARNING,
+                        "failed to set crawl times");
+}
+
 int
 gf_defrag_status_get (gf_defrag_info_t *defrag, dict_t *dict)
 {
@@ -3002,6 +3717,9 @@ gf_defrag_status_get (gf_defrag_info_t *defrag, dict_t *dict)
         if (ret)
                 gf_log (THIS->name, GF_LOG_WARNING,
                         "failed to set skipped file count");
+
+        gf_defrag_migrating_status_get (defrag, dict, &end);
+        gf_defrag_crawl_status_get (defrag, dict, &end);
 log:
         switch (defrag->defrag_status) {
         case GF_DEFRAG_STATUS_NOT_STARTED:
@@ -3031,6 +3749,10 @@ log:
                 PRIu64", lookups: %"PRIu64", failures: %"PRIu64", skipped: "
                 "%"PRIu64, files, size, lookup, failures, skipped);
 
+        if (!dict) {
+                gf_defrag_migrating_status_get (defrag, NULL, &end);
+                gf_defrag_crawl_status_get (defrag, NULL, &end);
+        }
 
 out:
         return 0;
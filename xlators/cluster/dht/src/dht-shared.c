@@ -152,6 +152,12 @@ dht_priv_dump (xlator_t *this)
         gf_proc_dump_write("disk_unit", "%c", conf->disk_unit);
         gf_proc_dump_write("refresh_interval", "%d", conf->refresh_interval);
         gf_proc_dump_write("unhashed_sticky_bit", "%d", conf->unhashed_sticky_bit);
+        gf_proc_dump_write("lookup_unhashed_bloom", "%d", conf->lookup_bloom);
+        gf_proc_dump_write("lookup_bloom.checks", "%"PRIu64,
+                           conf->bloom_checks);
+        gf_proc_dump_write("lookup_bloom.hits", "%"PRIu64, conf->bloom_hits);
+        gf_proc_dump_write("lookup_bloom.false_positives", "%"PRIu64,
+                           conf->bloom_false_positives);
 
         if (conf->du_stats && conf->subvolume_status) {
                 for (i = 0; i < conf->subvolume_cnt; i++) {
@@ -335,7 +341,8 @@ out:
 }
 void
 dht_init_regex (xlator_t *this, dict_t *odict, char *name,
-                regex_t *re, gf_boolean_t *re_valid)
+                regex_t *re, gf_boolean_t *re_valid,
+                dht_regex_filter_t *filter)
 {
         char    *temp_str;
 
@@ -358,6 +365,7 @@ dht_init_regex (xlator_t *this, dict_t *odict, char *name,
         if (regcomp(re,temp_str,REG_EXTENDED) == 0) {
                 gf_msg_debug (this->name, 0,
                               "using regex %s = %s", name, temp_str);
+                dht_regex_filter_init (filter, temp_str);
                 *re_valid = _gf_true;
         }
         else {
@@ -447,12 +455,22 @@ dht_reconfigure (xlator_t *this, dict_t *options)
 
         GF_OPTION_RECONF ("readdir-optimize", conf->readdir_optimize, options,
                           bool, out);
+        GF_OPTION_RECONF ("lookup-unhashed-bloom", conf->lookup_bloom,
+                          options, bool, out);
         GF_OPTION_RECONF ("randomize-hash-range-by-gfid",
                           conf->randomize_by_gfid,
                           options, bool, out);
 
         GF_OPTION_RECONF ("rebal-throttle", conf->dthrottle, options,
                           str, out);
+        GF_OPTION_RECONF ("rebal-migrate-window", conf->migrate_window,
+                          options, int32, out);
+        GF_OPTION_RECONF ("rebal-block-size", conf->migrate_blksize,
+                          options, size_uint64, out);
+        GF_OPTION_RECONF ("rebal-crawl-threads", conf->crawl_threads,
+                          options, int32, out);
+        GF_OPTION_RECONF ("rebal-crawl-checkpoint", conf->crawl_checkpoint,
+                          options, bool, out);
 
         if (conf->defrag) {
                 GF_DECIDE_DEFRAG_THROTTLE_COUNT (throttle_count, conf);
@@ -479,9 +497,11 @@ dht_reconfigure (xlator_t *this, dict_t *options)
         }
 
         dht_init_regex (this, options, "rsync-hash-regex",
-                        &conf->rsync_regex, &conf->rsync_regex_valid);
+                        &conf->rsync_regex, &conf->rsync_regex_valid,
+                        &conf->rsync_filter);
         dht_init_regex (this, options, "extra-hash-regex",
-                        &conf->extra_regex, &conf->extra_regex_valid);
+                        &conf->extra_regex, &conf->extra_regex_valid,
+                        &conf->extra_filter);
 
         GF_OPTION_RECONF ("weighted-rebalance", conf->do_weighting, options,
                           bool, out);
@@ -613,6 +633,7 @@ dht_init (xlator_t *this)
                 GF_VALIDATE_OR_GOTO (this->name, defrag, err);
 
                 LOCK_INIT (&defrag->lock);
+                INIT_LIST_HEAD (&defrag->migrating);
 
                 defrag->is_exiting = 0;
 
@@ -693,6 +714,9 @@ dht_init (xlator_t *this)
 
         GF_OPTION_INIT ("readdir-optimize", conf->readdir_optimize, bool, err);
 
+        GF_OPTION_INIT ("lookup-unhashed-bloom", conf->lookup_bloom, bool,
+                        err);
+
         if (defrag) {
                 GF_OPTION_INIT ("rebalance-stats", defrag->stats, bool, err);
                 if (dict_get_str (this->options, "rebalance-filter", &temp_str)
@@ -737,9 +761,11 @@ dht_init (xlator_t *this)
         }
 
         dht_init_regex (this, this->options, "rsync-hash-regex",
-                        &conf->rsync_regex, &conf->rsync_regex_valid);
+                        &conf->rsync_regex, &conf->rsync_regex_valid,
+                        &conf->rsync_filter);
         dht_init_regex (this, this->options, "extra-hash-regex",
-                        &conf->extra_regex, &conf->extra_regex_valid);
+                        &conf->extra_regex, &conf->extra_regex_valid,
+                        &conf->extra_filter);
 
         ret = dht_layouts_init (this, conf);
         if (ret == -1) {
@@ -763,6 +789,15 @@ dht_init (xlator_t *this)
         GF_OPTION_INIT ("randomize-hash-range-by-gfid",
                         conf->randomize_by_gfid, bool, err);
 
+        GF_OPTION_INIT ("rebal-migrate-window", conf->migrate_window,
+                        int32, err);
+        GF_OPTION_INIT ("rebal-block-size", conf->migrate_blksize,
+                        size_uint64, err);
+        GF_OPTION_INIT ("rebal-crawl-threads", conf->crawl_threads,
+                        int32, err);
+        GF_OPTION_INIT ("rebal-crawl-checkpoint", conf->crawl_checkpoint,
+                        bool, err);
+
         if (defrag) {
                 GF_OPTION_INIT ("rebal-throttle",
                                  conf->dthrottle, str, err);
@@ -920,6 +955,14 @@ struct volume_options options[] = {
           "that allows DHT to requests non-first subvolumes to filter out "
           "directory entries."
         },
+        { .key = {"lookup-unhashed-bloom"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Fetch a bloom filter of the names in each "
+          "directory from the bricks along with the directory layout, and "
+          "leave out the subvolumes which cannot have a name when it has to "
+          "be looked up on all of them."
+        },
         { .key = {"rsync-hash-regex"},
           .type = GF_OPTION_TYPE_STR,
           /* Setting a default here doesn't work.  See dht_init_regex. */
@@ -1012,5 +1055,43 @@ struct volume_options options[] = {
                          "max of [($(processing units) - 4) / 2), 4]"
         },
 
+        { .key  = {"rebal-migrate-window"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 64,
+          .default_value = "4",
+          .description = "Maximum number of blocks of a file read from the "
+                         "source and written to the destination at the same "
+                         "time while its data is migrated."
+        },
+
+        { .key  = {"rebal-block-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 4 * GF_UNIT_KB,
+          .max  = 1 * GF_UNIT_MB,
+          .default_value = "128KB",
+          .description = "Size of the reads and writes used to migrate the "
+                         "data of a file."
+        },
+
+        { .key  = {"rebal-crawl-threads"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = 8,
+          .default_value = "4",
+          .description = "Number of tasks crawling directories at the same "
+                         "time during rebalance and fix-layout. Each task "
+                         "takes a subtree queued by the others when it runs "
+                         "out of work."
+        },
+
+        { .key  = {"rebal-crawl-checkpoint"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "on",
+          .description = "Mark each subtree once rebalance is done with it, "
+                         "so that a restarted rebalance skips it instead of "
+                         "crawling the volume from the start."
+        },
+
         { .key  = {NULL} },
 };
@@ -0,0 +1,122 @@
+/*
+  Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "dht-common.h"
+#include "logging.h"
+#include "xlator.h"
+
+#include <regex.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <string.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+/*
+ * Helper functions
+ */
+
+/* what dht_munge_name() checks before calling regexec() */
+static int
+helper_filter_pass(dht_regex_filter_t *filter, const char *name)
+{
+    size_t len = strlen(name);
+
+    if (filter->prefix_len &&
+        (len < filter->prefix_len ||
+         memcmp(name, filter->prefix, filter->prefix_len)))
+        return 0;
+    if (filter->suffix_len &&
+        (len < filter->suffix_len ||
+         memcmp(name + len - filter->suffix_len, filter->suffix,
+                filter->suffix_len)))
+        return 0;
+    return 1;
+}
+
+static void
+helper_filter_expect(const char *pattern, const char *prefix,
+                     const char *suffix)
+{
+    dht_regex_filter_t filter;
+
+    dht_regex_filter_init(&filter, pattern);
+    assert_int_equal(filter.prefix_len, strlen(prefix));
+    assert_memory_equal(filter.prefix, prefix, filter.prefix_len);
+    assert_int_equal(filter.suffix_len, strlen(suffix));
+    assert_memory_equal(filter.suffix, suffix, filter.suffix_len);
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_dht_regex_filter_literals(void **state)
+{
+    // the default rsync-hash-regex
+    helper_filter_expect("^\\.(.+)\\.[^.]+$", ".", "");
+    helper_filter_expect("^abc", "abc", "");
+    helper_filter_expect("\\.tmp$", "", ".tmp");
+    helper_filter_expect("^ab*c", "a", "");
+    helper_filter_expect("^ab+c", "ab", "");
+    helper_filter_expect("^a\\.b(x)\\.c$", "a.b", ".c");
+    helper_filter_expect("ab+c$", "", "bc");
+    helper_filter_expect("ab?c$", "", "c");
+    helper_filter_expect("a[]x]c$", "", "c");
+    helper_filter_expect("x[[:alpha:]]$", "", "");
+    helper_filter_expect("^a|b$", "", "");
+    helper_filter_expect("abc", "", "");
+}
+
+/*
+ * The filter may only ever turn away names regexec() would not match
+ * anyway, whatever the pattern.
+ */
+static void
+test_dht_regex_filter_matches(void **state)
+{
+    const char *patterns[] = {
+        "^\\.(.+)\\.[^.]+$", "^(.+)\\.tmp$", "^abc", "\\.tmp$",
+        "^ab*c", "^ab+c$", "^ab?c", "a{2}b$", "a[]x]c$", "a[^]x]c$",
+        "x[[:alpha:]]$", "^a|b$", "(ab)+$", "^a\\.b(x)\\.c$", "ab+c$",
+        "^\\\\a", "a\\$", "^a\\(b\\)$", "^.*$", "(^a)", "a$|b",
+    };
+    const char *names[] = {
+        "", "a", "b", "c", "ab", "abc", "ac", "abbc", "aac", "aab",
+        "axc", "a]c", "ayc", "xy", "x", "abab", "a.bx.c", "a.b.c",
+        ".file.txt.aBcDeF", "file.tmp", ".tmp", "abtmp", "\\a", "a$",
+        "a(b)", "zabc", "abcz", "aaab",
+    };
+    int npatterns = sizeof(patterns) / sizeof(patterns[0]);
+    int nnames = sizeof(names) / sizeof(names[0]);
+    dht_regex_filter_t filter;
+    regex_t re;
+    int i, j;
+
+    for (i = 0; i < npatterns; i++) {
+        assert_int_equal(regcomp(&re, patterns[i], REG_EXTENDED), 0);
+        dht_regex_filter_init(&filter, patterns[i]);
+        for (j = 0; j < nnames; j++) {
+            if (regexec(&re, names[j], 0, NULL, 0) == 0)
+                assert_true(helper_filter_pass(&filter, names[j]));
+        }
+        regfree(&re);
+    }
+}
+
+int main(void) {
+    const struct CMUnitTest xlator_dht_hashfn_tests[] = {
+        unit_test(test_dht_regex_filter_literals),
+        unit_test(test_dht_regex_filter_matches),
+    };
+
+    return cmocka_run_group_tests(xlator_dht_hashfn_tests, NULL, NULL);
+}
@@ -13,6 +13,7 @@
 #include "xlator.h"
 
 #include <inttypes.h>
+#include <time.h>
 #include <stdarg.h>
 #include <stddef.h>
 #include <setjmp.h>
@@ -116,9 +117,174 @@ test_dht_layout_new(void **state)
     helper_xlator_destroy(xl);
 }
 
+/*
+ * Split the hash space evenly over cnt subvolumes, like
+ * dht_selfheal_layout_new_directory() does. The subvolume of entry i is
+ * the fake pointer (i + 1).
+ */
+static void
+helper_layout_fill(dht_layout_t *layout, int cnt)
+{
+    uint32_t chunk = 0xffffffff / cnt;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        layout->list[i].start = i * chunk;
+        layout->list[i].stop = (i == cnt - 1) ? 0xffffffff
+                                              : (i + 1) * chunk - 1;
+        layout->list[i].xlator = (xlator_t *)(uintptr_t)(i + 1);
+    }
+}
+
+static void
+test_dht_layout_search_hash(void **state)
+{
+    xlator_t *xl;
+    dht_layout_t *layout;
+    uint32_t hash;
+    int cnt = 37;
+    int i;
+
+    xl = helper_xlator_init(10);
+    layout = dht_layout_new(xl, cnt);
+    assert_non_null(layout);
+    helper_layout_fill(layout, cnt);
+
+    // store the ranges out of order, the index has to sort them
+    layout->list[0].start = layout->list[cnt - 1].start;
+    layout->list[0].stop = 0xffffffff;
+    layout->list[0].xlator = (xlator_t *)(uintptr_t)cnt;
+    layout->list[cnt - 1].start = 0;
+    layout->list[cnt - 1].stop = 0xffffffff / cnt - 1;
+    layout->list[cnt - 1].xlator = (xlator_t *)(uintptr_t)1;
+
+    assert_int_equal(layout->index_cnt, 0);
+    assert_int_equal(dht_layout_index_build(layout), 0);
+    assert_int_equal(layout->index_cnt, cnt);
+
+    // too few subvolumes to be worth an index
+    layout->cnt = DHT_LAYOUT_INDEX_MIN_CNT - 1;
+    assert_int_not_equal(dht_layout_index_build(layout), 0);
+    assert_int_equal(layout->index_cnt, 0);
+    layout->cnt = cnt;
+    assert_int_equal(dht_layout_index_build(layout), 0);
+
+    for (i = 0; i < cnt; i++) {
+        hash = layout->list[i].start;
+        assert_ptr_equal(dht_layout_search_hash(xl, layout, hash),
+                         layout->list[i].xlator);
+        hash = layout->list[i].stop;
+        assert_ptr_equal(dht_layout_search_hash(xl, layout, hash),
+                         layout->list[i].xlator);
+    }
+
+    // a hole in the layout is not found, with or without the index
+    layout->list[5].stop = layout->list[5].start + 10;
+    assert_int_equal(dht_layout_index_build(layout), 0);
+    assert_null(dht_layout_search_hash(xl, layout,
+                                       layout->list[5].start + 11));
+
+    // overlapping ranges leave the search to the linear scan
+    layout->list[5].stop = layout->list[6].start;
+    assert_int_not_equal(dht_layout_index_build(layout), 0);
+    assert_int_equal(layout->index_cnt, 0);
+    assert_ptr_equal(dht_layout_search_hash(xl, layout,
+                                            layout->list[6].start),
+                     layout->list[5].xlator);
+
+    // subvolumes that failed or own no range do not disable the index
+    layout->list[5].stop = layout->list[6].start - 1;
+    layout->list[3].err = ENOTCONN;
+    layout->list[3].start = layout->list[3].stop = 0;
+    layout->list[4].start = layout->list[4].stop = 0;
+    assert_int_equal(dht_layout_index_build(layout), 0);
+    assert_int_equal(layout->index_cnt, cnt - 2);
+    assert_ptr_equal(dht_layout_search_hash(xl, layout, 0),
+                     layout->list[cnt - 1].xlator);
+    assert_ptr_equal(dht_layout_search_hash(xl, layout,
+                                            layout->list[5].start),
+                     layout->list[5].xlator);
+    layout->list[3].err = 0;
+    helper_layout_fill(layout, cnt);
+
+    // a stale index is never trusted over list[]
+    layout->list[5].stop = layout->list[6].start - 1;
+    assert_int_equal(dht_layout_index_build(layout), 0);
+    layout->list[7].xlator = (xlator_t *)0x12345;
+    layout->list[6].stop = layout->list[7].stop;
+    layout->list[7].start = layout->list[7].stop = 0;
+    assert_ptr_equal(dht_layout_search_hash(xl, layout,
+                                            layout->list[6].stop),
+                     layout->list[6].xlator);
+
+    test_free(layout);
+    helper_xlator_destroy(xl);
+}
+
+static double
+helper_search_nsec(xlator_t *xl, dht_layout_t *layout, int rounds)
+{
+    struct timespec begin, end;
+    uint32_t hash = 0x9e3779b9;
+    uintptr_t sum = 0;
+    int i;
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (i = 0; i < rounds; i++) {
+        hash = hash * 1664525 + 1013904223;
+        sum += (uintptr_t)dht_layout_search_hash(xl, layout, hash);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    assert_true(sum != 0);
+
+    return ((end.tv_sec - begin.tv_sec) * 1e9
+            + (end.tv_nsec - begin.tv_nsec)) / rounds;
+}
+
+/*
+ * Not a pass/fail test: prints the cost of a search with and without the
+ * range index for a few brick counts.
+ */
+static void
+test_dht_layout_search_bench(void **state)
+{
+    xlator_t *xl;
+    dht_layout_t *layout;
+    int counts[] = { 4, 16, 64, 256, 1024 };
+    int rounds = 1000000;
+    double linear, indexed;
+    int i;
+
+    xl = helper_xlator_init(10);
+
+    for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        layout = dht_layout_new(xl, counts[i]);
+        assert_non_null(layout);
+        helper_layout_fill(layout, counts[i]);
+
+        layout->index_cnt = 0;
+        linear = helper_search_nsec(xl, layout, rounds);
+
+        // small layouts are not indexed and stay with the linear scan
+        dht_layout_index_build(layout);
+        indexed = helper_search_nsec(xl, layout, rounds);
+
+        print_message("subvols=%4d index=%s linear=%7.1fns "
+                      "search=%7.1fns\n", counts[i],
+                      layout->index_cnt ? "yes" : "no ", linear, indexed);
+
+        test_free(layout);
+    }
+
+    helper_xlator_destroy(xl);
+}
+
 int main(void) {
     const struct CMUnitTest xlator_dht_layout_tests[] = {
         unit_test(test_dht_layout_new),
+        unit_test(test_dht_layout_search_hash),
+        unit_test(test_dht_layout_search_bench),
     };
 
     return cmocka_run_group_tests(xlator_dht_layout_tests, NULL, NULL);
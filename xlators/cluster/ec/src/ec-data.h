@@ -294,6 +294,7 @@ struct _ec_heal
     uintptr_t         fixed;
     uint64_t          offset;
     uint64_t          size;
+    uint32_t          window;      /* blocks healed per lock */
     uint64_t          total_size;
     uint64_t          version[2];
     uint64_t          raw_size;
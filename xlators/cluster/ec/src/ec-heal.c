@@ -212,6 +212,20 @@ ec_heal_xattr_clean (dict_t *dict, char *key, data_t *data,
         return 0;
 }
 
+/* Offset requested by the caller of a read or write fop: the fop itself
+ * keeps the offset aligned to a stripe and the head it cut off. A read
+ * also scales the aligned offset down to fragments, a write does not. */
+static uint64_t
+ec_heal_fop_offset (ec_fop_data_t *fop)
+{
+    ec_t *ec = fop->xl->private;
+
+    if (fop->id == GF_FOP_READ)
+        return (uint64_t)fop->offset * ec->fragments + fop->head;
+
+    return (uint64_t)fop->offset + fop->head;
+}
+
 int32_t
 ec_heal_writev_cbk (call_frame_t *frame, void *cookie,
                     xlator_t *this, int32_t op_ret, int32_t op_errno,
@@ -225,7 +239,7 @@ ec_heal_writev_cbk (call_frame_t *frame, void *cookie,
 
     gf_msg_debug (fop->xl->name, 0, "%s: write op_ret %d, op_errno %s"
             " at %"PRIu64, uuid_utoa (heal->fd->inode->gfid), op_ret,
-            strerror (op_errno), heal->offset);
+            strerror (op_errno), ec_heal_fop_offset (fop));
 
     ec_heal_update(cookie, 0);
 
@@ -240,6 +254,7 @@ int32_t ec_heal_readv_cbk(call_frame_t * frame, void * cookie, xlator_t * this,
 {
     ec_fop_data_t * fop = cookie;
     ec_heal_t * heal = fop->data;
+    uint64_t offset = ec_heal_fop_offset (fop);
 
     ec_trace("READ_CBK", fop, "ret=%d, errno=%d", op_ret, op_errno);
 
@@ -249,10 +264,10 @@ int32_t ec_heal_readv_cbk(call_frame_t * frame, void * cookie, xlator_t * this,
     {
         gf_msg_debug (fop->xl->name, 0, "%s: read succeeded, proceeding "
                 "to write at %"PRIu64, uuid_utoa (heal->fd->inode->gfid),
-                heal->offset);
+                offset);
         ec_writev(heal->fop->frame, heal->xl, heal->bad, EC_MINIMUM_ONE,
                   ec_heal_writev_cbk, heal, heal->fd, vector, count,
-                  heal->offset, 0, iobref, NULL);
+                  offset, 0, iobref, NULL);
     }
     else
     {
@@ -260,8 +275,10 @@ int32_t ec_heal_readv_cbk(call_frame_t * frame, void * cookie, xlator_t * this,
                 gf_msg_debug (fop->xl->name, 0, "%s: read failed %s, failing "
                         "to heal block at %"PRIu64,
                         uuid_utoa (heal->fd->inode->gfid), strerror (op_errno),
-                        heal->offset);
+                        offset);
+                LOCK(&heal->lock);
                 heal->bad = 0;
+                UNLOCK(&heal->lock);
         }
         heal->done = 1;
     }
@@ -269,16 +286,29 @@ int32_t ec_heal_readv_cbk(call_frame_t * frame, void * cookie, xlator_t * this,
     return 0;
 }
 
+/* Heals the window of blocks starting at heal->offset. All of them are
+ * read (and then written) under the same heal lock; the state machine
+ * moves on once every read and write of the window has completed. */
 void ec_heal_data_block(ec_heal_t *heal)
 {
+    uint64_t offset = heal->offset;
+    uint32_t i;
+
     ec_trace("DATA", heal->fop, "good=%lX, bad=%lX", heal->good, heal->bad);
 
     if ((heal->good != 0) && (heal->bad != 0) &&
         (heal->iatt.ia_type == IA_IFREG))
     {
-        ec_readv(heal->fop->frame, heal->xl, heal->good, EC_MINIMUM_MIN,
-                 ec_heal_readv_cbk, heal, heal->fd, heal->size, heal->offset,
-                 0, NULL);
+        for (i = 0; i < heal->window; i++) {
+            if (offset >= heal->total_size)
+                break;
+
+            ec_readv(heal->fop->frame, heal->xl, heal->good, EC_MINIMUM_MIN,
+                     ec_heal_readv_cbk, heal, heal->fd, heal->size, offset,
+                     0, NULL);
+
+            offset += heal->size;
+        }
     }
 }
 
@@ -1799,6 +1829,7 @@ ec_rebuild_data (call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
 {
         ec_heal_t        *heal = NULL;
         int              ret = 0;
+        uint64_t         step = 0;
         syncbarrier_t    barrier;
         struct iobuf_pool *pool = NULL;
 
@@ -1812,24 +1843,32 @@ ec_rebuild_data (call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
         syncbarrier_init (heal->data);
         pool = ec->xl->ctx->iobuf_pool;
         heal->total_size = size;
-        heal->size = iobpool_default_pagesize (pool);
+        heal->size = ec->heal_block_size;
+        if (!heal->size)
+                heal->size = iobpool_default_pagesize (pool);
+        /* whole stripes only, so that blocks never share a stripe */
+        heal->size = ec_adjust_size (ec, heal->size, 0);
+        heal->window = ec->heal_window ? ec->heal_window : 1;
         heal->bad       = ec_char_array_to_mask (healed_sinks, ec->nodes);
         heal->good      = ec_char_array_to_mask (sources, ec->nodes);
         heal->iatt.ia_type = IA_IFREG;
         LOCK_INIT(&heal->lock);
 
+        step = heal->size * heal->window;
         for (heal->offset = 0; (heal->offset < size) && !heal->done;
-                                                   heal->offset += heal->size) {
+                                                   heal->offset += step) {
                 gf_msg_debug (ec->xl->name, 0, "%s: sources: %d, sinks: "
-                        "%d, offset: %"PRIu64" bsize: %"PRIu64,
+                        "%d, offset: %"PRIu64" bsize: %"PRIu64" window: %u",
                         uuid_utoa (fd->inode->gfid),
                         EC_COUNT (sources, ec->nodes),
                         EC_COUNT (healed_sinks, ec->nodes), heal->offset,
-                        heal->size);
+                        heal->size, heal->window);
                 ret = ec_sync_heal_block (frame, ec->xl, heal);
                 if (ret < 0)
                         break;
 
+                __sync_fetch_and_add (&ec->heal_bytes,
+                                      min (step, size - heal->offset));
         }
         memset (healed_sinks, 0, ec->nodes);
         ec_mask_to_char_array (heal->bad, healed_sinks, ec->nodes);
@@ -219,6 +219,148 @@ ec_shd_selfheal (struct subvol_healer *healer, int child, loc_t *loc)
                                 NULL);
 }
 
+struct ec_shd_heal {
+        struct subvol_healer *healer;
+        loc_t                 loc;
+};
+
+static int
+ec_shd_heal_task (void *opaque)
+{
+        struct ec_shd_heal *heal = opaque;
+
+        return ec_shd_selfheal (heal->healer, heal->healer->subvol,
+                                &heal->loc);
+}
+
+static int
+ec_shd_heal_done (int ret, call_frame_t *frame, void *opaque)
+{
+        struct ec_shd_heal   *heal   = opaque;
+        struct subvol_healer *healer = heal->healer;
+
+        if (heal->loc.inode)
+                inode_forget (heal->loc.inode, 0);
+        loc_wipe (&heal->loc);
+        GF_FREE (heal);
+
+        pthread_mutex_lock (&healer->mutex);
+        {
+                healer->heals--;
+                healer->healed++;
+                pthread_cond_signal (&healer->heal_cond);
+        }
+        pthread_mutex_unlock (&healer->mutex);
+
+        return 0;
+}
+
+/* Hands @loc over to a heal task, waiting while background-heals of them
+ * are already running. @loc is owned (and wiped) by the task. */
+static void
+ec_shd_heal_launch (struct subvol_healer *healer, loc_t *loc)
+{
+        ec_t               *ec   = healer->this->private;
+        struct ec_shd_heal *heal = NULL;
+        int                 max  = 0;
+        int                 ret  = -1;
+
+        max = ec->background_heals ? ec->background_heals : 1;
+
+        pthread_mutex_lock (&healer->mutex);
+        {
+                while (healer->heals >= max)
+                        pthread_cond_wait (&healer->heal_cond,
+                                           &healer->mutex);
+                healer->heals++;
+        }
+        pthread_mutex_unlock (&healer->mutex);
+
+        heal = GF_CALLOC (1, sizeof (*heal), ec_mt_shd_heal_t);
+        if (heal) {
+                heal->healer = healer;
+                heal->loc = *loc;
+                memset (loc, 0, sizeof (*loc));
+
+                ret = synctask_new (healer->this->ctx->env, ec_shd_heal_task,
+                                    ec_shd_heal_done, NULL, heal);
+                if (ret == 0)
+                        return;
+
+                *loc = heal->loc;
+                GF_FREE (heal);
+        }
+
+        /* heal it from here then */
+        ec_shd_selfheal (healer, healer->subvol, loc);
+
+        pthread_mutex_lock (&healer->mutex);
+        {
+                healer->heals--;
+                healer->healed++;
+        }
+        pthread_mutex_unlock (&healer->mutex);
+}
+
+static void
+ec_shd_sweep_begin (struct subvol_healer *healer)
+{
+        ec_t *ec = healer->this->private;
+
+        pthread_mutex_lock (&healer->mutex);
+        {
+                healer->healed = 0;
+                healer->bytes_start = ec->heal_bytes;
+                healer->sweep_start = time (NULL);
+                healer->sweep_end = 0;
+        }
+        pthread_mutex_unlock (&healer->mutex);
+}
+
+/* waits for the heals launched by the sweep */
+static void
+ec_shd_sweep_end (struct subvol_healer *healer)
+{
+        pthread_mutex_lock (&healer->mutex);
+        {
+                while (healer->heals > 0)
+                        pthread_cond_wait (&healer->heal_cond,
+                                           &healer->mutex);
+                healer->sweep_end = time (NULL);
+        }
+        pthread_mutex_unlock (&healer->mutex);
+}
+
+static void
+ec_shd_sweep_progress (struct subvol_healer *healer, char *buf, size_t len)
+{
+        ec_t     *ec      = healer->this->private;
+        uint64_t  bytes   = 0;
+        time_t    elapsed = 0;
+
+        buf[0] = '\0';
+
+        pthread_mutex_lock (&healer->mutex);
+        {
+                if (!healer->sweep_start)
+                        goto unlock;
+
+                bytes = ec->heal_bytes - healer->bytes_start;
+                elapsed = (healer->sweep_end ? healer->sweep_end : time (NULL))
+                          - healer->sweep_start;
+                if (elapsed <= 0)
+                        elapsed = 1;
+
+                snprintf (buf, len, "%s sweep: %"PRIu64" files, %"PRIu64
+                          " KB rebuilt at %"PRIu64" KB/s",
+                          healer->sweep_end ? "last" : "running",
+                          healer->healed, bytes / 1024,
+                          bytes / 1024 / elapsed);
+        }
+unlock:
+        pthread_mutex_unlock (&healer->mutex);
+}
+
 
 int
 ec_shd_index_heal (xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
@@ -252,7 +394,7 @@ ec_shd_index_heal (xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
         if (!loc.inode)
                 goto out;
 
-        ec_shd_selfheal (healer, healer->subvol, &loc);
+        ec_shd_heal_launch (healer, &loc);
 
 out:
         if (loc.inode)
@@ -281,9 +423,13 @@ ec_shd_index_sweep (struct subvol_healer *healer)
                 return -errno;
         }
 
+        ec_shd_sweep_begin (healer);
+
         ret = syncop_dir_scan (subvol, &loc, GF_CLIENT_PID_AFR_SELF_HEALD,
                                healer, ec_shd_index_heal);
 
+        ec_shd_sweep_end (healer);
+
         inode_forget (loc.inode, 0);
         loc_wipe (&loc);
 
@@ -305,7 +451,6 @@ ec_shd_full_heal (xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
                 return -EBUSY;
 
         loc.parent = inode_ref (parent->inode);
-        loc.name   = entry->d_name;
         gf_uuid_copy (loc.gfid, entry->d_stat.ia_gfid);
 
         /* If this fails with ENOENT/ESTALE index is stale */
@@ -314,13 +459,18 @@ ec_shd_full_heal (xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
         if (ret < 0)
                 goto out;
 
+        /* @loc outlives @entry in the heal task: name it from the path */
+        loc.name = strrchr (loc.path, '/');
+        if (loc.name)
+                loc.name++;
+
         loc.inode = ec_shd_inode_find (this, this, loc.gfid);
         if (!loc.inode) {
                 ret = -EINVAL;
                 goto out;
         }
 
-        ec_shd_selfheal (healer, healer->subvol, &loc);
+        ec_shd_heal_launch (healer, &loc);
 
         ret = 0;
 
@@ -336,12 +486,20 @@ ec_shd_full_sweep (struct subvol_healer *healer, inode_t *inode)
 {
         ec_t           *ec  = NULL;
         loc_t          loc  = {0};
+        int            ret  = 0;
 
         ec = healer->this->private;
         loc.inode = inode;
-        return syncop_ftw (ec->xl_list[healer->subvol], &loc,
-                           GF_CLIENT_PID_AFR_SELF_HEALD, healer,
-                           ec_shd_full_heal);
+
+        ec_shd_sweep_begin (healer);
+
+        ret = syncop_ftw (ec->xl_list[healer->subvol], &loc,
+                          GF_CLIENT_PID_AFR_SELF_HEALD, healer,
+                          ec_shd_full_heal);
+
+        ec_shd_sweep_end (healer);
+
+        return ret;
 }
 
 
@@ -429,6 +587,10 @@ ec_shd_healer_init (xlator_t *this, struct subvol_healer *healer)
         if (ret)
                 goto out;
 
+        ret = pthread_cond_init (&healer->heal_cond, NULL);
+        if (ret)
+                goto out;
+
         healer->this = this;
         healer->running = _gf_false;
         healer->rerun = _gf_false;
@@ -538,9 +700,11 @@ int
 ec_heal_op (xlator_t *this, dict_t *output, gf_xl_afr_op_t op, int xl_id)
 {
         char key[64] = {0};
+        char progress[256] = {0};
         int op_ret = 0;
         ec_t *ec = NULL;
         int     i = 0;
+        struct subvol_healer *healer = NULL;
         GF_UNUSED int     ret = 0;
 
         ec = this->private;
@@ -557,7 +721,22 @@ ec_heal_op (xlator_t *this, dict_t *output, gf_xl_afr_op_t op, int xl_id)
                 } else if (!ec_shd_is_subvol_local (this, i)) {
                         ret = dict_set_str (output, key, "Brick is remote");
                 } else {
+                        if (op == GF_SHD_OP_HEAL_FULL)
+                                healer = NTH_FULL_HEALER (this, i);
+                        else
+                                healer = NTH_INDEX_HEALER (this, i);
+
                         ret = dict_set_str (output, key, "Started self-heal");
+
+                        ec_shd_sweep_progress (healer, progress,
+                                               sizeof (progress));
+                        if (progress[0]) {
+                                snprintf (key, sizeof (key), "%d-%d-progress",
+                                          xl_id, i);
+                                ret = dict_set_dynstr_with_alloc (output, key,
+                                                                  progress);
+                        }
+
                         if (op == GF_SHD_OP_HEAL_FULL) {
                                 ec_shd_full_healer_spawn (this, i);
                         } else if (op == GF_SHD_OP_HEAL_INDEX) {
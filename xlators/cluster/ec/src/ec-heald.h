@@ -25,6 +25,15 @@ struct subvol_healer {
         pthread_mutex_t  mutex;
         pthread_cond_t   cond;
         pthread_t        thread;
+
+        /* files of a sweep are healed concurrently, at most
+         * background-heals of them at a time */
+        pthread_cond_t   heal_cond;
+        int              heals;          /* in flight */
+        uint64_t         healed;         /* files healed this sweep */
+        uint64_t         bytes_start;    /* ec->heal_bytes at sweep start */
+        time_t           sweep_start;
+        time_t           sweep_end;      /* zero while sweeping */
 };
 
 struct _ec_self_heald;
@@ -21,6 +21,10 @@
 #include "ec-messages.h"
 #include "ec-heald.h"
 
+#if EC_METHOD_CHUNK_SIZE != GF_EC_CHUNK_SIZE
+#error "GF_EC_CHUNK_SIZE does not match EC_METHOD_CHUNK_SIZE"
+#endif
+
 #define EC_MAX_FRAGMENTS EC_METHOD_MAX_FRAGMENTS
 /* The maximum number of nodes is derived from the maximum allowed fragments
  * using the rule that redundancy cannot be equal or greater than the number
@@ -237,6 +241,7 @@ reconfigure (xlator_t *this, dict_t *options)
         ec_t     *ec              = this->private;
         uint32_t heal_wait_qlen   = 0;
         uint32_t background_heals = 0;
+        uint64_t heal_block_size  = 0;
 
         GF_OPTION_RECONF ("self-heal-daemon", ec->shd.enabled, options, bool,
                           failed);
@@ -248,6 +253,11 @@ reconfigure (xlator_t *this, dict_t *options)
                           uint32, failed);
         GF_OPTION_RECONF ("heal-timeout", ec->shd.timeout, options,
                           int32, failed);
+        GF_OPTION_RECONF ("heal-block-size", heal_block_size, options,
+                          size_uint64, failed);
+        GF_OPTION_RECONF ("self-heal-window-size", ec->heal_window, options,
+                          uint32, failed);
+        ec->heal_block_size = heal_block_size;
         ec_configure_background_heal_opts (ec, background_heals,
                                            heal_wait_qlen);
         return 0;
@@ -515,6 +525,7 @@ int32_t
 init (xlator_t *this)
 {
     ec_t *ec = NULL;
+    uint64_t heal_block_size = 0;
 
     if (this->parents == NULL)
     {
@@ -576,6 +587,9 @@ init (xlator_t *this)
     GF_OPTION_INIT ("heal-wait-qlength", ec->heal_wait_qlen, uint32, failed);
     ec_configure_background_heal_opts (ec, ec->background_heals,
                                        ec->heal_wait_qlen);
+    GF_OPTION_INIT ("heal-block-size", heal_block_size, size_uint64, failed);
+    ec->heal_block_size = heal_block_size;
+    GF_OPTION_INIT ("self-heal-window-size", ec->heal_window, uint32, failed);
 
     if (ec->shd.iamshd)
             ec_selfheal_daemon_init (this);
@@ -1191,6 +1205,9 @@ int32_t ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heal-wait-qlength", "%d", ec->heal_wait_qlen);
     gf_proc_dump_write("healers", "%d", ec->healers);
     gf_proc_dump_write("heal-waiters", "%d", ec->heal_waiters);
+    gf_proc_dump_write("heal-block-size", "%u", ec->heal_block_size);
+    gf_proc_dump_write("self-heal-window-size", "%u", ec->heal_window);
+    gf_proc_dump_write("heal-bytes", "%"PRIu64, ec->heal_bytes);
 
     return 0;
 }
@@ -1298,5 +1315,21 @@ struct volume_options options[] =
       .description = "time interval for checking the need to self-heal "
                      "in self-heal-daemon"
     },
+    { .key = {"heal-block-size"},
+      .type = GF_OPTION_TYPE_SIZET,
+      .min = 4 * GF_UNIT_KB,
+      .max = 8 * GF_UNIT_MB,
+      .default_value = "128KB",
+      .description = "Size of the blocks file data is read and rebuilt in "
+                     "by self-heal. It is rounded up to whole stripes."
+    },
+    { .key = {"self-heal-window-size"},
+      .type = GF_OPTION_TYPE_INT,
+      .min = 1,
+      .max = 128,
+      .default_value = "4",
+      .description = "Number of heal blocks of a file healed under one "
+                     "lock, with their reads and writes issued together."
+    },
     { }
 };
@@ -49,6 +49,9 @@ struct _ec
     gf_boolean_t      shutdown;
     uint32_t          background_heals;
     uint32_t          heal_wait_qlen;
+    uint32_t          heal_block_size;
+    uint32_t          heal_window;
+    uint64_t          heal_bytes;      /* file data rebuilt by self-heal */
     struct list_head  pending_fops;
     struct list_head  heal_waiting;
     struct list_head  healing;
@@ -134,7 +134,8 @@ bitd_scrub_post_compute_check (xlator_t *this,
 static inline int32_t
 bitd_signature_staleness (xlator_t *this,
                           br_child_t *child, fd_t *fd,
-                          int *stale, unsigned long *version)
+                          int *stale, unsigned long *version,
+                          int8_t *signaturetype)
 {
         int32_t ret = -1;
         dict_t *xattr = NULL;
@@ -150,6 +151,7 @@ bitd_signature_staleness (xlator_t *this,
          */
         *stale = signptr->stale ? 1 : 0;
         *version = signptr->version;
+        *signaturetype = signptr->signaturetype;
 
         dict_unref (xattr);
 
@@ -167,7 +169,8 @@ bitd_signature_staleness (xlator_t *this,
  */
 int32_t
 bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
-                              fd_t *fd, unsigned long *version)
+                              fd_t *fd, unsigned long *version,
+                              int8_t *signaturetype)
 {
         int     stale = 0;
         int32_t ret   = -1;
@@ -179,7 +182,8 @@ bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
                 goto out;
         }
 
-        ret = bitd_signature_staleness (this, child, fd, &stale, version);
+        ret = bitd_signature_staleness (this, child, fd,
+                                        &stale, version, signaturetype);
         if (!ret && stale) {
                 gf_msg_debug (this->name, 0, "<STAGE: PRE> Object [GFID: %s] "
                               "has stale signature",
@@ -191,36 +195,13 @@ bitd_scrub_pre_compute_check (xlator_t *this, br_child_t *child,
         return ret;
 }
 
-/* static inline int */
-int
-bitd_compare_ckum (xlator_t *this,
-                   br_isignature_out_t *sign,
-                   unsigned char *md, inode_t *linked_inode,
-                   gf_dirent_t *entry, fd_t *fd, br_child_t *child, loc_t *loc)
+static int
+bitd_mark_corrupted (xlator_t *this, inode_t *linked_inode,
+                     fd_t *fd, br_child_t *child, loc_t *loc)
 {
         int   ret = -1;
         dict_t *xattr = NULL;
 
-        GF_VALIDATE_OR_GOTO ("bit-rot", this, out);
-        GF_VALIDATE_OR_GOTO (this->name, sign, out);
-        GF_VALIDATE_OR_GOTO (this->name, fd, out);
-        GF_VALIDATE_OR_GOTO (this->name, child, out);
-        GF_VALIDATE_OR_GOTO (this->name, linked_inode, out);
-        GF_VALIDATE_OR_GOTO (this->name, md, out);
-        GF_VALIDATE_OR_GOTO (this->name, entry, out);
-
-        if (strncmp
-            (sign->signature, (char *) md, strlen (sign->signature)) == 0) {
-                gf_msg_debug (this->name, 0, "%s [GFID: %s | Brick: %s] "
-                              "matches calculated checksum", loc->path,
-                              uuid_utoa (linked_inode->gfid),
-                              child->brick_path);
-                return 0;
-        }
-
-        gf_msg (this->name, GF_LOG_DEBUG, 0, BRB_MSG_CHECKSUM_MISMATCH,
-                "Object checksum mismatch: %s [GFID: %s | Brick: %s]",
-                loc->path, uuid_utoa (linked_inode->gfid), child->brick_path);
         gf_msg (this->name, GF_LOG_ALERT, 0, BRB_MSG_CHECKSUM_MISMATCH,
                 "CORRUPTION DETECTED: Object %s {Brick: %s | GFID: %s}",
                 loc->path, child->brick_path, uuid_utoa (linked_inode->gfid));
@@ -256,12 +237,200 @@ bitd_compare_ckum (xlator_t *this,
         return ret;
 }
 
+/* static inline int */
+int
+bitd_compare_ckum (xlator_t *this,
+                   br_isignature_out_t *sign,
+                   unsigned char *md, inode_t *linked_inode,
+                   gf_dirent_t *entry, fd_t *fd, br_child_t *child, loc_t *loc)
+{
+        int   ret = -1;
+
+        GF_VALIDATE_OR_GOTO ("bit-rot", this, out);
+        GF_VALIDATE_OR_GOTO (this->name, sign, out);
+        GF_VALIDATE_OR_GOTO (this->name, fd, out);
+        GF_VALIDATE_OR_GOTO (this->name, child, out);
+        GF_VALIDATE_OR_GOTO (this->name, linked_inode, out);
+        GF_VALIDATE_OR_GOTO (this->name, md, out);
+        GF_VALIDATE_OR_GOTO (this->name, entry, out);
+
+        /* signature (or root hash of a chunked signature) is binary */
+        if ((sign->signaturelen >= SHA256_DIGEST_LENGTH) &&
+            (memcmp (sign->signature, md, SHA256_DIGEST_LENGTH) == 0)) {
+                gf_msg_debug (this->name, 0, "%s [GFID: %s | Brick: %s] "
+                              "matches calculated checksum", loc->path,
+                              uuid_utoa (linked_inode->gfid),
+                              child->brick_path);
+                return 0;
+        }
+
+        gf_msg (this->name, GF_LOG_DEBUG, 0, BRB_MSG_CHECKSUM_MISMATCH,
+                "Object checksum mismatch: %s [GFID: %s | Brick: %s]",
+                loc->path, uuid_utoa (linked_inode->gfid), child->brick_path);
+
+        ret = bitd_mark_corrupted (this, linked_inode, fd, child, loc);
+ out:
+        return ret;
+}
+
+struct br_chunk_help {
+        struct br_scrubber *fsscrub;
+        br_chunk_hash_t    *ch;
+        gf_boolean_t        done;
+};
+
+/**
+ * Take an object off the chunk queue once its scrubber is done with it (or
+ * is being cancelled) and wait for the scrubbers still hashing its chunks,
+ * which work on the scrubber's stack.
+ */
+static void
+br_scrubber_chunks_unqueue (void *arg)
+{
+        int                   oldstate = 0;
+        struct br_chunk_help *help     = arg;
+        struct br_scrubber   *fsscrub  = help->fsscrub;
+        br_chunk_hash_t      *ch       = help->ch;
+
+        pthread_setcancelstate (PTHREAD_CANCEL_DISABLE, &oldstate);
+
+        pthread_mutex_lock (&fsscrub->mutex);
+        {
+                list_del_init (&ch->list);
+
+                /* cancelled with chunks left: have the helpers stop */
+                if (ch->next < ch->nchunks)
+                        ch->abort = 1;
+
+                while (ch->users)
+                        pthread_cond_wait (&fsscrub->chunkcond,
+                                           &fsscrub->mutex);
+        }
+        pthread_mutex_unlock (&fsscrub->mutex);
+
+        pthread_setcancelstate (oldstate, NULL);
+}
+
+/**
+ * Hash the chunks of an object on the scrubber pool: the chunks are queued
+ * for idle scrubbers to pick up while the calling scrubber hashes them too.
+ * The chunk hashes land in @ch->md, a chunk that does not verify stops all
+ * of them.
+ */
+static int32_t
+bitd_scrub_hash_chunks (xlator_t *this, br_chunk_hash_t *ch)
+{
+        br_private_t         *priv    = NULL;
+        struct br_scrubber   *fsscrub = NULL;
+        struct br_chunk_help  help    = {0, };
+
+        priv = this->private;
+        fsscrub = &priv->fsscrub;
+
+        br_chunk_hash_init (ch);
+
+        help.fsscrub = fsscrub;
+        help.ch = ch;
+
+        pthread_mutex_lock (&fsscrub->mutex);
+        {
+                list_add_tail (&ch->list, &fsscrub->chunkq);
+                pthread_cond_broadcast (&fsscrub->cond);
+        }
+        pthread_mutex_unlock (&fsscrub->mutex);
+
+        pthread_cleanup_push (br_scrubber_chunks_unqueue, &help);
+        {
+                (void) br_chunk_hash_worker (ch);
+        }
+        pthread_cleanup_pop (1);
+
+        return ch->failed ? -1 : 0;
+}
+
+/**
+ * Verify an object against a chunked signature, stopping at the first
+ * chunk that does not match. The chunks are spread over the scrubber pool
+ * (see bitd_scrub_hash_chunks ()). When the chunk hashes in the signature
+ * do not add up to its root hash (i.e. the signature itself is damaged),
+ * every chunk is hashed and the object is checked against the root hash
+ * alone.
+ *
+ * Returns 0 if the object verifies, 1 if it does not, -1 on error.
+ */
+static int
+bitd_scrub_chunked (xlator_t *this, br_child_t *child, fd_t *fd,
+                    br_isignature_out_t *sign, unsigned char *md)
+{
+        int                     ret      = -1;
+        br_chunked_signature_t *csign    = NULL;
+        br_chunk_hash_t         ch       = {0,};
+        unsigned char root[SHA256_DIGEST_LENGTH] = {0,};
+
+        if (sign->signaturelen < sizeof (br_chunked_signature_t))
+                goto out;
+
+        csign = (br_chunked_signature_t *) sign->signature;
+
+        ch.child = child;
+        ch.fd = fd;
+        ch.chunkbits = csign->chunkbits;
+        ch.nchunks = ntohl (csign->nchunks);
+
+        if ((ch.nchunks == 0) || (ch.nchunks > BR_CHUNKS_MAX) ||
+            (ch.chunkbits < BR_CHUNK_MIN_BITS) || (ch.chunkbits > 62) ||
+            (sign->signaturelen != br_chunked_signature_size (ch.nchunks))) {
+                gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_GET_SIGN_FAILED,
+                        "malformed chunked signature [GFID: %s]",
+                        uuid_utoa (fd->inode->gfid));
+                goto out;
+        }
+
+        ch.md = GF_CALLOC (ch.nchunks, SHA256_DIGEST_LENGTH,
+                           gf_common_mt_char);
+        if (!ch.md)
+                goto out;
+
+        SHA256 (csign->chunks,
+                (size_t) ch.nchunks * SHA256_DIGEST_LENGTH, root);
+        if (memcmp (root, csign->root, SHA256_DIGEST_LENGTH) == 0)
+                ch.expect = csign->chunks;
+        else
+                gf_msg (this->name, GF_LOG_WARNING, 0, BRB_MSG_GET_SIGN_FAILED,
+                        "chunk hashes of [GFID: %s] do not match the root "
+                        "hash, verifying the object as a whole",
+                        uuid_utoa (fd->inode->gfid));
+
+        ret = bitd_scrub_hash_chunks (this, &ch);
+        if (ret)
+                goto free_md;
+
+        if (ch.mismatch != ch.nchunks) {
+                gf_msg (this->name, GF_LOG_ALERT, 0, BRB_MSG_CHECKSUM_MISMATCH,
+                        "Chunk %u [offset %"PRIu64", %"PRIu64" bytes] of "
+                        "object [GFID: %s | Brick: %s] does not match its "
+                        "signature", ch.mismatch,
+                        (uint64_t) ch.mismatch << ch.chunkbits,
+                        (uint64_t) 1 << ch.chunkbits,
+                        uuid_utoa (fd->inode->gfid), child->brick_path);
+                ret = 1;
+                goto free_md;
+        }
+
+        SHA256 (ch.md, (size_t) ch.nchunks * SHA256_DIGEST_LENGTH, md);
+        ret = 0;
+
+ free_md:
+        GF_FREE (ch.md);
+ out:
+        return ret;
+}
+
 /**
  * "The Scrubber"
  *
- * Perform signature validation for a given object with the assumption
- * that the signature is SHA256 (because signer as of now _always_
- * signs with SHA256).
+ * Perform signature validation for a given object: a SHA256 of the whole
+ * object, or per chunk for objects signed in chunks.
  */
 int
 br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
@@ -277,6 +446,8 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
         inode_t             *linked_inode  = NULL;
         br_isignature_out_t *sign          = NULL;
         unsigned long        signedversion = 0;
+        int8_t               signaturetype = BR_SIGNATURE_TYPE_VOID;
+        gf_boolean_t         corrupted     = _gf_false;
         gf_dirent_t         *entry         = NULL;
         loc_t               *parent        = NULL;
 
@@ -344,7 +515,8 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
          *  - presence of bad object
          *  - signature staleness
          */
-        ret = bitd_scrub_pre_compute_check (this, child, fd, &signedversion);
+        ret = bitd_scrub_pre_compute_check (this, child, fd,
+                                            &signedversion, &signaturetype);
         if (ret)
                 goto unrefd; /* skip this object */
 
@@ -354,14 +526,28 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
         if (!md)
                 goto unrefd;
 
-        ret = br_calculate_obj_checksum (md, child, fd, &iatt);
-        if (ret) {
+        if (signaturetype == BR_SIGNATURE_TYPE_SHA256_CHUNKED) {
+                /* chunks are verified against the signature as hashed */
+                ret = bitd_scrub_post_compute_check (this, child, fd,
+                                                     signedversion, &sign);
+                if (ret)
+                        goto free_md;
+
+                ret = bitd_scrub_chunked (this, child, fd, sign, md);
+                GF_FREE (sign);
+                sign = NULL;
+        } else {
+                ret = br_calculate_obj_checksum (md, child, fd, &iatt);
+        }
+
+        if (ret < 0) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_CALC_ERROR,
                         "error calculating hash for object [GFID: %s]",
                         uuid_utoa (fd->inode->gfid));
                 ret = -1;
                 goto free_md;
         }
+        corrupted = (ret == 1);
 
         /**
          * perform post compute checks as an object's signature may have
@@ -372,8 +558,11 @@ br_scrubber_scrub_begin (xlator_t *this, struct br_fsscan_entry *fsentry)
         if (ret)
                 goto free_md;
 
-        ret = bitd_compare_ckum (this, sign, md,
-                                 linked_inode, entry, fd, child, &loc);
+        if (corrupted)
+                ret = bitd_mark_corrupted (this, linked_inode, fd, child, &loc);
+        else
+                ret = bitd_compare_ckum (this, sign, md,
+                                         linked_inode, entry, fd, child, &loc);
 
         GF_FREE (sign); /* alloced on post-compute */
 
@@ -709,11 +898,17 @@ br_fsscan_calculate_delta (uint32_t boot, uint32_t now, uint32_t times)
 #define BR_SCRUB_MONTHLY    (30 * 24 * 60 * 60)
 
 static unsigned int
-br_fsscan_calculate_timeout (uint32_t boot, uint32_t now, scrub_freq_t freq)
+br_fsscan_calculate_timeout (uint32_t boot, uint32_t now,
+                             struct br_scrubber *fsscrub)
 {
         uint32_t timo = 0;
 
-        switch (freq) {
+        if (fsscrub->interval &&
+            (fsscrub->frequency != BR_FSSCRUB_FREQ_STALLED))
+                return br_fsscan_calculate_delta (boot, now,
+                                                  fsscrub->interval);
+
+        switch (fsscrub->frequency) {
         case BR_FSSCRUB_FREQ_HOURLY:
                 timo = br_fsscan_calculate_delta (boot, now, BR_SCRUB_HOURLY);
                 break;
@@ -755,7 +950,7 @@ br_fsscan_schedule (xlator_t *this, br_child_t *child)
         fsscan->boot = tv.tv_sec;
 
         timo = br_fsscan_calculate_timeout (fsscan->boot,
-                                            fsscan->boot, fsscrub->frequency);
+                                            fsscan->boot, fsscrub);
         if (timo == 0) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_ZERO_TIMEOUT_BUG,
                         "BUG: Zero schedule timeout");
@@ -804,7 +999,7 @@ br_fsscan_activate (xlator_t *this, br_child_t *child)
 
         (void) gettimeofday (&now, NULL);
         timo = br_fsscan_calculate_timeout (fsscan->boot,
-                                            now.tv_sec, fsscrub->frequency);
+                                            now.tv_sec, fsscrub);
         if (timo == 0) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_ZERO_TIMEOUT_BUG,
                         "BUG: Zero schedule timeout");
@@ -840,7 +1035,7 @@ br_fsscan_reschedule (xlator_t *this, br_child_t *child)
 
         (void) gettimeofday (&now, NULL);
         timo = br_fsscan_calculate_timeout (fsscan->boot,
-                                            now.tv_sec, fsscrub->frequency);
+                                            now.tv_sec, fsscrub);
         if (timo == 0) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_ZERO_TIMEOUT_BUG,
                         "BUG: Zero schedule timeout");
@@ -934,16 +1129,40 @@ _br_scrubber_get_entry (br_child_t *child, struct br_fsscan_entry **fsentry)
         list_del_init (&(*fsentry)->list);
 }
 
+/* an object another scrubber hashes in chunks with chunks left to hash */
+static inline br_chunk_hash_t *
+_br_scrubber_get_chunks (struct br_scrubber *fsscrub)
+{
+        br_chunk_hash_t *ch = NULL;
+
+        list_for_each_entry (ch, &fsscrub->chunkq, list) {
+                if (!ch->abort && (ch->next < ch->nchunks)) {
+                        ch->users++;
+                        return ch;
+                }
+        }
+
+        return NULL;
+}
+
 static inline void
 _br_scrubber_find_scrubbable_entry (struct br_scrubber *fsscrub,
-                                     struct br_fsscan_entry **fsentry)
+                                     struct br_fsscan_entry **fsentry,
+                                     br_chunk_hash_t **ch)
 {
         br_child_t *child = NULL;
         br_child_t *firstchild = NULL;
 
         while (1) {
-                if (list_empty (&fsscrub->scrublist))
+                /* helping with an object under way comes first */
+                *ch = _br_scrubber_get_chunks (fsscrub);
+                if (*ch)
+                        break;
+
+                if (list_empty (&fsscrub->scrublist)) {
                         pthread_cond_wait (&fsscrub->cond, &fsscrub->mutex);
+                        continue;
+                }
 
                 firstchild = NULL;
                 for (child = _br_scrubber_get_next_child (fsscrub);
@@ -968,14 +1187,16 @@ _br_scrubber_find_scrubbable_entry (struct br_scrubber *fsscrub,
 
 static void
 br_scrubber_pick_entry (struct br_scrubber *fsscrub,
-                        struct br_fsscan_entry **fsentry)
+                        struct br_fsscan_entry **fsentry,
+                        br_chunk_hash_t **ch)
 {
         pthread_cleanup_push (_br_lock_cleaner, &fsscrub->mutex);
 
         pthread_mutex_lock (&fsscrub->mutex);
         {
                 *fsentry = NULL;
-                _br_scrubber_find_scrubbable_entry (fsscrub, fsentry);
+                *ch = NULL;
+                _br_scrubber_find_scrubbable_entry (fsscrub, fsentry, ch);
         }
         pthread_mutex_unlock (&fsscrub->mutex);
 
@@ -1041,17 +1262,59 @@ br_scrubber_scrub_entry (xlator_t *this, struct br_fsscan_entry *fsentry)
         pthread_cleanup_pop (1);
 }
 
+/* done helping (or cancelled): let the object's scrubber go on */
+static void
+br_scrubber_chunks_release (void *arg)
+{
+        struct br_chunk_help *help = arg;
+
+        /* a chunk taken but left unhashed fails the whole object */
+        if (!help->done) {
+                help->ch->failed = 1;
+                help->ch->abort = 1;
+        }
+
+        pthread_mutex_lock (&help->fsscrub->mutex);
+        {
+                if (--help->ch->users == 0)
+                        pthread_cond_broadcast (&help->fsscrub->chunkcond);
+        }
+        pthread_mutex_unlock (&help->fsscrub->mutex);
+}
+
+static void
+br_scrubber_help_chunks (struct br_scrubber *fsscrub, br_chunk_hash_t *ch)
+{
+        struct br_chunk_help help = {0, };
+
+        help.fsscrub = fsscrub;
+        help.ch = ch;
+
+        pthread_cleanup_push (br_scrubber_chunks_release, &help);
+        {
+                (void) br_chunk_hash_worker (ch);
+                help.done = _gf_true;
+        }
+        pthread_cleanup_pop (1);
+}
+
 void *br_scrubber_proc (void *arg)
 {
         xlator_t *this = NULL;
         struct br_scrubber *fsscrub = NULL;
         struct br_fsscan_entry *fsentry = NULL;
+        br_chunk_hash_t *ch = NULL;
 
         fsscrub = arg;
         THIS = this = fsscrub->this;
 
         while (1) {
-                br_scrubber_pick_entry (fsscrub, &fsentry);
+                br_scrubber_pick_entry (fsscrub, &fsentry, &ch);
+                if (ch) {
+                        br_scrubber_help_chunks (fsscrub, ch);
+                        continue;
+                }
+
                 br_scrubber_scrub_entry (this, fsentry);
                 sleep (1);
         }
@@ -1183,7 +1446,41 @@ br_scrubber_fetch_option (xlator_t *this,
 /* internal "throttle" override */
 #define BR_SCRUB_STALLED  "STALLED"
 
-/* TODO: token buket spec */
+/**
+ * object reads are rate limited on bytes, the budget being shared by
+ * all scrubber threads. rates are in bytes per second; tokens are
+ * generated every 600 msecs, so the per-tick share is 6/10th of it.
+ */
+#define BR_SCRUB_READ_RATE_LAZY    (32 * 1024 * 1024)
+#define BR_SCRUB_READ_RATE_NORMAL  (128 * 1024 * 1024)
+#define BR_SCRUB_READ_RATE_AGGRESSIVE  0 /* unlimited */
+
+static int32_t
+br_scrubber_throttle_reads (xlator_t *this, br_private_t *priv,
+                            scrub_throttle_t nthrottle)
+{
+        br_tbf_opspec_t spec = {0,};
+
+        spec.op = BR_TBF_OP_READ;
+
+        switch (nthrottle) {
+        case BR_SCRUB_THROTTLE_LAZY:
+                spec.rate = BR_SCRUB_READ_RATE_LAZY;
+                break;
+        case BR_SCRUB_THROTTLE_NORMAL:
+                spec.rate = BR_SCRUB_READ_RATE_NORMAL;
+                break;
+        default:
+                spec.rate = BR_SCRUB_READ_RATE_AGGRESSIVE;
+                break;
+        }
+
+        spec.rate = (spec.rate / 10) * 6;
+        spec.maxlimit = spec.rate;
+
+        return br_tbf_mod (priv->tbf, &spec);
+}
+
 static int32_t
 br_scrubber_handle_throttle (xlator_t *this, br_private_t *priv,
                              dict_t *options, gf_boolean_t scrubstall)
@@ -1218,6 +1515,12 @@ br_scrubber_handle_throttle (xlator_t *this, br_private_t *priv,
         if (ret)
                 goto error_return;
 
+        ret = br_scrubber_throttle_reads (this, priv, nthrottle);
+        if (ret)
+                gf_msg (this->name, GF_LOG_WARNING, 0, BRB_MSG_RATE_LIMIT_INFO,
+                        "could not set up read throttling for scrubber, "
+                        "reads are not rate limited");
+
         fsscrub->throttle = nthrottle;
         return 0;
 
@@ -1260,6 +1563,13 @@ br_scrubber_handle_freq (xlator_t *this, br_private_t *priv,
         if (ret)
                 goto error_return;
 
+        if (options)
+                GF_OPTION_RECONF ("scrub-debug-interval", fsscrub->interval,
+                                  options, uint32, error_return);
+        else
+                GF_OPTION_INIT ("scrub-debug-interval", fsscrub->interval,
+                                uint32, error_return);
+
         if (scrubstall)
                 tmp = BR_SCRUB_STALLED;
 
@@ -1306,6 +1616,14 @@ static void br_scrubber_log_option (xlator_t *this,
         if (scrubstall)
                 return; /* logged as pause */
 
+        if (fsscrub->interval) {
+                gf_msg (this->name, GF_LOG_INFO, 0, BRB_MSG_SCRUB_TUNABLE,
+                        "SCRUB TUNABLES:: [Frequency: every %u seconds "
+                        "(debug), Throttle: %s]", fsscrub->interval,
+                        scrub_throttle_str[fsscrub->throttle]);
+                return;
+        }
+
         gf_msg (this->name, GF_LOG_INFO, 0, BRB_MSG_SCRUB_TUNABLE, "SCRUB "
                 "TUNABLES:: [Frequency: %s, Throttle: %s]",
                 scrub_freq_str[fsscrub->frequency],
@@ -1354,10 +1672,12 @@ br_scrubber_init (xlator_t *this, br_private_t *priv)
 
         pthread_mutex_init (&fsscrub->mutex, NULL);
         pthread_cond_init (&fsscrub->cond, NULL);
+        pthread_cond_init (&fsscrub->chunkcond, NULL);
 
         fsscrub->nr_scrubbers = 0;
         INIT_LIST_HEAD (&fsscrub->scrubbers);
         INIT_LIST_HEAD (&fsscrub->scrublist);
+        INIT_LIST_HEAD (&fsscrub->chunkq);
 
         return 0;
 }
@@ -105,23 +105,43 @@ _br_tbf_dispatch_queued (br_tbf_bucket_t *bucket)
         }
 }
 
+/**
+ * release every queued request: used when throttling is turned off
+ * (rate set to zero) for a bucket.
+ */
+static void
+_br_tbf_release_queued (br_tbf_bucket_t *bucket)
+{
+        br_tbf_throttle_t *tmp = NULL;
+        br_tbf_throttle_t *throttle = NULL;
+
+        list_for_each_entry_safe (throttle, tmp, &bucket->queued, list) {
+                pthread_mutex_lock (&throttle->mutex);
+                {
+                        throttle->done = 1;
+                        list_del_init (&throttle->list);
+                        pthread_cond_signal (&throttle->cond);
+                }
+                pthread_mutex_unlock (&throttle->mutex);
+        }
+}
+
 void *br_tbf_tokengenerator (void *arg)
 {
-        unsigned long tokenrate = 0;
-        unsigned long maxtokens = 0;
         br_tbf_bucket_t *bucket = arg;
 
-        tokenrate = bucket->tokenrate;
-        maxtokens = bucket->maxtokens;
-
         while (1) {
                 usleep (BR_TBF_TOKENGEN_INTERVAL_USEC);
 
+                /**
+                 * rate and limit are picked up on every tick so that
+                 * br_tbf_mod() takes effect for an existing bucket.
+                 */
                 LOCK (&bucket->lock);
                 {
-                        bucket->tokens += tokenrate;
-                        if (bucket->tokens > maxtokens)
-                                bucket->tokens = maxtokens;
+                        bucket->tokens += bucket->tokenrate;
+                        if (bucket->tokens > bucket->maxtokens)
+                                bucket->tokens = bucket->maxtokens;
 
                         if (!list_empty (&bucket->queued))
                                 _br_tbf_dispatch_queued (bucket);
@@ -224,6 +244,10 @@ br_tbf_mod_bucket (br_tbf_bucket_t *bucket, br_tbf_opspec_t *spec)
                 bucket->tokens = 0;
                 bucket->tokenrate = spec->rate;
                 bucket->maxtokens = spec->maxlimit;
+
+                /* throttling turned off: nothing should wait anymore */
+                if (!bucket->tokenrate)
+                        _br_tbf_release_queued (bucket);
         }
         UNLOCK (&bucket->lock);
 
@@ -255,12 +279,45 @@ br_tbf_mod (br_tbf_t *tbf, br_tbf_opspec_t *tbfspec)
         return ret;
 }
 
+struct br_tbf_waiter {
+        br_tbf_bucket_t   *bucket;
+        br_tbf_throttle_t *throttle;
+};
+
+/**
+ * scanner and scrubber threads are cancelled when the service is
+ * paused or reconfigured. a waiter cancelled on the condition variable
+ * holds the throttle mutex: drop it, take the request off the queue (if
+ * it is still there) and release it.
+ */
+static void
+br_tbf_throttle_cleanup (void *arg)
+{
+        struct br_tbf_waiter *waiter = arg;
+        br_tbf_throttle_t *throttle = waiter->throttle;
+
+        pthread_mutex_unlock (&throttle->mutex);
+
+        LOCK (&waiter->bucket->lock);
+        {
+                if (!throttle->done)
+                        list_del_init (&throttle->list);
+        }
+        UNLOCK (&waiter->bucket->lock);
+
+        pthread_mutex_destroy (&throttle->mutex);
+        pthread_cond_destroy (&throttle->cond);
+
+        GF_FREE (throttle);
+}
+
 void
 br_tbf_throttle (br_tbf_t *tbf, br_tbf_ops_t op, unsigned long tokens_requested)
 {
         char waitq = 0;
         br_tbf_bucket_t *bucket = NULL;
         br_tbf_throttle_t *throttle = NULL;
+        struct br_tbf_waiter waiter = {0,};
 
         GF_ASSERT (op >= BR_TBF_OP_MIN);
         GF_ASSERT (op <= BR_TBF_OP_MAX);
@@ -271,6 +328,17 @@ br_tbf_throttle (br_tbf_t *tbf, br_tbf_ops_t op, unsigned long tokens_requested)
 
         LOCK (&bucket->lock);
         {
+                /* rate dropped to zero: not throttled anymore */
+                if (!bucket->tokenrate)
+                        goto unblock;
+
+                /**
+                 * a request larger than the bucket can ever hold would
+                 * wait forever; charge it a full bucket instead.
+                 */
+                if (tokens_requested > bucket->maxtokens)
+                        tokens_requested = bucket->maxtokens;
+
                 /**
                  * if there are enough tokens in the bucket there is no need
                  * to throttle the request: therefore, consume the required
@@ -292,15 +360,16 @@ br_tbf_throttle (br_tbf_t *tbf, br_tbf_ops_t op, unsigned long tokens_requested)
         UNLOCK (&bucket->lock);
 
         if (waitq) {
-                while (!throttle->done) {
-                        pthread_cond_wait (&throttle->cond, &throttle->mutex);
-                }
+                waiter.bucket = bucket;
+                waiter.throttle = throttle;
 
-                pthread_mutex_unlock (&throttle->mutex);
-
-                pthread_mutex_destroy (&throttle->mutex);
-                pthread_cond_destroy (&throttle->cond);
-
-                GF_FREE (throttle);
+                pthread_cleanup_push (br_tbf_throttle_cleanup, &waiter);
+                {
+                        while (!throttle->done) {
+                                pthread_cond_wait (&throttle->cond,
+                                                   &throttle->mutex);
+                        }
+                }
+                pthread_cleanup_pop (1);
         }
 }
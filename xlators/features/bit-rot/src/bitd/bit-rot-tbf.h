@@ -65,6 +65,6 @@ void
 br_tbf_throttle (br_tbf_t *, br_tbf_ops_t, unsigned long);
 
 #define TBF_THROTTLE_BEGIN(tbf, op, tokens) (br_tbf_throttle (tbf, op, tokens))
-#define TBF_THROTTLE_END(tbf, op, tokens) (void)
+#define TBF_THROTTLE_END(tbf, op, tokens) ((void) 0)
 
 #endif /** __BIT_ROT_TBF_H__ */
@@ -270,63 +270,253 @@ out:
 }
 
 /**
- * read 128k block from the object @object from the offset @offset
- * and return the buffer.
+ * Objects are read a block at a time, the next block being read while
+ * the current one is hashed, so that the disk and the CPU work side by
+ * side. Reads are wound asynchronously and waited upon.
  */
+typedef struct br_read_req {
+        pthread_mutex_t  lock;
+        pthread_cond_t   cond;
+        gf_boolean_t     pending;
+
+        off_t            offset;
+        size_t           size;
+
+        int32_t          op_ret;
+        int32_t          op_errno;
+        struct iovec    *iovec;
+        int              count;
+        struct iobref   *iobref;
+} br_read_req_t;
+
 static int32_t
-br_object_read_block_and_sign (xlator_t *this, fd_t *fd, br_child_t *child,
-                               off_t offset, size_t size, SHA256_CTX *sha256)
+br_object_readv_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
+                     int32_t op_ret, int32_t op_errno, struct iovec *vector,
+                     int32_t count, struct iatt *stbuf, struct iobref *iobref,
+                     dict_t *xdata)
 {
-        int32_t        ret    = -1;
-        br_tbf_t      *tbf    = NULL;
-        struct iovec  *iovec  = NULL;
-        struct iobref *iobref = NULL;
-        br_private_t  *priv   = NULL;
-        int            count  = 0;
-        int            i      = 0;
+        br_read_req_t *req = frame->local;
 
-        GF_VALIDATE_OR_GOTO ("bit-rot", this, out);
-        GF_VALIDATE_OR_GOTO (this->name, fd, out);
-        GF_VALIDATE_OR_GOTO (this->name, fd->inode, out);
-        GF_VALIDATE_OR_GOTO (this->name, child, out);
-        GF_VALIDATE_OR_GOTO (this->name, this->private, out);
+        frame->local = NULL;
+
+        pthread_mutex_lock (&req->lock);
+        {
+                req->op_ret = op_ret;
+                req->op_errno = op_errno;
+                if (op_ret > 0) {
+                        req->iovec = iov_dup (vector, count);
+                        req->count = count;
+                        if (iobref)
+                                req->iobref = iobref_ref (iobref);
+                        if (!req->iovec) {
+                                req->op_ret = -1;
+                                req->op_errno = ENOMEM;
+                        }
+                }
+
+                req->pending = _gf_false;
+                pthread_cond_signal (&req->cond);
+        }
+        pthread_mutex_unlock (&req->lock);
+
+        STACK_DESTROY (frame->root);
+        return 0;
+}
+
+static void
+br_object_read_start (xlator_t *this, br_child_t *child, fd_t *fd,
+                      br_read_req_t *req, off_t offset, size_t size)
+{
+        br_private_t *priv  = this->private;
+        call_frame_t *frame = NULL;
+        dict_t       *xdata = NULL;
+
+        req->offset = offset;
+        req->size = size;
+        req->op_ret = -1;
+        req->op_errno = ENOMEM;
+        req->iovec = NULL;
+        req->count = 0;
+        req->iobref = NULL;
+
+        frame = syncop_create_frame (this);
+        if (!frame)
+                return;
+
+        /* the scrubber does not fill the brick's page cache */
+        if (priv->iamscrubber) {
+                xdata = dict_new ();
+                if (xdata && dict_set_int8 (xdata,
+                                            GLUSTERFS_READ_NOCACHE, 1)) {
+                        dict_unref (xdata);
+                        xdata = NULL;
+                }
+        }
+
+        frame->local = req;
+        req->pending = _gf_true;
+
+        STACK_WIND (frame, br_object_readv_cbk, child->xl,
+                    child->xl->fops->readv, fd, size, offset, 0, xdata);
+
+        if (xdata)
+                dict_unref (xdata);
+}
+
+static int32_t
+br_object_read_wait (br_read_req_t *req)
+{
+        pthread_mutex_lock (&req->lock);
+        {
+                while (req->pending)
+                        pthread_cond_wait (&req->cond, &req->lock);
+        }
+        pthread_mutex_unlock (&req->lock);
+
+        return req->op_ret;
+}
+
+static void
+br_object_read_release (br_read_req_t *req)
+{
+        GF_FREE (req->iovec);
+        req->iovec = NULL;
+
+        if (req->iobref)
+                iobref_unref (req->iobref);
+        req->iobref = NULL;
+}
+
+static inline size_t
+br_object_read_size (off_t offset, off_t end)
+{
+        size_t size = BR_HASH_CALC_READ_SIZE;
+
+        if ((end >= 0) && ((end - offset) < size))
+                size = end - offset;
+
+        return size;
+}
+
+/* the caller got cancelled with no read in flight */
+static void
+br_object_read_cleanup (void *arg)
+{
+        int            i   = 0;
+        br_read_req_t *req = arg;
+
+        for (i = 0; i < 2; i++) {
+                br_object_read_release (&req[i]);
+                pthread_cond_destroy (&req[i].cond);
+                pthread_mutex_destroy (&req[i].lock);
+        }
+}
+
+static inline size_t
+br_object_iov_length (br_read_req_t *req)
+{
+        int    i   = 0;
+        size_t len = 0;
+
+        for (i = 0; i < req->count; i++)
+                len += req->iovec[i].iov_len;
+
+        return len;
+}
+
+/**
+ * read and hash [@offset, @end) of an object (till EOF when @end is -1)
+ * into @sha256. reading stops early when @abort gets set.
+ *
+ * read requests live on this stack and are completed by another thread,
+ * so cancellation is held off while a read is in flight. throttling is
+ * done with no read in flight and stays cancellable: a paused or
+ * reconfigured scrubber does not sit out its token wait.
+ */
+static int32_t
+br_object_read_and_sign (xlator_t *this, fd_t *fd, br_child_t *child,
+                         off_t offset, off_t end, SHA256_CTX *sha256,
+                         int *abort)
+{
+        int32_t        ret   = 0;
+        int            i     = 0;
+        int            cur   = 0;
+        int            state = 0;
+        size_t         size  = 0;
+        br_private_t  *priv  = NULL;
+        br_read_req_t  req[2];
 
         priv = this->private;
 
-        GF_VALIDATE_OR_GOTO (this->name, priv->tbf, out);
-        tbf = priv->tbf;
+        for (i = 0; i < 2; i++) {
+                memset (&req[i], 0, sizeof (req[i]));
+                pthread_mutex_init (&req[i].lock, NULL);
+                pthread_cond_init (&req[i].cond, NULL);
+        }
 
-        ret = syncop_readv (child->xl, fd,
-                            size, offset, 0, &iovec, &count, &iobref, NULL,
-                            NULL);
+        pthread_cleanup_push (br_object_read_cleanup, req);
 
-        if (ret < 0) {
-                gf_msg (this->name, GF_LOG_ERROR, errno, BRB_MSG_READV_FAILED,
-                        "readv on %s failed", uuid_utoa (fd->inode->gfid));
-                ret = -1;
-                goto out;
+        size = br_object_read_size (offset, end);
+        if (size) {
+                /* reads are throttled on bytes across all threads */
+                TBF_THROTTLE_BEGIN (priv->tbf, BR_TBF_OP_READ, size);
+
+                (void) pthread_setcancelstate (PTHREAD_CANCEL_DISABLE, &state);
+                br_object_read_start (this, child, fd, &req[cur],
+                                      offset, size);
+                ret = br_object_read_wait (&req[cur]);
+                (void) pthread_setcancelstate (state, NULL);
         }
 
-        if (ret == 0)
-                goto out;
+        while (size) {
+                if (ret < 0) {
+                        gf_msg (this->name, GF_LOG_ERROR, req[cur].op_errno,
+                                BRB_MSG_READV_FAILED, "readv on %s failed",
+                                uuid_utoa (fd->inode->gfid));
+                        gf_msg (this->name, GF_LOG_ERROR, 0,
+                                BRB_MSG_BLOCK_READ_FAILED, "reading block with "
+                                "offset %lu of object %s failed",
+                                req[cur].offset, uuid_utoa (fd->inode->gfid));
+                        break;
+                }
+
+                if (ret == 0)
+                        break;
+
+                TBF_THROTTLE_BEGIN (priv->tbf, BR_TBF_OP_HASH,
+                                    br_object_iov_length (&req[cur]));
+
+                offset = req[cur].offset + ret;
+                size = (abort && *abort) ? 0 : br_object_read_size (offset,
+                                                                    end);
+                if (size)
+                        TBF_THROTTLE_BEGIN (priv->tbf, BR_TBF_OP_READ, size);
 
-        for (i = 0; i < count; i++) {
-                TBF_THROTTLE_BEGIN (tbf, BR_TBF_OP_HASH, iovec[i].iov_len);
+                (void) pthread_setcancelstate (PTHREAD_CANCEL_DISABLE, &state);
                 {
-                        SHA256_Update (sha256, (const unsigned char *)
-                                       (iovec[i].iov_base), iovec[i].iov_len);
+                        /* start on the next block before hashing this one */
+                        if (size)
+                                br_object_read_start (this, child, fd,
+                                                      &req[!cur], offset,
+                                                      size);
+
+                        for (i = 0; i < req[cur].count; i++) {
+                                SHA256_Update (sha256, (const unsigned char *)
+                                               (req[cur].iovec[i].iov_base),
+                                               req[cur].iovec[i].iov_len);
+                        }
+
+                        br_object_read_release (&req[cur]);
+                        cur = !cur;
+
+                        ret = size ? br_object_read_wait (&req[cur]) : 0;
                 }
-                TBF_THROTTLE_BEGIN (tbf, BR_TBF_OP_HASH, iovec[i].iov_len);
+                (void) pthread_setcancelstate (state, NULL);
         }
 
- out:
-        if (iovec)
-                GF_FREE (iovec);
-
-        if (iobref)
-                iobref_unref (iobref);
+        pthread_cleanup_pop (1);
 
-        return ret;
+        return (ret < 0) ? -1 : 0;
 }
 
 int32_t
@@ -334,8 +524,6 @@ br_calculate_obj_checksum (unsigned char *md,
                            br_child_t *child, fd_t *fd, struct iatt *iatt)
 {
         int32_t   ret    = -1;
-        off_t     offset = 0;
-        size_t    block  = BR_HASH_CALC_READ_SIZE;
         xlator_t *this   = NULL;
 
         SHA256_CTX       sha256;
@@ -348,28 +536,180 @@ br_calculate_obj_checksum (unsigned char *md,
 
         SHA256_Init (&sha256);
 
-        while (1) {
-                ret = br_object_read_block_and_sign (this, fd, child,
-                                                     offset, block, &sha256);
-                if (ret < 0) {
-                        gf_msg (this->name, GF_LOG_ERROR, 0,
-                                BRB_MSG_BLOCK_READ_FAILED, "reading block with "
-                                "offset %lu of object %s failed", offset,
-                                uuid_utoa (fd->inode->gfid));
-                        break;
-                }
+        ret = br_object_read_and_sign (this, fd, child, 0, -1, &sha256, NULL);
+        if (ret == 0)
+                SHA256_Final (md, &sha256);
 
-                if (ret == 0)
+ out:
+        return ret;
+}
+
+/**
+ * chunk size and count for an object of @size bytes: as small a chunk
+ * as possible while still fitting in BR_CHUNKS_MAX chunks.
+ */
+void
+br_chunk_layout (uint64_t size, uint8_t *chunkbits, uint32_t *nchunks)
+{
+        uint8_t bits = BR_CHUNK_MIN_BITS;
+
+        while (size > ((uint64_t) BR_CHUNKS_MAX << bits))
+                bits++;
+
+        *chunkbits = bits;
+        *nchunks = (size + (1ULL << bits) - 1) >> bits;
+        if (*nchunks == 0)
+                *nchunks = 1;
+}
+
+static void
+br_hash_chunk (br_chunk_hash_t *ch, uint32_t idx)
+{
+        int32_t        ret    = 0;
+        off_t          offset = 0;
+        off_t          end    = 0;
+        unsigned char *md     = NULL;
+        xlator_t      *this   = NULL;
+
+        SHA256_CTX sha256;
+
+        this = ch->child->this;
+
+        offset = (off_t) idx << ch->chunkbits;
+        end = offset + ((off_t) 1 << ch->chunkbits);
+        if (idx == (ch->nchunks - 1))
+                end = -1; /* the last chunk runs till EOF */
+
+        SHA256_Init (&sha256);
+
+        ret = br_object_read_and_sign (this, ch->fd, ch->child,
+                                       offset, end, &sha256, &ch->abort);
+        if (ret) {
+                ch->failed = 1;
+                ch->abort = 1;
+                return;
+        }
+
+        if (ch->abort)
+                return;
+
+        md = ch->md + ((size_t) idx * SHA256_DIGEST_LENGTH);
+        SHA256_Final (md, &sha256);
+
+        if (ch->expect &&
+            memcmp (md, ch->expect + ((size_t) idx * SHA256_DIGEST_LENGTH),
+                    SHA256_DIGEST_LENGTH)) {
+                (void) __sync_bool_compare_and_swap (&ch->mismatch,
+                                                     ch->nchunks, idx);
+                ch->abort = 1;
+        }
+}
+
+/* hashes chunks of @arg (a br_chunk_hash_t) until none are left */
+void *
+br_chunk_hash_worker (void *arg)
+{
+        uint32_t         idx = 0;
+        br_chunk_hash_t *ch  = arg;
+
+        THIS = ch->child->this;
+        if (ch->setpid)
+                (void) syncopctx_setfspid (&ch->pid);
+
+        while (!ch->abort) {
+                idx = __sync_fetch_and_add (&ch->next, 1);
+                if (idx >= ch->nchunks)
                         break;
+                br_hash_chunk (ch, idx);
+        }
+
+        return NULL;
+}
 
-                offset += ret;
+struct br_chunk_helpers {
+        br_chunk_hash_t *ch;
+
+        int count;
+        int joined;
+        pthread_t threads[BR_CHUNK_THREADS_MAX];
+};
+
+static void
+br_chunk_helpers_join (void *arg)
+{
+        struct br_chunk_helpers *helpers = arg;
+
+        for (; helpers->joined < helpers->count; helpers->joined++)
+                (void) pthread_join (helpers->threads[helpers->joined], NULL);
+}
+
+/* the caller is being cancelled: stop helpers before @ch goes away */
+static void
+br_chunk_helpers_cancel (void *arg)
+{
+        struct br_chunk_helpers *helpers = arg;
+
+        helpers->ch->abort = 1;
+        br_chunk_helpers_join (helpers);
+}
+
+/* readies @ch for hashing by workers running as the caller's fspid */
+void
+br_chunk_hash_init (br_chunk_hash_t *ch)
+{
+        struct syncopctx *opctx = NULL;
+
+        ch->next = 0;
+        ch->failed = 0;
+        ch->abort = 0;
+        ch->mismatch = ch->nchunks;
+        ch->users = 0;
+        INIT_LIST_HEAD (&ch->list);
+
+        opctx = syncopctx_getctx ();
+        if (opctx && (opctx->valid & SYNCOPCTX_PID)) {
+                ch->setpid = _gf_true;
+                ch->pid = opctx->pid;
         }
+}
 
-        if (ret == 0)
-                SHA256_Final (md, &sha256);
+/**
+ * hash chunks of an object with (upto) @nthreads threads, the caller being
+ * one of them. with @ch->expect set, hashing stops at the first chunk that
+ * does not verify (@ch->mismatch).
+ */
+int32_t
+br_calculate_obj_chunk_checksums (br_chunk_hash_t *ch, int nthreads)
+{
+        int                      i       = 0;
+        struct br_chunk_helpers  helpers = {0,};
 
- out:
-        return ret;
+        br_chunk_hash_init (ch);
+
+        if (nthreads > BR_CHUNK_THREADS_MAX)
+                nthreads = BR_CHUNK_THREADS_MAX;
+        if (nthreads > ch->nchunks)
+                nthreads = ch->nchunks;
+
+        helpers.ch = ch;
+
+        pthread_cleanup_push (br_chunk_helpers_cancel, &helpers);
+        {
+                /* fewer helpers than asked for is fine */
+                for (i = 1; i < nthreads; i++) {
+                        if (gf_thread_create (&helpers.threads[helpers.count],
+                                              NULL, br_chunk_hash_worker, ch))
+                                break;
+                        helpers.count++;
+                }
+
+                (void) br_chunk_hash_worker (ch);
+
+                br_chunk_helpers_join (&helpers);
+        }
+        pthread_cleanup_pop (0);
+
+        return ch->failed ? -1 : 0;
 }
 
 static inline int32_t
@@ -379,6 +719,40 @@ br_object_checksum (unsigned char *md,
         return br_calculate_obj_checksum (md, object->child, fd,  iatt);
 }
 
+/**
+ * hash @object in chunks and build the chunked signature in @md (of
+ * br_chunked_signature_size (BR_CHUNKS_MAX) bytes), its length in @mdlen.
+ */
+static int32_t
+br_object_chunked_checksum (unsigned char *md, size_t *mdlen,
+                            br_object_t *object, fd_t *fd, struct iatt *iatt)
+{
+        int32_t                 ret   = 0;
+        br_chunk_hash_t         ch    = {0,};
+        br_chunked_signature_t *csign = NULL;
+
+        csign = (br_chunked_signature_t *) md;
+
+        ch.child = object->child;
+        ch.fd = fd;
+        br_chunk_layout (iatt->ia_size, &ch.chunkbits, &ch.nchunks);
+        ch.md = csign->chunks;
+
+        ret = br_calculate_obj_chunk_checksums (&ch, BR_CHUNK_THREADS);
+        if (ret)
+                goto out;
+
+        csign->chunkbits = ch.chunkbits;
+        csign->nchunks = htonl (ch.nchunks);
+        SHA256 (csign->chunks,
+                (size_t) ch.nchunks * SHA256_DIGEST_LENGTH, csign->root);
+
+        *mdlen = br_chunked_signature_size (ch.nchunks);
+
+ out:
+        return ret;
+}
+
 static inline int32_t
 br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
                      struct iatt *iatt)
@@ -388,14 +762,24 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
         dict_t          *xattr         = NULL;
         unsigned char   *md            = NULL;
         br_isignature_t *sign          = NULL;
+        br_private_t    *priv          = NULL;
+        size_t           mdlen         = SHA256_DIGEST_LENGTH;
+        int8_t           type          = BR_SIGNATURE_TYPE_SHA256;
 
         GF_VALIDATE_OR_GOTO ("bit-rot", object, out);
         GF_VALIDATE_OR_GOTO ("bit-rot", linked_inode, out);
         GF_VALIDATE_OR_GOTO ("bit-rot", fd, out);
 
         this = object->this;
+        priv = this->private;
 
-        md = GF_CALLOC (SHA256_DIGEST_LENGTH, sizeof (*md), gf_common_mt_char);
+        if (priv->chunked_threshold &&
+            (iatt->ia_size >= priv->chunked_threshold)) {
+                type = BR_SIGNATURE_TYPE_SHA256_CHUNKED;
+                mdlen = br_chunked_signature_size (BR_CHUNKS_MAX);
+        }
+
+        md = GF_CALLOC (mdlen, sizeof (*md), gf_common_mt_char);
         if (!md) {
                 gf_msg (this->name, GF_LOG_ERROR, ENOMEM, BRB_MSG_NO_MEMORY,
                         "failed to allocate memory for saving hash of the "
@@ -403,7 +787,11 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
                 goto out;
         }
 
-        ret = br_object_checksum (md, object, fd, iatt);
+        if (type == BR_SIGNATURE_TYPE_SHA256_CHUNKED)
+                ret = br_object_chunked_checksum (md, &mdlen,
+                                                  object, fd, iatt);
+        else
+                ret = br_object_checksum (md, object, fd, iatt);
         if (ret) {
                 gf_msg (this->name, GF_LOG_ERROR, 0,
                         BRB_MSG_CALC_CHECKSUM_FAILED, "calculating checksum "
@@ -412,8 +800,7 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
                 goto free_signature;
         }
 
-        sign = br_prepare_signature (md, SHA256_DIGEST_LENGTH,
-                                     BR_SIGNATURE_TYPE_SHA256, object);
+        sign = br_prepare_signature (md, mdlen, type, object);
         if (!sign) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_GET_SIGN_FAILED,
                         "failed to get the signature for the object %s",
@@ -423,7 +810,7 @@ br_object_read_sign (inode_t *linked_inode, fd_t *fd, br_object_t *object,
 
         xattr = dict_for_key_value
                 (GLUSTERFS_SET_OBJECT_SIGNATURE,
-                 (void *)sign, signature_size (SHA256_DIGEST_LENGTH));
+                 (void *)sign, signature_size (mdlen));
 
         if (!xattr) {
                 gf_msg (this->name, GF_LOG_ERROR, 0, BRB_MSG_SET_SIGN_FAILED,
@@ -1743,12 +2130,19 @@ br_rate_limit_signer (xlator_t *this, int child_count, int numbricks)
 static int32_t
 br_signer_handle_options (xlator_t *this, br_private_t *priv, dict_t *options)
 {
-        if (options)
+        if (options) {
                 GF_OPTION_RECONF ("expiry-time", priv->expiry_time,
                                   options, uint32, error_return);
-        else
+                GF_OPTION_RECONF ("chunked-sign-threshold",
+                                  priv->chunked_threshold,
+                                  options, size_uint64, error_return);
+        } else {
                 GF_OPTION_INIT ("expiry-time", priv->expiry_time,
                                 uint32, error_return);
+                GF_OPTION_INIT ("chunked-sign-threshold",
+                                priv->chunked_threshold,
+                                size_uint64, error_return);
+        }
 
         return 0;
 
@@ -1763,6 +2157,8 @@ br_signer_init (xlator_t *this, br_private_t *priv)
         int numbricks = 0;
 
         GF_OPTION_INIT ("expiry-time", priv->expiry_time, uint32, error_return);
+        GF_OPTION_INIT ("chunked-sign-threshold", priv->chunked_threshold,
+                        size_uint64, error_return);
         GF_OPTION_INIT ("brick-count", numbricks, int32, error_return);
 
         ret = br_rate_limit_signer (this, priv->child_count, numbricks);
@@ -2047,6 +2443,14 @@ struct volume_options options[] = {
           .description = "Waiting time for an object on which it waits "
                          "before it is signed",
         },
+        { .key = {"chunked-sign-threshold"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min = 0,
+          .default_value = "0",
+          .description = "Objects of at least this size are signed in "
+                         "chunks, which are hashed (and scrubbed) in "
+                         "parallel. 0 signs all objects as a whole.",
+        },
         { .key = {"brick-count"},
           .type = GF_OPTION_TYPE_STR,
           .description = "Total number of bricks for the current node for "
@@ -2068,6 +2472,13 @@ struct volume_options options[] = {
           .default_value = "biweekly",
           .description = "Scrub frequency for volume <VOLNAME>",
         },
+        { .key = {"scrub-debug-interval"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 0,
+          .default_value = "0",
+          .description = "Debug only: scrub every so many seconds instead "
+                         "of at scrub-freq (0 to follow scrub-freq)",
+        },
         { .key = {"scrub-state"},
           .type = GF_OPTION_TYPE_STR,
           .default_value = "active",
@@ -54,6 +54,28 @@ typedef enum scrub_freq {
 
 #define signature_size(hl) (sizeof (br_isignature_t) + hl + 1)
 
+/**
+ * Chunked signature (BR_SIGNATURE_TYPE_SHA256_CHUNKED): the object is
+ * hashed in (1 << chunkbits) byte chunks, the last one running till EOF.
+ * The signature carries the hash of each chunk and a root hash, which is
+ * the hash of the chunk hashes. Chunks are hashed, and verified, on their
+ * own and hence in parallel.
+ */
+#define BR_CHUNK_MIN_BITS     20  /* 1MB */
+#define BR_CHUNKS_MAX         64  /* keeps the signature xattr ~2KB */
+#define BR_CHUNK_THREADS      4   /* signer threads per object */
+#define BR_CHUNK_THREADS_MAX  16
+
+typedef struct __attribute__ ((__packed__)) br_chunked_signature {
+        unsigned char root[SHA256_DIGEST_LENGTH];
+        uint8_t       chunkbits;
+        uint32_t      nchunks;    /* network byte order */
+        unsigned char chunks[0];  /* @nchunks chunk hashes */
+} br_chunked_signature_t;
+
+#define br_chunked_signature_size(n)                                    \
+        (sizeof (br_chunked_signature_t) + ((n) * SHA256_DIGEST_LENGTH))
+
 struct br_scanfs {
         gf_lock_t entrylock;
 
@@ -115,6 +137,29 @@ struct br_child {
 
 typedef struct br_child br_child_t;
 
+typedef struct br_chunk_hash {
+        br_child_t          *child;
+        fd_t                *fd;
+
+        uint8_t              chunkbits;
+        uint32_t             nchunks;
+
+        unsigned char       *md;        /* computed chunk hashes */
+        const unsigned char *expect;    /* hashes to verify against */
+
+        gf_boolean_t         setpid;
+        pid_t                pid;       /* caller's fspid */
+
+        uint32_t             next;      /* next chunk to be hashed */
+        int                  failed;
+        int                  abort;
+        uint32_t             mismatch;  /* a chunk that did not verify,
+                                           @nchunks if none */
+
+        struct list_head     list;      /* on the scrubbers' chunk queue */
+        int                  users;     /* scrubbers helping to hash it */
+} br_chunk_hash_t;
+
 struct br_obj_n_workers {
         struct list_head objects;         /* queue of objects expired from the
                                              timer wheel and ready to be picked
@@ -137,6 +182,9 @@ struct br_scrubber {
          */
         scrub_freq_t frequency;
 
+        /* seconds between scrubs overriding @frequency, for tests */
+        uint32_t interval;
+
         pthread_mutex_t mutex;
         pthread_cond_t  cond;
 
@@ -147,6 +195,13 @@ struct br_scrubber {
          * list of "rotatable" subvolume(s) undergoing scrubbing
          */
         struct list_head scrublist;
+
+        /**
+         * objects being scrubbed in chunks: idle scrubbers pick chunks
+         * off these before waiting for the next object
+         */
+        struct list_head chunkq;
+        pthread_cond_t   chunkcond; /* last helper left an object */
 };
 
 typedef struct br_obj_n_workers br_obj_n_workers_t;
@@ -180,6 +235,9 @@ struct br_private {
 
         br_tbf_t *tbf;                    /* token bucket filter */
 
+        uint64_t chunked_threshold;       /* sign objects of at least this
+                                             size in chunks (0: never) */
+
         gf_boolean_t iamscrubber;         /* function as a fs scrubber */
 
         struct br_scrubber fsscrub;       /* scrubbers for this subvolume */
@@ -216,6 +274,18 @@ int32_t
 br_calculate_obj_checksum (unsigned char *,
                            br_child_t *, fd_t *, struct iatt *);
 
+void
+br_chunk_layout (uint64_t, uint8_t *, uint32_t *);
+
+void
+br_chunk_hash_init (br_chunk_hash_t *);
+
+void *
+br_chunk_hash_worker (void *);
+
+int32_t
+br_calculate_obj_chunk_checksums (br_chunk_hash_t *, int);
+
 int32_t
 br_prepare_loc (xlator_t *, br_child_t *, loc_t *, gf_dirent_t *, loc_t *);
 
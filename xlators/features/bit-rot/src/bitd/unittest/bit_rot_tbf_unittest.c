@@ -0,0 +1,198 @@
+/*
+  Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs.h"
+#include "globals.h"
+#include "bit-rot-tbf.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+// a token tick is 600ms: anything taking this long is stuck, a test that
+// blocks for good is killed by the alarm
+#define WAIT_MAX_SECS 10
+
+/*
+ * Helper functions
+ */
+static br_tbf_t *
+helper_tbf_new(unsigned long rate, unsigned long maxlimit)
+{
+    br_tbf_opspec_t spec = {
+        .op = BR_TBF_OP_READ,
+        .rate = rate,
+        .maxlimit = maxlimit,
+    };
+    br_tbf_t *tbf;
+
+    alarm(WAIT_MAX_SECS * 2);
+
+    tbf = br_tbf_init(&spec, 1);
+    assert_non_null(tbf);
+    assert_non_null(tbf->bucket[BR_TBF_OP_READ]);
+
+    return tbf;
+}
+
+static void
+helper_tbf_mod(br_tbf_t *tbf, unsigned long rate, unsigned long maxlimit)
+{
+    br_tbf_opspec_t spec = {
+        .op = BR_TBF_OP_READ,
+        .rate = rate,
+        .maxlimit = maxlimit,
+    };
+
+    assert_int_equal(br_tbf_mod(tbf, &spec), 0);
+}
+
+static double
+helper_now(void)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int
+helper_queued(br_tbf_t *tbf)
+{
+    br_tbf_bucket_t *bucket = tbf->bucket[BR_TBF_OP_READ];
+    int queued;
+
+    LOCK(&bucket->lock);
+    queued = !list_empty(&bucket->queued);
+    UNLOCK(&bucket->lock);
+
+    return queued;
+}
+
+struct helper_waiter {
+    br_tbf_t *tbf;
+    unsigned long tokens;
+    int done;
+};
+
+static void *
+helper_throttle(void *arg)
+{
+    struct helper_waiter *waiter = arg;
+
+    br_tbf_throttle(waiter->tbf, BR_TBF_OP_READ, waiter->tokens);
+    waiter->done = 1;
+
+    return NULL;
+}
+
+static void
+helper_wait_queued(br_tbf_t *tbf)
+{
+    double start = helper_now();
+
+    while (!helper_queued(tbf)) {
+        assert_true(helper_now() - start < WAIT_MAX_SECS);
+        usleep(1000);
+    }
+}
+
+/*
+ * Tests
+ */
+static void
+test_br_tbf_throttle_oversized(void **state)
+{
+    br_tbf_t *tbf = helper_tbf_new(100, 100);
+    double start = helper_now();
+
+    // never fits the bucket: charged a full bucket instead of waiting forever
+    br_tbf_throttle(tbf, BR_TBF_OP_READ, 1000);
+    assert_true(helper_now() - start < WAIT_MAX_SECS);
+    assert_false(helper_queued(tbf));
+}
+
+static void
+test_br_tbf_mod_rate(void **state)
+{
+    br_tbf_t *tbf = helper_tbf_new(1, 1000);
+    double start = helper_now();
+
+    // at the initial rate this takes 500 ticks
+    helper_tbf_mod(tbf, 1000, 1000);
+    br_tbf_throttle(tbf, BR_TBF_OP_READ, 500);
+    assert_true(helper_now() - start < WAIT_MAX_SECS);
+}
+
+static void
+test_br_tbf_mod_zero_rate(void **state)
+{
+    br_tbf_t *tbf = helper_tbf_new(1, 1000);
+    struct helper_waiter waiter = { tbf, 500, 0 };
+    pthread_t thread;
+    double start;
+
+    assert_int_equal(pthread_create(&thread, NULL, helper_throttle, &waiter),
+                     0);
+    helper_wait_queued(tbf);
+
+    // throttling turned off releases the waiter
+    start = helper_now();
+    helper_tbf_mod(tbf, 0, 1000);
+    assert_int_equal(pthread_join(thread, NULL), 0);
+    assert_true(helper_now() - start < WAIT_MAX_SECS);
+    assert_int_equal(waiter.done, 1);
+    assert_false(helper_queued(tbf));
+
+    // and later requests go through
+    br_tbf_throttle(tbf, BR_TBF_OP_READ, 500);
+}
+
+static void
+test_br_tbf_throttle_cancel(void **state)
+{
+    br_tbf_t *tbf = helper_tbf_new(1, 1000);
+    struct helper_waiter waiter = { tbf, 500, 0 };
+    pthread_t thread;
+    void *res;
+
+    assert_int_equal(pthread_create(&thread, NULL, helper_throttle, &waiter),
+                     0);
+    helper_wait_queued(tbf);
+
+    // a cancelled waiter takes its request off the queue
+    assert_int_equal(pthread_cancel(thread), 0);
+    assert_int_equal(pthread_join(thread, &res), 0);
+    assert_ptr_equal(res, PTHREAD_CANCELED);
+    assert_int_equal(waiter.done, 0);
+    assert_false(helper_queued(tbf));
+}
+
+int main(void) {
+    const struct CMUnitTest bit_rot_tbf_tests[] = {
+        cmocka_unit_test(test_br_tbf_throttle_oversized),
+        cmocka_unit_test(test_br_tbf_mod_rate),
+        cmocka_unit_test(test_br_tbf_mod_zero_rate),
+        cmocka_unit_test(test_br_tbf_throttle_cancel),
+    };
+    glusterfs_ctx_t *ctx;
+
+    ctx = glusterfs_ctx_new();
+    assert_non_null(ctx);
+    ctx->mem_acct_enable = 0;
+    assert_int_equal(glusterfs_globals_init(ctx), 0);
+    THIS->ctx = ctx;
+
+    return cmocka_run_group_tests(bit_rot_tbf_tests, NULL, NULL);
+}
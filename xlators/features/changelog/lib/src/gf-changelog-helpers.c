@@ -34,16 +34,24 @@ gf_changelog_write (int fd, char *buffer, size_t len)
         return written;
 }
 
-void
+size_t
 gf_rfc3986_encode (unsigned char *s, char *enc, char *estr)
 {
+        static const char  hex[] = "0123456789ABCDEF";
+        char              *ptr   = enc;
+
         for (; *s; s++) {
-                if (estr[*s])
-                        sprintf(enc, "%c", estr[*s]);
-                else
-                        sprintf(enc, "%%%02X", *s);
-                while (*++enc);
+                if (estr[*s]) {
+                        *ptr++ = estr[*s];
+                } else {
+                        *ptr++ = '%';
+                        *ptr++ = hex[*s >> 4];
+                        *ptr++ = hex[*s & 0xf];
+                }
         }
+        *ptr = '\0';
+
+        return (ptr - enc);
 }
 
 /**
@@ -208,7 +208,7 @@ gf_changelog_process (void *data);
 ssize_t
 gf_changelog_read_path (int fd, char *buffer, size_t bufsize);
 
-void
+size_t
 gf_rfc3986_encode (unsigned char *s, char *enc, char *estr);
 
 size_t
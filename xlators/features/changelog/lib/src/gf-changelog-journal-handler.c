@@ -129,6 +129,44 @@ conv_noop (char *ptr) { return ptr; }
 
 #define LINE_BUFSIZE  (3*PATH_MAX) /* enough buffer for extra chars too */
 
+/**
+ * decoded records are gathered here and written out in large chunks
+ * rather than with a write() per record. records are decoded in place
+ * at the tail of the buffer, which always has room for one more record.
+ */
+#define OUT_BUFSIZE   (16*LINE_BUFSIZE)
+
+typedef struct gf_changelog_outbuf {
+        int     fd;
+        off_t   len;
+        char   *buf;
+} gf_changelog_outbuf_t;
+
+static int
+gf_changelog_outbuf_flush (gf_changelog_outbuf_t *ob)
+{
+        if (!ob->len)
+                return 0;
+
+        if (gf_changelog_write (ob->fd, ob->buf, ob->len) != ob->len)
+                return -1;
+
+        ob->len = 0;
+        return 0;
+}
+
+/* room for the next record, at the tail of the buffer */
+static char *
+gf_changelog_outbuf_tail (gf_changelog_outbuf_t *ob)
+{
+        if ((OUT_BUFSIZE - ob->len) < LINE_BUFSIZE) {
+                if (gf_changelog_outbuf_flush (ob))
+                        return NULL;
+        }
+
+        return ob->buf + ob->len;
+}
+
 /**
  * using mmap() makes parsing easy. fgets() cannot be used here as
  * the binary gfid could contain a line-feed (0x0A), in that case fgets()
@@ -144,7 +182,7 @@ conv_noop (char *ptr) { return ptr; }
 static int
 gf_changelog_parse_binary (xlator_t *this,
                            gf_changelog_journal_t *jnl,
-                           int from_fd, int to_fd,
+                           gf_changelog_outbuf_t *ob, int from_fd,
                            size_t start_offset, struct stat *stbuf,
                            int version_idx)
 
@@ -161,7 +199,7 @@ gf_changelog_parse_binary (xlator_t *this,
         char    current_mover    = ' ';
         size_t  blen             = 0;
         int     parse_err        = 0;
-        char ascii[LINE_BUFSIZE] = {0,};
+        char   *ascii            = NULL;
 
         nleft = stbuf->st_size;
 
@@ -172,6 +210,8 @@ gf_changelog_parse_binary (xlator_t *this,
                 goto out;
         }
 
+        (void) madvise (start, nleft, MADV_SEQUENTIAL);
+
         mover = start;
 
         MOVER_MOVE (mover, nleft, start_offset);
@@ -196,7 +236,7 @@ gf_changelog_parse_binary (xlator_t *this,
                         PARSE_GFID_MOVE (ptr, uuid, mover, nleft, parse_err);
 
                         bname_start = mover;
-                        bname_end = strchr (mover, '\n');
+                        bname_end = memchr (mover, '\n', nleft);
                         if (bname_end == NULL) {
                                 parse_err = 1;
                                 break;
@@ -214,6 +254,16 @@ gf_changelog_parse_binary (xlator_t *this,
                 if (parse_err)
                         break;
 
+                /* keep within the room left for a record */
+                if (blen > (LINE_BUFSIZE - UUID_CANONICAL_FORM_LEN - 3)) {
+                        parse_err = 1;
+                        break;
+                }
+
+                ascii = gf_changelog_outbuf_tail (ob);
+                if (!ascii)
+                        goto write_err;
+
                 GF_CHANGELOG_FILL_BUFFER (&current_mover, ascii, off, 1);
                 GF_CHANGELOG_FILL_BUFFER (" ", ascii, off, 1);
                 GF_CHANGELOG_FILL_BUFFER (ptr, ascii, off, strlen (ptr));
@@ -222,25 +272,31 @@ gf_changelog_parse_binary (xlator_t *this,
                                                   ascii, off, blen);
                 GF_CHANGELOG_FILL_BUFFER ("\n", ascii, off, 1);
 
-                if (gf_changelog_write (to_fd, ascii, off) != off) {
-                        gf_log (this->name, GF_LOG_ERROR,
-                                "processing binary changelog failed due to "
-                                " error in writing ascii change (reason: %s)",
-                                strerror (errno));
-                        break;
-                }
+                ob->len += off;
 
                 MOVER_MOVE (mover, nleft, 1);
         }
 
-        if ((nleft == 0) && (!parse_err))
+        if ((nleft == 0) && (!parse_err)) {
+                if (gf_changelog_outbuf_flush (ob))
+                        goto write_err;
                 ret = 0;
+        }
+
+ unmap:
 
         if (munmap (start, stbuf->st_size))
                 gf_log (this->name, GF_LOG_ERROR,
                         "munmap() error (reason: %s)", strerror (errno));
  out:
         return ret;
+
+ write_err:
+        gf_log (this->name, GF_LOG_ERROR,
+                "processing binary changelog failed due to "
+                " error in writing ascii change (reason: %s)",
+                strerror (errno));
+        goto unmap;
 }
 
 /**
@@ -251,7 +307,7 @@ gf_changelog_parse_binary (xlator_t *this,
 static int
 gf_changelog_parse_ascii (xlator_t *this,
                           gf_changelog_journal_t *jnl,
-                          int from_fd, int to_fd,
+                          gf_changelog_outbuf_t *ob, int from_fd,
                           size_t start_offset, struct stat *stbuf,
                           int version_idx)
 {
@@ -262,12 +318,11 @@ gf_changelog_parse_ascii (xlator_t *this,
         off_t         off           = 0;
         off_t         nleft         = 0;
         char         *ptr           = NULL;
-        char         *eptr          = NULL;
         void         *start         = NULL;
         char         *mover         = NULL;
         int           parse_err     = 0;
         char          current_mover = ' ';
-        char ascii[LINE_BUFSIZE]    = {0,};
+        char         *ascii         = NULL;
         const char   *fopname       = NULL;
 
         nleft = stbuf->st_size;
@@ -279,6 +334,8 @@ gf_changelog_parse_ascii (xlator_t *this,
                 goto out;
         }
 
+        (void) madvise (start, nleft, MADV_SEQUENTIAL);
+
         mover = start;
 
         MOVER_MOVE (mover, nleft, start_offset);
@@ -287,6 +344,10 @@ gf_changelog_parse_ascii (xlator_t *this,
                 off = 0;
                 current_mover = *mover;
 
+                ascii = gf_changelog_outbuf_tail (ob);
+                if (!ascii)
+                        goto write_err;
+
                 GF_CHANGELOG_FILL_BUFFER (&current_mover, ascii, off, 1);
                 GF_CHANGELOG_FILL_BUFFER (" ", ascii, off, 1);
 
@@ -380,17 +441,18 @@ gf_changelog_parse_ascii (xlator_t *this,
 
                                 PARSE_GFID (mover, ptr, len,
                                             conv_noop, parse_err);
-                                eptr = calloc (3, strlen (ptr));
-                                if (!eptr) {
+                                /* <pargfid>/<bname> */
+                                if (len > (UUID_CANONICAL_FORM_LEN
+                                           + 1 + NAME_MAX)) {
                                         parse_err = 1;
                                         break;
                                 }
 
-                                gf_rfc3986_encode ((unsigned char *) ptr,
-                                                   eptr, jnl->rfc3986);
-                                FILL_AND_MOVE (eptr, ascii, off,
-                                               mover, nleft, len);
-                                free (eptr);
+                                /* encoded straight into the record */
+                                off += gf_rfc3986_encode ((unsigned char *) ptr,
+                                                          ascii + off,
+                                                          jnl->rfc3986);
+                                MOVER_MOVE (mover, nleft, len);
                         }
 
                         break;
@@ -403,27 +465,32 @@ gf_changelog_parse_ascii (xlator_t *this,
 
                 GF_CHANGELOG_FILL_BUFFER ("\n", ascii, off, 1);
 
-                if (gf_changelog_write (to_fd, ascii, off) != off) {
-                        gf_log (this->name, GF_LOG_ERROR,
-                                "processing ascii changelog failed due to "
-                                " error in writing change (reason: %s)",
-                                strerror (errno));
-                        break;
-                }
+                ob->len += off;
 
                 MOVER_MOVE (mover, nleft, 1);
 
         }
 
-        if ((nleft == 0) && (!parse_err))
+        if ((nleft == 0) && (!parse_err)) {
+                if (gf_changelog_outbuf_flush (ob))
+                        goto write_err;
                 ret = 0;
+        }
 
+ unmap:
         if (munmap (start, stbuf->st_size))
                 gf_log (this->name, GF_LOG_ERROR,
                         "munmap() error (reason: %s)", strerror (errno));
 
  out:
         return ret;
+
+ write_err:
+        gf_log (this->name, GF_LOG_ERROR,
+                "processing ascii changelog failed due to "
+                " error in writing change (reason: %s)",
+                strerror (errno));
+        goto unmap;
 }
 
 #define COPY_BUFSIZE  8192
@@ -461,6 +528,7 @@ gf_changelog_decode (xlator_t *this, gf_changelog_journal_t *jnl,
         int version_idx   = -1;
         size_t elen       = 0;
         char buffer[1024] = {0,};
+        gf_changelog_outbuf_t ob = {0,};
 
         CHANGELOG_GET_HEADER_INFO (from_fd, buffer, 1024, encoding,
                                    major_version, minor_version, elen);
@@ -495,26 +563,30 @@ gf_changelog_decode (xlator_t *this, gf_changelog_journal_t *jnl,
          */
         lseek (from_fd, elen, SEEK_SET);
 
+        ob.fd = to_fd;
+        ob.buf = GF_MALLOC (OUT_BUFSIZE, gf_changelog_mt_changelog_buffer_t);
+        if (!ob.buf)
+                goto out;
+
         switch (encoding) {
         case CHANGELOG_ENCODE_BINARY:
                 /**
                  * this ideally should have been a part of changelog-encoders.c
                  * (ie. part of the changelog translator).
                  */
-                ret = gf_changelog_parse_binary (this, jnl, from_fd,
-                                                 to_fd, elen, stbuf,
-                                                 version_idx);
+                ret = gf_changelog_parse_binary (this, jnl, &ob, from_fd,
+                                                 elen, stbuf, version_idx);
                 break;
 
         case CHANGELOG_ENCODE_ASCII:
-                ret = gf_changelog_parse_ascii (this, jnl, from_fd,
-                                                to_fd, elen, stbuf,
-                                                version_idx);
+                ret = gf_changelog_parse_ascii (this, jnl, &ob, from_fd,
+                                                elen, stbuf, version_idx);
                 break;
         default:
                 ret = gf_changelog_copy (this, from_fd, to_fd);
         }
 
+        GF_FREE (ob.buf);
  out:
         return ret;
 }
@@ -91,6 +91,9 @@ typedef struct gf_changelog_consume_data {
         /* from @offset */
         off_t           offset;
 
+        /* length of a changelog path in the htime file */
+        int             len;
+
         xlator_t       *this;
 
         gf_changelog_journal_t *jnl;
@@ -100,10 +103,40 @@ typedef struct gf_changelog_consume_data {
         /* return value */
         int retval;
 
+        /* set once parsed, until published */
+        gf_boolean_t parsed;
+
         /* journal processed */
         char changelog[PATH_MAX];
 } gf_changelog_consume_data_t;
 
+/**
+ * changelogs are parsed by a pool of threads, each picking the next one
+ * in the htime file as soon as it's done with its last, and published
+ * in htime order as soon as they are parsed. parsing runs at most this
+ * many changelogs ahead of publishing.
+ */
+#define GF_HISTORY_WINDOW  64
+
+typedef struct gf_changelog_history_window {
+        pthread_mutex_t  lock;
+        pthread_cond_t   cond;
+
+        xlator_t        *this;
+        gf_changelog_journal_t *jnl;
+
+        int              fd;         /* htime file */
+        int              len;
+
+        unsigned long    next;       /* next to be parsed */
+        unsigned long    publish;    /* next to be published */
+        unsigned long    to;
+
+        gf_boolean_t     failed;
+
+        gf_changelog_consume_data_t ccd[GF_HISTORY_WINDOW];
+} gf_changelog_history_window_t;
+
 /* event handler */
 CALLBACK gf_changelog_handle_journal;
 
@@ -520,7 +520,15 @@ gf_changelog_consume_wrap (void* data)
 
         ccd->retval = -1;
 
-        nread = pread (ccd->fd, ccd->changelog, PATH_MAX, ccd->offset);
+        /* room for the terminating NUL */
+        if (ccd->len <= 0 || ccd->len >= (int) sizeof (ccd->changelog)) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "invalid changelog path length %d in history "
+                        "metadata file", ccd->len);
+                goto out;
+        }
+
+        nread = pread (ccd->fd, ccd->changelog, ccd->len, ccd->offset);
         if (nread < 0) {
                 gf_log (this->name, GF_LOG_ERROR,
                         "cannot read from history metadata file (reason %s)",
@@ -528,7 +536,14 @@ gf_changelog_consume_wrap (void* data)
                 goto out;
         }
 
-        /* TODO: handle short reads and EOF. */
+        if (nread < ccd->len) {
+                gf_log (this->name, GF_LOG_ERROR,
+                        "short read from history metadata file at offset %"
+                        PRId64, (int64_t) ccd->offset);
+                goto out;
+        }
+        ccd->changelog[nread] = '\0';
+
         if (gf_is_changelog_usable (ccd->changelog) == 1) {
 
                 ret = gf_changelog_consume (ccd->this,
@@ -545,33 +560,82 @@ gf_changelog_consume_wrap (void* data)
         return NULL;
 }
 
+#define MAX_PARALLELS  10
+
+/**
+ * parses changelogs from the htime file, one after the other, until
+ * all of them are taken or publishing has failed.
+ */
+static void *
+gf_history_consume_worker (void *data)
+{
+        unsigned long                  idx  = 0;
+        gf_changelog_history_window_t *win  = NULL;
+        gf_changelog_consume_data_t   *curr = NULL;
+
+        win = (gf_changelog_history_window_t *) data;
+        THIS = win->this;
+
+        pthread_mutex_lock (&win->lock);
+        {
+                while (1) {
+                        if (win->failed || (win->next > win->to))
+                                break;
+
+                        /* don't run too far ahead of publishing */
+                        if (win->next >= win->publish + GF_HISTORY_WINDOW) {
+                                pthread_cond_wait (&win->cond, &win->lock);
+                                continue;
+                        }
+
+                        idx = win->next++;
+                        curr = &win->ccd[idx % GF_HISTORY_WINDOW];
+
+                        pthread_mutex_unlock (&win->lock);
+                        {
+                                curr->this   = win->this;
+                                curr->jnl    = win->jnl;
+                                curr->fd     = win->fd;
+                                curr->len    = win->len;
+                                curr->offset = idx * (win->len + 1);
+
+                                (void) gf_changelog_consume_wrap (curr);
+                        }
+                        pthread_mutex_lock (&win->lock);
+
+                        curr->parsed = _gf_true;
+                        pthread_cond_broadcast (&win->cond);
+                }
+        }
+        pthread_mutex_unlock (&win->lock);
+
+        return NULL;
+}
+
 /**
  * "gf_history_consume" is a worker function for history.
  * parses and moves changelogs files from index "from"
  * to index "to" in open htime file whose fd is "fd".
+ *
+ * parsing is done by @n_parallel threads; changelogs are published
+ * here, in order, as soon as each one is parsed.
  */
-
-#define MAX_PARALLELS  10
-
 void *
 gf_history_consume (void * data)
 {
-        xlator_t                    *this              = NULL;
-        gf_changelog_journal_t              *jnl               = NULL;
-        gf_changelog_journal_t              *hist_jnl          = NULL;
-        int                          ret               = 0;
-        int                          iter              = 0;
-        int                          fd                = -1;
-        int                          from              = -1;
-        int                          to                = -1;
-        int                          len               = -1;
-        int                          n_parallel        = 0;
-        int                          n_envoked         = 0;
-        gf_boolean_t                 publish           = _gf_true;
-        pthread_t th_id[MAX_PARALLELS]                 = {0,};
-        gf_changelog_history_data_t *hist_data         = NULL;
-        gf_changelog_consume_data_t ccd[MAX_PARALLELS] = {{0},};
-        gf_changelog_consume_data_t *curr              = NULL;
+        xlator_t                      *this              = NULL;
+        gf_changelog_journal_t        *jnl               = NULL;
+        gf_changelog_journal_t        *hist_jnl          = NULL;
+        int                            ret               = 0;
+        int                            iter              = 0;
+        int                            fd                = -1;
+        int                            n_parallel        = 0;
+        int                            n_envoked         = 0;
+        gf_boolean_t                   publish           = _gf_true;
+        pthread_t th_id[MAX_PARALLELS]                   = {0,};
+        gf_changelog_history_data_t   *hist_data         = NULL;
+        gf_changelog_history_window_t *win               = NULL;
+        gf_changelog_consume_data_t   *curr              = NULL;
 
         hist_data = (gf_changelog_history_data_t *) data;
         if (hist_data == NULL) {
@@ -580,9 +644,6 @@ gf_history_consume (void * data)
         }
 
         fd         = hist_data->htime_fd;
-        from       = hist_data->from;
-        to         = hist_data->to;
-        len        = hist_data->len;
         n_parallel = hist_data->n_parallel;
 
         THIS = hist_data->this;
@@ -604,66 +665,97 @@ gf_history_consume (void * data)
                 goto out;
         }
 
-        while (from <= to) {
-                n_envoked = 0;
-
-                for (iter = 0 ; (iter < n_parallel) && (from <= to); iter++) {
-                        curr = &ccd[iter];
-
-                        curr->this   = this;
-                        curr->jnl    = hist_jnl;
-                        curr->fd     = fd;
-                        curr->offset = from * (len + 1);
+        win = GF_CALLOC (1, sizeof (*win), gf_changelog_mt_history_data_t);
+        if (!win) {
+                hist_jnl->hist_done = -1;
+                goto out;
+        }
 
-                        curr->retval = 0;
-                        memset (curr->changelog, '\0', PATH_MAX);
+        pthread_mutex_init (&win->lock, NULL);
+        pthread_cond_init (&win->cond, NULL);
 
-                        ret = pthread_create (&th_id[iter], NULL,
-                                              gf_changelog_consume_wrap, curr);
-                        if (ret) {
-                                gf_log ( this->name, GF_LOG_ERROR,
-                                        "could not create consume-thread"
-                                        " reason (%s)", strerror (ret));
-                                ret = -1;
-                                goto sync;
-                        } else
-                                n_envoked++;
+        win->this    = this;
+        win->jnl     = hist_jnl;
+        win->fd      = fd;
+        win->len     = hist_data->len;
+        win->next    = hist_data->from;
+        win->publish = hist_data->from;
+        win->to      = hist_data->to;
 
-                        from++;
+        for (iter = 0; iter < n_parallel; iter++) {
+                ret = pthread_create (&th_id[n_envoked], NULL,
+                                      gf_history_consume_worker, win);
+                if (ret) {
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "could not create consume-thread"
+                                " reason (%s)", strerror (ret));
+                        break;
                 }
+                n_envoked++;
+        }
 
-        sync:
-                for (iter = 0; iter < n_envoked; iter++) {
-                        ret = pthread_join (th_id[iter], NULL);
-                        if (ret) {
-                                publish = _gf_false;
-                                gf_log (this->name, GF_LOG_ERROR,
-                                        "pthread_join() error %s",
-                                        strerror (ret));
-                                /* try to join the rest */
-                                continue;
-                        }
-
-                        if (publish == _gf_false)
-                                continue;
+        if (!n_envoked)
+                publish = _gf_false;
 
-                        curr = &ccd[iter];
-                        if (ccd->retval) {
-                                publish = _gf_false;
-                                gf_log (this->name, GF_LOG_ERROR,
-                                        "parsing error, ceased publishing...");
+        pthread_mutex_lock (&win->lock);
+        {
+                while (publish && (win->publish <= win->to)) {
+                        curr = &win->ccd[win->publish % GF_HISTORY_WINDOW];
+                        if (!curr->parsed) {
+                                pthread_cond_wait (&win->cond, &win->lock);
                                 continue;
                         }
 
-                        ret = gf_changelog_publish (curr->this,
-                                                    curr->jnl, curr->changelog);
-                        if (ret) {
-                                publish = _gf_false;
-                                gf_log (this->name, GF_LOG_ERROR,
-                                        "publish error, ceased publishing...");
+                        pthread_mutex_unlock (&win->lock);
+                        {
+                                if (curr->retval) {
+                                        publish = _gf_false;
+                                        gf_log (this->name, GF_LOG_ERROR,
+                                                "parsing error, ceased "
+                                                "publishing...");
+                                } else {
+                                        ret = gf_changelog_publish
+                                                (this, hist_jnl,
+                                                 curr->changelog);
+                                        if (ret) {
+                                                publish = _gf_false;
+                                                gf_log (this->name,
+                                                        GF_LOG_ERROR,
+                                                        "publish error, ceased "
+                                                        "publishing...");
+                                        } else {
+                                                gf_log (this->name,
+                                                        GF_LOG_DEBUG,
+                                                        "published %s",
+                                                        curr->changelog);
+                                        }
+                                }
                         }
+                        pthread_mutex_lock (&win->lock);
+
+                        curr->parsed = _gf_false;
+                        win->publish++;
+                        pthread_cond_broadcast (&win->cond);
                 }
+
+                /* let the parsers go */
+                win->failed = !publish;
+                pthread_cond_broadcast (&win->cond);
         }
+        pthread_mutex_unlock (&win->lock);
+
+        for (iter = 0; iter < n_envoked; iter++) {
+                ret = pthread_join (th_id[iter], NULL);
+                if (ret) {
+                        publish = _gf_false;
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "pthread_join() error %s", strerror (ret));
+                }
+        }
+
+        pthread_cond_destroy (&win->cond);
+        pthread_mutex_destroy (&win->lock);
+        GF_FREE (win);
 
        /* informing "parsing done". */
         hist_jnl->hist_done = (publish == _gf_true) ? 0 : -1;
@@ -889,7 +889,8 @@ changelog_open_journal (xlator_t *this,
                          CHANGELOG_VERSION_MAJOR,
                          CHANGELOG_VERSION_MINOR,
                          priv->ce->encoder);
-        ret = changelog_write_change (priv, buffer, strlen (buffer));
+        /* the journal buffer was flushed with the previous changelog */
+        ret = changelog_write (priv->changelog_fd, buffer, strlen (buffer));
         if (ret) {
                 close (priv->changelog_fd);
                 priv->changelog_fd = -1;
@@ -947,10 +948,220 @@ changelog_snap_write_change (changelog_priv_t *priv, char *buffer, size_t len)
         return changelog_write (priv->c_snap_fd, buffer, len);
 }
 
+int
+changelog_journal_init (changelog_priv_t *priv, size_t size)
+{
+        changelog_journal_t *jnl = &priv->journal;
+        int                  i   = 0;
+
+        pthread_mutex_init (&jnl->lock, NULL);
+        pthread_cond_init (&jnl->cond, NULL);
+
+        jnl->seq = 1;
+        jnl->size = size;
+        if (!size)
+                return 0;
+
+        for (i = 0; i < 2; i++) {
+                jnl->buf[i] = GF_CALLOC (1, size, gf_changelog_mt_journal_t);
+                if (!jnl->buf[i])
+                        goto err;
+        }
+
+        return 0;
+ err:
+        changelog_journal_fini (priv);
+        return -1;
+}
+
+void
+changelog_journal_fini (changelog_priv_t *priv)
+{
+        changelog_journal_t *jnl = &priv->journal;
+
+        GF_FREE (jnl->buf[0]);
+        GF_FREE (jnl->buf[1]);
+        jnl->buf[0] = jnl->buf[1] = NULL;
+        jnl->size = 0;
+
+        pthread_cond_destroy (&jnl->cond);
+        pthread_mutex_destroy (&jnl->lock);
+}
+
+/**
+ * Write out the batch being filled, switching to the other buffer so that
+ * records can be added while the write is in progress. Called with the
+ * journal lock held and no write in progress; the lock is dropped for the
+ * duration of the write.
+ */
+static int
+__changelog_journal_write (changelog_priv_t *priv)
+{
+        changelog_journal_t *jnl   = &priv->journal;
+        char                *buf   = NULL;
+        size_t               len   = 0;
+        uint64_t             batch = 0;
+        int                  ret   = 0;
+
+        buf = jnl->buf[jnl->fill];
+        len = jnl->len;
+        batch = jnl->seq;
+
+        jnl->fill ^= 1;
+        jnl->len = 0;
+        jnl->seq++;
+        jnl->writing = _gf_true;
+
+        pthread_mutex_unlock (&jnl->lock);
+        {
+                if (len)
+                        ret = changelog_write (priv->changelog_fd, buf, len);
+        }
+        pthread_mutex_lock (&jnl->lock);
+
+        jnl->writing = _gf_false;
+        jnl->done = batch;
+        jnl->outcome[batch % CHANGELOG_JOURNAL_OUTCOMES] =
+                (batch << 1) | (ret ? 1 : 0);
+        pthread_cond_broadcast (&jnl->cond);
+
+        return ret;
+}
+
+static int
+__changelog_journal_flush (changelog_priv_t *priv)
+{
+        changelog_journal_t *jnl = &priv->journal;
+
+        while (jnl->writing)
+                pthread_cond_wait (&jnl->cond, &jnl->lock);
+
+        if (!jnl->len)
+                return 0;
+
+        return __changelog_journal_write (priv);
+}
+
+/**
+ * Write out everything recorded so far. Called under the dispatcher lock
+ * before the journal is fsync()'d or rolled over, so that no record ends
+ * up in the wrong changelog.
+ */
+int
+changelog_journal_flush (changelog_priv_t *priv)
+{
+        changelog_journal_t *jnl = &priv->journal;
+        int                  ret = 0;
+
+        if (!jnl->size)
+                return 0;
+
+        pthread_mutex_lock (&jnl->lock);
+        {
+                ret = __changelog_journal_flush (priv);
+        }
+        pthread_mutex_unlock (&jnl->lock);
+
+        return ret;
+}
+
 int
 changelog_write_change (changelog_priv_t *priv, char *buffer, size_t len)
 {
-        return changelog_write (priv->changelog_fd, buffer, len);
+        changelog_journal_t *jnl = &priv->journal;
+        int                  ret = 0;
+
+        if (!jnl->size)
+                return changelog_write (priv->changelog_fd, buffer, len);
+
+        pthread_mutex_lock (&jnl->lock);
+        {
+                /* the waiters of the batch written out learn how it
+                   went, this record goes to the next one regardless */
+                if (jnl->len + len > jnl->size)
+                        (void) __changelog_journal_flush (priv);
+
+                /* too large to batch: nothing else is pending now */
+                if (len > jnl->size) {
+                        ret = changelog_write (priv->changelog_fd,
+                                               buffer, len);
+                        goto unlock;
+                }
+
+                memcpy (jnl->buf[jnl->fill] + jnl->len, buffer, len);
+                jnl->len += len;
+        }
+ unlock:
+        pthread_mutex_unlock (&jnl->lock);
+
+        return ret;
+}
+
+/**
+ * The batch holding everything recorded so far. Called under the
+ * dispatcher lock, right after recording.
+ */
+uint64_t
+changelog_journal_mark (changelog_priv_t *priv)
+{
+        changelog_journal_t *jnl   = &priv->journal;
+        uint64_t             batch = 0;
+
+        if (!jnl->size)
+                return 0;
+
+        pthread_mutex_lock (&jnl->lock);
+        {
+                batch = jnl->len ? jnl->seq : jnl->seq - 1;
+        }
+        pthread_mutex_unlock (&jnl->lock);
+
+        return batch;
+}
+
+/**
+ * Wait until @batch is written, writing it (and whatever joined it) if no
+ * one else is, and return how the write of @batch went. A waiter that
+ * falls more than CHANGELOG_JOURNAL_OUTCOMES batches behind no longer
+ * knows and is told it failed, which at worst records a change twice.
+ */
+int
+changelog_journal_commit (changelog_priv_t *priv, uint64_t batch)
+{
+        changelog_journal_t *jnl     = &priv->journal;
+        gf_boolean_t         waited  = _gf_false;
+        uint64_t             outcome = 0;
+        int                  ret     = 0;
+
+        if (!batch)
+                return 0;
+
+        pthread_mutex_lock (&jnl->lock);
+        {
+                while (jnl->done < batch) {
+                        if (jnl->writing) {
+                                pthread_cond_wait (&jnl->cond, &jnl->lock);
+                                continue;
+                        }
+
+                        if (jnl->delay && !waited) {
+                                waited = _gf_true;
+                                pthread_mutex_unlock (&jnl->lock);
+                                usleep (jnl->delay);
+                                pthread_mutex_lock (&jnl->lock);
+                                continue;
+                        }
+
+                        (void) __changelog_journal_write (priv);
+                }
+
+                outcome = jnl->outcome[batch % CHANGELOG_JOURNAL_OUTCOMES];
+                if ((outcome >> 1) != batch || (outcome & 1))
+                        ret = -1;
+        }
+        pthread_mutex_unlock (&jnl->lock);
+
+        return ret;
 }
 
 /*
@@ -1015,6 +1226,10 @@ changelog_handle_change (xlator_t *this,
         int ret = 0;
 
         if (CHANGELOG_TYPE_IS_ROLLOVER (cld->cld_type)) {
+                if (priv->changelog_fd != -1 &&
+                    changelog_journal_flush (priv))
+                        gf_log (this->name, GF_LOG_ERROR,
+                                "error writing changelog to disk");
                 changelog_encode_change (priv);
                 ret = changelog_start_next_change (this, priv,
                                                    cld->cld_roll_time,
@@ -1033,6 +1248,7 @@ changelog_handle_change (xlator_t *this,
                 return 0;
 
         if (CHANGELOG_TYPE_IS_FSYNC (cld->cld_type)) {
+                (void) changelog_journal_flush (priv);
                 ret = fsync (priv->changelog_fd);
                 if (ret < 0) {
                         gf_log (this->name, GF_LOG_ERROR,
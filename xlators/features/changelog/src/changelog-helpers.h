@@ -188,6 +188,34 @@ typedef struct changelog_ev_selector {
 } changelog_ev_selector_t;
 
 
+/* outcomes of the last batches written, see changelog_journal_commit() */
+#define CHANGELOG_JOURNAL_OUTCOMES 64
+
+/**
+ * Journal records are copied here under the dispatcher lock and written
+ * out by whichever thread waiting on them gets there first, together with
+ * everything recorded meanwhile (group commit). A record is on disk before
+ * its fop unwinds, as with a write per record.
+ */
+typedef struct changelog_journal {
+        pthread_mutex_t lock;
+        pthread_cond_t  cond;
+
+        char           *buf[2];
+        size_t          size;      /* of each buffer, 0: write through */
+        int             fill;      /* buffer taking records */
+        size_t          len;       /* bytes in ->buf[->fill] */
+
+        uint64_t        seq;       /* batch in ->buf[->fill] */
+        uint64_t        done;      /* last batch written */
+        /* (batch << 1 | failed) of batch, at batch % OUTCOMES */
+        uint64_t        outcome[CHANGELOG_JOURNAL_OUTCOMES];
+        gf_boolean_t    writing;
+
+        /* usecs a writer waits for more records to join the batch */
+        int32_t         delay;
+} changelog_journal_t;
+
 /* changelog's private structure */
 struct changelog_priv {
         gf_boolean_t active;
@@ -227,6 +255,9 @@ struct changelog_priv {
         /* fsync() interval */
         int32_t fsync_interval;
 
+        /* group commit of journal records */
+        changelog_journal_t journal;
+
         /* changelog type maps */
         const char *maps[CHANGELOG_MAX_TYPE];
 
@@ -422,6 +453,16 @@ changelog_write (int fd, char *buffer, size_t len);
 int
 changelog_write_change (changelog_priv_t *priv, char *buffer, size_t len);
 int
+changelog_journal_init (changelog_priv_t *priv, size_t size);
+void
+changelog_journal_fini (changelog_priv_t *priv);
+uint64_t
+changelog_journal_mark (changelog_priv_t *priv);
+int
+changelog_journal_commit (changelog_priv_t *priv, uint64_t batch);
+int
+changelog_journal_flush (changelog_priv_t *priv);
+int
 changelog_handle_change (xlator_t *this,
                          changelog_priv_t *priv, changelog_log_data_t *cld);
 void
@@ -29,6 +29,7 @@ enum gf_changelog_mem_types {
         gf_changelog_mt_libgfchangelog_call_pool_t = gf_common_mt_end + 13,
         gf_changelog_mt_libgfchangelog_event_t     = gf_common_mt_end + 14,
         gf_changelog_mt_ev_dispatcher_t            = gf_common_mt_end + 15,
+        gf_changelog_mt_journal_t                  = gf_common_mt_end + 16,
         gf_changelog_mt_end
 };
 
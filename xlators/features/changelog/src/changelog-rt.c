@@ -50,8 +50,9 @@ int
 changelog_rt_enqueue (xlator_t *this, changelog_priv_t *priv, void *cbatch,
                       changelog_log_data_t *cld_0, changelog_log_data_t *cld_1)
 {
-        int             ret = 0;
-        changelog_rt_t *crt = NULL;
+        int             ret   = 0;
+        uint64_t        batch = 0;
+        changelog_rt_t *crt   = NULL;
 
         crt = (changelog_rt_t *) cbatch;
 
@@ -60,8 +61,14 @@ changelog_rt_enqueue (xlator_t *this, changelog_priv_t *priv, void *cbatch,
                 ret = changelog_handle_change (this, priv, cld_0);
                 if (!ret && cld_1)
                         ret = changelog_handle_change (this, priv, cld_1);
+                if (!ret)
+                        batch = changelog_journal_mark (priv);
         }
         UNLOCK (&crt->lock);
 
+        /* the records are written out together with others' */
+        if (!ret)
+                ret = changelog_journal_commit (priv, batch);
+
         return ret;
 }
@@ -2392,6 +2392,8 @@ reconfigure (xlator_t *this, dict_t *options)
                           priv->rollover_time, options, int32, out);
         GF_OPTION_RECONF ("fsync-interval",
                           priv->fsync_interval, options, int32, out);
+        GF_OPTION_RECONF ("journal-commit-delay",
+                          priv->journal.delay, options, int32, out);
         GF_OPTION_RECONF ("changelog-barrier-timeout",
                           timeout, options, time, out);
         changelog_assign_barrier_timeout (priv, timeout);
@@ -2455,6 +2457,7 @@ changelog_freeup_options (xlator_t *this, changelog_priv_t *priv)
         if (ret)
                 gf_log (this->name, GF_LOG_ERROR,
                         "could not cleanup bootstrapper");
+        changelog_journal_fini (priv);
         GF_FREE (priv->changelog_brick);
         GF_FREE (priv->changelog_dir);
 }
@@ -2465,6 +2468,7 @@ changelog_init_options (xlator_t *this, changelog_priv_t *priv)
         int       ret            = 0;
         char     *tmp            = NULL;
         uint32_t  timeout        = 0;
+        size_t    journal_size   = 0;
         char htime_dir[PATH_MAX] = {0,};
         char csnap_dir[PATH_MAX] = {0,};
 
@@ -2520,8 +2524,15 @@ changelog_init_options (xlator_t *this, changelog_priv_t *priv)
         GF_OPTION_INIT ("fsync-interval",
                         priv->fsync_interval, int32, dealloc_2);
 
+        GF_OPTION_INIT ("journal-buffer-size", journal_size, size, dealloc_2);
+        ret = changelog_journal_init (priv, journal_size);
+        if (ret)
+                goto dealloc_2;
+        GF_OPTION_INIT ("journal-commit-delay",
+                        priv->journal.delay, int32, dealloc_3);
+
         GF_OPTION_INIT ("changelog-barrier-timeout",
-                        timeout, time, dealloc_2);
+                        timeout, time, dealloc_3);
         changelog_assign_barrier_timeout (priv, timeout);
 
         GF_ASSERT (cb_bootstrap[priv->op_mode].mode == priv->op_mode);
@@ -2530,12 +2541,14 @@ changelog_init_options (xlator_t *this, changelog_priv_t *priv)
         /* ... now bootstrap the logger */
         ret = priv->cb->ctor (this, &priv->cd);
         if (ret)
-                goto dealloc_2;
+                goto dealloc_3;
 
         priv->changelog_fd = -1;
 
         return 0;
 
+ dealloc_3:
+        changelog_journal_fini (priv);
  dealloc_2:
         GF_FREE (priv->changelog_dir);
  dealloc_1:
@@ -2773,6 +2786,24 @@ struct volume_options options[] = {
          .description = "do not open CHANGELOG file with O_SYNC mode."
                         " instead perform fsync() at specified intervals"
         },
+        {.key = {"journal-buffer-size"},
+         .type = GF_OPTION_TYPE_SIZET,
+         .min = 0,
+         .max = 4 * GF_UNIT_MB,
+         .default_value = "64KB",
+         .description = "buffer in which records of concurrent fops are "
+                        "gathered to be written to the changelog with a "
+                        "single write (0 writes each record on its own)."
+                        " takes effect on restart of the brick"
+        },
+        {.key = {"journal-commit-delay"},
+         .type = GF_OPTION_TYPE_INT,
+         .min = 0,
+         .max = 10000,
+         .default_value = "0",
+         .description = "microseconds to wait for more records before "
+                        "writing a batch to the changelog"
+        },
         { .key = {"changelog-barrier-timeout"},
           .type = GF_OPTION_TYPE_TIME,
           .default_value = BARRIER_TIMEOUT,
@@ -171,7 +171,7 @@ clrlk_clear_posixlk (xlator_t *this, pl_inode_t *pl_inode, clrlk_args *args,
                             || plock->user_flock.l_len != ulock.l_len))
                                 continue;
 
-                        list_del_init (&plock->list);
+                        __delete_lock (pl_inode, plock);
                         if (plock->blocked) {
                                 bcount++;
                                 pl_trace_out (this, plock->frame, NULL, NULL,
@@ -235,6 +235,7 @@ blkd:
 
                         bcount++;
                         list_del_init (&ilock->blocked_locks);
+                        pl_itree_remove (&ilock->itree);
                         list_add (&ilock->blocked_locks, &released);
                 }
         }
@@ -268,7 +269,7 @@ granted:
                                 continue;
 
                         gcount++;
-                        list_del_init (&ilock->list);
+                        __delete_inode_lock (ilock);
                         list_add (&ilock->list, &released);
                 }
         }
@@ -282,7 +283,7 @@ granted:
 
         ret = 0;
 out:
-        grant_blocked_inode_locks (this, pl_inode, dom);
+        grant_blocked_inode_locks (this, pl_inode, dom, 0, LLONG_MAX);
         *blkd    = bcount;
         *granted = gcount;
         return ret;
@@ -53,6 +53,9 @@ __allocate_domain (const char *volume)
         INIT_LIST_HEAD (&dom->blocked_entrylks);
         INIT_LIST_HEAD (&dom->inodelk_list);
         INIT_LIST_HEAD (&dom->blocked_inodelks);
+        pl_itree_init (&dom->inodelk_tree);
+        pl_itree_init (&dom->blocked_inodelk_tree);
+        dom->blocked_seq = 0;
 
 out:
         if (dom && (NULL == dom->domain)) {
@@ -428,6 +431,7 @@ pl_inode_get (xlator_t *this, inode_t *inode)
 
                 INIT_LIST_HEAD (&pl_inode->dom_list);
                 INIT_LIST_HEAD (&pl_inode->ext_list);
+                pl_itree_init (&pl_inode->ext_tree);
                 INIT_LIST_HEAD (&pl_inode->rw_list);
                 INIT_LIST_HEAD (&pl_inode->reservelk_list);
                 INIT_LIST_HEAD (&pl_inode->blocked_reservelks);
@@ -486,6 +490,7 @@ void
 __delete_lock (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
         list_del_init (&lock->list);
+        pl_itree_remove (&lock->itree);
 }
 
 
@@ -523,6 +528,11 @@ __insert_lock (pl_inode_t *pl_inode, posix_lock_t *lock)
 
         list_add_tail (&lock->list, &pl_inode->ext_list);
 
+        /* only granted locks take part in conflict checks */
+        if (!lock->blocked)
+                pl_itree_insert (&pl_inode->ext_tree, &lock->itree,
+                                 lock->fl_start, lock->fl_end);
+
         return;
 }
 
@@ -697,55 +707,53 @@ done:
         return v;
 }
 
+/* Return true if the granted lock in @node conflicts with @data */
+static int
+__lock_conflicts (pl_itree_node_t *node, void *data)
+{
+        posix_lock_t *l    = NULL;
+        posix_lock_t *lock = data;
+
+        l = pl_itree_entry (node, posix_lock_t, itree);
+
+        if (same_owner (l, lock))
+                return 0;
+
+        return ((l->fl_type == F_WRLCK) || (lock->fl_type == F_WRLCK));
+}
+
 static posix_lock_t *
 first_conflicting_overlap (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
-        posix_lock_t *l = NULL;
-        posix_lock_t *conf = NULL;
+        pl_itree_node_t *node = NULL;
+        posix_lock_t    *conf = NULL;
 
         pthread_mutex_lock (&pl_inode->mutex);
         {
-                list_for_each_entry (l, &pl_inode->ext_list, list) {
-                        if (l->blocked)
-                                continue;
-
-                        if (locks_overlap (l, lock)) {
-                                if (same_owner (l, lock))
-                                        continue;
-
-                                if ((l->fl_type == F_WRLCK) ||
-                                    (lock->fl_type == F_WRLCK)) {
-                                        conf = l;
-                                        goto unlock;
-                                }
-                        }
-                }
+                node = pl_itree_search (&pl_inode->ext_tree, lock->fl_start,
+                                        lock->fl_end, __lock_conflicts, lock);
+                if (node)
+                        conf = pl_itree_entry (node, posix_lock_t, itree);
         }
-unlock:
         pthread_mutex_unlock (&pl_inode->mutex);
 
         return conf;
 }
 
 /*
-  Start searching from {begin}, and return the first lock that
-  conflicts, NULL if no conflict
-  If {begin} is NULL, then start from the beginning of the list
+  Return the lowest granted lock overlapping {lock}, NULL if none
 */
 static posix_lock_t *
 first_overlap (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
-        posix_lock_t *l = NULL;
+        pl_itree_node_t *node = NULL;
 
-        list_for_each_entry (l, &pl_inode->ext_list, list) {
-                if (l->blocked)
-                        continue;
-
-                if (locks_overlap (l, lock))
-                        return l;
-        }
+        node = pl_itree_search (&pl_inode->ext_tree, lock->fl_start,
+                                lock->fl_end, NULL, NULL);
+        if (!node)
+                return NULL;
 
-        return NULL;
+        return pl_itree_entry (node, posix_lock_t, itree);
 }
 
 
@@ -754,21 +762,12 @@ first_overlap (pl_inode_t *pl_inode, posix_lock_t *lock)
 static int
 __is_lock_grantable (pl_inode_t *pl_inode, posix_lock_t *lock)
 {
-        posix_lock_t *l = NULL;
-        int           ret = 1;
-
-        list_for_each_entry (l, &pl_inode->ext_list, list) {
-                if (!l->blocked && locks_overlap (lock, l)) {
-                        if (((l->fl_type == F_WRLCK)
-                             || (lock->fl_type == F_WRLCK))
-                            && (lock->fl_type != F_UNLCK)
-                            && !same_owner (l, lock)) {
-                                ret = 0;
-                                break;
-                        }
-                }
-        }
-        return ret;
+        if (lock->fl_type == F_UNLCK)
+                return 1;
+
+        return (pl_itree_search (&pl_inode->ext_tree, lock->fl_start,
+                                 lock->fl_end, __lock_conflicts,
+                                 lock) == NULL);
 }
 
 
@@ -68,7 +68,7 @@ get_domain (pl_inode_t *pl_inode, const char *volume);
 
 void
 grant_blocked_inode_locks (xlator_t *this, pl_inode_t *pl_inode,
-                           pl_dom_list_t *dom);
+                           pl_dom_list_t *dom, off_t start, off_t end);
 
 void
 __delete_inode_lock (pl_inode_lock_t *lock);
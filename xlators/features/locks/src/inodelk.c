@@ -22,6 +22,7 @@ inline void
 __delete_inode_lock (pl_inode_lock_t *lock)
 {
         list_del_init (&lock->list);
+        pl_itree_remove (&lock->itree);
 }
 
 static inline void
@@ -122,55 +123,72 @@ same_inodelk_owner (pl_inode_lock_t *l1, pl_inode_lock_t *l2)
                 (l1->client == l2->client));
 }
 
-/* Returns true if the 2 inodelks conflict with each other */
+/* A granted inodelk conflicts unless it is shared or held by the same owner */
 static int
-inodelk_conflict (pl_inode_lock_t *l1, pl_inode_lock_t *l2)
+__inodelk_granted_conflict (pl_itree_node_t *node, void *data)
 {
-        return (inodelk_overlap (l1, l2) &&
-                inodelk_type_conflict (l1, l2));
+        pl_inode_lock_t *l    = NULL;
+        pl_inode_lock_t *lock = data;
+
+        l = pl_itree_entry (node, pl_inode_lock_t, itree);
+
+        return (inodelk_type_conflict (lock, l) &&
+                !same_inodelk_owner (lock, l));
 }
 
 /* Determine if lock is grantable or not */
 static pl_inode_lock_t *
 __inodelk_grantable (pl_dom_list_t *dom, pl_inode_lock_t *lock)
 {
-        pl_inode_lock_t *l = NULL;
-        pl_inode_lock_t *ret = NULL;
-        if (list_empty (&dom->inodelk_list))
-                goto out;
-        list_for_each_entry (l, &dom->inodelk_list, list){
-                if (inodelk_conflict (lock, l) &&
-                    !same_inodelk_owner (lock, l)) {
-                        ret = l;
-                        goto out;
-                }
-        }
-out:
-        return ret;
+        pl_itree_node_t *node = NULL;
+
+        node = pl_itree_search (&dom->inodelk_tree, lock->fl_start,
+                                lock->fl_end, __inodelk_granted_conflict,
+                                lock);
+        if (!node)
+                return NULL;
+
+        return pl_itree_entry (node, pl_inode_lock_t, itree);
 }
 
+struct __blocked_match {
+        pl_inode_lock_t *lock;
+        uint64_t         before;   /* only locks queued before this */
+};
+
+static int
+__inodelk_blocked_conflict (pl_itree_node_t *node, void *data)
+{
+        pl_inode_lock_t        *l     = NULL;
+        struct __blocked_match *match = data;
+
+        l = pl_itree_entry (node, pl_inode_lock_t, itree);
+
+        return ((l->blkd_seq < match->before) &&
+                inodelk_type_conflict (match->lock, l));
+}
+
+/* Conflicting blocked locks queued before @before (all of them for a new
+ * lock, whose @before is UINT64_MAX) */
 static pl_inode_lock_t *
-__blocked_lock_conflict (pl_dom_list_t *dom, pl_inode_lock_t *lock)
+__blocked_lock_conflict (pl_dom_list_t *dom, pl_inode_lock_t *lock,
+                         uint64_t before)
 {
-        pl_inode_lock_t *l   = NULL;
-        pl_inode_lock_t *ret = NULL;
+        pl_itree_node_t        *node  = NULL;
+        struct __blocked_match  match = {lock, before};
 
-        if (list_empty (&dom->blocked_inodelks))
+        node = pl_itree_search (&dom->blocked_inodelk_tree, lock->fl_start,
+                                lock->fl_end, __inodelk_blocked_conflict,
+                                &match);
+        if (!node)
                 return NULL;
 
-        list_for_each_entry (l, &dom->blocked_inodelks, blocked_locks) {
-                if (inodelk_conflict (lock, l)) {
-                        ret = l;
-                        goto out;
-                }
-        }
-
-out:
-        return ret;
+        return pl_itree_entry (node, pl_inode_lock_t, itree);
 }
 
 static int
-__owner_has_lock (pl_dom_list_t *dom, pl_inode_lock_t *newlock)
+__owner_has_lock (pl_dom_list_t *dom, pl_inode_lock_t *newlock,
+                  uint64_t before)
 {
         pl_inode_lock_t *lock = NULL;
 
@@ -180,13 +198,43 @@ __owner_has_lock (pl_dom_list_t *dom, pl_inode_lock_t *newlock)
         }
 
         list_for_each_entry (lock, &dom->blocked_inodelks, blocked_locks) {
-                if (same_inodelk_owner (lock, newlock))
+                if ((lock != newlock) && (lock->blkd_seq < before) &&
+                    same_inodelk_owner (lock, newlock))
                         return 1;
         }
 
         return 0;
 }
 
+/* Queue @lock on the domain's blocked list, in arrival order */
+static void
+__inodelk_block (pl_dom_list_t *dom, pl_inode_lock_t *lock)
+{
+        gettimeofday (&lock->blkd_time, NULL);
+        lock->blkd_seq = dom->blocked_seq++;
+
+        list_add_tail (&lock->blocked_locks, &dom->blocked_inodelks);
+        pl_itree_insert (&dom->blocked_inodelk_tree, &lock->itree,
+                         lock->fl_start, lock->fl_end);
+}
+
+static void
+__inodelk_unblock (pl_inode_lock_t *lock)
+{
+        list_del_init (&lock->blocked_locks);
+        pl_itree_remove (&lock->itree);
+}
+
+static void
+__inodelk_grant (pl_dom_list_t *dom, pl_inode_lock_t *lock)
+{
+        __pl_inodelk_ref (lock);
+        gettimeofday (&lock->granted_time, NULL);
+
+        list_add (&lock->list, &dom->inodelk_list);
+        pl_itree_insert (&dom->inodelk_tree, &lock->itree,
+                         lock->fl_start, lock->fl_end);
+}
 
 /* Determines if lock can be granted and adds the lock. If the lock
  * is blocking, adds it to the blocked_inodelks list of the domain.
@@ -204,8 +252,7 @@ __lock_inodelk (xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
                 if (can_block == 0)
                         goto out;
 
-                gettimeofday (&lock->blkd_time, NULL);
-                list_add_tail (&lock->blocked_locks, &dom->blocked_inodelks);
+                __inodelk_block (dom, lock);
 
                 gf_log (this->name, GF_LOG_TRACE,
                         "%s (pid=%d) lk-owner:%s %"PRId64" - %"PRId64" => Blocked",
@@ -231,13 +278,13 @@ __lock_inodelk (xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
          * will not be unlocked by SHD from Machine1.
          * TODO: Find why 'owner_has_lock' is checked even for blocked locks.
          */
-        if (__blocked_lock_conflict (dom, lock) && !(__owner_has_lock (dom, lock))) {
+        if (__blocked_lock_conflict (dom, lock, UINT64_MAX) &&
+            !(__owner_has_lock (dom, lock, UINT64_MAX))) {
                 ret = -EAGAIN;
                 if (can_block == 0)
                         goto out;
 
-                gettimeofday (&lock->blkd_time, NULL);
-                list_add_tail (&lock->blocked_locks, &dom->blocked_inodelks);
+                __inodelk_block (dom, lock);
 
                 gf_log (this->name, GF_LOG_DEBUG,
                         "Lock is grantable, but blocking to prevent starvation");
@@ -252,9 +299,8 @@ __lock_inodelk (xlator_t *this, pl_inode_t *pl_inode, pl_inode_lock_t *lock,
 
                 goto out;
         }
-        __pl_inodelk_ref (lock);
-        gettimeofday (&lock->granted_time, NULL);
-        list_add (&lock->list, &dom->inodelk_list);
+
+        __inodelk_grant (dom, lock);
 
         ret = 0;
 
@@ -316,36 +362,99 @@ out:
 }
 
 
+/* Grant a blocked lock if neither a granted lock nor a lock queued ahead
+ * of it stands in the way. It keeps its place in the queue otherwise. */
 static void
-__grant_blocked_inode_locks (xlator_t *this, pl_inode_t *pl_inode,
-                             struct list_head *granted, pl_dom_list_t *dom)
+__grant_blocked_inode_lock (pl_dom_list_t *dom, pl_inode_lock_t *bl,
+                            struct list_head *granted)
 {
-        int              bl_ret = 0;
-        pl_inode_lock_t *bl = NULL;
-        pl_inode_lock_t *tmp = NULL;
+        if (__inodelk_grantable (dom, bl))
+                return;
+
+        if (__blocked_lock_conflict (dom, bl, bl->blkd_seq) &&
+            !__owner_has_lock (dom, bl, bl->blkd_seq))
+                return;
+
+        __inodelk_unblock (bl);
+        __inodelk_grant (dom, bl);
+
+        list_add (&bl->blocked_locks, granted);
+}
 
-        struct list_head blocked_list;
+static int
+__collect_blocked_inodelk (pl_itree_node_t *node, void *data)
+{
+        pl_inode_lock_t ***tail = data;
 
-        INIT_LIST_HEAD (&blocked_list);
-        list_splice_init (&dom->blocked_inodelks, &blocked_list);
+        **tail = pl_itree_entry (node, pl_inode_lock_t, itree);
+        (*tail)++;
 
-        list_for_each_entry_safe (bl, tmp, &blocked_list, blocked_locks) {
+        return 0;
+}
 
-                list_del_init (&bl->blocked_locks);
+static int
+__blocked_inodelk_cmp (const void *a, const void *b)
+{
+        const pl_inode_lock_t *l1 = *(pl_inode_lock_t * const *) a;
+        const pl_inode_lock_t *l2 = *(pl_inode_lock_t * const *) b;
 
-                bl_ret = __lock_inodelk (this, pl_inode, bl, 1, dom);
+        if (l1->blkd_seq == l2->blkd_seq)
+                return 0;
 
-                if (bl_ret == 0) {
-                        list_add (&bl->blocked_locks, granted);
+        return (l1->blkd_seq < l2->blkd_seq) ? -1 : 1;
+}
+
+/* Only blocked locks overlapping the released range [@start, @end] can
+ * have become grantable: those are looked up in the blocked lock tree and
+ * retried in the order they were queued. */
+static void
+__grant_blocked_inode_locks (xlator_t *this, pl_inode_t *pl_inode,
+                             struct list_head *granted, pl_dom_list_t *dom,
+                             off_t start, off_t end)
+{
+        uint32_t          count  = 0;
+        uint32_t          i      = 0;
+        pl_inode_lock_t  *bl     = NULL;
+        pl_inode_lock_t  *tmp    = NULL;
+        pl_inode_lock_t **waiters = NULL;
+        pl_inode_lock_t **tail   = NULL;
+        pl_inode_lock_t   region = {{0,},};
+
+        if (pl_itree_empty (&dom->blocked_inodelk_tree))
+                return;
+
+        region.fl_start = start;
+        region.fl_end = end;
+
+        waiters = GF_CALLOC (dom->blocked_inodelk_tree.count,
+                             sizeof (*waiters), gf_common_mt_pointer);
+        if (!waiters) {
+                /* walk the whole queue instead */
+                list_for_each_entry_safe (bl, tmp, &dom->blocked_inodelks,
+                                          blocked_locks) {
+                        if (inodelk_overlap (bl, &region))
+                                __grant_blocked_inode_lock (dom, bl, granted);
                 }
+                return;
         }
-        return;
+
+        tail = waiters;
+        (void) pl_itree_search (&dom->blocked_inodelk_tree, start, end,
+                                __collect_blocked_inodelk, &tail);
+        count = tail - waiters;
+
+        qsort (waiters, count, sizeof (*waiters), __blocked_inodelk_cmp);
+
+        for (i = 0; i < count; i++)
+                __grant_blocked_inode_lock (dom, waiters[i], granted);
+
+        GF_FREE (waiters);
 }
 
-/* Grant all inodelks blocked on a lock */
+/* Grant inodelks blocked on the range [@start, @end] */
 void
 grant_blocked_inode_locks (xlator_t *this, pl_inode_t *pl_inode,
-                           pl_dom_list_t *dom)
+                           pl_dom_list_t *dom, off_t start, off_t end)
 {
         struct list_head granted;
         pl_inode_lock_t *lock;
@@ -355,7 +464,8 @@ grant_blocked_inode_locks (xlator_t *this, pl_inode_t *pl_inode,
 
         pthread_mutex_lock (&pl_inode->mutex);
         {
-                __grant_blocked_inode_locks (this, pl_inode, &granted, dom);
+                __grant_blocked_inode_locks (this, pl_inode, &granted, dom,
+                                             start, end);
         }
         pthread_mutex_unlock (&pl_inode->mutex);
 
@@ -463,7 +573,7 @@ pl_inodelk_client_cleanup (xlator_t *this, pl_ctx_t *ctx)
                                         list_add_tail (&l->client_list,
                                                        &released);
                                 } else {
-                                        list_del_init(&l->blocked_locks);
+                                        __inodelk_unblock (l);
                                         list_add_tail (&l->client_list,
                                                        &unwind);
                                 }
@@ -490,7 +600,8 @@ pl_inodelk_client_cleanup (xlator_t *this, pl_ctx_t *ctx)
 
 		dom = get_domain (pl_inode, l->volume);
 
-		grant_blocked_inode_locks (this, pl_inode, dom);
+		grant_blocked_inode_locks (this, pl_inode, dom, l->fl_start,
+                                           l->fl_end);
 
 		pthread_mutex_lock (&pl_inode->mutex);
 		{
@@ -514,9 +625,13 @@ pl_inode_setlk (xlator_t *this, pl_ctx_t *ctx, pl_inode_t *pl_inode,
         gf_boolean_t      unref            =  _gf_true;
         gf_boolean_t      need_inode_unref =  _gf_false;
         short             fl_type;
+        off_t             fl_start;
+        off_t             fl_end;
 
 	lock->pl_inode = pl_inode;
         fl_type = lock->fl_type;
+        fl_start = lock->fl_start;
+        fl_end = lock->fl_end;
 
         /* Ideally, AFTER a successful lock (both blocking and non-blocking) or
          * an unsuccessful blocking lock operation, the inode needs to be ref'd.
@@ -608,7 +723,8 @@ out:
          */
         if ((fl_type == F_UNLCK) && (ret == 0)) {
                 inode_unref (pl_inode->inode);
-                grant_blocked_inode_locks (this, pl_inode, dom);
+                grant_blocked_inode_locks (this, pl_inode, dom, fl_start,
+                                           fl_end);
         }
 
         return ret;
@@ -0,0 +1,232 @@
+/*
+   Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#include <stddef.h>
+
+#include "interval-tree.h"
+
+static inline int
+__itree_height (pl_itree_node_t *node)
+{
+        return node ? node->height : 0;
+}
+
+static inline void
+__itree_update (pl_itree_node_t *node)
+{
+        int lh = __itree_height (node->left);
+        int rh = __itree_height (node->right);
+
+        node->height = 1 + ((lh > rh) ? lh : rh);
+
+        node->max = node->end;
+        if (node->left && (node->left->max > node->max))
+                node->max = node->left->max;
+        if (node->right && (node->right->max > node->max))
+                node->max = node->right->max;
+}
+
+/* nodes with equal start are ordered by address to keep keys unique */
+static inline int
+__itree_cmp (pl_itree_node_t *a, pl_itree_node_t *b)
+{
+        if (a->start != b->start)
+                return (a->start < b->start) ? -1 : 1;
+        if (a != b)
+                return ((uintptr_t) a < (uintptr_t) b) ? -1 : 1;
+        return 0;
+}
+
+static pl_itree_node_t *
+__itree_rotate_right (pl_itree_node_t *node)
+{
+        pl_itree_node_t *pivot = node->left;
+
+        node->left = pivot->right;
+        pivot->right = node;
+
+        __itree_update (node);
+        __itree_update (pivot);
+
+        return pivot;
+}
+
+static pl_itree_node_t *
+__itree_rotate_left (pl_itree_node_t *node)
+{
+        pl_itree_node_t *pivot = node->right;
+
+        node->right = pivot->left;
+        pivot->left = node;
+
+        __itree_update (node);
+        __itree_update (pivot);
+
+        return pivot;
+}
+
+static pl_itree_node_t *
+__itree_balance (pl_itree_node_t *node)
+{
+        int balance = 0;
+
+        __itree_update (node);
+
+        balance = __itree_height (node->left) - __itree_height (node->right);
+
+        if (balance > 1) {
+                if (__itree_height (node->left->left)
+                    < __itree_height (node->left->right))
+                        node->left = __itree_rotate_left (node->left);
+                return __itree_rotate_right (node);
+        }
+
+        if (balance < -1) {
+                if (__itree_height (node->right->right)
+                    < __itree_height (node->right->left))
+                        node->right = __itree_rotate_right (node->right);
+                return __itree_rotate_left (node);
+        }
+
+        return node;
+}
+
+static pl_itree_node_t *
+__itree_insert (pl_itree_node_t *root, pl_itree_node_t *node)
+{
+        if (!root)
+                return node;
+
+        if (__itree_cmp (node, root) < 0)
+                root->left = __itree_insert (root->left, node);
+        else
+                root->right = __itree_insert (root->right, node);
+
+        return __itree_balance (root);
+}
+
+static pl_itree_node_t *
+__itree_remove_min (pl_itree_node_t *root, pl_itree_node_t **min)
+{
+        if (!root->left) {
+                *min = root;
+                return root->right;
+        }
+
+        root->left = __itree_remove_min (root->left, min);
+        return __itree_balance (root);
+}
+
+static pl_itree_node_t *
+__itree_remove (pl_itree_node_t *root, pl_itree_node_t *node, int *found)
+{
+        int              cmp   = 0;
+        pl_itree_node_t *left  = NULL;
+        pl_itree_node_t *right = NULL;
+        pl_itree_node_t *min   = NULL;
+
+        if (!root)
+                return NULL;
+
+        cmp = __itree_cmp (node, root);
+        if (cmp < 0) {
+                root->left = __itree_remove (root->left, node, found);
+        } else if (cmp > 0) {
+                root->right = __itree_remove (root->right, node, found);
+        } else {
+                *found = 1;
+
+                left = root->left;
+                right = root->right;
+                if (!right)
+                        return left;
+
+                right = __itree_remove_min (right, &min);
+                min->left = left;
+                min->right = right;
+                return __itree_balance (min);
+        }
+
+        return __itree_balance (root);
+}
+
+/**
+ * in-order walk over nodes overlapping [@start, @end]: subtrees whose
+ * largest end lies before @start are skipped, as is everything right of
+ * a node starting past @end.
+ */
+static pl_itree_node_t *
+__itree_search (pl_itree_node_t *node, off_t start, off_t end,
+                pl_itree_match_t match, void *data)
+{
+        pl_itree_node_t *found = NULL;
+
+        if (!node || (node->max < start))
+                return NULL;
+
+        found = __itree_search (node->left, start, end, match, data);
+        if (found)
+                return found;
+
+        if (node->start > end)
+                return NULL;
+
+        if ((node->end >= start) && (!match || match (node, data)))
+                return node;
+
+        return __itree_search (node->right, start, end, match, data);
+}
+
+void
+pl_itree_init (pl_itree_t *tree)
+{
+        tree->root = NULL;
+        tree->count = 0;
+}
+
+void
+pl_itree_insert (pl_itree_t *tree, pl_itree_node_t *node,
+                 off_t start, off_t end)
+{
+        node->left = node->right = NULL;
+        node->start = start;
+        node->end = end;
+        node->max = end;
+        node->height = 1;
+
+        tree->root = __itree_insert (tree->root, node);
+        tree->count++;
+
+        node->tree = tree;
+}
+
+/* no-op for a node which is not linked into any tree */
+void
+pl_itree_remove (pl_itree_node_t *node)
+{
+        int         found = 0;
+        pl_itree_t *tree  = node->tree;
+
+        if (!tree)
+                return;
+
+        tree->root = __itree_remove (tree->root, node, &found);
+        if (found)
+                tree->count--;
+
+        node->tree = NULL;
+        node->left = node->right = NULL;
+}
+
+pl_itree_node_t *
+pl_itree_search (pl_itree_t *tree, off_t start, off_t end,
+                 pl_itree_match_t match, void *data)
+{
+        return __itree_search (tree->root, start, end, match, data);
+}
@@ -0,0 +1,68 @@
+/*
+   Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef __INTERVAL_TREE_H__
+#define __INTERVAL_TREE_H__
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/**
+ * Interval tree of byte ranges (both ends inclusive) used to look up
+ * overlapping locks without walking every lock held on an inode. It is
+ * an AVL tree ordered by range start, each node carrying the largest
+ * range end found in its subtree. Nodes are embedded in the lock and
+ * the tree does no allocation; callers serialize access (pl_inode's
+ * mutex).
+ */
+struct pl_itree;
+
+typedef struct pl_itree_node {
+        struct pl_itree_node *left;
+        struct pl_itree_node *right;
+        struct pl_itree      *tree;    /* tree the node is linked into */
+
+        off_t                 start;
+        off_t                 end;
+        off_t                 max;     /* largest end in this subtree */
+        int                   height;
+} pl_itree_node_t;
+
+typedef struct pl_itree {
+        pl_itree_node_t *root;
+        uint32_t         count;
+} pl_itree_t;
+
+/* return non-zero to stop the search at @node */
+typedef int (*pl_itree_match_t) (pl_itree_node_t *node, void *data);
+
+#define pl_itree_entry(node, type, member)                              \
+        ((type *)((char *)(node) - (unsigned long)(&((type *)0)->member)))
+
+void
+pl_itree_init (pl_itree_t *tree);
+
+void
+pl_itree_insert (pl_itree_t *tree, pl_itree_node_t *node,
+                 off_t start, off_t end);
+
+void
+pl_itree_remove (pl_itree_node_t *node);
+
+pl_itree_node_t *
+pl_itree_search (pl_itree_t *tree, off_t start, off_t end,
+                 pl_itree_match_t match, void *data);
+
+static inline int
+pl_itree_empty (pl_itree_t *tree)
+{
+        return (tree->root == NULL);
+}
+
+#endif /* __INTERVAL_TREE_H__ */
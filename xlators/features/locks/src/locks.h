@@ -17,11 +17,13 @@
 #include "client_t.h"
 
 #include "lkowner.h"
+#include "interval-tree.h"
 
 struct __pl_fd;
 
 struct __posix_lock {
         struct list_head   list;
+        pl_itree_node_t    itree;      /* granted locks: in ext_tree */
 
         short              fl_type;
         off_t              fl_start;
@@ -50,6 +52,9 @@ typedef struct __posix_lock posix_lock_t;
 struct __pl_inode_lock {
         struct list_head   list;
         struct list_head   blocked_locks; /* list_head pointing to blocked_inodelks */
+        pl_itree_node_t    itree;      /* in the domain's granted or
+                                          blocked lock tree */
+        uint64_t           blkd_seq;   /* queueing order when blocked */
         int                ref;
 
         short              fl_type;
@@ -94,6 +99,9 @@ struct __pl_dom_list_t {
         struct list_head   blocked_entrylks; /* List of all blocked entrylks */
         struct list_head   inodelk_list;     /* List of inode locks */
         struct list_head   blocked_inodelks; /* List of all blocked inodelks */
+        pl_itree_t         inodelk_tree;     /* granted inodelks by range */
+        pl_itree_t         blocked_inodelk_tree; /* blocked inodelks by range */
+        uint64_t           blocked_seq;      /* next blocked inodelk's order */
 };
 typedef struct __pl_dom_list_t pl_dom_list_t;
 
@@ -133,6 +141,7 @@ struct __pl_inode {
 
         struct list_head dom_list;       /* list of domains */
         struct list_head ext_list;       /* list of fcntl locks */
+        pl_itree_t       ext_tree;       /* granted fcntl locks by range */
         struct list_head rw_list;        /* list of waiting r/w requests */
         struct list_head reservelk_list;        /* list of reservelks */
         struct list_head blocked_reservelks;        /* list of blocked reservelks */
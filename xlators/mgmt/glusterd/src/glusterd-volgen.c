@@ -3853,6 +3853,17 @@ bitrot_option_handler (volgen_graph_t *graph, struct volopt_map_entry *vme,
                         return -1;
         }
 
+        if (!strcmp (vme->option, "chunked-sign-threshold")) {
+                ret = gf_asprintf (&bitrot_option, "chunked-sign-threshold");
+                if (ret != -1) {
+                        ret = xlator_set_option (xl, bitrot_option, vme->value);
+                        GF_FREE (bitrot_option);
+                }
+
+                if (ret)
+                        return -1;
+        }
+
         return ret;
 }
 
@@ -3891,6 +3902,13 @@ scrubber_option_handler (volgen_graph_t *graph, struct volopt_map_entry *vme,
                         return -1;
         }
 
+        if (!strcmp (vme->option, "scrub-debug-interval")) {
+                ret = xlator_set_option (xl, "scrub-debug-interval",
+                                         vme->value);
+                if (ret)
+                        return -1;
+        }
+
         if (!strcmp (vme->option, "scrubber")) {
                 if (!strcmp (vme->value, "pause")) {
                         ret = gf_asprintf (&scrub_option, "scrub-state");
@@ -173,6 +173,31 @@ validate_defrag_throttle_option (glusterd_volinfo_t *volinfo, dict_t *dict,
         return ret;
 }
 
+static int
+validate_thread_placement (glusterd_volinfo_t *volinfo, dict_t *dict,
+                           char *key, char *value, char **op_errstr)
+{
+        char                 errstr[2048] = "";
+        int                  ret          = 0;
+        xlator_t            *this         = NULL;
+
+        this = THIS;
+        GF_ASSERT (this);
+
+        ret = gf_thread_placement_validate (value);
+        if (ret) {
+                snprintf (errstr, sizeof (errstr), "%s should be "
+                          "{none|spread|nodes|node:<N>|cpus:<list>}", key);
+                gf_msg (this->name, GF_LOG_ERROR, EINVAL,
+                        GD_MSG_INVALID_ENTRY, "%s", errstr);
+                *op_errstr = gf_strdup (errstr);
+        }
+
+        gf_msg_debug (this->name, 0, "Returning %d", ret);
+
+        return ret;
+}
+
 static int
 validate_quota (glusterd_volinfo_t *volinfo, dict_t *dict, char *key,
                 char *value, char **op_errstr)
@@ -270,6 +295,44 @@ out:
         return ret;
 }
 
+/* read-hash-mode 3 (least expected wait) is only understood by
+ * 3.7.4 clients; the older modes stay settable on older clusters */
+static int
+validate_read_hash_mode (glusterd_volinfo_t *volinfo, dict_t *dict,
+                         char *key, char *value, char **op_errstr)
+{
+        char                 errstr[2048]  = "";
+        glusterd_conf_t     *priv          = NULL;
+        int                  ret           = 0;
+        int                  mode          = 0;
+        xlator_t            *this          = NULL;
+
+        this = THIS;
+        GF_ASSERT (this);
+        priv = this->private;
+        GF_ASSERT (priv);
+
+        ret = gf_string2int (value, &mode);
+        if (ret)
+                goto out;
+
+        if (mode == 3 && priv->op_version < GD_OP_VERSION_3_7_4) {
+                snprintf (errstr, sizeof (errstr), "%s value 3 requires "
+                          "cluster op-version %d or higher", key,
+                          GD_OP_VERSION_3_7_4);
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        GD_MSG_INVALID_ENTRY, "%s", errstr);
+                *op_errstr = gf_strdup (errstr);
+                ret = -1;
+                goto out;
+        }
+
+out:
+        gf_msg_debug (this->name, 0, "Returning %d", ret);
+
+        return ret;
+}
+
 static int
 validate_subvols_per_directory (glusterd_volinfo_t *volinfo, dict_t *dict,
                                 char *key, char *value, char **op_errstr)
@@ -441,6 +504,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 1,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "cluster.lookup-unhashed-bloom",
+          .voltype    = "cluster/distribute",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
         { .key        = "cluster.rsync-hash-regex",
           .voltype    = "cluster/distribute",
           .type       = NO_DOC,
@@ -474,6 +542,30 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .validate_fn = validate_defrag_throttle_option,
           .flags       = OPT_FLAG_CLIENT_OPT,
         },
+        { .key         = "cluster.rebal-migrate-window",
+          .voltype     = "cluster/distribute",
+          .option      = "rebal-migrate-window",
+          .op_version  = GD_OP_VERSION_3_7_4,
+          .flags       = OPT_FLAG_CLIENT_OPT,
+        },
+        { .key         = "cluster.rebal-block-size",
+          .voltype     = "cluster/distribute",
+          .option      = "rebal-block-size",
+          .op_version  = GD_OP_VERSION_3_7_4,
+          .flags       = OPT_FLAG_CLIENT_OPT,
+        },
+        { .key         = "cluster.rebal-crawl-threads",
+          .voltype     = "cluster/distribute",
+          .option      = "rebal-crawl-threads",
+          .op_version  = GD_OP_VERSION_3_7_4,
+          .flags       = OPT_FLAG_CLIENT_OPT,
+        },
+        { .key         = "cluster.rebal-crawl-checkpoint",
+          .voltype     = "cluster/distribute",
+          .option      = "rebal-crawl-checkpoint",
+          .op_version  = GD_OP_VERSION_3_7_4,
+          .flags       = OPT_FLAG_CLIENT_OPT,
+        },
         /* NUFA xlator options (Distribute special case) */
         { .key        = "cluster.nufa",
           .voltype    = "cluster/distribute",
@@ -526,9 +618,15 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 2,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
-        { .key        = "cluster.read-hash-mode",
+        { .key         = "cluster.read-hash-mode",
+          .voltype     = "cluster/replicate",
+          .op_version  = 2,
+          .flags       = OPT_FLAG_CLIENT_OPT,
+          .validate_fn = validate_read_hash_mode
+        },
+        { .key        = "cluster.read-hedge",
           .voltype    = "cluster/replicate",
-          .op_version = 2,
+          .op_version = GD_OP_VERSION_3_7_4,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
         { .key        = "cluster.background-self-heal-count",
@@ -771,6 +869,24 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 1,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "performance.shared-cache",
+          .voltype    = "performance/io-cache",
+          .option     = "shared-cache",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.shared-cache-size",
+          .voltype    = "performance/io-cache",
+          .option     = "shared-cache-size",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.shared-cache-group",
+          .voltype    = "performance/io-cache",
+          .option     = "shared-cache-group",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
 
         /* IO-threads xlator options */
         { .key         = "performance.io-thread-count",
@@ -802,6 +918,22 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "performance/io-threads",
           .op_version  = 2
         },
+        { .key         = "performance.io-thread-queue-count",
+          .voltype     = "performance/io-threads",
+          .option      = "queue-count",
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
+        { .key         = "performance.io-thread-fair-queueing",
+          .voltype     = "performance/io-threads",
+          .option      = "fair-queueing",
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
+        { .key         = "performance.io-thread-placement",
+          .voltype     = "performance/io-threads",
+          .option      = "thread-placement",
+          .op_version  = GD_OP_VERSION_3_7_4,
+          .validate_fn = validate_thread_placement,
+        },
 
         /* Other perf xlators' options */
         { .key        = "performance.cache-size",
@@ -834,6 +966,18 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 1,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "performance.write-behind-aggregate-size",
+          .voltype    = "performance/write-behind",
+          .option     = "aggregate-size",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "performance.write-behind-aggregate-writes",
+          .voltype    = "performance/write-behind",
+          .option     = "aggregate-writes",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
         { .key        = "performance.strict-o-direct",
           .voltype    = "performance/write-behind",
           .option     = "strict-O_DIRECT",
@@ -946,6 +1090,20 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = 2,
           .flags      = OPT_FLAG_CLIENT_OPT
         },
+        { .key        = "client.read-batch-size",
+          .voltype    = "protocol/client",
+          .option     = "transport.socket.read-batch-size",
+          .type       = NO_DOC,
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
+        { .key        = "client.ssl-ktls",
+          .voltype    = "protocol/client",
+          .option     = "transport.socket.ssl-ktls",
+          .type       = NO_DOC,
+          .op_version = GD_OP_VERSION_3_7_4,
+          .flags      = OPT_FLAG_CLIENT_OPT
+        },
         { .key        = "network.remote-dio",
           .voltype    = "protocol/client",
           .option     = "filter-O_DIRECT",
@@ -962,6 +1120,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "protocol/client",
           .op_version  = GD_OP_VERSION_3_7_0,
         },
+        { .key         = "client.event-thread-placement",
+          .voltype     = "protocol/client",
+          .option      = "event-thread-placement",
+          .op_version  = GD_OP_VERSION_3_7_4,
+          .validate_fn = validate_thread_placement,
+        },
 
         /* Server xlator options */
         { .key         = "network.ping-timeout",
@@ -995,6 +1159,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .type        = NO_DOC,
           .op_version  = 1
         },
+        { .key         = "server.read-batch-size",
+          .voltype     = "protocol/server",
+          .option      = "transport.socket.read-batch-size",
+          .type        = NO_DOC,
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
         { .key         = "server.allow-insecure",
           .voltype     = "protocol/server",
           .option      = "rpc-auth-allow-insecure",
@@ -1045,6 +1215,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .type        = NO_DOC,
           .op_version  = 2
         },
+        { .key         = "server.ssl-ktls",
+          .voltype     = "protocol/server",
+          .option      = "transport.socket.ssl-ktls",
+          .type        = NO_DOC,
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
         { .key         = "auth.ssl-allow",
           .voltype     = "protocol/server",
           .option      = "!ssl-allow",
@@ -1075,6 +1251,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "protocol/server",
           .op_version  = GD_OP_VERSION_3_7_0,
         },
+        { .key         = "server.event-thread-placement",
+          .voltype     = "protocol/server",
+          .option      = "event-thread-placement",
+          .op_version  = GD_OP_VERSION_3_7_4,
+          .validate_fn = validate_thread_placement,
+        },
 
         /* Generic transport options */
         { .key         = SSL_CERT_DEPTH_OPT,
@@ -1719,6 +1901,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "storage/posix",
           .op_version  = 3
         },
+        { .key         = "storage.readdirp-fill-threads",
+          .voltype     = "storage/posix",
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
+        { .key         = "storage.name-bloom-refresh-interval",
+          .voltype     = "storage/posix",
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
         { .option      = "update-link-count-parent",
           .key         = "storage.build-pgfid",
           .voltype     = "storage/posix",
@@ -1775,6 +1965,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .type        = NO_DOC,
           .op_version  = 3
         },
+        { .key         = "changelog.journal-buffer-size",
+          .voltype     = "features/changelog",
+          .type        = NO_DOC,
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
+        { .key         = "changelog.journal-commit-delay",
+          .voltype     = "features/changelog",
+          .type        = NO_DOC,
+          .op_version  = GD_OP_VERSION_3_7_4
+        },
         { .key         = "changelog.changelog-barrier-timeout",
           .voltype     = "features/changelog",
           .value       = BARRIER_TIMEOUT,
@@ -2000,6 +2200,20 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .op_version = GD_OP_VERSION_3_7_0,
           .type       = NO_DOC,
         },
+        { .key        = "features.chunked-sign-threshold",
+          .voltype    = "features/bitrot",
+          .value      = "0",
+          .option     = "chunked-sign-threshold",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .type       = NO_DOC,
+        },
+        { .key        = "features.scrub-debug-interval",
+          .voltype    = "features/bitrot",
+          .value      = "0",
+          .option     = "scrub-debug-interval",
+          .op_version = GD_OP_VERSION_3_7_4,
+          .type       = NO_DOC,
+        },
         /* Upcall translator options */
         { .key         = "features.cache-invalidation",
           .voltype     = "features/upcall",
@@ -2018,6 +2232,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
           .voltype     = "cluster/disperse",
           .op_version  = GD_OP_VERSION_3_7_3,
         },
+        { .key         = "disperse.heal-block-size",
+          .voltype     = "cluster/disperse",
+          .op_version  = GD_OP_VERSION_3_7_4,
+        },
+        { .key         = "disperse.self-heal-window-size",
+          .voltype     = "cluster/disperse",
+          .op_version  = GD_OP_VERSION_3_7_4,
+        },
         { .key        = "cluster.heal-timeout",
           .voltype    = "cluster/disperse",
           .option     = "!heal-timeout",
@@ -40,7 +40,7 @@
  */
 
 #define GLFS_IO_CACHE_BASE                   GLFS_MSGID_COMP_IO_CACHE
-#define GLFS_IO_CACHE_NUM_MESSAGES           6
+#define GLFS_IO_CACHE_NUM_MESSAGES           7
 #define GLFS_MSGID_END  (GLFS_IO_CACHE_BASE + GLFS_IO_CACHE_NUM_MESSAGES + 1)
 
 /* Messages with message IDs */
@@ -103,6 +103,17 @@
 
 #define IO_CACHE_MSG_INODE_NULL        (GLFS_IO_CACHE_BASE + 6)
 
+/*!
+ * @messageid
+ * @diagnosis Shared cache file could not be set up or is in use with a
+ *            different page size
+ * @recommendedaction Check the path given in shared-cache, or remove the
+ *            file once no client uses it
+ *
+ */
+
+#define IO_CACHE_MSG_SHARED_CACHE        (GLFS_IO_CACHE_BASE + 7)
+
 
 /*------------*/
 #define glfs_msg_end_x GLFS_MSGID_END, "Invalid: End of messages"
@@ -1737,6 +1737,9 @@ init (xlator_t *this)
         glusterfs_ctx_t *ctx               = NULL;
         data_t          *data              = 0;
         uint32_t         num_pages         = 0;
+        char            *shared_path       = NULL;
+        char            *shared_group      = NULL;
+        uint64_t         shared_size       = 0;
 
         xl_options = this->options;
 
@@ -1772,6 +1775,12 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("max-file-size", table->max_file_size, size_uint64, out);
 
+        GF_OPTION_INIT ("shared-cache", shared_path, path, out);
+
+        GF_OPTION_INIT ("shared-cache-size", shared_size, size_uint64, out);
+
+        GF_OPTION_INIT ("shared-cache-group", shared_group, str, out);
+
         if  (!check_cache_size_ok (this, table->cache_size)) {
                 ret = -1;
                 goto out;
@@ -1839,6 +1848,13 @@ init (xlator_t *this)
                 goto out;
         }
 
+        /* the shared cache is only a second level: run without it if it
+         * cannot be set up */
+        if (shared_path)
+                table->shm = ioc_shm_attach (this, shared_path,
+                                             shared_group, shared_size,
+                                             table->page_size);
+
         ret = 0;
 
         ctx = this->ctx;
@@ -2059,6 +2075,8 @@ ioc_priv_dump (xlator_t *this)
                 gf_proc_dump_write ("cache_timeout", "%u", priv->cache_timeout);
                 gf_proc_dump_write ("min-file-size", "%u", priv->min_file_size);
                 gf_proc_dump_write ("max-file-size", "%u", priv->max_file_size);
+                if (priv->shm)
+                        ioc_shm_dump (priv->shm);
         }
         pthread_mutex_unlock (&priv->table_lock);
 out:
@@ -2115,6 +2133,8 @@ fini (xlator_t *this)
 
         GF_ASSERT (list_empty (&table->inodes));
         */
+        ioc_shm_detach (table->shm);
+
         pthread_mutex_destroy (&table->table_lock);
         GF_FREE (table);
 
@@ -2188,5 +2208,32 @@ struct volume_options options[] = {
           .description = "Maximum file size which would be cached by the "
           "io-cache translator."
         },
+        { .key  = {"shared-cache"},
+          .type = GF_OPTION_TYPE_PATH,
+          .description = "File (preferably on tmpfs, e.g. under /dev/shm) "
+          "holding a second level cache shared by all client processes "
+          "on the host configured with the same file. Pages read by one "
+          "of them are served to the others as long as the file has not "
+          "changed. The file must be owned by the process' user or root "
+          "and writable by no other user, so without shared-cache-group "
+          "only processes of the same user share it. Takes effect on the "
+          "next mount."
+        },
+        { .key  = {"shared-cache-group"},
+          .type = GF_OPTION_TYPE_STR,
+          .description = "Group whose members share the shared-cache file "
+          "across users (e.g. qemu and a root FUSE mount): the file is "
+          "created writable by this group, and a file owned by root or "
+          "the process' user is accepted when only this group can write "
+          "to it besides the owner. Takes effect on the next mount."
+        },
+        { .key  = {"shared-cache-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 16 * GF_UNIT_MB,
+          .max  = 64 * GF_UNIT_GB,
+          .default_value = "256MB",
+          .description = "Size of the shared cache file when it gets "
+          "created. A file already in use keeps its size."
+        },
         { .key = {NULL} },
 };
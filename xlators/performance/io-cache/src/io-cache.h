@@ -34,6 +34,7 @@ struct ioc_table;
 struct ioc_local;
 struct ioc_page;
 struct ioc_inode;
+struct ioc_shm;
 
 struct ioc_priority {
         struct list_head list;
@@ -93,6 +94,8 @@ struct ioc_local {
         fd_t             *fd;
         int32_t          need_xattr;
         dict_t           *xattr_req;
+        int8_t           shared;         /* page fault served from the
+                                          * shared cache */
 };
 
 /*
@@ -165,6 +168,8 @@ struct ioc_table {
         int32_t          cache_timeout;
         int32_t          max_pri;
         struct mem_pool  *mem_pool;
+        struct ioc_shm   *shm;     /* host-wide cache shared with other
+                                    * clients, if configured */
 };
 
 typedef struct ioc_table ioc_table_t;
@@ -319,10 +324,31 @@ ioc_inode_wakeup (call_frame_t *frame, ioc_inode_t *ioc_inode,
 int8_t
 ioc_cache_still_valid (ioc_inode_t *ioc_inode, struct iatt *stbuf);
 
+int32_t
+ioc_inode_need_revalidate (ioc_inode_t *ioc_inode);
+
 int32_t
 ioc_prune (ioc_table_t *table);
 
 int32_t
 ioc_need_prune (ioc_table_t *table);
 
+struct ioc_shm *
+ioc_shm_attach (xlator_t *this, const char *path, const char *group,
+                uint64_t size, uint64_t page_size);
+
+void
+ioc_shm_detach (struct ioc_shm *shm);
+
+int32_t
+ioc_shm_get (struct ioc_shm *shm, uuid_t gfid, off_t offset,
+             struct iatt *stbuf, struct iovec *vector, struct iobref **iobref);
+
+void
+ioc_shm_put (struct ioc_shm *shm, uuid_t gfid, off_t offset,
+             struct iatt *stbuf, struct iovec *vector, int32_t count);
+
+void
+ioc_shm_dump (struct ioc_shm *shm);
+
 #endif /* __IO_CACHE_H */
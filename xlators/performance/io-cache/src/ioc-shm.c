@@ -0,0 +1,505 @@
+/*
+  Copyright (c) 2015 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <grp.h>
+
+#include "glusterfs.h"
+#include "logging.h"
+#include "statedump.h"
+#include "io-cache.h"
+#include "ioc-mem-types.h"
+#include "io-cache-messages.h"
+
+/*
+ * Shared cache: a second level of io-cache kept in a file mapped by every
+ * client process on the host which is configured with the same path, so
+ * that mounts and gfapi consumers reading the same files hold one copy of
+ * each page between them.
+ *
+ * The file is a header, an array of buckets and the page data. A page is
+ * keyed by volume, gfid and offset and hashed to a bucket of IOC_SHM_WAYS
+ * slots. Each slot carries a sequence count which is odd while the slot
+ * is written: readers take no lock, they copy the data out and treat a
+ * slot whose count moved meanwhile as a miss. Writers claim a slot by
+ * bumping the count with a CAS and give up if another writer holds it.
+ * Slots are reused in clock order within the bucket; a slot earns its
+ * second chance by being read.
+ *
+ * A page is only served when the mtime (and size, when known) it was read
+ * with matches what io-cache has validated for the inode, the same rule
+ * ioc_cache_still_valid () applies to the private cache, and only while
+ * that mtime is within cache-timeout of being validated. Writes change
+ * the mtime, so stale copies are never returned and get recycled.
+ *
+ * Whoever can write the file decides what our reads return, so it has to
+ * belong to us or to root and be writable by no other user. Processes
+ * running as different users (say qemu and a root FUSE mount) share one
+ * file through a group they are all in, set with shared-cache-group:
+ * the file may then be writable by that group and no other.
+ */
+
+#define IOC_SHM_MAGIC    0x494f4353             /* "IOCS" */
+#define IOC_SHM_VERSION  1
+#define IOC_SHM_WAYS     8
+#define IOC_SHM_ALIGN    4096
+
+struct ioc_shm_slot {
+        uint32_t      seq;
+        uint32_t      referenced;
+        uint64_t      volume;
+        unsigned char gfid[16];
+        int64_t       offset;
+        int64_t       mtime;
+        int64_t       mtime_nsec;
+        int64_t       ia_size;
+        uint64_t      len;
+};
+
+struct ioc_shm_bucket {
+        uint32_t            hand;
+        uint32_t            pad;
+        struct ioc_shm_slot slot[IOC_SHM_WAYS];
+};
+
+struct ioc_shm_header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t page_size;
+        uint64_t bucket_count;
+        uint64_t data_offset;
+};
+
+struct ioc_shm {
+        char                  *path;
+        void                  *base;
+        size_t                 size;
+        uint64_t               page_size;
+        uint64_t               bucket_count;
+        struct ioc_shm_bucket *buckets;
+        char                  *data;
+        uint64_t               volume;
+
+        uint64_t               hits;
+        uint64_t               misses;
+        uint64_t               stores;
+        uint64_t               busy;
+};
+
+
+static inline uint32_t
+ioc_shm_seq (struct ioc_shm_slot *slot)
+{
+        return *(volatile uint32_t *)&slot->seq;
+}
+
+
+static inline char *
+ioc_shm_slot_data (struct ioc_shm *shm, struct ioc_shm_bucket *bucket,
+                   struct ioc_shm_slot *slot)
+{
+        uint64_t index = 0;
+
+        index = (bucket - shm->buckets) * IOC_SHM_WAYS
+                + (slot - bucket->slot);
+
+        return shm->data + index * shm->page_size;
+}
+
+
+static struct ioc_shm_bucket *
+ioc_shm_bucket (struct ioc_shm *shm, uuid_t gfid, off_t offset)
+{
+        struct {
+                uint64_t      volume;
+                unsigned char gfid[16];
+                int64_t       offset;
+        } key;
+
+        memset (&key, 0, sizeof (key));
+        key.volume = shm->volume;
+        gf_uuid_copy (key.gfid, gfid);
+        key.offset = offset;
+
+        return &shm->buckets[SuperFastHash ((char *)&key, sizeof (key))
+                             % shm->bucket_count];
+}
+
+
+static inline int
+ioc_shm_slot_is (struct ioc_shm *shm, struct ioc_shm_slot *slot,
+                 uuid_t gfid, off_t offset)
+{
+        return ((slot->volume == shm->volume) && (slot->offset == offset)
+                && !gf_uuid_compare (slot->gfid, gfid));
+}
+
+
+struct ioc_shm *
+ioc_shm_attach (xlator_t *this, const char *path, const char *group,
+                uint64_t size, uint64_t page_size)
+{
+        struct ioc_shm        *shm     = NULL;
+        struct ioc_shm_header *header  = NULL;
+        struct stat            st      = {0, };
+        uint64_t               buckets = 0;
+        uint64_t               offset  = 0;
+        size_t                 total   = 0;
+        uint32_t               magic   = 0;
+        struct group          *gr      = NULL;
+        mode_t                 mode    = 0600;
+        int                    fd      = -1;
+        int                    ret     = -1;
+        char                   create  = 0;
+
+        shm = GF_CALLOC (1, sizeof (*shm), gf_ioc_mt_ioc_shm_t);
+        if (!shm)
+                goto out;
+
+        shm->path = gf_strdup (path);
+        if (!shm->path)
+                goto out;
+
+        buckets = max (size / (IOC_SHM_WAYS * page_size), 1);
+        offset = roof (sizeof (*header), IOC_SHM_ALIGN)
+                 + roof (buckets * sizeof (struct ioc_shm_bucket),
+                         IOC_SHM_ALIGN);
+        total = offset + buckets * IOC_SHM_WAYS * page_size;
+
+        if (group) {
+                gr = getgrnam (group);
+                if (!gr) {
+                        gf_msg (this->name, GF_LOG_WARNING, 0,
+                                IO_CACHE_MSG_SHARED_CACHE,
+                                "group %s of shared cache %s does not exist",
+                                group, path);
+                        goto out;
+                }
+                mode = 0660;
+        }
+
+        fd = open (path, O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, mode);
+        if (fd < 0) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        IO_CACHE_MSG_SHARED_CACHE,
+                        "cannot open shared cache %s", path);
+                goto out;
+        }
+
+        /* whoever comes first lays the file out */
+        if (flock (fd, LOCK_EX) || fstat (fd, &st)) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        IO_CACHE_MSG_SHARED_CACHE,
+                        "cannot lock shared cache %s", path);
+                goto out;
+        }
+
+        /* a file we just created: hand it to the group (our umask may
+         * have dropped its write bit) */
+        if (gr && !st.st_size && (st.st_uid == geteuid ()) &&
+            ((st.st_gid != gr->gr_gid) || !(st.st_mode & S_IWGRP))) {
+                if (fchown (fd, -1, gr->gr_gid) || fchmod (fd, 0660) ||
+                    fstat (fd, &st)) {
+                        gf_msg (this->name, GF_LOG_WARNING, errno,
+                                IO_CACHE_MSG_SHARED_CACHE,
+                                "cannot give shared cache %s to group %s",
+                                path, group);
+                        goto out;
+                }
+        }
+
+        /* whoever can write the file can feed us any data */
+        if (!S_ISREG (st.st_mode) ||
+            ((st.st_uid != geteuid ()) && (st.st_uid != 0)) ||
+            (st.st_mode & S_IWOTH) ||
+            ((st.st_mode & S_IWGRP) && (!gr || (st.st_gid != gr->gr_gid)))) {
+                gf_msg (this->name, GF_LOG_WARNING, EPERM,
+                        IO_CACHE_MSG_SHARED_CACHE,
+                        "shared cache %s is not a regular file owned by uid "
+                        "%d or root and writable by no one else%s%s, not "
+                        "using it", path, (int) geteuid (),
+                        gr ? " but group " : "", gr ? group : "");
+                goto out;
+        }
+
+        /* a file whose creator died before setting the magic is laid
+         * out again */
+        if ((st.st_size >= sizeof (*header)) &&
+            (pread (fd, &magic, sizeof (magic), 0) != sizeof (magic))) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        IO_CACHE_MSG_SHARED_CACHE,
+                        "cannot read shared cache %s", path);
+                goto out;
+        }
+
+        if (!magic) {
+                /* blocks are allocated now, not on a page fault in
+                 * the mapping once tmpfs is full */
+                ret = posix_fallocate (fd, 0, total);
+                if (ret) {
+                        gf_msg (this->name, GF_LOG_WARNING, ret,
+                                IO_CACHE_MSG_SHARED_CACHE,
+                                "cannot size shared cache %s", path);
+                        ret = -1;
+                        goto out;
+                }
+                create = 1;
+        } else {
+                total = st.st_size;
+        }
+
+        shm->base = mmap (NULL, total, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fd, 0);
+        if (shm->base == MAP_FAILED) {
+                shm->base = NULL;
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        IO_CACHE_MSG_SHARED_CACHE,
+                        "cannot map shared cache %s", path);
+                goto out;
+        }
+        shm->size = total;
+
+        header = shm->base;
+        if (create) {
+                memset (shm->base, 0, offset);
+                header->version = IOC_SHM_VERSION;
+                header->page_size = page_size;
+                header->bucket_count = buckets;
+                header->data_offset = offset;
+                __sync_synchronize ();
+                header->magic = IOC_SHM_MAGIC;
+        } else if ((header->magic != IOC_SHM_MAGIC) ||
+                   (header->version != IOC_SHM_VERSION) ||
+                   (header->page_size != page_size) ||
+                   !header->bucket_count ||
+                   (header->data_offset < sizeof (*header) +
+                    header->bucket_count * sizeof (struct ioc_shm_bucket)) ||
+                   (total < header->data_offset + header->bucket_count
+                    * IOC_SHM_WAYS * page_size)) {
+                gf_msg (this->name, GF_LOG_WARNING, 0,
+                        IO_CACHE_MSG_SHARED_CACHE,
+                        "shared cache %s has a different layout (page size "
+                        "%"PRIu64"), not using it", path, header->page_size);
+                goto out;
+        }
+
+        /* the file's geometry wins over our cache-size */
+        shm->page_size = header->page_size;
+        shm->bucket_count = header->bucket_count;
+        shm->buckets = (void *)((char *)shm->base
+                                + roof (sizeof (*header), IOC_SHM_ALIGN));
+        shm->data = (char *)shm->base + header->data_offset;
+
+        /* names of the volume's xlators are the same in every graph */
+        shm->volume = gf_dm_hashfn (this->name, strlen (this->name));
+
+        gf_msg (this->name, GF_LOG_INFO, 0, IO_CACHE_MSG_SHARED_CACHE,
+                "using shared cache %s (%"GF_PRI_SIZET" bytes)", path,
+                shm->size);
+
+        ret = 0;
+out:
+        if (fd >= 0) {
+                flock (fd, LOCK_UN);
+                close (fd);
+        }
+
+        if (ret) {
+                ioc_shm_detach (shm);
+                shm = NULL;
+        }
+
+        return shm;
+}
+
+
+void
+ioc_shm_detach (struct ioc_shm *shm)
+{
+        if (!shm)
+                return;
+
+        if (shm->base)
+                munmap (shm->base, shm->size);
+
+        GF_FREE (shm->path);
+        GF_FREE (shm);
+}
+
+
+/*
+ * looks up the page of @gfid at @offset; @stbuf carries the mtime and
+ * size it has to have been read with. On a hit the data is copied into a
+ * fresh iobuf referred by @iobref and its length returned, -1 otherwise.
+ */
+int32_t
+ioc_shm_get (struct ioc_shm *shm, uuid_t gfid, off_t offset,
+             struct iatt *stbuf, struct iovec *vector, struct iobref **iobref)
+{
+        struct ioc_shm_bucket *bucket = NULL;
+        struct ioc_shm_slot   *slot   = NULL;
+        struct iobuf          *iobuf  = NULL;
+        uint64_t               len    = 0;
+        uint32_t               seq    = 0;
+        int32_t                ret    = -1;
+        int                    i      = 0;
+
+        bucket = ioc_shm_bucket (shm, gfid, offset);
+
+        for (i = 0; i < IOC_SHM_WAYS; i++) {
+                slot = &bucket->slot[i];
+
+                seq = ioc_shm_seq (slot);
+                if (seq & 1)
+                        continue;
+                __sync_synchronize ();
+
+                if (!ioc_shm_slot_is (shm, slot, gfid, offset))
+                        continue;
+
+                if ((slot->mtime != stbuf->ia_mtime) ||
+                    (slot->mtime_nsec != stbuf->ia_mtime_nsec) ||
+                    (stbuf->ia_size && (slot->ia_size != stbuf->ia_size)))
+                        continue;
+
+                len = slot->len;
+                if (!len || (len > shm->page_size))
+                        continue;
+
+                if (!iobuf) {
+                        iobuf = iobuf_get2 (THIS->ctx->iobuf_pool,
+                                            shm->page_size);
+                        if (!iobuf)
+                                goto out;
+                }
+
+                memcpy (iobuf->ptr, ioc_shm_slot_data (shm, bucket, slot),
+                        len);
+
+                __sync_synchronize ();
+                if (ioc_shm_seq (slot) != seq)
+                        /* rewritten under us */
+                        continue;
+
+                if (!slot->referenced)
+                        slot->referenced = 1;
+
+                ret = len;
+                break;
+        }
+
+        if (ret < 0)
+                goto out;
+
+        *iobref = iobref_new ();
+        if (!*iobref) {
+                ret = -1;
+                goto out;
+        }
+
+        iobref_add (*iobref, iobuf);
+        vector->iov_base = iobuf->ptr;
+        vector->iov_len = ret;
+
+out:
+        if (iobuf)
+                iobuf_unref (iobuf);
+
+        if (ret < 0)
+                __sync_fetch_and_add (&shm->misses, 1);
+        else
+                __sync_fetch_and_add (&shm->hits, 1);
+
+        return ret;
+}
+
+
+/* publishes a page read from the volume */
+void
+ioc_shm_put (struct ioc_shm *shm, uuid_t gfid, off_t offset,
+             struct iatt *stbuf, struct iovec *vector, int32_t count)
+{
+        struct ioc_shm_bucket *bucket = NULL;
+        struct ioc_shm_slot   *slot   = NULL;
+        struct ioc_shm_slot   *victim = NULL;
+        size_t                 len    = 0;
+        uint32_t               seq    = 0;
+        int                    i      = 0;
+
+        len = iov_length (vector, count);
+        if (!len || (len > shm->page_size))
+                return;
+
+        bucket = ioc_shm_bucket (shm, gfid, offset);
+
+        /* an older copy of the page is replaced in place */
+        for (i = 0; i < IOC_SHM_WAYS; i++) {
+                slot = &bucket->slot[i];
+                if (!ioc_shm_slot_is (shm, slot, gfid, offset))
+                        continue;
+
+                if ((slot->mtime == stbuf->ia_mtime) &&
+                    (slot->mtime_nsec == stbuf->ia_mtime_nsec) &&
+                    (slot->ia_size == stbuf->ia_size) && (slot->len == len))
+                        /* someone got here first */
+                        return;
+
+                victim = slot;
+                break;
+        }
+
+        for (i = 0; !victim && (i < 2 * IOC_SHM_WAYS); i++) {
+                slot = &bucket->slot[__sync_fetch_and_add (&bucket->hand, 1)
+                                     % IOC_SHM_WAYS];
+                if (slot->referenced)
+                        slot->referenced = 0;
+                else
+                        victim = slot;
+        }
+
+        if (!victim)
+                victim = slot;
+
+        seq = ioc_shm_seq (victim);
+        if ((seq & 1) ||
+            !__sync_bool_compare_and_swap (&victim->seq, seq, seq + 1)) {
+                __sync_fetch_and_add (&shm->busy, 1);
+                return;
+        }
+
+        victim->referenced = 0;
+        victim->volume = shm->volume;
+        gf_uuid_copy (victim->gfid, gfid);
+        victim->offset = offset;
+        victim->mtime = stbuf->ia_mtime;
+        victim->mtime_nsec = stbuf->ia_mtime_nsec;
+        victim->ia_size = stbuf->ia_size;
+        victim->len = len;
+
+        iov_unload (ioc_shm_slot_data (shm, bucket, victim), vector, count);
+
+        __sync_synchronize ();
+        victim->seq = seq + 2;
+
+        __sync_fetch_and_add (&shm->stores, 1);
+}
+
+
+void
+ioc_shm_dump (struct ioc_shm *shm)
+{
+        gf_proc_dump_write ("shared_cache", "%s", shm->path);
+        gf_proc_dump_write ("shared_cache_size", "%"GF_PRI_SIZET, shm->size);
+        gf_proc_dump_write ("shared_hits", "%"PRIu64, shm->hits);
+        gf_proc_dump_write ("shared_misses", "%"PRIu64, shm->misses);
+        gf_proc_dump_write ("shared_stores", "%"PRIu64, shm->stores);
+        gf_proc_dump_write ("shared_busy", "%"PRIu64, shm->busy);
+}
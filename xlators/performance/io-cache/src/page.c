@@ -447,12 +447,16 @@ ioc_fault_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
                         destroy_size = __ioc_inode_flush (ioc_inode);
                 }
 
-                if ((op_ret >= 0) && !zero_filled) {
+                /* a shared cache hit is only as fresh as what we had
+                 * validated already, it must not extend that */
+                if ((op_ret >= 0) && !zero_filled && !local->shared) {
                         ioc_inode->cache.mtime = stbuf->ia_mtime;
                         ioc_inode->cache.mtime_nsec = stbuf->ia_mtime_nsec;
+                        ioc_inode->ia_size = stbuf->ia_size;
                 }
 
-                gettimeofday (&ioc_inode->cache.tv, NULL);
+                if (!local->shared)
+                        gettimeofday (&ioc_inode->cache.tv, NULL);
 
                 if (op_ret < 0) {
                         /* error, readv returned -1 */
@@ -531,6 +535,10 @@ unlock:
 
         ioc_waitq_return (waitq);
 
+        if (table->shm && (op_ret > 0) && !zero_filled && !local->shared)
+                ioc_shm_put (table->shm, ioc_inode->inode->gfid, offset,
+                             stbuf, vector, count);
+
         if (iobref_page_size) {
                 ioc_table_lock (table);
                 {
@@ -581,6 +589,10 @@ ioc_page_fault (ioc_inode_t *ioc_inode, call_frame_t *frame, fd_t *fd,
         int32_t       op_ret      = -1, op_errno = -1;
         ioc_waitq_t  *waitq       = NULL;
         ioc_page_t   *page        = NULL;
+        struct iatt   stbuf       = {0, };
+        struct iovec  vector      = {0, };
+        struct iobref *iobref     = NULL;
+        int32_t       len         = -1;
 
         GF_ASSERT (ioc_inode);
         if (frame == NULL) {
@@ -621,6 +633,37 @@ ioc_page_fault (ioc_inode_t *ioc_inode, call_frame_t *frame, fd_t *fd,
         fault_local->pending_size = table->page_size;
         fault_local->inode = ioc_inode;
 
+        if (table->shm) {
+                /* the mtime is only worth matching against while it is
+                 * still within cache-timeout of being validated */
+                ioc_inode_lock (ioc_inode);
+                {
+                        if (!ioc_inode_need_revalidate (ioc_inode)) {
+                                stbuf.ia_mtime = ioc_inode->cache.mtime;
+                                stbuf.ia_mtime_nsec =
+                                        ioc_inode->cache.mtime_nsec;
+                                stbuf.ia_size = ioc_inode->ia_size;
+                        }
+                }
+                ioc_inode_unlock (ioc_inode);
+
+                /* only once we know what the file looks like */
+                if (stbuf.ia_mtime)
+                        len = ioc_shm_get (table->shm, fd->inode->gfid,
+                                           offset, &stbuf, &vector, &iobref);
+                if (len >= 0) {
+                        gf_msg_trace (frame->this->name, 0,
+                                      "shared cache hit for offset = %"
+                                      PRId64, offset);
+                        fault_local->shared = 1;
+                        ioc_fault_cbk (fault_frame, NULL, fault_frame->this,
+                                       len, 0, &vector, 1, &stbuf, iobref,
+                                       NULL);
+                        iobref_unref (iobref);
+                        return;
+                }
+        }
+
         gf_msg_trace (frame->this->name, 0,
                       "stack winding page fault for offset = %"PRId64" with "
                       "frame %p", offset, fault_frame);
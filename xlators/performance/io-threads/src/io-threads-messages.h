@@ -40,7 +40,7 @@
  */
 
 #define GLFS_IO_THREADS_BASE                   GLFS_MSGID_COMP_IO_THREADS
-#define GLFS_IO_THREADS_NUM_MESSAGES           5
+#define GLFS_IO_THREADS_NUM_MESSAGES           6
 #define GLFS_MSGID_END (GLFS_IO_THREADS_BASE + \
         GLFS_IO_THREADS_NUM_MESSAGES + 1)
 
@@ -95,6 +95,16 @@
 
 #define IO_THREADS_MSG_SIZE_NOT_SET        (GLFS_IO_THREADS_BASE + 5)
 
+/*!
+ * @messageid
+ * @diagnosis The worker threads could not be placed as configured by the
+ * thread-placement option, they keep running where they were.
+ * @recommendedaction  Check the CPU list or NUMA node in the option.
+ *
+ */
+
+#define IO_THREADS_MSG_PLACEMENT_FAILED    (GLFS_IO_THREADS_BASE + 6)
+
 
 /*------------*/
 #define glfs_msg_end_x GLFS_MSGID_END, "Invalid: End of messages"
@@ -48,8 +48,230 @@ struct volume_options options[];
                 }                                                              \
         } while (0)
 
+static int
+iot_stub_cost (call_stub_t *stub)
+{
+        size_t  size = 0;
+
+        switch (stub->fop) {
+        case GF_FOP_READ:
+                size = stub->args.size;
+                break;
+        case GF_FOP_WRITE:
+                size = iov_length (stub->args.vector, stub->args.count);
+                break;
+        default:
+                break;
+        }
+
+        return 1 + (size / IOT_FAIR_COST_UNIT);
+}
+
+
+static iot_client_ctx_t *
+iot_client_ctx_new (iot_conf_t *conf, client_t *client)
+{
+        iot_client_ctx_t   *ctx   = NULL;
+        iot_client_queue_t *queue = NULL;
+        int                 i     = 0;
+        int                 j     = 0;
+
+        ctx = GF_CALLOC (1, sizeof (*ctx) +
+                         conf->shard_count * sizeof (*queue),
+                         gf_iot_mt_client_ctx_t);
+        if (!ctx)
+                return NULL;
+
+        INIT_LIST_HEAD (&ctx->clients);
+        ctx->client = client;
+
+        for (i = 0; i < conf->shard_count; i++) {
+                queue = &ctx->queues[i];
+                for (j = 0; j < IOT_PRI_MAX; j++) {
+                        INIT_LIST_HEAD (&queue->reqs[j]);
+                        INIT_LIST_HEAD (&queue->sched[j]);
+                }
+        }
+
+        return ctx;
+}
+
+
+static iot_client_ctx_t *
+iot_client_ctx_get (iot_conf_t *conf, client_t *client)
+{
+        iot_client_ctx_t *ctx = NULL;
+        void             *tmp = NULL;
+
+        if (!client)
+                return conf->no_client;
+
+        client_ctx_get (client, conf->this, &tmp);
+        if (tmp)
+                return tmp;
+
+        pthread_mutex_lock (&conf->mutex);
+        {
+                client_ctx_get (client, conf->this, &tmp);
+                if (tmp) {
+                        ctx = tmp;
+                        goto unlock;
+                }
+
+                ctx = iot_client_ctx_new (conf, client);
+                if (!ctx)
+                        goto unlock;
+
+                if (client_ctx_set (client, conf->this, ctx) != 0) {
+                        GF_FREE (ctx);
+                        ctx = NULL;
+                        goto unlock;
+                }
+
+                list_add_tail (&ctx->clients, &conf->clients);
+        }
+unlock:
+        pthread_mutex_unlock (&conf->mutex);
+
+        return ctx;
+}
+
+
+/*
+ * Requests on the same gfid (or, for entry operations on new names, the
+ * same parent directory) are routed to the same queue, so that the worker
+ * serving them finds the inode contexts and locks in its cache.
+ */
+static iot_shard_t *
+iot_stub_shard (iot_conf_t *conf, call_stub_t *stub)
+{
+        inode_t       *inode = NULL;
+        unsigned char *gfid  = NULL;
+        uint32_t       hash  = 0;
+
+        if (conf->shard_count == 1)
+                return &conf->shards[0];
+
+        if (stub->args.fd)
+                inode = stub->args.fd->inode;
+        else
+                inode = stub->args.loc.inode;
+
+        if (inode && !gf_uuid_is_null (inode->gfid))
+                gfid = inode->gfid;
+        else if (!gf_uuid_is_null (stub->args.loc.gfid))
+                gfid = stub->args.loc.gfid;
+        else if (!gf_uuid_is_null (stub->args.loc.pargfid))
+                gfid = stub->args.loc.pargfid;
+
+        if (gfid)
+                hash = (gfid[12] << 24) | (gfid[13] << 16) |
+                       (gfid[14] << 8) | gfid[15];
+        else
+                hash = __sync_fetch_and_add (&conf->next_shard, 1);
+
+        return &conf->shards[hash % conf->shard_count];
+}
+
+
+/*
+ * The *-prio-threads limits are shared by all queues, take a slot of
+ * priority @pri without holding any of the queue locks.
+ */
+static gf_boolean_t
+iot_pri_acquire (iot_conf_t *conf, int pri)
+{
+        int32_t count = 0;
+
+        do {
+                count = conf->ac_iot_count[pri];
+                if (count >= conf->ac_iot_limit[pri])
+                        return _gf_false;
+        } while (!__sync_bool_compare_and_swap (&conf->ac_iot_count[pri],
+                                                count, count + 1));
+
+        return _gf_true;
+}
+
+
+static void
+iot_pri_release (iot_conf_t *conf, int pri)
+{
+        __sync_sub_and_fetch (&conf->ac_iot_count[pri], 1);
+}
+
+
+/*
+ * Deficit round robin among the clients with queued requests of priority
+ * @pri. A client is served as long as its deficit covers the cost of its
+ * oldest request, otherwise it is topped up and moved behind the others.
+ */
+static call_stub_t *
+__iot_fair_dequeue (iot_shard_t *shard, int pri)
+{
+        iot_client_queue_t *queue = NULL;
+        call_stub_t        *stub  = NULL;
+        struct timeval      now   = {0, };
+        uint64_t            wait  = 0;
+        int                 cost  = 0;
+
+        while (!list_empty (&shard->fair_sched[pri])) {
+                queue = list_entry (shard->fair_sched[pri].next,
+                                    iot_client_queue_t, sched[pri]);
+                stub = list_entry (queue->reqs[pri].next, call_stub_t, list);
+
+                cost = iot_stub_cost (stub);
+                if (queue->deficit[pri] >= cost)
+                        break;
+
+                queue->deficit[pri] += IOT_FAIR_QUANTUM;
+                list_move_tail (&queue->sched[pri], &shard->fair_sched[pri]);
+                stub = NULL;
+        }
+
+        if (!stub)
+                return NULL;
+
+        list_del_init (&stub->list);
+        queue->deficit[pri] -= cost;
+
+        if (--queue->queue_sizes[pri] == 0) {
+                list_del_init (&queue->sched[pri]);
+                queue->deficit[pri] = 0;
+        }
+
+        gettimeofday (&now, NULL);
+        wait = (now.tv_sec - stub->queued.tv_sec) * 1000000
+               + (now.tv_usec - stub->queued.tv_usec);
+
+        queue->served++;
+        queue->wait_usec += wait;
+        if (wait > queue->max_wait_usec)
+                queue->max_wait_usec = wait;
+
+        return stub;
+}
+
+
+static call_stub_t *
+__iot_dequeue_pri (iot_shard_t *shard, int pri)
+{
+        call_stub_t *stub = NULL;
+
+        /* requests queued before fair queueing got enabled go first */
+        if (!list_empty (&shard->reqs[pri])) {
+                stub = list_entry (shard->reqs[pri].next, call_stub_t, list);
+                list_del_init (&stub->list);
+                return stub;
+        }
+
+        return __iot_fair_dequeue (shard, pri);
+}
+
+
 call_stub_t *
-__iot_dequeue (iot_conf_t *conf, int *pri, struct timespec *sleep)
+__iot_dequeue (iot_conf_t *conf, iot_shard_t *shard, int *pri,
+               struct timespec *sleep)
 {
         call_stub_t  *stub = NULL;
         int           i = 0;
@@ -59,8 +281,8 @@ __iot_dequeue (iot_conf_t *conf, int *pri, struct timespec *sleep)
 	sleep->tv_sec = 0;
 	sleep->tv_nsec = 0;
         for (i = 0; i < IOT_PRI_MAX; i++) {
-                if (list_empty (&conf->reqs[i]) ||
-                   (conf->ac_iot_count[i] >= conf->ac_iot_limit[i]))
+                if ((shard->queue_sizes[i] == 0) ||
+                    !iot_pri_acquire (conf, i))
                         continue;
 
 		if (i == IOT_PRI_LEAST) {
@@ -105,6 +327,7 @@ __iot_dequeue (iot_conf_t *conf, int *pri, struct timespec *sleep)
 
 					pthread_mutex_unlock(
 						&conf->throttle.lock);
+                                        iot_pri_release (conf, i);
 					break;
 				}
 			}
@@ -112,8 +335,7 @@ __iot_dequeue (iot_conf_t *conf, int *pri, struct timespec *sleep)
 			pthread_mutex_unlock(&conf->throttle.lock);
 		}
 
-                stub = list_entry (conf->reqs[i].next, call_stub_t, list);
-                conf->ac_iot_count[i]++;
+                stub = __iot_dequeue_pri (shard, i);
                 *pri = i;
                 break;
         }
@@ -121,34 +343,134 @@ __iot_dequeue (iot_conf_t *conf, int *pri, struct timespec *sleep)
         if (!stub)
                 return NULL;
 
-        conf->queue_size--;
-        conf->queue_sizes[*pri]--;
-        list_del_init (&stub->list);
+        shard->queue_size--;
+        shard->queue_sizes[*pri]--;
+        __sync_sub_and_fetch (&conf->queue_size, 1);
 
         return stub;
 }
 
 
 void
-__iot_enqueue (iot_conf_t *conf, call_stub_t *stub, int pri)
+__iot_enqueue (iot_conf_t *conf, iot_shard_t *shard, iot_client_ctx_t *ctx,
+               call_stub_t *stub, int pri)
 {
+        iot_client_queue_t *queue = NULL;
+
         if (pri < 0 || pri >= IOT_PRI_MAX)
                 pri = IOT_PRI_MAX-1;
 
-        list_add_tail (&stub->list, &conf->reqs[pri]);
+        if (ctx) {
+                queue = &ctx->queues[shard->index];
+                gettimeofday (&stub->queued, NULL);
+                list_add_tail (&stub->list, &queue->reqs[pri]);
+                if (queue->queue_sizes[pri]++ == 0)
+                        list_add_tail (&queue->sched[pri],
+                                       &shard->fair_sched[pri]);
+        } else {
+                list_add_tail (&stub->list, &shard->reqs[pri]);
+        }
 
-        conf->queue_size++;
-        conf->queue_sizes[pri]++;
+        shard->queue_size++;
+        shard->queue_sizes[pri]++;
+        __sync_add_and_fetch (&conf->queue_size, 1);
 
         return;
 }
 
 
+/*
+ * Look for work in the queues of other workers when the home queue is
+ * empty. Busy queues are skipped rather than waited for, the caller
+ * comes back as long as requests are queued anywhere.
+ */
+static call_stub_t *
+iot_steal (iot_conf_t *conf, iot_shard_t *home, int *pri,
+           struct timespec *sleep)
+{
+        iot_shard_t *shard = NULL;
+        call_stub_t *stub  = NULL;
+        int          i     = 0;
+
+        for (i = 1; i < conf->shard_count; i++) {
+                shard = &conf->shards[(home->index + i) % conf->shard_count];
+
+                if (!shard->queue_size)
+                        continue;
+
+                if (pthread_mutex_trylock (&shard->mutex) != 0)
+                        continue;
+                {
+                        stub = __iot_dequeue (conf, shard, pri, sleep);
+                        if (stub)
+                                shard->stolen++;
+                }
+                pthread_mutex_unlock (&shard->mutex);
+
+                if (stub || sleep->tv_sec || sleep->tv_nsec)
+                        break;
+        }
+
+        return stub;
+}
+
+
+static iot_shard_t *
+iot_worker_home (iot_conf_t *conf)
+{
+        iot_shard_t *home = NULL;
+        int          i    = 0;
+
+        pthread_mutex_lock (&conf->mutex);
+        {
+                home = &conf->shards[0];
+                for (i = 1; i < conf->shard_count; i++) {
+                        if (conf->shards[i].worker_count < home->worker_count)
+                                home = &conf->shards[i];
+                }
+                home->worker_count++;
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
+        return home;
+}
+
+
+/*
+ * Move the calling worker to where the thread-placement option wants it,
+ * when the option has changed since the worker last looked.
+ */
+static void
+iot_worker_place (iot_conf_t *conf, int index, uint32_t *gen)
+{
+        char placement[GF_THREAD_PLACEMENT_MAX];
+        int  ret = 0;
+
+        if (*gen == __sync_add_and_fetch (&conf->placement_gen, 0))
+                return;
+
+        pthread_mutex_lock (&conf->mutex);
+        {
+                *gen = conf->placement_gen;
+                strcpy (placement, conf->placement);
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
+        ret = gf_thread_set_placement (pthread_self (), placement, index);
+        if (ret)
+                gf_msg (conf->this->name, GF_LOG_WARNING, ret,
+                        IO_THREADS_MSG_PLACEMENT_FAILED,
+                        "failed to apply thread placement \"%s\" to "
+                        "worker %d", placement, index);
+}
+
+
 void *
 iot_worker (void *data)
 {
         iot_conf_t       *conf = NULL;
         xlator_t         *this = NULL;
+        iot_shard_t      *home = NULL;
         call_stub_t      *stub = NULL;
         struct timespec   sleep_till = {0, };
         int               ret = 0;
@@ -156,37 +478,52 @@ iot_worker (void *data)
         char              timeout = 0;
         char              bye = 0;
 	struct timespec	  sleep = {0,};
+        int               index = 0;
+        uint32_t          placement_gen = 0;
 
         conf = data;
         this = conf->this;
         THIS = this;
 
+        home = iot_worker_home (conf);
+        index = __sync_fetch_and_add (&conf->next_worker, 1);
+
         for (;;) {
+                iot_worker_place (conf, index, &placement_gen);
+
                 sleep_till.tv_sec = time (NULL) + conf->idle_time;
 
-                pthread_mutex_lock (&conf->mutex);
-                {
-                        if (pri != -1) {
-                                conf->ac_iot_count[pri]--;
-                                pri = -1;
-                        }
-                        while (conf->queue_size == 0) {
-                                conf->sleep_count++;
+                if (pri != -1) {
+                        iot_pri_release (conf, pri);
+                        pri = -1;
+                }
 
-                                ret = pthread_cond_timedwait (&conf->cond,
-                                                              &conf->mutex,
+                pthread_mutex_lock (&home->mutex);
+                {
+                        /* a request queued anywhere is worth waking up for */
+                        home->sleep_count++;
+                        while (__sync_add_and_fetch (&conf->queue_size,
+                                                     0) == 0) {
+                                ret = pthread_cond_timedwait (&home->cond,
+                                                              &home->mutex,
                                                               &sleep_till);
-                                conf->sleep_count--;
-
                                 if (ret == ETIMEDOUT) {
                                         timeout = 1;
                                         break;
                                 }
                         }
+                        home->sleep_count--;
+
+                        stub = __iot_dequeue (conf, home, &pri, &sleep);
+                }
+                pthread_mutex_unlock (&home->mutex);
 
-                        if (timeout) {
+                if (timeout) {
+                        pthread_mutex_lock (&conf->mutex);
+                        {
                                 if (conf->curr_count > IOT_MIN_THREADS) {
                                         conf->curr_count--;
+                                        home->worker_count--;
                                         bye = 1;
                                         gf_msg_debug (conf->this->name, 0,
                                                       "timeout, terminated. conf->curr_count=%d",
@@ -195,16 +532,21 @@ iot_worker (void *data)
                                         timeout = 0;
                                 }
                         }
+                        pthread_mutex_unlock (&conf->mutex);
+                }
 
-                        stub = __iot_dequeue (conf, &pri, &sleep);
-			if (!stub && (sleep.tv_sec || sleep.tv_nsec)) {
-				pthread_cond_timedwait(&conf->cond,
-						       &conf->mutex, &sleep);
-				pthread_mutex_unlock(&conf->mutex);
-				continue;
-			}
+                if (!stub && !sleep.tv_sec && !sleep.tv_nsec)
+                        stub = iot_steal (conf, home, &pri, &sleep);
+
+                if (!stub && (sleep.tv_sec || sleep.tv_nsec)) {
+                        pthread_mutex_lock (&home->mutex);
+                        {
+                                pthread_cond_timedwait (&home->cond,
+                                                        &home->mutex, &sleep);
+                        }
+                        pthread_mutex_unlock (&home->mutex);
+                        continue;
                 }
-                pthread_mutex_unlock (&conf->mutex);
 
                 if (stub) /* guard against spurious wakeups */
                         call_resume (stub);
@@ -213,31 +555,71 @@ iot_worker (void *data)
                         break;
         }
 
-        if (pri != -1) {
-                pthread_mutex_lock (&conf->mutex);
+        if (pri != -1)
+                iot_pri_release (conf, pri);
+
+        return NULL;
+}
+
+
+/*
+ * Wake up an idle worker of any queue to steal the request that was just
+ * queued, when all workers of its own queue are busy.
+ */
+static gf_boolean_t
+iot_wake_other (iot_conf_t *conf, iot_shard_t *busy)
+{
+        iot_shard_t *shard = NULL;
+        int          i     = 0;
+
+        for (i = 1; i < conf->shard_count; i++) {
+                shard = &conf->shards[(busy->index + i) % conf->shard_count];
+
+                if (!shard->sleep_count)
+                        continue;
+
+                pthread_mutex_lock (&shard->mutex);
                 {
-                        conf->ac_iot_count[pri]--;
+                        pthread_cond_signal (&shard->cond);
                 }
-                pthread_mutex_unlock (&conf->mutex);
+                pthread_mutex_unlock (&shard->mutex);
+
+                return _gf_true;
         }
-        return NULL;
+
+        return _gf_false;
 }
 
 
 int
 do_iot_schedule (iot_conf_t *conf, call_stub_t *stub, int pri)
 {
-        int   ret = 0;
+        iot_shard_t      *shard = NULL;
+        iot_client_ctx_t *ctx   = NULL;
+        gf_boolean_t      woken = _gf_false;
+        int               ret   = 0;
 
-        pthread_mutex_lock (&conf->mutex);
-        {
-                __iot_enqueue (conf, stub, pri);
+        shard = iot_stub_shard (conf, stub);
 
-                pthread_cond_signal (&conf->cond);
+        if (conf->fair_queueing)
+                ctx = iot_client_ctx_get (conf, stub->frame->root->client);
 
-                ret = __iot_workers_scale (conf);
+        pthread_mutex_lock (&shard->mutex);
+        {
+                __iot_enqueue (conf, shard, ctx, stub, pri);
+
+                if (shard->sleep_count) {
+                        pthread_cond_signal (&shard->cond);
+                        woken = _gf_true;
+                }
         }
-        pthread_mutex_unlock (&conf->mutex);
+        pthread_mutex_unlock (&shard->mutex);
+
+        if (!woken)
+                woken = iot_wake_other (conf, shard);
+
+        if (!woken && conf->curr_count < conf->max_count)
+                ret = iot_workers_scale (conf);
 
         return ret;
 }
@@ -744,9 +1126,15 @@ __iot_workers_scale (iot_conf_t *conf)
         pthread_t thread;
         int       ret = 0;
         int       i = 0;
+        int       j = 0;
+        int       queued = 0;
 
-        for (i = 0; i < IOT_PRI_MAX; i++)
-                scale += min (conf->queue_sizes[i], conf->ac_iot_limit[i]);
+        for (i = 0; i < IOT_PRI_MAX; i++) {
+                queued = 0;
+                for (j = 0; j < conf->shard_count; j++)
+                        queued += conf->shards[j].queue_sizes[i];
+                scale += min (queued, conf->ac_iot_limit[i]);
+        }
 
         if (scale < IOT_MIN_THREADS)
                 scale = IOT_MIN_THREADS;
@@ -846,10 +1234,77 @@ mem_acct_init (xlator_t *this)
         return ret;
 }
 
+static void
+iot_client_ctx_dump (iot_conf_t *conf, iot_client_ctx_t *ctx, int idx)
+{
+        iot_client_queue_t *queue         = NULL;
+        char                key[GF_DUMP_MAX_BUF_LEN];
+        int                 queue_size    = 0;
+        uint64_t            served        = 0;
+        uint64_t            wait_usec     = 0;
+        uint64_t            max_wait_usec = 0;
+        int                 i             = 0;
+        int                 j             = 0;
+
+        snprintf (key, sizeof (key), "client[%d].client_uid", idx);
+        gf_proc_dump_write (key, "%s", ctx->client ? ctx->client->client_uid
+                                                   : "<none>");
+
+        for (i = 0; i < IOT_PRI_MAX; i++) {
+                queue_size = 0;
+                for (j = 0; j < conf->shard_count; j++)
+                        queue_size += ctx->queues[j].queue_sizes[i];
+
+                snprintf (key, sizeof (key), "client[%d].queue_size[%d]",
+                          idx, i);
+                gf_proc_dump_write (key, "%d", queue_size);
+        }
+
+        for (j = 0; j < conf->shard_count; j++) {
+                queue = &ctx->queues[j];
+                served += queue->served;
+                wait_usec += queue->wait_usec;
+                if (queue->max_wait_usec > max_wait_usec)
+                        max_wait_usec = queue->max_wait_usec;
+        }
+
+        snprintf (key, sizeof (key), "client[%d].served", idx);
+        gf_proc_dump_write (key, "%"PRIu64, served);
+
+        snprintf (key, sizeof (key), "client[%d].avg_wait_usec", idx);
+        gf_proc_dump_write (key, "%"PRIu64, served ? wait_usec / served : 0);
+
+        snprintf (key, sizeof (key), "client[%d].max_wait_usec", idx);
+        gf_proc_dump_write (key, "%"PRIu64, max_wait_usec);
+}
+
+
+static void
+iot_shard_dump (iot_shard_t *shard)
+{
+        char  key[GF_DUMP_MAX_BUF_LEN];
+
+        snprintf (key, sizeof (key), "queue[%d].queue_size", shard->index);
+        gf_proc_dump_write (key, "%d", shard->queue_size);
+
+        snprintf (key, sizeof (key), "queue[%d].workers", shard->index);
+        gf_proc_dump_write (key, "%d", shard->worker_count);
+
+        snprintf (key, sizeof (key), "queue[%d].sleep_count", shard->index);
+        gf_proc_dump_write (key, "%d", shard->sleep_count);
+
+        snprintf (key, sizeof (key), "queue[%d].stolen", shard->index);
+        gf_proc_dump_write (key, "%"PRIu64, shard->stolen);
+}
+
+
 int
 iot_priv_dump (xlator_t *this)
 {
-        iot_conf_t     *conf   =   NULL;
+        iot_conf_t       *conf   =   NULL;
+        iot_client_ctx_t *ctx    =   NULL;
+        int               i      =   0;
+        int               sleep_count = 0;
         char           key_prefix[GF_DUMP_MAX_BUF_LEN];
 
         if (!this)
@@ -866,7 +1321,9 @@ iot_priv_dump (xlator_t *this)
 
         gf_proc_dump_write("maximum_threads_count", "%d", conf->max_count);
         gf_proc_dump_write("current_threads_count", "%d", conf->curr_count);
-        gf_proc_dump_write("sleep_count", "%d", conf->sleep_count);
+        for (i = 0; i < conf->shard_count; i++)
+                sleep_count += conf->shards[i].sleep_count;
+        gf_proc_dump_write("sleep_count", "%d", sleep_count);
         gf_proc_dump_write("idle_time", "%d", conf->idle_time);
         gf_proc_dump_write("stack_size", "%zd", conf->stack_size);
         gf_proc_dump_write("high_priority_threads", "%d",
@@ -882,14 +1339,54 @@ iot_priv_dump (xlator_t *this)
 			   conf->throttle.cached_rate);
 	gf_proc_dump_write("least rate limit", "%u", conf->throttle.rate_limit);
 
+        gf_proc_dump_write("queue_count", "%d", conf->shard_count);
+        for (i = 0; i < conf->shard_count; i++)
+                iot_shard_dump (&conf->shards[i]);
+
+        gf_proc_dump_write("fair_queueing", "%d", conf->fair_queueing);
+        gf_proc_dump_write("thread_placement", "%s", conf->placement);
+
+        if (pthread_mutex_trylock (&conf->mutex) != 0)
+                return 0;
+        {
+                i = 0;
+                list_for_each_entry (ctx, &conf->clients, clients) {
+                        iot_client_ctx_dump (conf, ctx, i++);
+                }
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
         return 0;
 }
 
+static void
+iot_set_placement (iot_conf_t *conf, const char *placement)
+{
+        if (gf_thread_placement_validate (placement) != 0) {
+                gf_msg (conf->this->name, GF_LOG_WARNING, EINVAL,
+                        IO_THREADS_MSG_PLACEMENT_FAILED,
+                        "invalid thread placement \"%s\"", placement);
+                return;
+        }
+
+        pthread_mutex_lock (&conf->mutex);
+        {
+                if (strcmp (conf->placement, placement) != 0) {
+                        strncpy (conf->placement, placement,
+                                 sizeof (conf->placement) - 1);
+                        __sync_add_and_fetch (&conf->placement_gen, 1);
+                }
+        }
+        pthread_mutex_unlock (&conf->mutex);
+}
+
+
 int
 reconfigure (xlator_t *this, dict_t *options)
 {
 	iot_conf_t      *conf = NULL;
 	int		 ret = -1;
+        char            *placement = NULL;
 
         conf = this->private;
         if (!conf)
@@ -916,18 +1413,59 @@ reconfigure (xlator_t *this, dict_t *options)
 	GF_OPTION_RECONF("least-rate-limit", conf->throttle.rate_limit, options,
 			 int32, out);
 
+        GF_OPTION_RECONF ("fair-queueing", conf->fair_queueing, options, bool,
+                          out);
+
+        GF_OPTION_RECONF ("thread-placement", placement, options, str, out);
+        iot_set_placement (conf, placement);
+
 	ret = 0;
 out:
 	return ret;
 }
 
 
+static int
+iot_shards_init (iot_conf_t *conf)
+{
+        iot_shard_t *shard = NULL;
+        int          ret   = 0;
+        int          i     = 0;
+        int          j     = 0;
+
+        conf->shards = GF_CALLOC (conf->shard_count, sizeof (*conf->shards),
+                                  gf_iot_mt_shard_t);
+        if (!conf->shards)
+                return -ENOMEM;
+
+        for (i = 0; i < conf->shard_count; i++) {
+                shard = &conf->shards[i];
+                shard->index = i;
+
+                ret = pthread_mutex_init (&shard->mutex, NULL);
+                if (ret)
+                        return ret;
+
+                ret = pthread_cond_init (&shard->cond, NULL);
+                if (ret)
+                        return ret;
+
+                for (j = 0; j < IOT_PRI_MAX; j++) {
+                        INIT_LIST_HEAD (&shard->reqs[j]);
+                        INIT_LIST_HEAD (&shard->fair_sched[j]);
+                }
+        }
+
+        return 0;
+}
+
+
 int
 init (xlator_t *this)
 {
         iot_conf_t *conf = NULL;
         int         ret  = -1;
-        int         i    = 0;
+        char       *placement = NULL;
 
 	if (!this->children || this->children->next) {
 		gf_msg ("io-threads", GF_LOG_ERROR, 0,
@@ -951,13 +1489,6 @@ init (xlator_t *this)
                 goto out;
         }
 
-        if ((ret = pthread_cond_init(&conf->cond, NULL)) != 0) {
-                gf_msg (this->name, GF_LOG_ERROR, 0,
-                        IO_THREADS_MSG_INIT_FAILED,
-                        "pthread_cond_init failed (%d)", ret);
-                goto out;
-        }
-
         if ((ret = pthread_mutex_init(&conf->mutex, NULL)) != 0) {
                 gf_msg (this->name, GF_LOG_ERROR, 0,
                         IO_THREADS_MSG_INIT_FAILED,
@@ -994,12 +1525,33 @@ init (xlator_t *this)
                 goto out;
         }
 
+        GF_OPTION_INIT ("fair-queueing", conf->fair_queueing, bool, out);
+
+        GF_OPTION_INIT ("queue-count", conf->shard_count, int32, out);
+
         conf->this = this;
 
-        for (i = 0; i < IOT_PRI_MAX; i++) {
-                INIT_LIST_HEAD (&conf->reqs[i]);
+        /* workers start out wherever the process runs */
+        strcpy (conf->placement, "none");
+        GF_OPTION_INIT ("thread-placement", placement, str, out);
+        iot_set_placement (conf, placement);
+
+        ret = iot_shards_init (conf);
+        if (ret) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        IO_THREADS_MSG_INIT_FAILED,
+                        "request queue initialization failed (%d)", ret);
+                goto out;
         }
 
+        INIT_LIST_HEAD (&conf->clients);
+        conf->no_client = iot_client_ctx_new (conf, NULL);
+        if (!conf->no_client) {
+                ret = -1;
+                goto out;
+        }
+        list_add_tail (&conf->no_client->clients, &conf->clients);
+
 	ret = iot_workers_scale (conf);
 
         if (ret == -1) {
@@ -1012,8 +1564,11 @@ init (xlator_t *this)
 	this->private = conf;
         ret = 0;
 out:
-        if (ret)
+        if (ret && conf) {
+                GF_FREE (conf->no_client);
+                GF_FREE (conf->shards);
                 GF_FREE (conf);
+        }
 
 	return ret;
 }
@@ -1024,12 +1579,45 @@ fini (xlator_t *this)
 {
 	iot_conf_t *conf = this->private;
 
+        if (conf) {
+                GF_FREE (conf->no_client);
+                GF_FREE (conf->shards);
+        }
 	GF_FREE (conf);
 
 	this->private = NULL;
 	return;
 }
 
+int
+iot_client_destroy (xlator_t *this, client_t *client)
+{
+        iot_conf_t       *conf = NULL;
+        iot_client_ctx_t *ctx  = NULL;
+        void             *tmp  = NULL;
+
+        conf = this->private;
+        if (!conf)
+                return 0;
+
+        client_ctx_del (client, this, &tmp);
+        if (!tmp)
+                return 0;
+
+        ctx = tmp;
+
+        /* every queued request holds a ref on the client */
+        pthread_mutex_lock (&conf->mutex);
+        {
+                list_del_init (&ctx->clients);
+        }
+        pthread_mutex_unlock (&conf->mutex);
+
+        GF_FREE (ctx);
+
+        return 0;
+}
+
 struct xlator_dumpops dumpops = {
         .priv    = iot_priv_dump,
 };
@@ -1081,7 +1669,9 @@ struct xlator_fops fops = {
         .zerofill    = iot_zerofill,
 };
 
-struct xlator_cbks cbks;
+struct xlator_cbks cbks = {
+        .client_destroy = iot_client_destroy,
+};
 
 struct volume_options options[] = {
 	{ .key  = {"thread-count"},
@@ -1147,6 +1737,32 @@ struct volume_options options[] = {
 	 .description = "Max number of least priority operations to handle "
 			"per-second"
 	},
+        { .key  = {"queue-count"},
+          .type = GF_OPTION_TYPE_INT,
+          .min  = 1,
+          .max  = IOT_MAX_THREADS,
+          .default_value = "1",
+          .description = "Number of request queues the worker threads are "
+                         "spread over. Requests on the same file go to the "
+                         "same queue, idle workers steal from the others. "
+                         "Takes effect on restart of the process"
+        },
+        { .key  = {"fair-queueing"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Queue requests per client and serve the clients "
+                         "of each priority by deficit round robin, so that "
+                         "a client with a deep queue can not starve others"
+        },
+        { .key  = {"thread-placement"},
+          .type = GF_OPTION_TYPE_STR,
+          .default_value = "none",
+          .description = "Placement of the worker threads on CPUs: none "
+                         "(as inherited at startup, e.g. from taskset), "
+                         "spread (worker n on online CPU n), nodes (worker "
+                         "n on NUMA node n), node:<N> (all on NUMA node N) "
+                         "or cpus:<list> (all on the listed CPUs)"
+        },
 	{ .key  = {NULL},
         },
 };
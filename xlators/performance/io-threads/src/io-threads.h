@@ -24,6 +24,7 @@
 #include "iot-mem-types.h"
 #include <semaphore.h>
 #include "statedump.h"
+#include "client_t.h"
 
 
 struct iot_conf;
@@ -57,22 +58,65 @@ struct iot_least_throttle {
 	pthread_mutex_t	lock;
 };
 
-struct iot_conf {
+/* cost of a request in fair queueing, in units of IOT_FAIR_COST_UNIT bytes */
+#define IOT_FAIR_COST_UNIT      (128 * 1024)
+#define IOT_FAIR_QUANTUM        1
+
+/*
+ * Requests of a single client in one of the request queues, served by
+ * deficit round robin against the other clients with queued requests of
+ * the same priority.
+ */
+typedef struct iot_client_queue {
+        struct list_head     reqs[IOT_PRI_MAX];
+        struct list_head     sched[IOT_PRI_MAX]; /* in shard->fair_sched[] */
+        int32_t              deficit[IOT_PRI_MAX];
+        int                  queue_sizes[IOT_PRI_MAX];
+        uint64_t             served;
+        uint64_t             wait_usec;          /* total time spent queued */
+        uint64_t             max_wait_usec;
+} iot_client_queue_t;
+
+typedef struct iot_client_ctx {
+        struct list_head     clients;            /* in conf->clients */
+        client_t            *client;             /* NULL: internal requests */
+        iot_client_queue_t   queues[];           /* one per request queue */
+} iot_client_ctx_t;
+
+/*
+ * A request queue. Each worker serves the queue it was assigned to and
+ * steals from the others when that one runs dry.
+ */
+typedef struct iot_shard {
         pthread_mutex_t      mutex;
         pthread_cond_t       cond;
+        int                  index;
+        struct list_head     reqs[IOT_PRI_MAX];
+        /* clients with queued requests, when fair queueing */
+        struct list_head     fair_sched[IOT_PRI_MAX];
+        int                  queue_sizes[IOT_PRI_MAX];
+        int                  queue_size;
+        int32_t              sleep_count;
+        int32_t              worker_count;       /* protected by conf->mutex */
+        uint64_t             stolen;
+} iot_shard_t;
+
+struct iot_conf {
+        /* protects thread scaling and the list of clients */
+        pthread_mutex_t      mutex;
 
         int32_t              max_count;   /* configured maximum */
         int32_t              curr_count;  /* actual number of threads running */
-        int32_t              sleep_count;
 
         int32_t              idle_time;   /* in seconds */
 
-        struct list_head     reqs[IOT_PRI_MAX];
+        iot_shard_t         *shards;
+        int32_t              shard_count;
+        uint32_t             next_shard;
 
         int32_t              ac_iot_limit[IOT_PRI_MAX];
         int32_t              ac_iot_count[IOT_PRI_MAX];
-        int                  queue_sizes[IOT_PRI_MAX];
-        int                  queue_size;
+        int                  queue_size;  /* all queues, updated atomically */
         pthread_attr_t       w_attr;
         gf_boolean_t         least_priority; /*Enable/Disable least-priority */
 
@@ -80,6 +124,15 @@ struct iot_conf {
         size_t              stack_size;
 
 	struct iot_least_throttle throttle;
+
+        gf_boolean_t         fair_queueing;
+        struct list_head     clients;
+        iot_client_ctx_t    *no_client;  /* requests without a client_t */
+
+        /* CPU placement of the workers, see gf_thread_set_placement() */
+        char                 placement[GF_THREAD_PLACEMENT_MAX];
+        uint32_t             placement_gen;  /* bumped on every change */
+        uint32_t             next_worker;    /* placement index */
 };
 
 typedef struct iot_conf iot_conf_t;
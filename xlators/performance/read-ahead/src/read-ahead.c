@@ -25,8 +25,27 @@
 #include <sys/time.h>
 #include "read-ahead-messages.h"
 
+/* a read at most this far past the previous one of a young stream is
+ * taken for the second read of a strided stream */
+#define RA_MAX_STRIDE(file)     (64 * (file)->page_size)
+
+/* upper bound of page-count */
+#define RA_MAX_WINDOW           16
+
 static void
-read_ahead (call_frame_t *frame, ra_file_t *file);
+read_ahead (call_frame_t *frame, ra_file_t *file, int stream);
+
+
+/* pages are kept whole multiples of a disperse stripe below us, so that
+ * no read ahead ends in a partial stripe */
+static uint64_t
+ra_file_page_size (ra_conf_t *conf)
+{
+        if (conf->stripe_size <= 1)
+                return conf->page_size;
+
+        return roof (conf->page_size, conf->stripe_size);
+}
 
 
 int
@@ -58,7 +77,6 @@ ra_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
                 file->disabled = 1;
 
-        file->offset = (unsigned long long) 0;
         file->conf = conf;
         file->pages.next = &file->pages;
         file->pages.prev = &file->pages;
@@ -75,14 +93,9 @@ ra_open_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         ra_conf_unlock (conf);
 
         file->fd = fd;
-        file->page_count = conf->page_count;
-        file->page_size = conf->page_size;
+        file->page_size = ra_file_page_size (conf);
         pthread_mutex_init (&file->file_lock, NULL);
 
-        if (!file->disabled) {
-                file->page_count = 1;
-        }
-
         ret = fd_ctx_set (fd, this, (uint64_t)(long)file);
         if (ret == -1) {
                 gf_msg (frame->this->name, GF_LOG_WARNING,
@@ -135,7 +148,6 @@ ra_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
                 file->disabled = 1;
 
-        file->offset = (unsigned long long) 0;
         //file->size = fd->inode->buf.ia_size;
         file->conf = conf;
         file->pages.next = &file->pages;
@@ -153,8 +165,7 @@ ra_create_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
         ra_conf_unlock (conf);
 
         file->fd = fd;
-        file->page_count = conf->page_count;
-        file->page_size = conf->page_size;
+        file->page_size = ra_file_page_size (conf);
         pthread_mutex_init (&file->file_lock, NULL);
 
         ret = fd_ctx_set (fd, this, (uint64_t)(long)file);
@@ -265,75 +276,249 @@ out:
 }
 
 
+/* prefetch window of @stream: pages for a sequential stream, reads for a
+ * strided one */
+static uint32_t
+ra_stream_window (ra_file_t *file, ra_stream_t *stream)
+{
+        uint64_t window = 0;
+
+        if (!stream->hits)
+                return 0;
+
+        if (stream->stride)
+                window = 2 * stream->hits;
+        else
+                window = roof (2 * stream->run, file->page_size)
+                         / file->page_size;
+
+        return min (window, min (file->conf->page_count, RA_MAX_WINDOW));
+}
+
+
+/* a page read ahead for @idx was dropped unused: slow the stream down */
 void
-read_ahead (call_frame_t *frame, ra_file_t *file)
+__ra_stream_wasted (ra_file_t *file, int idx)
 {
-        off_t      ra_offset   = 0;
-        size_t     ra_size     = 0;
-        off_t      trav_offset = 0;
-        ra_page_t *trav        = NULL;
-        off_t      cap         = 0;
-        char       fault       = 0;
+        ra_stream_t *stream = NULL;
 
-        GF_VALIDATE_OR_GOTO ("read-ahead", frame, out);
-        GF_VALIDATE_OR_GOTO (frame->this->name, file, out);
+        RA_STAT_INC (file->conf, wasted);
 
-        if (!file->page_count) {
-                goto out;
-        }
+        if ((idx < 0) || (idx >= RA_MAX_STREAMS))
+                return;
 
-        ra_size   = file->page_size * file->page_count;
-        ra_offset = floor (file->offset, file->page_size);
-        cap       = file->size ? file->size : file->offset + ra_size;
+        stream = &file->streams[idx];
 
-        while (ra_offset < min (file->offset + ra_size, cap)) {
+        stream->run /= 2;
+        if (stream->hits > 1)
+                stream->hits /= 2;
+}
 
-                ra_file_lock (file);
-                {
-                        trav = ra_page_get (file, ra_offset);
+
+/* drops the pages read for stream @idx which start before @end */
+static void
+__ra_stream_purge (ra_file_t *file, int idx, off_t end)
+{
+        ra_page_t *trav = NULL;
+        ra_page_t *next = NULL;
+
+        trav = file->pages.next;
+        while (trav != &file->pages && trav->offset < end) {
+                next = trav->next;
+                if (trav->stream == idx) {
+                        if (!trav->waitq) {
+                                /* evicted before any read asked for it */
+                                if (trav->dirty)
+                                        __ra_stream_wasted (file, idx);
+                                ra_page_purge (trav);
+                        } else {
+                                trav->stale = 1;
+                        }
                 }
-                ra_file_unlock (file);
+                trav = next;
+        }
+}
 
-                if (!trav)
-                        break;
 
-                ra_offset += file->page_size;
+static void
+__ra_streams_reset (ra_file_t *file)
+{
+        int i = 0;
+
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                file->streams[i].run = 0;
+                file->streams[i].hits = 0;
+                file->streams[i].ahead = 0;
         }
+}
 
-        if (trav) {
-                /* comfortable enough */
-                goto out;
+
+/*
+ * Finds the stream a read of @size bytes at @offset belongs to: the one
+ * it directly follows, the one it is a stride past, or a young stream it
+ * makes a strided one of. Otherwise the read starts a new stream in place
+ * of the least recently used one. Returns the stream's index.
+ */
+static int
+__ra_stream_match (ra_file_t *file, off_t offset, size_t size)
+{
+        ra_stream_t *stream = NULL;
+        ra_stream_t *lru    = NULL;
+        off_t        next   = 0;
+        int          i      = 0;
+
+        file->clock++;
+
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                stream = &file->streams[i];
+
+                if (!stream->active) {
+                        if (!lru || lru->active)
+                                lru = stream;
+                        continue;
+                }
+
+                if (!lru || (lru->active && (stream->used < lru->used)))
+                        lru = stream;
+
+                next = stream->last + stream->size;
+
+                if (offset == next) {
+                        stream->stride = 0;
+                        goto hit;
+                }
+
+                if (stream->stride &&
+                    (offset == stream->last + stream->stride))
+                        goto hit;
+
+                if (!stream->hits && (offset > next) &&
+                    ((offset - stream->last) <= RA_MAX_STRIDE (file))) {
+                        stream->stride = offset - stream->last;
+                        goto hit;
+                }
+
+                if ((offset >= stream->last) && (offset < next))
+                        /* read again */
+                        goto touch;
         }
 
-        trav_offset = ra_offset;
+        i = lru - file->streams;
+        if (lru->active)
+                __ra_stream_purge (file, i, file->pages.prev->offset + 1);
 
-        cap  = file->size ? file->size : ra_offset + ra_size;
+        memset (lru, 0, sizeof (*lru));
+        lru->active = 1;
+        lru->last = offset;
+        lru->size = size;
+        lru->used = file->clock;
 
-        while (trav_offset < min(ra_offset + ra_size, cap)) {
-                fault = 0;
-                ra_file_lock (file);
-                {
-                        trav = ra_page_get (file, trav_offset);
-                        if (!trav) {
-                                fault = 1;
-                                trav = ra_page_create (file, trav_offset);
-                                if (trav)
-                                        trav->dirty = 1;
+        RA_STAT_INC (file->conf, streams);
+
+        return i;
+
+hit:
+        stream->hits++;
+        stream->run += size;
+
+        if (stream->stride && (stream->hits == 2))
+                RA_STAT_INC (file->conf, strides);
+touch:
+        stream->last = offset;
+        stream->size = size;
+        stream->used = file->clock;
+
+        return i;
+}
+
+
+static void
+read_ahead (call_frame_t *frame, ra_file_t *file, int idx)
+{
+        ra_stream_t *stream      = NULL;
+        ra_page_t   *trav        = NULL;
+        off_t        from[RA_MAX_WINDOW];
+        off_t        to[RA_MAX_WINDOW];
+        off_t        next        = 0;
+        off_t        trav_offset = 0;
+        off_t        cap         = 0;
+        uint32_t     window      = 0;
+        int          ranges      = 0;
+        int          i           = 0;
+        char         fault       = 0;
+
+        GF_VALIDATE_OR_GOTO ("read-ahead", frame, out);
+        GF_VALIDATE_OR_GOTO (frame->this->name, file, out);
+
+        ra_file_lock (file);
+        {
+                stream = &file->streams[idx];
+                window = ra_stream_window (file, stream);
+                next = stream->last + stream->size;
+
+                if (!window) {
+                        /* not enough of a pattern yet */
+                } else if (!stream->stride) {
+                        from[0] = max (stream->ahead, next);
+                        to[0] = next + window * file->page_size;
+                        if (from[0] < to[0]) {
+                                stream->ahead = to[0];
+                                ranges = 1;
+                        }
+                } else {
+                        for (i = 1; i <= window; i++) {
+                                from[ranges] = stream->last
+                                               + i * stream->stride;
+                                to[ranges] = from[ranges] + stream->size;
+                                if (to[ranges] <= stream->ahead)
+                                        continue;
+                                stream->ahead = to[ranges];
+                                ranges++;
                         }
                 }
-                ra_file_unlock (file);
 
-                if (!trav) {
-                        /* OUT OF MEMORY */
-                        break;
-                }
+                if (file->stbuf.ia_size)
+                        cap = roof (file->stbuf.ia_size, file->page_size);
+        }
+        ra_file_unlock (file);
 
-                if (fault) {
-                        gf_msg_trace (frame->this->name, 0,
-                                      "RA at offset=%"PRId64, trav_offset);
-                        ra_page_fault (file, frame, trav_offset);
+        for (i = 0; i < ranges; i++) {
+                trav_offset = floor (from[i], file->page_size);
+
+                while (trav_offset < to[i]) {
+                        if (cap && (trav_offset >= cap))
+                                break;
+
+                        fault = 0;
+                        ra_file_lock (file);
+                        {
+                                trav = ra_page_get (file, trav_offset);
+                                if (!trav) {
+                                        fault = 1;
+                                        trav = ra_page_create (file,
+                                                               trav_offset);
+                                        if (trav) {
+                                                trav->dirty = 1;
+                                                trav->stream = idx;
+                                        }
+                                }
+                        }
+                        ra_file_unlock (file);
+
+                        if (!trav) {
+                                /* OUT OF MEMORY */
+                                goto out;
+                        }
+
+                        if (fault) {
+                                gf_msg_trace (frame->this->name, 0,
+                                              "RA at offset=%"PRId64,
+                                              trav_offset);
+                                RA_STAT_INC (file->conf, prefetched);
+                                ra_page_fault (file, frame, trav_offset);
+                        }
+                        trav_offset += file->page_size;
                 }
-                trav_offset += file->page_size;
         }
 
 out:
@@ -390,6 +575,7 @@ dispatch_requests (call_frame_t *frame, ra_file_t *file)
                                         local->op_errno = ENOMEM;
                                         goto unlock;
                                 }
+                                trav->stream = local->stream;
                                 fault = 1;
                                 need_atime_update = 0;
                         }
@@ -399,12 +585,16 @@ dispatch_requests (call_frame_t *frame, ra_file_t *file)
                                 gf_msg_trace (frame->this->name, 0,
                                               "HIT at offset=%"PRId64".",
                                               trav_offset);
+                                if (!fault)
+                                        RA_STAT_INC (conf, hits);
                                 ra_frame_fill (trav, frame);
                         } else {
                                 gf_msg_trace (frame->this->name, 0,
                                               "IN-TRANSIT at "
                                               "offset=%"PRId64".",
                                               trav_offset);
+                                if (!fault)
+                                        RA_STAT_INC (conf, waits);
                                 ra_wait_on_page (trav, frame);
                                 need_atime_update = 0;
                         }
@@ -420,6 +610,7 @@ dispatch_requests (call_frame_t *frame, ra_file_t *file)
                         gf_msg_trace (frame->this->name, 0,
                                       "MISS at offset=%"PRId64".",
                                       trav_offset);
+                        RA_STAT_INC (conf, misses);
                         ra_page_fault (file, frame, trav_offset);
                 }
 
@@ -466,17 +657,14 @@ ra_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 {
         ra_file_t   *file            = NULL;
         ra_local_t  *local           = NULL;
-        ra_conf_t   *conf            = NULL;
         int          op_errno        = EINVAL;
-        char         expected_offset = 1;
+        int          stream          = 0;
         uint64_t     tmp_file        = 0;
 
         GF_ASSERT (frame);
         GF_VALIDATE_OR_GOTO (frame->this->name, this, unwind);
         GF_VALIDATE_OR_GOTO (frame->this->name, fd, unwind);
 
-        conf = this->private;
-
         gf_msg_trace (this->name, 0,
                       "NEW REQ at offset=%"PRId64" for size=%"GF_PRI_SIZET"",
                       offset, size);
@@ -488,29 +676,14 @@ ra_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                 goto disabled;
         }
 
-        if (file->offset != offset) {
-                gf_msg_trace (this->name, 0,
-                              "unexpected offset (%"PRId64" != %"PRId64") "
-                              "resetting",
-                              file->offset, offset);
-
-                expected_offset = file->expected = file->page_count = 0;
-        } else {
-                gf_msg_trace (this->name, 0,
-                              "expected offset (%"PRId64") when page_count=%d",
-                              offset, file->page_count);
-
-                if (file->expected < (file->page_size * conf->page_count)) {
-                        file->expected += size;
-                        file->page_count = min ((file->expected
-                                                 / file->page_size),
-                                                conf->page_count);
-                }
+        ra_file_lock (file);
+        {
+                stream = __ra_stream_match (file, offset, size);
         }
+        ra_file_unlock (file);
 
-        if (!expected_offset) {
-                flush_region (frame, file, 0, file->pages.prev->offset + 1, 0);
-        }
+        gf_msg_trace (this->name, 0, "read at offset=%"PRId64" is on "
+                      "stream %d", offset, stream);
 
         local = mem_get0 (this->local_pool);
         if (!local) {
@@ -522,6 +695,7 @@ ra_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         local->offset     = offset;
         local->size       = size;
         local->wait_count = 1;
+        local->stream     = stream;
 
         local->fill.next  = &local->fill;
         local->fill.prev  = &local->fill;
@@ -532,14 +706,18 @@ ra_readv (call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
         dispatch_requests (frame, file);
 
-        flush_region (frame, file, 0, floor (offset, file->page_size), 0);
+        /* what the stream has moved past */
+        ra_file_lock (file);
+        {
+                __ra_stream_purge (file, stream,
+                                   floor (offset, file->page_size));
+        }
+        ra_file_unlock (file);
 
-        read_ahead (frame, file);
+        read_ahead (frame, file, stream);
 
         ra_frame_return (frame);
 
-        file->offset = offset + size;
-
         return 0;
 
 unwind:
@@ -678,7 +856,11 @@ ra_writev (call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
                 flush_region (frame, file, 0, file->pages.prev->offset+1, 1);
                 frame->local = file;
                 /* reset the read-ahead counters too */
-                file->expected = file->page_count = 0;
+                ra_file_lock (file);
+                {
+                        __ra_streams_reset (file);
+                }
+                ra_file_unlock (file);
         }
 
         STACK_WIND (frame, ra_writev_cbk,
@@ -805,6 +987,7 @@ ra_fdctx_dump (xlator_t *this, fd_t *fd)
 {
 	ra_file_t    *file     = NULL;
         ra_page_t    *page     = NULL;
+        ra_stream_t  *stream   = NULL;
         int32_t       ret      = 0, i = 0;
         uint64_t      tmp_file = 0;
         char         *path     = NULL;
@@ -842,10 +1025,21 @@ ra_fdctx_dump (xlator_t *this, fd_t *fd)
 
         gf_proc_dump_write ("page-size", "%"PRId64, file->page_size);
 
-        gf_proc_dump_write ("page-count", "%u", file->page_count);
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+                stream = &file->streams[i];
+                if (!stream->active)
+                        continue;
+
+                sprintf (key, "stream[%d]", i);
+                gf_proc_dump_write (key, "last=%"PRId64" size=%"GF_PRI_SIZET
+                                    " stride=%"PRId64" window=%u ahead=%"
+                                    PRId64, stream->last, stream->size,
+                                    stream->stride,
+                                    ra_stream_window (file, stream),
+                                    stream->ahead);
+        }
 
-        gf_proc_dump_write ("next-expected-offset-for-sequential-reads",
-                            "%"PRId64, file->offset);
+        i = 0;
 
         for (page = file->pages.next; page != &file->pages;
              page = page->next) {
@@ -1077,6 +1271,18 @@ ra_priv_dump (xlator_t *this)
                 gf_proc_dump_write ("page_count", "%d", conf->page_count);
                 gf_proc_dump_write ("force_atime_update", "%d",
                                     conf->force_atime_update);
+                gf_proc_dump_write ("stripe_size", "%"PRIu64,
+                                    conf->stripe_size);
+                gf_proc_dump_write ("hits", "%"PRIu64, conf->stats.hits);
+                gf_proc_dump_write ("waits", "%"PRIu64, conf->stats.waits);
+                gf_proc_dump_write ("misses", "%"PRIu64, conf->stats.misses);
+                gf_proc_dump_write ("prefetched", "%"PRIu64,
+                                    conf->stats.prefetched);
+                gf_proc_dump_write ("wasted", "%"PRIu64, conf->stats.wasted);
+                gf_proc_dump_write ("streams", "%"PRIu64,
+                                    conf->stats.streams);
+                gf_proc_dump_write ("strided_streams", "%"PRIu64,
+                                    conf->stats.strides);
         }
         pthread_mutex_unlock (&conf->conf_lock);
 
@@ -1140,6 +1346,7 @@ init (xlator_t *this)
 {
         ra_conf_t *conf              = NULL;
         int32_t    ret               = -1;
+        uint64_t   shard_block_size  = 0;
 
         GF_VALIDATE_OR_GOTO ("read-ahead", this, out);
 
@@ -1170,6 +1377,9 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("force-atime-update", conf->force_atime_update, bool, out);
 
+        xlator_probe_backend (FIRST_CHILD (this), &shard_block_size,
+                              &conf->stripe_size);
+
         conf->files.next = &conf->files;
         conf->files.prev = &conf->files;
 
@@ -26,6 +26,10 @@ struct ra_file;
 struct ra_waitq;
 
 
+/* streams tracked per fd */
+#define RA_MAX_STREAMS  8
+
+
 struct ra_waitq {
         struct ra_waitq *next;
         void            *data;
@@ -54,6 +58,7 @@ struct ra_local {
         size_t            pending_size;
         fd_t             *fd;
         int32_t           wait_count;
+        int               stream;   /* index into file->streams */
         pthread_mutex_t   local_lock;
 };
 
@@ -72,6 +77,26 @@ struct ra_page {
         struct ra_waitq  *waitq;
         struct iobref    *iobref;
         char              stale;
+        int               stream;   /* the stream it was read for */
+};
+
+
+/*
+ * A run of reads on an fd which are either back to back or a fixed
+ * stride apart. The prefetch window grows with the data the stream has
+ * consumed (and so stays small while a stream is starting) and is cut
+ * by half whenever prefetched pages get thrown away unread.
+ */
+struct ra_stream {
+        char              active;
+        off_t             last;     /* offset of the latest read */
+        size_t            size;     /* size of the latest read */
+        off_t             stride;   /* distance between reads, 0 if they
+                                       are sequential */
+        uint64_t          run;      /* bytes consumed by the stream */
+        uint32_t          hits;     /* reads which followed the pattern */
+        off_t             ahead;    /* prefetched up to this offset */
+        uint64_t          used;     /* file->clock at the latest read */
 };
 
 
@@ -81,25 +106,37 @@ struct ra_file {
         struct ra_conf    *conf;
         fd_t              *fd;
         int                disabled;
-        size_t             expected;
         struct ra_page     pages;
-        off_t              offset;
         size_t             size;
         int32_t            refcount;
         pthread_mutex_t    file_lock;
         struct iatt        stbuf;
         uint64_t           page_size;
-        uint32_t           page_count;
+        struct ra_stream   streams[RA_MAX_STREAMS];
+        uint64_t           clock;
+};
+
+
+struct ra_stats {
+        uint64_t          hits;       /* pages found ready */
+        uint64_t          waits;      /* pages found in flight */
+        uint64_t          misses;     /* pages read on demand */
+        uint64_t          prefetched; /* pages read ahead */
+        uint64_t          wasted;     /* read ahead but never used */
+        uint64_t          streams;    /* streams started */
+        uint64_t          strides;    /* streams found to be strided */
 };
 
 
 struct ra_conf {
         uint64_t          page_size;
         uint32_t          page_count;
+        uint64_t          stripe_size;  /* of a disperse volume below */
         void             *cache_block;
         struct ra_file    files;
         gf_boolean_t      force_atime_update;
         pthread_mutex_t   conf_lock;
+        struct ra_stats   stats;
 };
 
 
@@ -109,6 +146,13 @@ typedef struct ra_page ra_page_t;
 typedef struct ra_file ra_file_t;
 typedef struct ra_waitq ra_waitq_t;
 typedef struct ra_fill ra_fill_t;
+typedef struct ra_stream ra_stream_t;
+
+#define RA_STAT_INC(conf, counter)                                      \
+        __sync_fetch_and_add (&(conf)->stats.counter, 1)
+
+void
+__ra_stream_wasted (ra_file_t *file, int stream);
 
 ra_page_t *
 ra_page_get (ra_file_t *file,
@@ -27,6 +27,8 @@
 #define WB_AGGREGATE_SIZE         131072 /* 128 KB */
 #define WB_WINDOW_SIZE            1048576 /* 1MB */
 
+#define WB_BW_SAMPLE_USEC         100000  /* 100ms */
+
 typedef struct list_head list_head_t;
 struct wb_conf;
 struct wb_inode;
@@ -105,6 +107,14 @@ typedef struct wb_inode {
 				liability generation higher than itself)
 			     */
 	size_t       size; /* Size of the file to catch write after EOF. */
+
+        /* with aggregate-writes, window_conf follows the bandwidth-delay
+           product of the writes to the bricks */
+        uint64_t       latency;   /* usec, moving average */
+        uint64_t       bandwidth; /* bytes/sec, moving average */
+        uint64_t       bw_bytes;  /* written since bw_start */
+        struct timeval bw_start;
+
         gf_lock_t    lock;
         xlator_t    *this;
 } wb_inode_t;
@@ -131,6 +141,7 @@ typedef struct wb_request {
 					      STACK_WIND to server and therefore the
 					      amount by which we shrink the window.
 					   */
+        struct timeval        wind_time;   /* valid only in @head */
 
 	int                   op_ret;
 	int                   op_errno;
@@ -160,6 +171,9 @@ typedef struct wb_request {
 typedef struct wb_conf {
         uint64_t         aggregate_size;
         uint64_t         window_size;
+        gf_boolean_t     aggregate_writes;
+        uint64_t         aggregate_align;    /* disperse stripe below us */
+        uint64_t         aggregate_boundary; /* shard block below us */
         gf_boolean_t     flush_behind;
         gf_boolean_t     trickling_writes;
 	gf_boolean_t     strict_write_ordering;
@@ -593,6 +607,34 @@ wb_enqueue_tempted (wb_inode_t *wb_inode, call_stub_t *stub)
 }
 
 
+/* with aggregate-writes the window has room for two full writes if it
+ * can, so that one can be filled while the other is in flight. it never
+ * goes past cache-size. */
+static ssize_t
+wb_window_clamp (wb_conf_t *conf, uint64_t window)
+{
+        if (!conf->aggregate_writes)
+                return conf->window_size;
+
+        window = max (window, 2 * conf->aggregate_size);
+
+        return min (window, conf->window_size);
+}
+
+
+/* the window of @wb_inode as currently configured: what was measured
+ * for it is dropped once aggregate-writes is turned off, and bounded
+ * anew after cache-size or aggregate-size change */
+static ssize_t
+__wb_inode_window (wb_inode_t *wb_inode)
+{
+        wb_inode->window_conf = wb_window_clamp (wb_inode->this->private,
+                                                 wb_inode->window_conf);
+
+        return wb_inode->window_conf;
+}
+
+
 wb_inode_t *
 __wb_inode_create (xlator_t *this, inode_t *inode)
 {
@@ -615,7 +657,7 @@ __wb_inode_create (xlator_t *this, inode_t *inode)
 
         wb_inode->this = this;
 
-        wb_inode->window_conf = conf->window_size;
+        wb_inode->window_conf = wb_window_clamp (conf, conf->window_size);
 
         LOCK_INIT (&wb_inode->lock);
 
@@ -724,6 +766,55 @@ wb_fulfill_err (wb_request_t *head, int op_errno)
 }
 
 
+static void
+wb_window_update (wb_inode_t *wb_inode, wb_request_t *head)
+{
+        wb_conf_t      *conf    = NULL;
+        struct timeval  now     = {0, };
+        uint64_t        lat     = 0;
+        uint64_t        elapsed = 0;
+        uint64_t        rate    = 0;
+        uint64_t        bdp     = 0;
+
+        conf = wb_inode->this->private;
+        if (!conf->aggregate_writes)
+                return;
+
+        gettimeofday (&now, NULL);
+
+        lat = (now.tv_sec - head->wind_time.tv_sec) * 1000000
+              + now.tv_usec - head->wind_time.tv_usec;
+
+        LOCK (&wb_inode->lock);
+        {
+                wb_inode->latency = wb_inode->latency ?
+                        (7 * wb_inode->latency + lat) / 8 : lat;
+
+                if (!wb_inode->bw_start.tv_sec)
+                        wb_inode->bw_start = head->wind_time;
+
+                wb_inode->bw_bytes += head->total_size;
+
+                elapsed = (now.tv_sec - wb_inode->bw_start.tv_sec) * 1000000
+                          + now.tv_usec - wb_inode->bw_start.tv_usec;
+                if (elapsed < WB_BW_SAMPLE_USEC)
+                        goto unlock;
+
+                rate = wb_inode->bw_bytes * 1000000 / elapsed;
+                wb_inode->bandwidth = wb_inode->bandwidth ?
+                        (3 * wb_inode->bandwidth + rate) / 4 : rate;
+                wb_inode->bw_bytes = 0;
+                wb_inode->bw_start = now;
+
+                /* twice the data the bricks can take in one round trip */
+                bdp = wb_inode->bandwidth * wb_inode->latency / 1000000;
+                wb_inode->window_conf = wb_window_clamp (conf, 2 * bdp);
+        }
+unlock:
+        UNLOCK (&wb_inode->lock);
+}
+
+
 int
 wb_fulfill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 		int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
@@ -749,7 +840,9 @@ wb_fulfill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 		 * a real error condition (i.e., ENOSPC).
 		 */
 		wb_fulfill_err (head, EIO);
-	}
+	} else {
+                wb_window_update (wb_inode, head);
+        }
 
 	wb_head_done (head);
 
@@ -769,6 +862,61 @@ wb_fulfill_cbk (call_frame_t *frame, void *cookie, xlator_t *this,
 	} while (0)
 
 
+/* With aggregate-writes a chain is not bounded by MAX_VECTOR_COUNT: the
+ * data of all its requests is copied into one buffer for the flush.
+ */
+static int
+wb_fulfill_collapse (wb_inode_t *wb_inode, wb_request_t *head,
+                     struct iovec *vector, struct iobref **iobref_p)
+{
+	wb_request_t  *req    = NULL;
+        struct iobuf  *iobuf  = NULL;
+        struct iobref *iobref = NULL;
+        char          *ptr    = NULL;
+
+        head->total_size = head->write_size;
+	list_for_each_entry (req, &head->winds, winds)
+                head->total_size += req->write_size;
+
+        iobuf = iobuf_get2 (wb_inode->this->ctx->iobuf_pool,
+                            head->total_size);
+        if (!iobuf)
+                return -1;
+
+        iobref = iobref_new ();
+        if (!iobref) {
+                iobuf_unref (iobuf);
+                return -1;
+        }
+
+        if (iobref_add (iobref, iobuf)) {
+                iobuf_unref (iobuf);
+                iobref_unref (iobref);
+                return -1;
+        }
+
+        ptr = iobuf->ptr;
+
+        iov_unload (ptr, head->stub->args.vector, head->stub->args.count);
+        ptr += iov_length (head->stub->args.vector, head->stub->args.count);
+
+	list_for_each_entry (req, &head->winds, winds) {
+                iov_unload (ptr, req->stub->args.vector,
+                            req->stub->args.count);
+                ptr += iov_length (req->stub->args.vector,
+                                   req->stub->args.count);
+        }
+
+        vector[0].iov_base = iobuf->ptr;
+        vector[0].iov_len = ptr - (char *) iobuf->ptr;
+
+        iobuf_unref (iobuf);
+
+        *iobref_p = iobref;
+        return 0;
+}
+
+
 int
 wb_fulfill_head (wb_inode_t *wb_inode, wb_request_t *head)
 {
@@ -778,13 +926,25 @@ wb_fulfill_head (wb_inode_t *wb_inode, wb_request_t *head)
 	call_frame_t *frame    = NULL;
         gf_boolean_t  fderr    = _gf_false;
         xlator_t     *this     = NULL;
+        wb_conf_t    *conf     = NULL;
+        struct iobref *iobref  = NULL;
 
         this = THIS;
+        conf = wb_inode->this->private;
 
         /* make sure head->total_size is updated before we run into any
          * errors
          */
 
+        if (conf->aggregate_writes &&
+            (!list_empty (&head->winds) ||
+             (head->stub->args.count > MAX_VECTOR_COUNT))) {
+                if (wb_fulfill_collapse (wb_inode, head, vector, &iobref))
+                        goto err;
+                count = 1;
+                goto wind;
+        }
+
 	WB_IOV_LOAD (vector, count, head, head);
 
 	list_for_each_entry (req, &head->winds, winds) {
@@ -795,6 +955,8 @@ wb_fulfill_head (wb_inode_t *wb_inode, wb_request_t *head)
 			goto err;
 	}
 
+wind:
+
         if (wb_fd_err (head->fd, this, NULL)) {
                 fderr = _gf_true;
                 goto err;
@@ -807,6 +969,8 @@ wb_fulfill_head (wb_inode_t *wb_inode, wb_request_t *head)
 	frame->root->lk_owner = head->lk_owner;
 	frame->local = head;
 
+        gettimeofday (&head->wind_time, NULL);
+
 	LOCK (&wb_inode->lock);
 	{
 		wb_inode->transit += head->total_size;
@@ -818,10 +982,16 @@ wb_fulfill_head (wb_inode_t *wb_inode, wb_request_t *head)
 		    head->fd, vector, count,
 		    head->stub->args.offset,
 		    head->stub->args.flags,
-		    head->stub->args.iobref, NULL);
+		    iobref ? iobref : head->stub->args.iobref, NULL);
+
+        if (iobref)
+                iobref_unref (iobref);
 
 	return 0;
 err:
+        if (iobref)
+                iobref_unref (iobref);
+
         if (!fderr) {
                 /* frame creation failure */
                 fderr = ENOMEM;
@@ -840,17 +1010,93 @@ err:
 		head = req;						\
 		expected_offset = req->stub->args.offset +		\
 			req->write_size;				\
-		curr_aggregate = 0;					\
-		vector_count = 0;					\
+		curr_aggregate = req->write_size;			\
+		vector_count = req->stub->args.count;			\
 	} while (0)
 
 
+/* true if adding @req to @head's chain makes it span a shard block
+ * boundary, which shard would have to split the write at */
+static gf_boolean_t
+wb_crosses_boundary (wb_conf_t *conf, wb_request_t *head, wb_request_t *req)
+{
+        uint64_t start = 0;
+        uint64_t end   = 0;
+
+        if (!conf->aggregate_writes || !conf->aggregate_boundary)
+                return _gf_false;
+
+        start = head->stub->args.offset;
+        end = req->stub->args.offset + req->write_size - 1;
+
+        return ((start / conf->aggregate_boundary)
+                != (end / conf->aggregate_boundary));
+}
+
+
+/* Cuts @head's chain after the last request ending on a disperse stripe
+ * boundary, so that the write wound now leaves no partial stripe for
+ * disperse to read-modify-write. Returns the head of the part cut off,
+ * or NULL if there is no such point or it leaves too small a write.
+ */
+static wb_request_t *
+wb_chain_split_aligned (wb_conf_t *conf, wb_request_t *head)
+{
+        wb_request_t *req     = NULL;
+        wb_request_t *last    = NULL;
+        wb_request_t *next    = NULL;
+        list_head_t  *pos     = NULL;
+        list_head_t   rest;
+        uint64_t      end     = 0;
+        size_t        size    = 0;
+        size_t        aligned = 0;
+
+        if (!conf->aggregate_writes || (conf->aggregate_align <= 1))
+                return NULL;
+
+        end = head->stub->args.offset + head->write_size;
+        size = head->write_size;
+        if (!(end % conf->aggregate_align)) {
+                last = head;
+                aligned = size;
+        }
+
+        list_for_each_entry (req, &head->winds, winds) {
+                end += req->write_size;
+                size += req->write_size;
+                if (!(end % conf->aggregate_align)) {
+                        last = req;
+                        aligned = size;
+                }
+        }
+
+        if (!last || (aligned == size) || (aligned < conf->aggregate_size / 2))
+                return NULL;
+
+        pos = (last == head) ? &head->winds : &last->winds;
+        next = list_entry (pos->next, wb_request_t, winds);
+
+        INIT_LIST_HEAD (&rest);
+        while (next->winds.next != &head->winds) {
+                req = list_entry (next->winds.next, wb_request_t, winds);
+                list_move_tail (&req->winds, &rest);
+        }
+
+        list_del_init (&next->winds);
+        list_splice_init (&rest, &next->winds);
+
+        return next;
+}
+
+
 int
 wb_fulfill (wb_inode_t *wb_inode, list_head_t *liabilities)
 {
 	wb_request_t  *req     = NULL;
 	wb_request_t  *head    = NULL;
 	wb_request_t  *tmp     = NULL;
+	wb_request_t  *rest    = NULL;
+	wb_request_t  *iter    = NULL;
 	wb_conf_t     *conf    = NULL;
 	off_t          expected_offset = 0;
 	size_t         curr_aggregate = 0;
@@ -861,7 +1107,7 @@ wb_fulfill (wb_inode_t *wb_inode, list_head_t *liabilities)
 
 	list_for_each_entry_safe (req, tmp, liabilities, winds) {
 		list_del_init (&req->winds);
-
+retry:
 		if (!head) {
 			NEXT_HEAD (head, req);
 			continue;
@@ -882,13 +1128,32 @@ wb_fulfill (wb_inode_t *wb_inode, list_head_t *liabilities)
 			continue;
 		}
 
-		if ((curr_aggregate + req->write_size) > conf->aggregate_size) {
+		if (wb_crosses_boundary (conf, head, req)) {
 			NEXT_HEAD (head, req);
 			continue;
 		}
 
-		if (vector_count + req->stub->args.count >
-		    MAX_VECTOR_COUNT) {
+		if ((curr_aggregate + req->write_size) > conf->aggregate_size) {
+			rest = wb_chain_split_aligned (conf, head);
+			if (!rest) {
+				NEXT_HEAD (head, req);
+				continue;
+			}
+
+			/* wind the aligned part, carry on with the rest */
+			NEXT_HEAD (head, rest);
+			list_for_each_entry (iter, &head->winds, winds) {
+				curr_aggregate += iter->write_size;
+				vector_count += iter->stub->args.count;
+			}
+			expected_offset = head->stub->args.offset
+				+ curr_aggregate;
+			goto retry;
+		}
+
+		if (!conf->aggregate_writes &&
+		    (vector_count + req->stub->args.count >
+		     MAX_VECTOR_COUNT)) {
 			NEXT_HEAD (head, req);
 			continue;
 		}
@@ -936,7 +1201,7 @@ __wb_pick_unwinds (wb_inode_t *wb_inode, list_head_t *lies)
 
 	list_for_each_entry_safe (req, tmp, &wb_inode->temptation, lie) {
 		if (!req->ordering.fulfilled &&
-		    wb_inode->window_current > wb_inode->window_conf)
+		    wb_inode->window_current > __wb_inode_window (wb_inode))
 			continue;
 
 		list_del_init (&req->lie);
@@ -975,7 +1240,7 @@ __wb_collapse_small_writes (wb_request_t *holder, wb_request_t *req)
                 req_len = iov_length (req->stub->args.vector,
                                       req->stub->args.count);
 
-                required_size = max ((THIS->ctx->page_size),
+                required_size = max (req->wb_inode->this->ctx->page_size,
                                      (holder_len + req_len));
                 iobuf = iobuf_get2 (req->wb_inode->this->ctx->iobuf_pool,
                                     required_size);
@@ -1091,7 +1356,10 @@ __wb_preprocess_winds (wb_inode_t *wb_inode)
 
 		space_left = page_size - holder->write_size;
 
-		if (space_left < req->write_size) {
+		/* with aggregate-writes, writes are put together in a
+		   single buffer per flush by wb_fulfill_head () instead */
+		if (conf->aggregate_writes ||
+		    space_left < req->write_size) {
 			holder->ordering.go = 1;
 			holder = req;
 			continue;
@@ -1128,18 +1396,53 @@ __wb_preprocess_winds (wb_inode_t *wb_inode)
 }
 
 
+/* With aggregate-writes, written data is held back while earlier writes
+ * are in flight, till there is aggregate-size of it. It is let go right
+ * away when nothing is in flight (so the completion of the in-flight
+ * writes clocks the next ones out), when the window is full, or when any
+ * other operation is queued behind it.
+ */
+static gf_boolean_t
+__wb_hold_liabilities (wb_inode_t *wb_inode)
+{
+        wb_conf_t    *conf    = NULL;
+        wb_request_t *req     = NULL;
+        size_t        pending = 0;
+
+        conf = wb_inode->this->private;
+
+        if (!conf->aggregate_writes || !wb_inode->transit)
+                return _gf_false;
+
+        if (wb_inode->window_current > __wb_inode_window (wb_inode))
+                return _gf_false;
+
+        list_for_each_entry (req, &wb_inode->todo, todo) {
+                if (!req->ordering.tempted)
+                        return _gf_false;
+
+                pending += req->write_size;
+        }
+
+        return (pending < conf->aggregate_size);
+}
+
+
 void
 __wb_pick_winds (wb_inode_t *wb_inode, list_head_t *tasks,
 		 list_head_t *liabilities)
 {
 	wb_request_t *req = NULL;
 	wb_request_t *tmp = NULL;
+        gf_boolean_t  hold = _gf_false;
+
+        hold = __wb_hold_liabilities (wb_inode);
 
 	list_for_each_entry_safe (req, tmp, &wb_inode->todo, todo) {
 		if (wb_liability_has_conflict (wb_inode, req))
 			continue;
 
-		if (req->ordering.tempted && !req->ordering.go)
+		if (req->ordering.tempted && (!req->ordering.go || hold))
 			/* wait some more */
 			continue;
 
@@ -1972,6 +2275,11 @@ wb_priv_dump (xlator_t *this)
 
         gf_proc_dump_write ("aggregate_size", "%d", conf->aggregate_size);
         gf_proc_dump_write ("window_size", "%d", conf->window_size);
+        gf_proc_dump_write ("aggregate_writes", "%d", conf->aggregate_writes);
+        gf_proc_dump_write ("aggregate_align", "%"PRIu64,
+                            conf->aggregate_align);
+        gf_proc_dump_write ("aggregate_boundary", "%"PRIu64,
+                            conf->aggregate_boundary);
         gf_proc_dump_write ("flush_behind", "%d", conf->flush_behind);
         gf_proc_dump_write ("trickling_writes", "%d", conf->trickling_writes);
 
@@ -2065,6 +2373,10 @@ wb_inode_dump (xlator_t *this, inode_t *inode)
         gf_proc_dump_write ("window_current", "%"GF_PRI_SIZET,
                             wb_inode->window_current);
 
+        gf_proc_dump_write ("latency_usec", "%"PRIu64, wb_inode->latency);
+
+        gf_proc_dump_write ("bandwidth", "%"PRIu64, wb_inode->bandwidth);
+
 
         ret = TRY_LOCK (&wb_inode->lock);
         if (!ret)
@@ -2112,12 +2424,33 @@ out:
 int
 reconfigure (xlator_t *this, dict_t *options)
 {
-        wb_conf_t *conf = NULL;
-        int        ret  = -1;
+        wb_conf_t *conf           = NULL;
+        int        ret            = -1;
+        uint64_t   window_size    = 0;
+        uint64_t   aggregate_size = 0;
 
         conf = this->private;
 
-        GF_OPTION_RECONF ("cache-size", conf->window_size, options, size_uint64, out);
+        GF_OPTION_RECONF ("cache-size", window_size, options, size_uint64,
+                          out);
+
+        GF_OPTION_RECONF ("aggregate-size", aggregate_size, options,
+                          size_uint64, out);
+
+        if (window_size < aggregate_size) {
+                gf_msg (this->name, GF_LOG_ERROR, 0,
+                        WRITE_BEHIND_MSG_EXCEEDED_MAX_SIZE,
+                        "aggregate-size(%"PRIu64") cannot be more than "
+                        "window-size(%"PRIu64"), not reconfiguring them",
+                        aggregate_size, window_size);
+                goto out;
+        }
+
+        conf->window_size = window_size;
+        conf->aggregate_size = aggregate_size;
+
+        GF_OPTION_RECONF ("aggregate-writes", conf->aggregate_writes, options,
+                          bool, out);
 
         GF_OPTION_RECONF ("flush-behind", conf->flush_behind, options, bool,
                           out);
@@ -2136,6 +2469,22 @@ out:
 }
 
 
+/* Picks the shard block size and the disperse stripe size large writes
+ * are to be cut along.
+ */
+static void
+wb_probe_backend (xlator_t *xl, wb_conf_t *conf)
+{
+        xlator_probe_backend (xl, &conf->aggregate_boundary,
+                              &conf->aggregate_align);
+
+        if (conf->aggregate_boundary && conf->aggregate_align &&
+            (conf->aggregate_boundary % conf->aggregate_align))
+                /* shard blocks would not hold whole stripes anyway */
+                conf->aggregate_align = 0;
+}
+
+
 int32_t
 init (xlator_t *this)
 {
@@ -2163,7 +2512,12 @@ init (xlator_t *this)
         }
 
         /* configure 'options aggregate-size <size>' */
-        conf->aggregate_size = WB_AGGREGATE_SIZE;
+        GF_OPTION_INIT ("aggregate-size", conf->aggregate_size, size_uint64,
+                        out);
+
+        GF_OPTION_INIT ("aggregate-writes", conf->aggregate_writes, bool, out);
+
+        wb_probe_backend (FIRST_CHILD (this), conf);
 
         /* configure 'option window-size <size>' */
         GF_OPTION_INIT ("cache-size", conf->window_size, size_uint64, out);
@@ -2275,6 +2629,25 @@ struct volume_options options[] = {
           .type = GF_OPTION_TYPE_BOOL,
           .default_value = "on",
         },
+        { .key  = {"aggregate-size"},
+          .type = GF_OPTION_TYPE_SIZET,
+          .min  = 128 * GF_UNIT_KB,
+          .max  = 4 * GF_UNIT_MB,
+          .default_value = "128KB",
+          .description = "Largest write sent to the bricks when contiguous "
+                         "writes are put together."
+        },
+        { .key = {"aggregate-writes"},
+          .type = GF_OPTION_TYPE_BOOL,
+          .default_value = "off",
+          .description = "Hold back written data while earlier writes are "
+                         "in flight till aggregate-size of it is queued, cut "
+                         "writes along the shard blocks and disperse stripes "
+                         "below, and size the write-behind window from the "
+                         "measured throughput and latency of the bricks. "
+                         "The window is at least twice aggregate-size where "
+                         "cache-size allows it, and at most cache-size."
+        },
         { .key = {"strict-O_DIRECT"},
           .type = GF_OPTION_TYPE_BOOL,
           .default_value = "off",
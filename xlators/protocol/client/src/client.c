@@ -16,6 +16,7 @@
 #include "statedump.h"
 #include "compat-errno.h"
 #include "event.h"
+#include "syncop.h"
 
 #include "xdr-rpc.h"
 #include "glusterfs3.h"
@@ -2366,6 +2367,15 @@ client_check_event_threads (xlator_t *this, clnt_conf_t *conf, int32_t old,
                                           conf->event_threads);
 }
 
+/* placement failures are logged and leave the threads where they are */
+static void
+client_set_thread_placement (xlator_t *this, char *placement)
+{
+        (void) event_pool_set_placement (this->ctx->event_pool, placement);
+        if (this->ctx->env)
+                (void) syncenv_set_placement (this->ctx->env, placement);
+}
+
 int
 reconfigure (xlator_t *this, dict_t *options)
 {
@@ -2377,6 +2387,7 @@ reconfigure (xlator_t *this, dict_t *options)
         char        *old_remote_host   = NULL;
         char        *new_remote_host   = NULL;
         int32_t      new_nthread       = 0;
+        char        *placement         = NULL;
 
 	conf = this->private;
 
@@ -2393,6 +2404,10 @@ reconfigure (xlator_t *this, dict_t *options)
         if (ret)
                 goto out;
 
+        GF_OPTION_RECONF ("event-thread-placement", placement, options, str,
+                          out);
+        client_set_thread_placement (this, placement);
+
         ret = client_check_remote_host (this, options);
         if (ret)
                 goto out;
@@ -2446,6 +2461,7 @@ init (xlator_t *this)
 {
         int          ret = -1;
         clnt_conf_t *conf = NULL;
+        char        *placement = NULL;
 
         if (this->children) {
                 gf_msg (this->name, GF_LOG_ERROR, EINVAL,
@@ -2478,6 +2494,9 @@ init (xlator_t *this)
         if (ret)
                 goto out;
 
+        GF_OPTION_INIT ("event-thread-placement", placement, str, out);
+        client_set_thread_placement (this, placement);
+
         ret = client_init_grace_timer (this, this->options, conf);
         if (ret)
                 goto out;
@@ -2635,6 +2654,14 @@ client_priv_dump (xlator_t *this)
                                    conn->ping_timeout);
                 gf_proc_dump_write("total_bytes_written", "%"PRIu64,
                                    conn->trans->total_bytes_write);
+                gf_proc_dump_write("total_writev_calls", "%"PRIu64,
+                                   conn->trans->total_writev_calls);
+                gf_proc_dump_write("total_msgs_written", "%"PRIu64,
+                                   conn->trans->total_msgs_written);
+                gf_proc_dump_write("total_readv_calls", "%"PRIu64,
+                                   conn->trans->total_readv_calls);
+                gf_proc_dump_write("total_msgs_read", "%"PRIu64,
+                                   conn->trans->total_msgs_read);
                 gf_proc_dump_write("ping_msgs_sent", "%"PRIu64,
                                     conn->pingcnt);
                 gf_proc_dump_write("msgs_sent", "%"PRIu64,
@@ -2812,6 +2839,16 @@ struct volume_options options[] = {
                          " responses faster, depending on available processing"
                          " power. Range 1-32 threads."
         },
+        { .key   = {"event-thread-placement"},
+          .type  = GF_OPTION_TYPE_STR,
+          .default_value = "none",
+          .description = "Placement of the event threads and synctask "
+                         "processors of the process on CPUs: none (left "
+                         "as inherited, e.g. from taskset), spread "
+                         "(thread n on online CPU n), nodes (thread n on "
+                         "NUMA node n), node:<N> (all on NUMA node N) or "
+                         "cpus:<list> (all on the listed CPUs, e.g. 0-3,8)."
+        },
         { .key   = {NULL} },
 };
 
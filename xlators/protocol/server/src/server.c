@@ -21,6 +21,7 @@
 #include "defaults.h"
 #include "authenticate.h"
 #include "event.h"
+#include "syncop.h"
 #include "server-messages.h"
 
 rpcsvc_cbk_program_t server_cbk_prog = {
@@ -290,6 +291,10 @@ server_priv (xlator_t *this)
         char              key[GF_DUMP_MAX_BUF_LEN] = {0,};
         uint64_t          total_read = 0;
         uint64_t          total_write = 0;
+        uint64_t          total_writev = 0;
+        uint64_t          total_msgs = 0;
+        uint64_t          total_readv = 0;
+        uint64_t          total_msgs_read = 0;
         int32_t           ret  = -1;
 
         GF_VALIDATE_OR_GOTO ("server", this, out);
@@ -308,6 +313,10 @@ server_priv (xlator_t *this)
                 list_for_each_entry (xprt, &conf->xprt_list, list) {
                         total_read  += xprt->total_bytes_read;
                         total_write += xprt->total_bytes_write;
+                        total_writev += xprt->total_writev_calls;
+                        total_msgs  += xprt->total_msgs_written;
+                        total_readv += xprt->total_readv_calls;
+                        total_msgs_read += xprt->total_msgs_read;
                 }
         }
         pthread_mutex_unlock (&conf->mutex);
@@ -318,6 +327,18 @@ server_priv (xlator_t *this)
         gf_proc_dump_build_key(key, "server", "total-bytes-write");
         gf_proc_dump_write(key, "%"PRIu64, total_write);
 
+        gf_proc_dump_build_key(key, "server", "total-writev-calls");
+        gf_proc_dump_write(key, "%"PRIu64, total_writev);
+
+        gf_proc_dump_build_key(key, "server", "total-msgs-written");
+        gf_proc_dump_write(key, "%"PRIu64, total_msgs);
+
+        gf_proc_dump_build_key(key, "server", "total-readv-calls");
+        gf_proc_dump_write(key, "%"PRIu64, total_readv);
+
+        gf_proc_dump_build_key(key, "server", "total-msgs-read");
+        gf_proc_dump_write(key, "%"PRIu64, total_msgs_read);
+
         ret = 0;
 out:
         if (ret)
@@ -706,6 +727,15 @@ server_check_event_threads (xlator_t *this, server_conf_t *conf, int32_t old,
                                           conf->event_threads);
 }
 
+/* placement failures are logged and leave the threads where they are */
+static void
+server_set_thread_placement (xlator_t *this, char *placement)
+{
+        (void) event_pool_set_placement (this->ctx->event_pool, placement);
+        if (this->ctx->env)
+                (void) syncenv_set_placement (this->ctx->env, placement);
+}
+
 int
 reconfigure (xlator_t *this, dict_t *options)
 {
@@ -720,6 +750,7 @@ reconfigure (xlator_t *this, dict_t *options)
         char                     *statedump_path = NULL;
         xlator_t                 *xl     = NULL;
         int32_t                   new_nthread = 0;
+        char                     *placement = NULL;
 
         conf = this->private;
 
@@ -835,6 +866,10 @@ reconfigure (xlator_t *this, dict_t *options)
         if (ret)
                 goto out;
 
+        GF_OPTION_RECONF ("event-thread-placement", placement, options, str,
+                          out);
+        server_set_thread_placement (this, placement);
+
         ret = server_init_grace_timer (this, options, conf);
 
 out:
@@ -870,6 +905,7 @@ init (xlator_t *this)
         rpcsvc_listener_t *listener = NULL;
         char              *transport_type = NULL;
         char              *statedump_path = NULL;
+        char              *placement = NULL;
         int               total_transport = 0;
 
         GF_VALIDATE_OR_GOTO ("init", this, out);
@@ -901,6 +937,9 @@ init (xlator_t *this)
         if (ret)
                 goto out;
 
+        GF_OPTION_INIT ("event-thread-placement", placement, str, out);
+        server_set_thread_placement (this, placement);
+
         ret = server_init_grace_timer (this, this->options, conf);
         if (ret)
                 goto out;
@@ -1384,6 +1423,16 @@ struct volume_options options[] = {
                          " responses faster, depending on available processing"
                          " power. Range 1-32 threads."
         },
+        { .key   = {"event-thread-placement"},
+          .type  = GF_OPTION_TYPE_STR,
+          .default_value = "none",
+          .description = "Placement of the event threads and synctask "
+                         "processors of the process on CPUs: none (left "
+                         "as inherited, e.g. from taskset), spread "
+                         "(thread n on online CPU n), nodes (thread n on "
+                         "NUMA node n), node:<N> (all on NUMA node N) or "
+                         "cpus:<list> (all on the listed CPUs, e.g. 0-3,8)."
+        },
 
         { .key   = {NULL} },
 };
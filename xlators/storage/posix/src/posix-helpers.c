@@ -18,6 +18,7 @@
 #include <ftw.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <sys/mman.h>
 
 #ifdef HAVE_SYS_ACL_H
 #ifdef HAVE_ACL_LIBACL_H /* for acl_to_any_text() */
@@ -48,6 +49,8 @@
 #include "timer.h"
 #include "glusterfs3-xdr.h"
 #include "hashfn.h"
+#include "bloom.h"
+#include "syncop.h"
 #include "glusterfs-acl.h"
 #include <fnmatch.h>
 
@@ -428,6 +431,12 @@ _posix_xattr_get_set (dict_t *xattr_req, char *key, data_t *data,
         } else if (strcmp(key, CTR_REQUEST_LINK_COUNT_XDATA) == 0) {
                 ret = dict_set (filler->xattr,
                                 CTR_REQUEST_LINK_COUNT_XDATA, data);
+        } else if (!strcmp (key, GF_NAME_BLOOM_KEY)) {
+                if (filler->real_path && filler->loc && filler->loc->inode &&
+                    IA_ISDIR (filler->stbuf->ia_type))
+                        posix_name_bloom_fill (filler->this, filler->real_path,
+                                               filler->loc->inode,
+                                               filler->stbuf, filler->xattr);
         } else {
                 ret = _posix_xattr_get_set_from_backend (filler, key);
         }
@@ -436,6 +445,255 @@ out:
 }
 
 
+void
+posix_name_bloom_free (struct posix_name_bloom *nb)
+{
+        if (!nb)
+                return;
+
+        GF_FREE (nb->buf);
+        GF_FREE (nb);
+}
+
+
+/*
+ * Read the directory twice, once to size the filter and once to fill it.
+ * Returns the serialized filter, or NULL with *len 0 if the directory is
+ * too big to be worth one.
+ */
+static char *
+posix_name_bloom_build (xlator_t *this, const char *real_path, size_t *len)
+{
+        DIR            *dir    = NULL;
+        struct dirent  *entry  = NULL;
+        gf_bloom_t     *bloom  = NULL;
+        char           *buf    = NULL;
+        uint32_t        count  = 0;
+
+        *len = 0;
+
+        dir = opendir (real_path);
+        if (!dir) {
+                gf_msg (this->name, GF_LOG_WARNING, errno,
+                        P_MSG_OPENDIR_FAILED,
+                        "opendir failed on %s", real_path);
+                goto out;
+        }
+
+        while ((entry = readdir (dir)) != NULL) {
+                if (++count > POSIX_NAME_BLOOM_MAX_ENTRIES)
+                        goto out;
+        }
+
+        bloom = gf_bloom_new (count);
+        if (!bloom)
+                goto out;
+
+        rewinddir (dir);
+        while ((entry = readdir (dir)) != NULL) {
+                if (!strcmp (entry->d_name, ".") ||
+                    !strcmp (entry->d_name, ".."))
+                        continue;
+                gf_bloom_add (bloom, entry->d_name);
+        }
+
+        *len = gf_bloom_serialized_size (bloom);
+        buf = GF_MALLOC (*len, gf_posix_mt_char);
+        if (!buf) {
+                *len = 0;
+                goto out;
+        }
+        gf_bloom_serialize (bloom, buf);
+
+out:
+        if (dir)
+                closedir (dir);
+        gf_bloom_free (bloom);
+
+        return buf;
+}
+
+
+struct posix_name_bloom_args {
+        xlator_t        *this;
+        inode_t         *inode;
+        char            *real_path;
+        uint32_t         ctime;         /* of the directory before it is */
+        uint32_t         ctime_nsec;    /* read */
+};
+
+
+static int
+posix_name_bloom_task (void *opaque)
+{
+        struct posix_name_bloom_args *args = opaque;
+        struct posix_private         *priv = NULL;
+        struct posix_name_bloom      *nb   = NULL;
+        xlator_t                     *this = NULL;
+        uint64_t                      tmp  = 0;
+        char                         *buf  = NULL;
+        size_t                        len  = 0;
+        time_t                        now  = 0;
+
+        this = args->this;
+        priv = this->private;
+
+        buf = posix_name_bloom_build (this, args->real_path, &len);
+        now = time (NULL);
+
+        LOCK (&priv->lock);
+        {
+                priv->name_bloom_builds++;
+        }
+        UNLOCK (&priv->lock);
+
+        LOCK (&args->inode->lock);
+        {
+                if (!__inode_ctx_get (args->inode, this, &tmp))
+                        nb = (struct posix_name_bloom *)(long) tmp;
+                if (nb) {
+                        GF_FREE (nb->buf);
+                        nb->buf = buf;
+                        nb->len = buf ? len : 0;
+                        nb->ctime = args->ctime;
+                        nb->ctime_nsec = args->ctime_nsec;
+                        nb->reusable = ((now - args->ctime) >= 2);
+                        nb->building = _gf_false;
+                        buf = NULL;
+                }
+        }
+        UNLOCK (&args->inode->lock);
+
+        GF_FREE (buf);
+
+        return 0;
+}
+
+
+static int
+posix_name_bloom_task_done (int ret, call_frame_t *frame, void *opaque)
+{
+        struct posix_name_bloom_args *args = opaque;
+
+        inode_unref (args->inode);
+        GF_FREE (args->real_path);
+        GF_FREE (args);
+
+        return 0;
+}
+
+
+/*
+ * Add the name bloom filter of a directory to the reply of a lookup.
+ *
+ * A filter is reused for as long as the directory's ctime does not move,
+ * and only if it was built at least a second after the last change, as
+ * entries created within the same timestamp tick would go unnoticed
+ * otherwise. A changing directory is rebuilt at most once per
+ * name-bloom-refresh-interval; in between no filter is handed out, which
+ * makes the client look the name up as it always did. A filter that is
+ * handed out never misses a name the directory had when it was read.
+ *
+ * Reading the directory is left to a synctask, the lookup itself only
+ * ever hands out a filter which is already built.
+ */
+void
+posix_name_bloom_fill (xlator_t *this, const char *real_path, inode_t *inode,
+                       struct iatt *stbuf, dict_t *xattr)
+{
+        struct posix_private         *priv   = NULL;
+        struct posix_name_bloom      *nb     = NULL;
+        struct posix_name_bloom_args *args   = NULL;
+        uint64_t                      tmp    = 0;
+        char                         *buf    = NULL;
+        size_t                        len    = 0;
+        time_t                        now    = 0;
+        gf_boolean_t                  build  = _gf_false;
+        int                           ret    = 0;
+
+        priv = this->private;
+        if (!priv->name_bloom_refresh)
+                return;
+
+        now = time (NULL);
+
+        LOCK (&inode->lock);
+        {
+                if (!__inode_ctx_get (inode, this, &tmp))
+                        nb = (struct posix_name_bloom *)(long) tmp;
+
+                if (!nb) {
+                        nb = GF_CALLOC (1, sizeof (*nb),
+                                        gf_posix_mt_name_bloom_t);
+                        if (!nb)
+                                goto unlock;
+                        if (__inode_ctx_put (inode, this, (uint64_t)(long) nb)) {
+                                GF_FREE (nb);
+                                goto unlock;
+                        }
+                        build = _gf_true;
+                } else if (nb->reusable && nb->ctime == stbuf->ia_ctime &&
+                           nb->ctime_nsec == stbuf->ia_ctime_nsec) {
+                        if (nb->buf)
+                                buf = gf_memdup (nb->buf, nb->len);
+                        len = nb->len;
+                } else if (!nb->building &&
+                           (now - nb->built) >= priv->name_bloom_refresh) {
+                        build = _gf_true;
+                }
+
+                /* keep other lookups from rebuilding it at the same time */
+                if (build) {
+                        nb->built = now;
+                        nb->reusable = _gf_false;
+                        nb->building = _gf_true;
+                }
+        }
+unlock:
+        UNLOCK (&inode->lock);
+
+        if (build) {
+                args = GF_CALLOC (1, sizeof (*args), gf_posix_mt_name_bloom_t);
+                if (args) {
+                        args->this = this;
+                        args->inode = inode_ref (inode);
+                        args->real_path = gf_strdup (real_path);
+                        args->ctime = stbuf->ia_ctime;
+                        args->ctime_nsec = stbuf->ia_ctime_nsec;
+                }
+                if (!args || !args->real_path ||
+                    synctask_new (this->ctx->env, posix_name_bloom_task,
+                                  posix_name_bloom_task_done, NULL, args)) {
+                        if (args)
+                                posix_name_bloom_task_done (-1, NULL, args);
+                        LOCK (&inode->lock);
+                        {
+                                nb->building = _gf_false;
+                        }
+                        UNLOCK (&inode->lock);
+                }
+        }
+
+        if (!buf)
+                return;
+
+        ret = dict_set_bin (xattr, GF_NAME_BLOOM_KEY, buf, len);
+        if (ret) {
+                GF_FREE (buf);
+                gf_msg (this->name, GF_LOG_WARNING, 0, P_MSG_XDATA_GETXATTR,
+                        "Failed to set dictionary value for %s",
+                        GF_NAME_BLOOM_KEY);
+                return;
+        }
+
+        LOCK (&priv->lock);
+        {
+                priv->name_bloom_served++;
+        }
+        UNLOCK (&priv->lock);
+}
+
+
 int
 posix_fill_gfid_path (xlator_t *this, const char *path, struct iatt *iatt)
 {
@@ -653,6 +911,69 @@ out:
         return ret;
 }
 
+/*
+ * posix_pstatat - stat @name relative to the open directory @dirfd. This
+ * spares the walk of the full handle path from the brick root for every
+ * directory entry. @real_path is only used to fetch the gfid from the
+ * backend when @gfid is not known yet.
+ */
+int
+posix_pstatat (xlator_t *this, int dirfd, uuid_t gfid, const char *name,
+               const char *real_path, struct iatt *buf_p)
+{
+        struct stat  lstatbuf = {0, };
+        struct iatt  stbuf = {0, };
+        int          ret = 0;
+        struct posix_private *priv = NULL;
+
+        priv = this->private;
+
+        ret = sys_fstatat (dirfd, name, &lstatbuf, AT_SYMLINK_NOFOLLOW);
+
+        if (ret != 0) {
+                if (ret == -1) {
+                        if (errno != ENOENT)
+                                gf_msg (this->name, GF_LOG_WARNING, errno,
+                                        P_MSG_LSTAT_FAILED,
+                                        "fstatat failed on %s",
+                                        real_path ? real_path : name);
+                } else {
+                        // may be some backend filesytem issue
+                        gf_msg (this->name, GF_LOG_ERROR, 0, P_MSG_LSTAT_FAILED,
+                                "fstatat failed on %s and return value is %d "
+                                "instead of -1. Please see dmesg output to "
+                                "check whether the failure is due to backend "
+                                "filesystem issue",
+                                real_path ? real_path : name, ret);
+                        ret = -1;
+                }
+                goto out;
+        }
+
+        if ((lstatbuf.st_ino == priv->handledir.st_ino) &&
+            (lstatbuf.st_dev == priv->handledir.st_dev)) {
+                errno = ENOENT;
+                return -1;
+        }
+
+        if (!S_ISDIR (lstatbuf.st_mode))
+                lstatbuf.st_nlink --;
+
+        iatt_from_stat (&stbuf, &lstatbuf);
+
+        if (gfid && !gf_uuid_is_null (gfid))
+                gf_uuid_copy (stbuf.ia_gfid, gfid);
+        else if (real_path)
+                posix_fill_gfid_path (this, real_path, &stbuf);
+
+        posix_fill_ino_from_gfid (this, &stbuf);
+
+        if (buf_p)
+                *buf_p = stbuf;
+out:
+        return ret;
+}
+
 static void
 _handle_list_xattr (dict_t *xattr_req, const char *real_path, int fdnum,
                     posix_xattr_filler_t *filler)
@@ -1966,6 +2287,150 @@ posix_fsyncer (void *d)
         }
 }
 
+
+/*
+ * Fill entries of @job until none are left to be picked. Called both by the
+ * readdirp caller and by the fill threads working on the same job.
+ */
+void
+posix_readdirp_job_run (struct posix_readdirp_job *job)
+{
+        char *hpath = NULL;
+        int   len   = 0;
+        int   idx   = 0;
+
+        len = strlen (job->dirpath);
+        hpath = alloca (len + 256); /* NAME_MAX */
+        memcpy (hpath, job->dirpath, len);
+        hpath[len] = '/';
+
+        for (;;) {
+                pthread_mutex_lock (&job->mutex);
+                {
+                        idx = (job->next < job->count) ? job->next++ : -1;
+                }
+                pthread_mutex_unlock (&job->mutex);
+
+                if (idx < 0)
+                        break;
+
+                posix_readdirp_fill_entry (job->this, job->fd, job->dirfd,
+                                           hpath, len, job->entries[idx],
+                                           job->dict);
+
+                pthread_mutex_lock (&job->mutex);
+                {
+                        if (++job->done == job->count)
+                                pthread_cond_broadcast (&job->cond);
+                }
+                pthread_mutex_unlock (&job->mutex);
+        }
+}
+
+
+static struct posix_readdirp_job *
+posix_readdirp_job_pick (xlator_t *this)
+{
+        struct posix_private      *priv = NULL;
+        struct posix_readdirp_job *job  = NULL;
+
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->readdirp_mutex);
+        {
+                while (list_empty (&priv->readdirp_jobs) &&
+                       priv->readdirp_fillers <= priv->readdirp_fill_threads)
+                        pthread_cond_wait (&priv->readdirp_cond,
+                                           &priv->readdirp_mutex);
+
+                /* option was reduced, let the surplus threads exit */
+                if (priv->readdirp_fillers > priv->readdirp_fill_threads) {
+                        priv->readdirp_fillers--;
+                        goto unlock;
+                }
+
+                job = list_entry (priv->readdirp_jobs.next,
+                                  struct posix_readdirp_job, list);
+
+                pthread_mutex_lock (&job->mutex);
+                {
+                        job->refs++;
+                }
+                pthread_mutex_unlock (&job->mutex);
+        }
+unlock:
+        pthread_mutex_unlock (&priv->readdirp_mutex);
+
+        return job;
+}
+
+
+static void *
+posix_readdirp_filler (void *d)
+{
+        xlator_t                  *this = d;
+        struct posix_private      *priv = NULL;
+        struct posix_readdirp_job *job  = NULL;
+
+        priv = this->private;
+
+        for (;;) {
+                job = posix_readdirp_job_pick (this);
+                if (!job)
+                        break;
+
+                posix_readdirp_job_run (job);
+
+                /* nothing left to pick, keep others from picking it up */
+                pthread_mutex_lock (&priv->readdirp_mutex);
+                {
+                        list_del_init (&job->list);
+                }
+                pthread_mutex_unlock (&priv->readdirp_mutex);
+
+                pthread_mutex_lock (&job->mutex);
+                {
+                        if (--job->refs == 0)
+                                pthread_cond_broadcast (&job->cond);
+                }
+                pthread_mutex_unlock (&job->mutex);
+        }
+
+        return NULL;
+}
+
+
+void
+posix_spawn_readdirp_fillers (xlator_t *this)
+{
+        struct posix_private *priv = NULL;
+        pthread_t             thread;
+        int                   ret  = 0;
+
+        priv = this->private;
+
+        pthread_mutex_lock (&priv->readdirp_mutex);
+        {
+                while (priv->readdirp_fillers < priv->readdirp_fill_threads) {
+                        ret = gf_thread_create (&thread, NULL,
+                                                posix_readdirp_filler, this);
+                        if (ret) {
+                                gf_msg (this->name, GF_LOG_ERROR, errno,
+                                        P_MSG_READDIRP_FILLER_CREATE_FAILED,
+                                        "readdirp fill thread creation "
+                                        "failed");
+                                break;
+                        }
+                        pthread_detach (thread);
+                        priv->readdirp_fillers++;
+                }
+
+                /* wake up idle threads beyond a reduced limit */
+                pthread_cond_broadcast (&priv->readdirp_cond);
+        }
+        pthread_mutex_unlock (&priv->readdirp_mutex);
+}
+
 /**
  * TODO: move fd/inode interfaces into a single routine..
  */
@@ -2108,3 +2573,88 @@ posix_fdget_objectsignature (int fd, dict_t *xattr)
  error_return:
         return -EINVAL;
 }
+
+/**
+ * residency of the page cache pages backing [@offset, @offset + @size)
+ * of @fd, a byte per page in *@vecp (to be GF_FREE()d) with the lowest
+ * bit set for pages that are resident. returns the number of pages, or
+ * -1 if residency could not be determined.
+ */
+int
+posix_page_residency (int fd, off_t offset, size_t size, unsigned char **vecp)
+{
+        long           pagesize = 0;
+        off_t          start    = 0;
+        size_t         len      = 0;
+        void          *addr     = NULL;
+        unsigned char *vec      = NULL;
+        int            npages   = 0;
+
+        pagesize = sysconf (_SC_PAGESIZE);
+        if (pagesize <= 0 || !size)
+                return -1;
+
+        start = offset & ~((off_t) pagesize - 1);
+        len = size + (offset - start);
+        npages = (len + pagesize - 1) / pagesize;
+
+        vec = GF_CALLOC (npages, sizeof (*vec), gf_common_mt_char);
+        if (!vec)
+                return -1;
+
+        addr = mmap (NULL, len, PROT_READ, MAP_SHARED, fd, start);
+        if (addr == MAP_FAILED)
+                goto err;
+
+        if (mincore (addr, len, (void *) vec)) {
+                (void) munmap (addr, len);
+                goto err;
+        }
+
+        (void) munmap (addr, len);
+
+        *vecp = vec;
+        return npages;
+
+ err:
+        GF_FREE (vec);
+        return -1;
+}
+
+/**
+ * drop the pages of [@offset, @offset + @size) that were not resident
+ * as per @vec (from posix_page_residency() over a range starting at
+ * @offset): pages brought in by a one-off reader leave the cache again,
+ * pages others had cached stay.
+ */
+void
+posix_page_drop_new (int fd, off_t offset, size_t size,
+                     unsigned char *vec, int npages)
+{
+        long  pagesize = 0;
+        off_t start    = 0;
+        off_t end      = 0;
+        int   first    = 0;
+        int   i        = 0;
+
+        pagesize = sysconf (_SC_PAGESIZE);
+        if (pagesize <= 0)
+                return;
+
+        start = offset & ~((off_t) pagesize - 1);
+        end = offset + size;
+        npages = min (npages, (int) ((end - start + pagesize - 1) / pagesize));
+
+        for (i = 0; i <= npages; i++) {
+                if ((i < npages) && !(vec[i] & 1))
+                        continue;
+
+                /* pages [first, i) were not resident before */
+                if (i > first)
+                        (void) posix_fadvise (fd,
+                                              start + (off_t) first * pagesize,
+                                              (off_t) (i - first) * pagesize,
+                                              POSIX_FADV_DONTNEED);
+                first = i + 1;
+        }
+}
@@ -21,6 +21,8 @@ enum gf_posix_mem_types_ {
         gf_posix_mt_posix_dev_t,
         gf_posix_mt_trash_path,
 	gf_posix_mt_paiocb,
+        gf_posix_mt_readdirp_entries,
+        gf_posix_mt_name_bloom_t,
         gf_posix_mt_end
 };
 #endif
@@ -80,7 +80,8 @@ posix_forget (xlator_t *this, inode_t *inode)
 {
         uint64_t tmp_cache = 0;
         if (!inode_ctx_del (inode, this, &tmp_cache))
-                dict_destroy ((dict_t *)(long)tmp_cache);
+                posix_name_bloom_free ((struct posix_name_bloom *)
+                                       (long)tmp_cache);
 
         return 0;
 }
@@ -2618,6 +2619,8 @@ posix_readv (call_frame_t *frame, xlator_t *this,
         struct posix_fd *      pfd        = NULL;
         struct iatt            stbuf      = {0,};
         int                    ret        = -1;
+        unsigned char        * resident   = NULL;
+        int                    npages     = -1;
 
         VALIDATE_OR_GOTO (frame, out);
         VALIDATE_OR_GOTO (this, out);
@@ -2649,6 +2652,14 @@ posix_readv (call_frame_t *frame, xlator_t *this,
         }
 
         _fd = pfd->fd;
+
+        /**
+         * one-off readers (e.g. the scrubber) should not fill the cache,
+         * nor evict what others have cached: note what was resident.
+         */
+        if (xdata && dict_get (xdata, GLUSTERFS_READ_NOCACHE))
+                npages = posix_page_residency (_fd, offset, size, &resident);
+
         op_ret = pread (_fd, iobuf->ptr, size, offset);
         if (op_ret == -1) {
                 op_errno = errno;
@@ -2657,6 +2668,9 @@ posix_readv (call_frame_t *frame, xlator_t *this,
                 goto out;
         }
 
+        if (npages > 0 && op_ret > 0)
+                posix_page_drop_new (_fd, offset, op_ret, resident, npages);
+
         LOCK (&priv->lock);
         {
                 priv->read_value    += op_ret;
@@ -2697,6 +2711,7 @@ out:
                 iobref_unref (iobref);
         if (iobuf)
                 iobuf_unref (iobuf);
+        GF_FREE (resident);
 
         return 0;
 }
@@ -5507,91 +5522,204 @@ out:
 
 dict_t *
 posix_entry_xattr_fill (xlator_t *this, inode_t *inode,
-                        fd_t *fd, char *name, dict_t *dict,
+                        const char *entry_path, dict_t *dict,
                         struct iatt *stbuf)
 {
         loc_t  tmp_loc    = {0,};
-        char  *entry_path = NULL;
 
         /* if we don't send the 'loc', open-fd-count be a problem. */
         tmp_loc.inode = inode;
 
-        MAKE_HANDLE_PATH (entry_path, this, fd->inode->gfid, name);
-        if (!entry_path) {
-                gf_msg (this->name, GF_LOG_WARNING, 0,
-                        P_MSG_HANDLE_CREATE,
-                        "Failed to create handle path for %s/%s",
-                        uuid_utoa (fd->inode->gfid), name);
-
-                return NULL;
-        }
         return posix_xattr_fill (this, entry_path, &tmp_loc, NULL, -1, dict,
                                  stbuf);
 
 }
 
 
-int
-posix_readdirp_fill (xlator_t *this, fd_t *fd, gf_dirent_t *entries, dict_t *dict)
+/*
+ * Fill stat, inode and requested xattrs of a single readdirp entry. @hpath
+ * holds the handle path of the directory followed by a '/' at @len.
+ */
+void
+posix_readdirp_fill_entry (xlator_t *this, fd_t *fd, int dirfd, char *hpath,
+                           int len, gf_dirent_t *entry, dict_t *dict)
 {
-        gf_dirent_t     *entry    = NULL;
-        inode_table_t   *itable   = NULL;
-	inode_t         *inode    = NULL;
-	char            *hpath    = NULL;
-	int              len      = 0;
+        inode_t         *inode    = NULL;
         struct iatt      stbuf    = {0, };
-	uuid_t           gfid;
+        uuid_t           gfid     = {0, };
         int              ret      = -1;
-	if (list_empty(&entries->list))
-		return 0;
 
-        itable = fd->inode->table;
+        inode = inode_grep (fd->inode->table, fd->inode, entry->d_name);
+        if (inode)
+                gf_uuid_copy (gfid, inode->gfid);
 
-	len = posix_handle_path (this, fd->inode->gfid, NULL, NULL, 0);
-        if (len <= 0)
-                return -1;
-	hpath = alloca (len + 256); /* NAME_MAX */
-	if (posix_handle_path (this, fd->inode->gfid, NULL, hpath, len) <= 0)
+        /* the full path is needed only for fetching xattrs by path */
+        if (!inode || dict)
+                strcpy (&hpath[len+1], entry->d_name);
+        else
+                hpath = NULL;
+
+        ret = posix_pstatat (this, dirfd, gfid, entry->d_name, hpath, &stbuf);
+        if (ret == -1) {
+                if (inode)
+                        inode_unref (inode);
+                return;
+        }
+
+        if (!inode)
+                inode = inode_find (fd->inode->table, stbuf.ia_gfid);
+
+        if (!inode)
+                inode = inode_new (fd->inode->table);
+
+        entry->inode = inode;
+
+        if (dict) {
+                entry->dict = posix_entry_xattr_fill (this, entry->inode,
+                                                      hpath, dict, &stbuf);
+        }
+
+        entry->d_stat = stbuf;
+        if (stbuf.ia_ino)
+                entry->d_ino = stbuf.ia_ino;
+}
+
+
+static int
+posix_readdirp_fill_parallel (xlator_t *this, fd_t *fd, int dirfd,
+                              const char *dirpath, gf_dirent_t *entries,
+                              int count, dict_t *dict)
+{
+        struct posix_private      *priv  = NULL;
+        struct posix_readdirp_job  job   = {{0, }, };
+        gf_dirent_t               *entry = NULL;
+        int                        i     = 0;
+
+        priv = this->private;
+
+        job.entries = GF_CALLOC (count, sizeof (*job.entries),
+                                 gf_posix_mt_readdirp_entries);
+        if (!job.entries)
                 return -1;
-	len = strlen (hpath);
-	hpath[len] = '/';
 
-        list_for_each_entry (entry, &entries->list, list) {
-		memset (gfid, 0, 16);
-		inode = inode_grep (fd->inode->table, fd->inode,
-				    entry->d_name);
-		if (inode)
-			gf_uuid_copy (gfid, inode->gfid);
+        list_for_each_entry (entry, &entries->list, list)
+                job.entries[i++] = entry;
+
+        INIT_LIST_HEAD (&job.list);
+        pthread_mutex_init (&job.mutex, NULL);
+        pthread_cond_init (&job.cond, NULL);
+        job.this    = this;
+        job.fd      = fd;
+        job.dirfd   = dirfd;
+        job.dirpath = dirpath;
+        job.dict    = dict;
+        job.count   = count;
+
+        pthread_mutex_lock (&priv->readdirp_mutex);
+        {
+                list_add_tail (&job.list, &priv->readdirp_jobs);
+                pthread_cond_broadcast (&priv->readdirp_cond);
+        }
+        pthread_mutex_unlock (&priv->readdirp_mutex);
+
+        posix_readdirp_job_run (&job);
 
-		strcpy (&hpath[len+1], entry->d_name);
+        pthread_mutex_lock (&job.mutex);
+        {
+                while (job.done < job.count)
+                        pthread_cond_wait (&job.cond, &job.mutex);
+        }
+        pthread_mutex_unlock (&job.mutex);
 
-                ret = posix_pstat (this, gfid, hpath, &stbuf);
+        pthread_mutex_lock (&priv->readdirp_mutex);
+        {
+                list_del_init (&job.list);
+        }
+        pthread_mutex_unlock (&priv->readdirp_mutex);
 
-                if (ret == -1)
-                      continue;
+        /* fill threads may still hold the job while finding it drained */
+        pthread_mutex_lock (&job.mutex);
+        {
+                while (job.refs)
+                        pthread_cond_wait (&job.cond, &job.mutex);
+        }
+        pthread_mutex_unlock (&job.mutex);
 
-		if (!inode)
-			inode = inode_find (itable, stbuf.ia_gfid);
+        pthread_cond_destroy (&job.cond);
+        pthread_mutex_destroy (&job.mutex);
+        GF_FREE (job.entries);
 
-		if (!inode)
-			inode = inode_new (itable);
+        return 0;
+}
 
-		entry->inode = inode;
 
-                if (dict) {
-                        entry->dict =
-                                posix_entry_xattr_fill (this, entry->inode,
-                                                        fd, entry->d_name,
-                                                        dict, &stbuf);
+int
+posix_readdirp_fill (xlator_t *this, fd_t *fd, DIR *dir, gf_dirent_t *entries,
+                     dict_t *dict)
+{
+        struct posix_private *priv     = NULL;
+        gf_dirent_t          *entry    = NULL;
+        char                 *hpath    = NULL;
+        int                   len      = 0;
+        int                   dfd      = -1;
+        int                   count    = 0;
+        int                   ret      = -1;
+        struct timeval        begin    = {0, };
+        struct timeval        end      = {0, };
+        uint64_t              elapsed  = 0;
+
+        if (list_empty(&entries->list))
+                return 0;
+
+        priv = this->private;
+
+        gettimeofday (&begin, NULL);
+
+        dfd = dirfd (dir);
+        if (dfd < 0)
+                return -1;
+
+        len = posix_handle_path (this, fd->inode->gfid, NULL, NULL, 0);
+        if (len <= 0)
+                return -1;
+        hpath = alloca (len + 256); /* NAME_MAX */
+        if (posix_handle_path (this, fd->inode->gfid, NULL, hpath, len) <= 0)
+                return -1;
+        len = strlen (hpath);
+        hpath[len] = '/';
+
+        list_for_each_entry (entry, &entries->list, list)
+                count++;
+
+        if (priv->readdirp_fill_threads && count > 1) {
+                hpath[len] = '\0';
+                ret = posix_readdirp_fill_parallel (this, fd, dfd, hpath,
+                                                    entries, count, dict);
+                hpath[len] = '/';
+        }
+
+        if (ret) {
+                list_for_each_entry (entry, &entries->list, list) {
+                        posix_readdirp_fill_entry (this, fd, dfd, hpath, len,
+                                                   entry, dict);
                 }
+        }
+
+        gettimeofday (&end, NULL);
+        elapsed = (end.tv_sec - begin.tv_sec) * 1000000
+                  + (end.tv_usec - begin.tv_usec);
 
-                entry->d_stat = stbuf;
-                if (stbuf.ia_ino)
-                        entry->d_ino = stbuf.ia_ino;
-		inode = NULL;
+        LOCK (&priv->lock);
+        {
+                priv->readdirp_fill_count++;
+                priv->readdirp_fill_entries += count;
+                priv->readdirp_fill_usec += elapsed;
+                if (elapsed > priv->readdirp_fill_max_usec)
+                        priv->readdirp_fill_max_usec = elapsed;
         }
+        UNLOCK (&priv->lock);
 
-	return 0;
+        return 0;
 }
 
 
@@ -5661,7 +5789,7 @@ posix_do_readdir (call_frame_t *frame, xlator_t *this,
         if (whichop != GF_FOP_READDIRP)
                 goto out;
 
-	posix_readdirp_fill (this, fd, &entries, dict);
+	posix_readdirp_fill (this, fd, dir, &entries, dict);
 
 out:
         STACK_UNWIND_STRICT (readdir, frame, op_ret, op_errno, &entries, NULL);
@@ -5738,6 +5866,22 @@ posix_priv (xlator_t *this)
         gf_proc_dump_write("max_read","%d", priv->read_value);
         gf_proc_dump_write("max_write","%d", priv->write_value);
         gf_proc_dump_write("nr_files","%ld", priv->nr_files);
+        gf_proc_dump_write("readdirp_fill_threads", "%u",
+                           priv->readdirp_fill_threads);
+        gf_proc_dump_write("readdirp_fill_count", "%"PRIu64,
+                           priv->readdirp_fill_count);
+        gf_proc_dump_write("readdirp_fill_entries", "%"PRIu64,
+                           priv->readdirp_fill_entries);
+        gf_proc_dump_write("readdirp_fill_usec", "%"PRIu64,
+                           priv->readdirp_fill_usec);
+        gf_proc_dump_write("readdirp_fill_max_usec", "%"PRIu64,
+                           priv->readdirp_fill_max_usec);
+        gf_proc_dump_write("name_bloom_refresh", "%u",
+                           priv->name_bloom_refresh);
+        gf_proc_dump_write("name_bloom_builds", "%"PRIu64,
+                           priv->name_bloom_builds);
+        gf_proc_dump_write("name_bloom_served", "%"PRIu64,
+                           priv->name_bloom_served);
 
         return 0;
 }
@@ -5763,6 +5907,8 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
         int32_t                 weak_checksum   = 0;
         unsigned char           strong_checksum[MD5_DIGEST_LENGTH] = {0};
         struct posix_private    *priv           = NULL;
+        char                    *type           = NULL;
+        dict_t                  *rsp_xdata      = NULL;
 
         VALIDATE_OR_GOTO (frame, out);
         VALIDATE_OR_GOTO (this, out);
@@ -5809,14 +5955,33 @@ posix_rchecksum (call_frame_t *frame, xlator_t *this,
                 goto out;
 
         weak_checksum = gf_rsync_weak_checksum ((unsigned char *) buf, (size_t) ret);
+
+        /* callers comparing copies of a block can ask for the faster
+           strong checksum, the reply says which one they got */
+        if (xdata && !dict_get_str (xdata, GF_RCHECKSUM_TYPE_KEY, &type) &&
+            !strcmp (type, GF_RCHECKSUM_XXH64)) {
+                rsp_xdata = dict_new ();
+                if (rsp_xdata &&
+                    !dict_set_str (rsp_xdata, GF_RCHECKSUM_TYPE_KEY,
+                                   GF_RCHECKSUM_XXH64)) {
+                        gf_rsync_xxh64_checksum ((unsigned char *) buf,
+                                                 (size_t) ret,
+                                                 strong_checksum);
+                        op_ret = 0;
+                        goto out;
+                }
+        }
+
         gf_rsync_strong_checksum ((unsigned char *) buf, (size_t) ret, (unsigned char *) strong_checksum);
 
         op_ret = 0;
 out:
         STACK_UNWIND_STRICT (rchecksum, frame, op_ret, op_errno,
-                             weak_checksum, strong_checksum, NULL);
+                             weak_checksum, strong_checksum, rsp_xdata);
 
         GF_FREE (alloc_buf);
+        if (rsp_xdata)
+                dict_unref (rsp_xdata);
 
         return 0;
 }
@@ -6001,6 +6166,13 @@ struct posix_private *priv = NULL;
                           options, uint32, out);
         posix_spawn_health_check_thread (this);
 
+        GF_OPTION_RECONF ("readdirp-fill-threads", priv->readdirp_fill_threads,
+                          options, uint32, out);
+        posix_spawn_readdirp_fillers (this);
+
+        GF_OPTION_RECONF ("name-bloom-refresh-interval",
+                          priv->name_bloom_refresh, options, uint32, out);
+
 	ret = 0;
 out:
 	return ret;
@@ -6497,6 +6669,17 @@ init (xlator_t *this)
 
         GF_OPTION_INIT ("batch-fsync-delay-usec", _private->batch_fsync_delay_usec,
                         uint32, out);
+
+        pthread_mutex_init (&_private->readdirp_mutex, NULL);
+        pthread_cond_init (&_private->readdirp_cond, NULL);
+        INIT_LIST_HEAD (&_private->readdirp_jobs);
+
+        GF_OPTION_INIT ("readdirp-fill-threads",
+                        _private->readdirp_fill_threads, uint32, out);
+        posix_spawn_readdirp_fillers (this);
+
+        GF_OPTION_INIT ("name-bloom-refresh-interval",
+                        _private->name_bloom_refresh, uint32, out);
 out:
         return ret;
 }
@@ -6654,6 +6837,28 @@ struct volume_options options[] = {
           .default_value = "off",
           .description = "Enable placeholders for gfid to path conversion"
         },
+        { .key = {"readdirp-fill-threads"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = 16,
+          .default_value = "0",
+          .validate = GF_OPT_VALIDATE_BOTH,
+          .description = "Number of threads helping readdirp to collect "
+                         "stat and xattrs of directory entries in parallel, "
+                         "set to 0 to fill entries serially"
+        },
+        { .key = {"name-bloom-refresh-interval"},
+          .type = GF_OPTION_TYPE_INT,
+          .min = 0,
+          .max = 3600,
+          .default_value = "5",
+          .validate = GF_OPT_VALIDATE_BOTH,
+          .description = "Minimum interval in seconds between rebuilds of "
+                         "the bloom filter of names in a directory which is "
+                         "being modified, handed to distribute on lookup to "
+                         "skip bricks which do not have a name. Set to 0 to "
+                         "not build filters"
+        },
 #if GF_DARWIN_HOST_OS
         { .key = {"xattr-user-namespace-mode"},
           .type = GF_OPTION_TYPE_STR,
@@ -155,6 +155,26 @@ struct posix_private {
 	uint32_t        batch_fsync_delay_usec;
         gf_boolean_t    update_pgfid_nlinks;
 
+        /* threads helping readdirp with per-entry stat/xattr collection */
+        uint32_t          readdirp_fill_threads;
+        uint32_t          readdirp_fillers;
+        struct list_head  readdirp_jobs;
+        pthread_mutex_t   readdirp_mutex;
+        pthread_cond_t    readdirp_cond;
+
+        /* readdirp fill statistics, protected by @lock */
+        uint64_t        readdirp_fill_count;
+        uint64_t        readdirp_fill_entries;
+        uint64_t        readdirp_fill_usec;
+        uint64_t        readdirp_fill_max_usec;
+
+        /* seconds between rebuilds of a changing directory's name bloom
+           filter, 0 to not hand out filters */
+        uint32_t        name_bloom_refresh;
+        /* name bloom statistics, protected by @lock */
+        uint64_t        name_bloom_builds;
+        uint64_t        name_bloom_served;
+
         /* seconds to sleep between health checks */
         uint32_t        health_check_interval;
         pthread_t       health_check;
@@ -184,6 +204,26 @@ typedef struct {
         int32_t     op_errno;
 } posix_xattr_filler_t;
 
+/**
+ * posix_readdirp_job - entries of one readdirp reply, whose stat and xattrs
+ * are filled by the readdirp caller together with the fill threads
+ */
+struct posix_readdirp_job {
+        struct list_head  list;     /* in priv->readdirp_jobs */
+        xlator_t         *this;
+        fd_t             *fd;
+        int               dirfd;    /* fd of the open directory */
+        const char       *dirpath;  /* handle path of the directory */
+        dict_t           *dict;
+        gf_dirent_t     **entries;
+        int               count;
+        int               next;     /* next entry to be picked */
+        int               done;     /* entries filled so far */
+        int               refs;     /* fill threads working on the job */
+        pthread_mutex_t   mutex;
+        pthread_cond_t    cond;
+};
+
 
 #define POSIX_BASE_PATH(this) (((struct posix_private *)this->private)->base_path)
 
@@ -199,6 +239,8 @@ int posix_istat (xlator_t *this, uuid_t gfid, const char *basename,
                  struct iatt *iatt);
 int posix_pstat (xlator_t *this, uuid_t gfid, const char *real_path,
                  struct iatt *iatt);
+int posix_pstatat (xlator_t *this, int dirfd, uuid_t gfid, const char *name,
+                   const char *real_path, struct iatt *iatt);
 dict_t *posix_xattr_fill (xlator_t *this, const char *path, loc_t *loc,
                           fd_t *fd, int fdnum, dict_t *xattr, struct iatt *buf);
 int posix_handle_pair (xlator_t *this, const char *real_path, char *key,
@@ -226,6 +268,38 @@ __posix_fd_set_odirect (fd_t *fd, struct posix_fd *pfd, int opflags,
 void posix_spawn_health_check_thread (xlator_t *this);
 
 void *posix_fsyncer (void *);
+
+/* directories with more entries than this get no name bloom filter */
+#define POSIX_NAME_BLOOM_MAX_ENTRIES (256 * 1024)
+
+/*
+ * Serialized bloom filter of the names in a directory, kept in the
+ * directory's inode ctx.
+ */
+struct posix_name_bloom {
+        uint32_t        ctime;          /* of the directory it was built */
+        uint32_t        ctime_nsec;     /* from, if it can be reused */
+        gf_boolean_t    reusable;
+        gf_boolean_t    building;       /* a synctask is reading it */
+        time_t          built;
+        char           *buf;            /* NULL if the directory was too */
+        size_t          len;            /* big */
+};
+
+void posix_name_bloom_fill (xlator_t *this, const char *real_path,
+                            inode_t *inode, struct iatt *stbuf, dict_t *xattr);
+void posix_name_bloom_free (struct posix_name_bloom *nb);
+
+int posix_page_residency (int fd, off_t offset, size_t size,
+                          unsigned char **vecp);
+void posix_page_drop_new (int fd, off_t offset, size_t size,
+                          unsigned char *vec, int npages);
+
+void posix_spawn_readdirp_fillers (xlator_t *this);
+void posix_readdirp_job_run (struct posix_readdirp_job *job);
+void posix_readdirp_fill_entry (xlator_t *this, fd_t *fd, int dirfd,
+                                char *hpath, int len, gf_dirent_t *entry,
+                                dict_t *dict);
 int
 posix_get_ancestry (xlator_t *this, inode_t *leaf_inode,
                     gf_dirent_t *head, char **path, int type, int32_t *op_errno,